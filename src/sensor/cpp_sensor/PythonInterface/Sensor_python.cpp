@@ -1,82 +1,461 @@
-
-#include <pybind11/pybind11.h>
-#include <pybind11/stl.h>
-namespace py = pybind11;
-
-#include <iostream>
-using namespace std;
-
-
-#include "Sensor_python.h"
-#include "PixelLayer.h"
-#include "LayerDebugger.h"
-#include "Monitor.h"
-
-// ndarray_converter.h is needed to import/export cv::Mat to numpy's ndarray
-#include "ndarray_converter.h"
-#include "PyDictConversion.h"
-#include <boost/property_tree/ini_parser.hpp>
-
-
-//=============================================================================
-//							   Static functions
-//=============================================================================
-void SetWorkingDir(const string& a_working_dir)
-{
-	Config::WORKING_DIR = a_working_dir;
-}
-//-----------------------------------------------------------------------------
-void AddDebugger(const string& a_name,
-				 const SegmentationLayer& a_layer)
-{
-	LayerDebugger::AddDebugger(a_layer, a_name);
-}
-//-----------------------------------------------------------------------------
-void LoadConfigFile(const string& a_filename)
-{
-	Config::LoadConfigFile(a_filename);
-}
-
-//-----------------------------------------------------------------------------
-void SetConfig(pybind11::dict a_dict)
-{
-	boost::property_tree::ptree tree = ConvertDictToPtree(a_dict);
-	Config::SetConfig(tree);
-	//try { boost::property_tree::ini_parser::write_ini("test.ini", tree); }
-	//catch (...) {}
-}
-
-//=============================================================================
-//								Pybind11 Module
-//=============================================================================
-PYBIND11_MODULE(cpp_sensor, m)
-{
-	NDArrayConverter::init_numpy();
-
-	m.def("SetWorkingDir", &SetWorkingDir);
-	m.def("AddDebugger", &AddDebugger);
-	m.def("LoadConfigFile", &LoadConfigFile);
-	m.def("SetConfig", &SetConfig);
-
-	py::class_<SegmentationLayer, PySegLayer>(m, "SegLayer")
-		.def(py::init<const cv::Mat&>())
-		.def("SegmentLayer", &SegmentationLayer::SegmentLayer)
-		.def("GetCoefStabilization", 
-			 &SegmentationLayer::GetCoefStabilization,
-			 py::arg("min_phase") = 0)
-		.def("GetNbCycles", &SegmentationLayer::GetNbCycles)
-		.def("GetNbCascades", &SegmentationLayer::GetNbCascades)
-		.def("GetNbSpikes", &SegmentationLayer::GetNbSpikes);
-
-	py::class_<PixelLayer, SegmentationLayer>(m, "PixelLayer")
-		.def(py::init<const string&>())
-		.def(py::init<const cv::Mat&>());
-	//	.def("Add", &SensorPixel::DebugSegmentation)
-	//	.def("SetWorkingDir", &SensorPixel::SetWorkingDir);
-
-	py::class_<SegmentLayerMonitor>(m, "SegLayerMonitor")
-		.def(py::init<string, SegmentationLayer&>())
-		.def("GetDisplay", &SegmentLayerMonitor::GetDisplay);
-
-	
-}
+
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+namespace py = pybind11;
+
+#include <iostream>
+#include <stdexcept>
+#include <tuple>
+using namespace std;
+
+
+#include "Sensor_python.h"
+#include "PixelLayer.h"
+#include "PackedPixelLayer.h"
+#include "SegmentationLayerT.h"
+#include "GalleryMatcher.h"
+#include "PyramidSegmenter.h"
+#include "VideoSegmenter.h"
+#include "VideoPipeline.h"
+#include "LayerDebugger.h"
+#include "LayerRenderer.h"
+#include "LayerState.h"
+#include "LayerTracer.h"
+#include "Monitor.h"
+#include "SyntheticImage.h"
+
+// ndarray_converter.h is needed to import/export cv::Mat to numpy's ndarray
+#include "ndarray_converter.h"
+#include "PyDictConversion.h"
+#include <boost/property_tree/ini_parser.hpp>
+
+
+//=============================================================================
+//							   Static functions
+//=============================================================================
+void SetWorkingDir(const string& a_working_dir)
+{
+	Config::WORKING_DIR = a_working_dir;
+}
+//-----------------------------------------------------------------------------
+void AddDebugger(const string& a_name,
+				 const SegmentationLayer& a_layer)
+{
+	LayerDebugger::AddDebugger(a_layer, a_name);
+}
+//-----------------------------------------------------------------------------
+void LoadConfigFile(const string& a_filename)
+{
+	Config::LoadConfigFile(a_filename);
+}
+
+//-----------------------------------------------------------------------------
+void SegmentDirtyFrame(VideoSegmenter& a_segmenter, const cv::Mat& a_frame,
+					   const vector<tuple<int, int, int, int> >& a_dirty_rects)
+{
+	// The rectangles are given as (x, y, width, height) tuples
+	vector<cv::Rect> dirtyRects;
+	for (auto& rect : a_dirty_rects)
+	{
+		dirtyRects.push_back(cv::Rect(get<0>(rect), get<1>(rect),
+									  get<2>(rect), get<3>(rect)));
+	}
+	a_segmenter.SegmentFrame(a_frame, dirtyRects);
+}
+
+//-----------------------------------------------------------------------------
+typedef void (LayerRenderer::*LayerRenderFunc)(const NeuralLayer&, cv::Mat&,
+											   cv::Size, cv::Rect, 
+											   cv::Point2f);
+
+template <LayerRenderFunc RENDER>
+cv::Mat RenderLayer(LayerRenderer& a_renderer, 
+					const SegmentationLayer& a_layer,
+					cv::Mat a_out, int a_width, int a_height)
+{
+	// Render into the given array if any, so that no image is allocated. Its
+	// data is shared when it is a contiguous uint8 array of 3 channels.
+	cv::Size size(a_width, a_height);
+	if (!a_out.empty()) size = a_out.size();
+
+	(a_renderer.*RENDER)(a_layer, a_out, size, cv::Rect(), cv::Point2f());
+	return a_out;
+}
+
+//-----------------------------------------------------------------------------
+py::dict GetPhaseCounters(const SegmentationLayer& a_layer)
+{
+	const PhaseCounters& counters = a_layer.GetPhaseCounters();
+
+	// Hardware counters that were available, empty if not counted
+	py::list hwCounters;
+	for (int c = 0; c < NB_HW_COUNTERS; ++c)
+	{
+		if (counters.hw_available & (1u << c))
+			hwCounters.append(HardwareCounters::GetCounterName((HwCounter)c));
+	}
+
+	// Time, calls and hardware events of each phase, by phase name
+	py::dict phases;
+	for (int p = 0; p < NB_SIM_PHASES; ++p)
+	{
+		py::dict phase;
+		phase["time_ms"] = counters.GetTimeMs((SimPhase)p);
+		phase["calls"] = counters.calls[p];
+		for (int c = 0; c < NB_HW_COUNTERS; ++c)
+		{
+			if (counters.hw_available & (1u << c))
+			{
+				phase[HardwareCounters::GetCounterName((HwCounter)c)] =
+					counters.hw[p][c];
+			}
+		}
+		phases[PhaseCounters::GetPhaseName((SimPhase)p)] = phase;
+	}
+
+	py::dict dict;
+	dict["phases"] = phases;
+	dict["hw_counters"] = hwCounters;
+	dict["spikes"] = counters.spikes;
+	dict["merges"] = counters.merges;
+	return dict;
+}
+
+//-----------------------------------------------------------------------------
+py::list GetHardwareCounters()
+{
+	// Counters available on the calling thread
+	py::list names;
+	HardwareCounters* counters = HardwareCounters::GetThreadCounters();
+	for (int c = 0; counters && c < NB_HW_COUNTERS; ++c)
+	{
+		if (counters->GetAvailable() & (1u << c))
+			names.append(HardwareCounters::GetCounterName((HwCounter)c));
+	}
+	return names;
+}
+
+//-----------------------------------------------------------------------------
+py::tuple GenerateSyntheticImageRegions(const SyntheticImageParams& a_params)
+{
+	// The image and the index of the region of each pixel
+	cv::Mat regions;
+	cv::Mat img = GenerateSyntheticImage(a_params, &regions);
+	return py::make_tuple(img, regions);
+}
+
+//-----------------------------------------------------------------------------
+py::bytes GetBinaryState(const SegmentationLayer& a_layer)
+{
+	vector<char> state = a_layer.GetBinaryState();
+	return py::bytes(state.data(), state.size());
+}
+
+//-----------------------------------------------------------------------------
+void ParseBinaryState(const py::bytes& a_state, LayerStateView& a_view)
+{
+	// The state is read in place from the bytes object
+	char* data;
+	Py_ssize_t size;
+	if (PyBytes_AsStringAndSize(a_state.ptr(), &data, &size) != 0)
+		throw py::error_already_set();
+
+	if (!a_view.Parse(data, (size_t)size))
+		throw std::runtime_error("Invalid layer state");
+}
+
+//-----------------------------------------------------------------------------
+void SetBinaryState(SegmentationLayer& a_layer, const py::bytes& a_state)
+{
+	LayerStateView view;
+	ParseBinaryState(a_state, view);
+	if (!a_layer.LoadBinaryState(view))
+		throw std::runtime_error("Layer state doesn't fit the layer");
+}
+
+//-----------------------------------------------------------------------------
+unique_ptr<PixelLayer> CreatePixelLayerFromFile(const string& a_img_file)
+{
+	return CreatePixelLayer(a_img_file);
+}
+
+//-----------------------------------------------------------------------------
+unique_ptr<PixelLayer> CreatePixelLayerFromImage(const cv::Mat& a_img)
+{
+	ImageData imgData(a_img);
+	return CreatePixelLayer(imgData);
+}
+
+//-----------------------------------------------------------------------------
+unique_ptr<PixelLayer> CreatePixelLayerFromState(const py::bytes& a_state)
+{
+	LayerStateView view;
+	ParseBinaryState(a_state, view);
+
+	// The layer of the class saved, e.g. specialized or fixed size
+	unique_ptr<PixelLayer> layer = CreatePixelLayer(view);
+	if (!layer) throw std::runtime_error("Invalid layer state");
+
+	return layer;
+}
+
+//-----------------------------------------------------------------------------
+unique_ptr<PackedPixelLayer> CreatePackedLayerFromState(
+	const py::bytes& a_state)
+{
+	unique_ptr<PixelLayer> layer = CreatePixelLayerFromState(a_state);
+	if (layer->GetLayerClass() != PIXEL_LAYER_PACKED)
+		throw std::runtime_error("Layer state isn't a packed layer");
+
+	return unique_ptr<PackedPixelLayer>(
+		static_cast<PackedPixelLayer*>(layer.release()));
+}
+
+//-----------------------------------------------------------------------------
+void SetConfig(pybind11::dict a_dict)
+{
+	boost::property_tree::ptree tree = ConvertDictToPtree(a_dict);
+	Config::SetConfig(tree);
+	//try { boost::property_tree::ini_parser::write_ini("test.ini", tree); }
+	//catch (...) {}
+}
+
+//=============================================================================
+//								Pybind11 Module
+//=============================================================================
+PYBIND11_MODULE(cpp_sensor, m)
+{
+	NDArrayConverter::init_numpy();
+
+	m.def("SetWorkingDir", &SetWorkingDir);
+	m.def("AddDebugger", &AddDebugger);
+	m.def("LoadConfigFile", &LoadConfigFile);
+	m.def("SetConfig", &SetConfig);
+	m.def("StartTrace", &LayerTracer::Start);
+	m.def("StopTrace", &LayerTracer::Stop);
+	m.def("GetTrace", &LayerTracer::GetChromeTrace);
+	m.def("WriteTrace", &LayerTracer::WriteChromeTrace);
+	m.def("GetHardwareCounters", &GetHardwareCounters);
+	m.def("CreatePixelLayer",
+		  (unique_ptr<PixelLayer> (*)(const string&, bool)) &CreatePixelLayer,
+		  py::arg("img_file"),
+		  py::arg("random_init") = Config::PIXEL_RANDOM_INIT);
+
+	py::class_<CancellationToken>(m, "CancellationToken")
+		.def(py::init<>())
+		.def("Cancel", &CancellationToken::Cancel)
+		.def("Reset", &CancellationToken::Reset)
+		.def("IsCancelled", &CancellationToken::IsCancelled);
+
+	py::class_<SegmentationResult>(m, "SegmentationResult")
+		.def_readonly("labels", &SegmentationResult::labels)
+		.def_readonly("convergence", &SegmentationResult::convergence)
+		.def_readonly("converged", &SegmentationResult::converged)
+		.def_readonly("deadline_reached", 
+					  &SegmentationResult::deadline_reached)
+		.def_readonly("cancelled", &SegmentationResult::cancelled)
+		.def_readonly("cycles", &SegmentationResult::cycles)
+		.def_readonly("cascades", &SegmentationResult::cascades)
+		.def_readonly("time_ms", &SegmentationResult::time_ms);
+
+	py::class_<SegmentationLayer, PySegLayer>(m, "SegLayer")
+		.def(py::init<const cv::Mat&>())
+		.def("SegmentLayer", &SegmentationLayer::SegmentLayer)
+		.def("Step", &SegmentationLayer::Step,
+			 py::call_guard<py::gil_scoped_release>())
+		.def("RunCascades", &SegmentationLayer::RunCascades,
+			 py::call_guard<py::gil_scoped_release>())
+		.def("RunCycles", &SegmentationLayer::RunCycles,
+			 py::call_guard<py::gil_scoped_release>())
+		.def("SegmentWithDeadline", &SegmentationLayer::SegmentWithDeadline,
+			 py::arg("time_budget_ms"), py::arg("cancel") = nullptr,
+			 py::arg("clear_small_segments") = false,
+			 py::call_guard<py::gil_scoped_release>())
+		.def("RestartSegmentation", &SegmentationLayer::RestartSegmentation)
+		.def("IsConverged", &SegmentationLayer::IsConverged)
+		.def("IsSegmentationDone", &SegmentationLayer::IsSegmentationDone)
+		.def("GetConvergence", &SegmentationLayer::GetConvergence)
+		.def("GetCoefStabilization", 
+			 &SegmentationLayer::GetCoefStabilization,
+			 py::arg("min_phase") = 0)
+		.def("GetNbCycles", &SegmentationLayer::GetNbCycles)
+		.def("GetNbCascades", &SegmentationLayer::GetNbCascades)
+		.def("GetNbSpikes", &SegmentationLayer::GetNbSpikes)
+		.def("GetPhaseCounters", &GetPhaseCounters)
+		.def("ResetPhaseCounters", &SegmentationLayer::ResetPhaseCounters)
+		.def("GetWeightPlanesMemory", 
+			 &SegmentationLayer::GetWeightPlanesMemory)
+		.def("GetLabels", 
+			 (cv::Mat (SegmentationLayer::*)() const)
+			 &SegmentationLayer::GetLabels)
+		.def("SaveBinaryState", &SegmentationLayer::SaveBinaryState)
+		.def("LoadBinaryState", 
+			 (bool (SegmentationLayer::*)(const string&))
+			 &SegmentationLayer::LoadBinaryState)
+		.def("ValidateLayerState", &SegmentationLayer::ValidateLayerState)
+		.def("GetBinaryState", &GetBinaryState)
+		.def("SetBinaryState", &SetBinaryState);
+
+	// Created by CreatePixelLayer(), so that the specialized and fixed size
+	// layers are used from Python as well. Pickled as their binary state, 
+	// see NeuralLayer::SaveBinaryState().
+	py::class_<PixelLayer, SegmentationLayer>(m, "PixelLayer")
+		.def(py::init(&CreatePixelLayerFromFile))
+		.def(py::init(&CreatePixelLayerFromImage))
+		.def(py::pickle(&GetBinaryState, &CreatePixelLayerFromState));
+	//	.def("Add", &SensorPixel::DebugSegmentation)
+	//	.def("SetWorkingDir", &SensorPixel::SetWorkingDir);
+
+	py::class_<PackedImageResult>(m, "PackedImageResult")
+		.def_readonly("labels", &PackedImageResult::labels)
+		.def_readonly("cycles", &PackedImageResult::cycles)
+		.def_readonly("cascades", &PackedImageResult::cascades)
+		.def_readonly("convergence", &PackedImageResult::convergence)
+		.def_readonly("converged", &PackedImageResult::converged);
+
+	// Packed layers restore their own class, the pickling of PixelLayer 
+	// would create a different layer
+	py::class_<PackedPixelLayer, PixelLayer>(m, "PackedPixelLayer")
+		.def(py::init<const vector<cv::Mat>&>())
+		.def(py::pickle(&GetBinaryState, &CreatePackedLayerFromState))
+		.def("SegmentImages", &PackedPixelLayer::SegmentImages,
+			 py::call_guard<py::gil_scoped_release>())
+		.def("GetNbImages", &PackedPixelLayer::GetNbImages);
+
+	py::class_<SegmentLayerMonitor>(m, "SegLayerMonitor")
+		.def(py::init<string, SegmentationLayer&>())
+		.def("GetDisplay", 
+			 (cv::Mat (SegmentLayerMonitor::*)()) 
+			 &SegmentLayerMonitor::GetDisplay);
+
+	py::class_<LayerRenderer>(m, "LayerRenderer")
+		.def(py::init<>())
+		.def("RenderSegments", 
+			 &RenderLayer<&LayerRenderer::RenderSegments>,
+			 py::arg("layer"), py::arg("out") = py::none(),
+			 py::arg("width") = 0, py::arg("height") = 0)
+		.def("RenderPhases", 
+			 &RenderLayer<&LayerRenderer::RenderPhases>,
+			 py::arg("layer"), py::arg("out") = py::none(),
+			 py::arg("width") = 0, py::arg("height") = 0)
+		.def("RenderPotentials", 
+			 &RenderLayer<&LayerRenderer::RenderPotentials>,
+			 py::arg("layer"), py::arg("out") = py::none(),
+			 py::arg("width") = 0, py::arg("height") = 0);
+
+	py::class_<GalleryMatch>(m, "GalleryMatch")
+		.def_readonly("gallery_id", &GalleryMatch::gallery_id)
+		.def_readonly("score", &GalleryMatch::score);
+
+	py::class_<GalleryMatcher>(m, "GalleryMatcher")
+		.def(py::init<>())
+		.def("SetProbe", 
+			 (void (GalleryMatcher::*)(const string&))
+			 &GalleryMatcher::SetProbe)
+		.def("SetProbe", 
+			 (void (GalleryMatcher::*)(const cv::Mat&))
+			 &GalleryMatcher::SetProbe)
+		.def("AddGalleryImage",
+			 (uint (GalleryMatcher::*)(const string&))
+			 &GalleryMatcher::AddGalleryImage)
+		.def("AddGalleryImage",
+			 (uint (GalleryMatcher::*)(const cv::Mat&))
+			 &GalleryMatcher::AddGalleryImage)
+		.def("ClearGallery", &GalleryMatcher::ClearGallery)
+		.def("Match", &GalleryMatcher::Match,
+			 py::arg("top_k") = 0,
+			 py::call_guard<py::gil_scoped_release>())
+		.def("GetGallerySize", &GalleryMatcher::GetGallerySize)
+		.def("GetNbAbandoned", &GalleryMatcher::GetNbAbandoned);
+
+	py::class_<PyramidLevelStats>(m, "PyramidLevelStats")
+		.def_readonly("width", &PyramidLevelStats::width)
+		.def_readonly("height", &PyramidLevelStats::height)
+		.def_readonly("cycles", &PyramidLevelStats::cycles)
+		.def_readonly("cascades", &PyramidLevelStats::cascades)
+		.def_readonly("spikes", &PyramidLevelStats::spikes)
+		.def_readonly("time_ms", &PyramidLevelStats::time_ms);
+
+	py::class_<PyramidSegmenter>(m, "PyramidSegmenter")
+		.def(py::init<>())
+		.def("Segment",
+			 (unique_ptr<PixelLayer> (PyramidSegmenter::*)(const string&))
+			 &PyramidSegmenter::Segment)
+		.def("Segment",
+			 (unique_ptr<PixelLayer> (PyramidSegmenter::*)(const cv::Mat&))
+			 &PyramidSegmenter::Segment)
+		.def("GetLevelStats", &PyramidSegmenter::GetLevelStats);
+
+	py::class_<VideoFrameStats>(m, "VideoFrameStats")
+		.def_readonly("frame", &VideoFrameStats::frame)
+		.def_readonly("warm_neurons", &VideoFrameStats::warm_neurons)
+		.def_readonly("active_neurons", &VideoFrameStats::active_neurons)
+		.def_readonly("cycles", &VideoFrameStats::cycles)
+		.def_readonly("cascades", &VideoFrameStats::cascades)
+		.def_readonly("spikes", &VideoFrameStats::spikes)
+		.def_readonly("time_ms", &VideoFrameStats::time_ms);
+
+	py::class_<VideoSegmenter>(m, "VideoSegmenter")
+		.def(py::init<>())
+		.def("SetVideoSource", &VideoSegmenter::SetVideoSource)
+		.def("SegmentNextFrame", &VideoSegmenter::SegmentNextFrame,
+			 py::call_guard<py::gil_scoped_release>())
+		.def("SegmentFrame",
+			 (void (VideoSegmenter::*)(const cv::Mat&))
+			 &VideoSegmenter::SegmentFrame,
+			 py::call_guard<py::gil_scoped_release>())
+		.def("SegmentFrame", &SegmentDirtyFrame,
+			 py::arg("frame"), py::arg("dirty_rects"),
+			 py::call_guard<py::gil_scoped_release>())
+		.def("Reset", &VideoSegmenter::Reset)
+		.def("GetLayer", &VideoSegmenter::GetLayer,
+			 py::return_value_policy::reference_internal)
+		.def("GetFrameStats", &VideoSegmenter::GetFrameStats)
+		.def("GetNbFrames", &VideoSegmenter::GetNbFrames)
+		.def_readwrite("WARM_START_DELTA", &VideoSegmenter::WARM_START_DELTA)
+		.def_readwrite("PARTIAL_RESEGMENTATION", 
+					   &VideoSegmenter::PARTIAL_RESEGMENTATION);
+
+	py::class_<VideoPipelineStats>(m, "VideoPipelineStats")
+		.def_readonly("frames_decoded", &VideoPipelineStats::frames_decoded)
+		.def_readonly("frames_segmented", 
+					  &VideoPipelineStats::frames_segmented)
+		.def_readonly("frames_written", &VideoPipelineStats::frames_written)
+		.def_readonly("time_ms", &VideoPipelineStats::time_ms)
+		.def_readonly("throughput_fps", &VideoPipelineStats::throughput_fps)
+		.def_readonly("decode_blocked_ms", 
+					  &VideoPipelineStats::decode_blocked_ms)
+		.def_readonly("segment_blocked_ms", 
+					  &VideoPipelineStats::segment_blocked_ms)
+		.def_readonly("segment_idle_ms", &VideoPipelineStats::segment_idle_ms)
+		.def_readonly("write_idle_ms", &VideoPipelineStats::write_idle_ms)
+		.def_readonly("decoded_queue_max", 
+					  &VideoPipelineStats::decoded_queue_max)
+		.def_readonly("segmented_queue_max", 
+					  &VideoPipelineStats::segmented_queue_max);
+
+	py::class_<VideoPipeline>(m, "VideoPipeline")
+		.def(py::init<>())
+		.def("SetVideoSource", &VideoPipeline::SetVideoSource)
+		.def("SetOutputFile", &VideoPipeline::SetOutputFile)
+		.def("Run", &VideoPipeline::Run,
+			 py::call_guard<py::gil_scoped_release>())
+		.def("GetStats", &VideoPipeline::GetStats)
+		.def("GetSegmenter", &VideoPipeline::GetSegmenter,
+			 py::return_value_policy::reference_internal)
+		.def_readwrite("NB_WORKERS", &VideoPipeline::NB_WORKERS)
+		.def_readwrite("QUEUE_SIZE", &VideoPipeline::QUEUE_SIZE);
+
+	py::class_<SyntheticImageParams>(m, "SyntheticImageParams")
+		.def(py::init<>())
+		.def_readwrite("width", &SyntheticImageParams::width)
+		.def_readwrite("height", &SyntheticImageParams::height)
+		.def_readwrite("nb_regions", &SyntheticImageParams::nb_regions)
+		.def_readwrite("size_skew", &SyntheticImageParams::size_skew)
+		.def_readwrite("noise", &SyntheticImageParams::noise)
+		.def_readwrite("gradient", &SyntheticImageParams::gradient)
+		.def_readwrite("seed", &SyntheticImageParams::seed);
+	m.def("GenerateSyntheticImage", &GenerateSyntheticImageRegions);
+
+	
+}
@@ -0,0 +1,48 @@
+/** @file bench_main.cpp
+ *
+ * Main file of the benchmarks. The results are written to SENSOR_Bench.json
+ * in the working directory unless another --benchmark_out is given, so that
+ * they can be compared between versions, e.g. with the compare.py tool of
+ * Google Benchmark.
+ *
+ *  @author Vincent de Ladurantaye
+ */
+
+#include <cstring>
+#include <vector>
+using namespace std;
+
+#include "benchmark/benchmark.h"
+
+#include "Config.h"
+
+
+int main(int argc, char *argv[])
+{
+	Config::LoadConfigFile("SensorPixel.ini");
+
+	// Write the results as JSON by default
+	vector<char*> args(argv, argv + argc);
+	bool hasOut = false;
+	for (int i = 1; i < argc; ++i)
+	{
+		if (strncmp(argv[i], "--benchmark_out=", 16) == 0) hasOut = true;
+	}
+	char outArg[] = "--benchmark_out=SENSOR_Bench.json";
+	char formatArg[] = "--benchmark_out_format=json";
+	if (!hasOut)
+	{
+		args.push_back(outArg);
+		args.push_back(formatArg);
+	}
+	int nbArgs = (int)args.size();
+
+	::benchmark::Initialize(&nbArgs, args.data());
+	if (::benchmark::ReportUnrecognizedArguments(nbArgs, args.data()))
+		return 1;
+
+	::benchmark::RunSpecifiedBenchmarks();
+	::benchmark::Shutdown();
+
+	return 0;
+}
@@ -0,0 +1,396 @@
+/** @file bench_pixel.cpp
+*
+* Benchmarks of the pixel layers: the steps of the simulation on carGray.bmp,
+* and whole segmentations of carGray.bmp and of synthetic images from 64x128
+* to 4096x4096, and of synthetic images of increasing number of regions and
+* noise to see how the cost scales with the workload. The standard input
+* sizes are also segmented with and without the fixed size layers.
+*
+* @authors Vincent de Ladurantaye
+*/
+#include "benchmark/benchmark.h"
+
+#include "LayerCoupler.h"
+#include "LayerState.h"
+#include "SegmentationLayerT.h"
+#include "SyntheticImage.h"
+
+#include <chrono>
+#include <unordered_set>
+using namespace std;
+
+
+//=============================================================================
+//								BenchPixelLayer
+//=============================================================================
+/**
+* Pixel layer giving access to the steps of the simulation. The neurons are
+* initialized without randomness so that every run simulates the same thing.
+*/
+class BenchPixelLayer : public PixelLayer
+{
+public:
+	BenchPixelLayer(ImageData& a_img_data) :
+		PixelLayer(a_img_data, false)
+	{
+	}
+
+	using PixelLayer::PropagateSpike;
+	using PixelLayer::GetHomogeneity;
+
+	/**
+	* Runs a cascade as in SegmentationLayer::Step(), without the convergence
+	* checks. Returns the time spent firing the neurons, in seconds.
+	*/
+	double RunCascade()
+	{
+		float delta = FindNextTimeStep();
+		sim_time += delta;
+		AdvanceTime(delta);
+
+		auto start = chrono::steady_clock::now();
+		while (FireNeurons(n_cascades, sim_time) > 0)
+		{
+		}
+		chrono::duration<double> fireTime =
+			chrono::steady_clock::now() - start;
+
+		GlobalInhibition();
+		++n_cascades;
+
+		return fireTime.count();
+	}
+};
+
+//=============================================================================
+//									Inputs
+//=============================================================================
+/**
+* Get the image of the car, loaded once
+*/
+static ImageData& GetCarImage()
+{
+	static ImageData carData("carGray.bmp");
+	return carData;
+}
+
+//=============================================================================
+/**
+* Get the parameters of the synthetic images of the size benchmarks: about
+* one region per 32x32 pixels, of uneven sizes, with a little noise
+*/
+static SyntheticImageParams GetSyntheticParams(int a_width, int a_height)
+{
+	SyntheticImageParams params;
+	params.width = a_width;
+	params.height = a_height;
+	params.nb_regions = max(1, a_width * a_height / 1024);
+	params.size_skew = 0.5f;
+	params.noise = 2.0f;
+	params.gradient = 8.0f;
+	return params;
+}
+
+//=============================================================================
+/**
+* Adds the counters of a segmented layer to the results
+*/
+static void SetSegmentationCounters(benchmark::State& a_state,
+									PixelLayer& a_layer)
+{
+	// Labels of the neurons which fired, CountSegments() being too slow
+	// for the images with many segments
+	unordered_set<int> labels;
+	for (auto& neuron : a_layer.neurons)
+	{
+		if (neuron.phase > 0) labels.insert(neuron.label);
+	}
+
+	a_state.counters["cascades"] = a_layer.GetNbCascades();
+	a_state.counters["cycles"] = a_layer.GetNbCycles();
+	a_state.counters["spikes"] = (double)a_layer.GetNbSpikes();
+	a_state.counters["neurons"] = a_layer.size;
+	a_state.counters["segments"] = (double)labels.size();
+}
+
+//=============================================================================
+//								Microbenchmarks
+//=============================================================================
+static void BM_AdvanceTime(benchmark::State& a_state)
+{
+	BenchPixelLayer layer(GetCarImage());
+	vector<Neuron> neurons = layer.neurons;
+
+	// A small step so that no neuron reaches the threshold, the potentials
+	// being restored every batch so that they don't build up
+	const int batchSize = 1000;
+	int step = 0;
+	for (auto _ : a_state)
+	{
+		if (++step == batchSize)
+		{
+			a_state.PauseTiming();
+			layer.neurons = neurons;
+			step = 0;
+			a_state.ResumeTiming();
+		}
+
+		layer.AdvanceTime(1e-6f);
+	}
+
+	a_state.SetItemsProcessed(a_state.iterations() * layer.size);
+}
+BENCHMARK(BM_AdvanceTime);
+
+//=============================================================================
+static void BM_FireNeurons(benchmark::State& a_state)
+{
+	BenchPixelLayer layer(GetCarImage());
+	vector<char> state = layer.GetBinaryState();
+	LayerStateView stateView;
+	stateView.Parse(state.data(), state.size());
+
+	// Only the firing waves of each cascade are timed. The layer is restored
+	// every batch of cascades, so that the iterations keep simulating the
+	// start of the segmentation rather than a converged layer.
+	const uint batchSize = 50;
+	uint startCascades = layer.GetNbCascades();
+	unsigned long startSpikes = layer.GetNbSpikes();
+	unsigned long nbSpikes = 0;
+	for (auto _ : a_state)
+	{
+		if (layer.GetNbCascades() == startCascades + batchSize)
+		{
+			nbSpikes += layer.GetNbSpikes() - startSpikes;
+			layer.LoadBinaryState(stateView);
+		}
+
+		a_state.SetIterationTime(layer.RunCascade());
+	}
+	nbSpikes += layer.GetNbSpikes() - startSpikes;
+
+	a_state.counters["spikes"] = benchmark::Counter((double)nbSpikes,
+		benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_FireNeurons)->UseManualTime();
+
+//=============================================================================
+static void BM_PropagateSpike(benchmark::State& a_state)
+{
+	// Propagate from every neuron of a layer in the middle of its
+	// segmentation, the state being restored for each pass
+	BenchPixelLayer layer(GetCarImage());
+	layer.RunCascades(50);
+	vector<Neuron> neurons = layer.neurons;
+	vector<bool> isSegmented = layer.is_segmented;
+	int phase = layer.GetNbCascades();
+
+	for (auto _ : a_state)
+	{
+		a_state.PauseTiming();
+		layer.neurons = neurons;
+		layer.is_segmented = isSegmented;
+		a_state.ResumeTiming();
+
+		for (uint y = 0; y < layer.height; ++y)
+		for (uint x = 0; x < layer.width; ++x)
+		{
+			layer.PropagateSpike(layer.GetNeuronId(x, y), phase);
+		}
+	}
+
+	a_state.SetItemsProcessed(a_state.iterations() * layer.size);
+}
+BENCHMARK(BM_PropagateSpike);
+
+//=============================================================================
+static void BM_GetHomogeneity(benchmark::State& a_state)
+{
+	BenchPixelLayer layer(GetCarImage());
+
+	for (auto _ : a_state)
+	{
+		double sum = 0;
+		for (uint y = 0; y < layer.height; ++y)
+		for (uint x = 0; x < layer.width; ++x)
+		{
+			sum += layer.GetHomogeneity(x, y, layer.HOMOG_RADIUS);
+		}
+		benchmark::DoNotOptimize(sum);
+	}
+
+	a_state.SetItemsProcessed(a_state.iterations() * layer.size);
+}
+BENCHMARK(BM_GetHomogeneity);
+
+//=============================================================================
+static void BM_CountSegments(benchmark::State& a_state)
+{
+	BenchPixelLayer layer(GetCarImage());
+	layer.SegmentLayer();
+
+	for (auto _ : a_state)
+	{
+		layer.CountSegments();
+	}
+
+	a_state.counters["segments"] = (double)layer.segments.size();
+	a_state.SetItemsProcessed(a_state.iterations() * layer.size);
+}
+BENCHMARK(BM_CountSegments);
+
+//=============================================================================
+static void BM_CouplerSpikeHandler(benchmark::State& a_state)
+{
+	// A spike of the probe layer reaches every neuron of the gallery layer
+	const cv::Mat& carImg = GetCarImage().gray_image_;
+	ImageData probeData(carImg(cv::Rect(100, 0, 64, 48)));
+	ImageData galleryData(carImg(cv::Rect(110, 10, 64, 48)));
+	BenchPixelLayer probe(probeData);
+	BenchPixelLayer gallery(galleryData);
+	PixelLayerCoupler coupler(&probe, &gallery);
+
+	uint id = 0;
+	for (auto _ : a_state)
+	{
+		coupler.Layer1SpikeHandler(id, probe.layer_id, 1);
+		id = (id + 1) % probe.size;
+	}
+
+	a_state.SetItemsProcessed(a_state.iterations() * gallery.size);
+}
+BENCHMARK(BM_CouplerSpikeHandler);
+
+//=============================================================================
+static void BM_RunCoupling(benchmark::State& a_state)
+{
+	// Every spike reaches all the neurons of the other layer, so the cost
+	// grows with the square of the size of the layers
+	const cv::Mat& carImg = GetCarImage().gray_image_;
+	ImageData probeData(carImg(cv::Rect(100, 0, 32, 24)));
+	ImageData galleryData(carImg(cv::Rect(105, 5, 32, 24)));
+
+	for (auto _ : a_state)
+	{
+		a_state.PauseTiming();
+		BenchPixelLayer probe(probeData);
+		BenchPixelLayer gallery(galleryData);
+		probe.SegmentLayer();
+		gallery.SegmentLayer();
+		PixelLayerCoupler coupler(&probe, &gallery);
+		a_state.ResumeTiming();
+
+		benchmark::DoNotOptimize(coupler.RunCoupling(a_state.range(0)));
+	}
+}
+BENCHMARK(BM_RunCoupling)->Arg(20)->Unit(benchmark::kMillisecond);
+
+//=============================================================================
+//							  End-to-end benchmarks
+//=============================================================================
+/**
+* Creates and segments the layer of the image, as the Python module does
+*/
+static void SegmentImage(benchmark::State& a_state, ImageData& a_img_data)
+{
+	unique_ptr<PixelLayer> layer;
+	for (auto _ : a_state)
+	{
+		layer = CreatePixelLayer(a_img_data, false);
+		layer->SegmentLayer();
+	}
+
+	SetSegmentationCounters(a_state, *layer);
+	a_state.SetItemsProcessed(a_state.iterations() * layer->size);
+}
+//-----------------------------------------------------------------------------
+static void SegmentImage(benchmark::State& a_state,
+						 const SyntheticImageParams& a_params)
+{
+	ImageData imgData(GenerateSyntheticImage(a_params));
+	SegmentImage(a_state, imgData);
+	a_state.counters["regions"] = a_params.nb_regions;
+}
+
+//=============================================================================
+static void BM_SegmentCarGray(benchmark::State& a_state)
+{
+	SegmentImage(a_state, GetCarImage());
+}
+BENCHMARK(BM_SegmentCarGray)->Unit(benchmark::kMillisecond);
+
+//=============================================================================
+static void BM_SegmentSynthetic(benchmark::State& a_state)
+{
+	SegmentImage(a_state, GetSyntheticParams((int)a_state.range(0),
+											 (int)a_state.range(1)));
+	a_state.SetComplexityN(a_state.range(0) * a_state.range(1));
+}
+BENCHMARK(BM_SegmentSynthetic)
+	->Args({ 64, 128 })
+	->Args({ 256, 256 })
+	->Args({ 512, 512 })
+	->Unit(benchmark::kMillisecond)
+	->Complexity();
+// The largest images take seconds to minutes, a single run is enough
+BENCHMARK(BM_SegmentSynthetic)
+	->Args({ 1024, 1024 })
+	->Args({ 2048, 2048 })
+	->Args({ 4096, 4096 })
+	->Iterations(1)
+	->Unit(benchmark::kMillisecond);
+
+//=============================================================================
+static void BM_SegmentFixedSize(benchmark::State& a_state)
+{
+	// Standard input sizes, segmented by the fixed size layer or by the
+	// specialized layer of any size. The images are generated with the flag
+	// off so that they aren't cropped to the configured size.
+	bool fixedSize = Config::FIXED_INPUT_IMGS_SIZE;
+	Config::FIXED_INPUT_IMGS_SIZE = false;
+	ImageData imgData(GenerateSyntheticImage(GetSyntheticParams(
+		(int)a_state.range(0), 128)));
+
+	Config::FIXED_INPUT_IMGS_SIZE = a_state.range(1) != 0;
+	SegmentImage(a_state, imgData);
+
+	Config::FIXED_INPUT_IMGS_SIZE = fixedSize;
+}
+BENCHMARK(BM_SegmentFixedSize)
+	->ArgsProduct({ { 64, 48 }, { 0, 1 } })
+	->Unit(benchmark::kMillisecond);
+
+//=============================================================================
+static void BM_SegmentRegions(benchmark::State& a_state)
+{
+	// Number of regions of a 256x256 image, with the segments merged or not
+	bool merge = Config::SEG_MERGE_SEGMENTS;
+	Config::SEG_MERGE_SEGMENTS = a_state.range(1) != 0;
+
+	SyntheticImageParams params = GetSyntheticParams(256, 256);
+	params.nb_regions = (uint)a_state.range(0);
+	SegmentImage(a_state, params);
+	a_state.SetComplexityN(a_state.range(0));
+
+	Config::SEG_MERGE_SEGMENTS = merge;
+}
+BENCHMARK(BM_SegmentRegions)
+	->ArgsProduct({ benchmark::CreateRange(4, 4096, 4), { 0 } })
+	->Unit(benchmark::kMillisecond)
+	->Complexity();
+BENCHMARK(BM_SegmentRegions)
+	->ArgsProduct({ benchmark::CreateRange(4, 4096, 4), { 1 } })
+	->Unit(benchmark::kMillisecond)
+	->Complexity();
+
+//=============================================================================
+static void BM_SegmentNoise(benchmark::State& a_state)
+{
+	// Noise of a 256x256 image, in gray levels
+	SyntheticImageParams params = GetSyntheticParams(256, 256);
+	params.noise = (float)a_state.range(0);
+	SegmentImage(a_state, params);
+}
+BENCHMARK(BM_SegmentNoise)
+	->DenseRange(0, 16, 4)
+	->Unit(benchmark::kMillisecond);
@@ -0,0 +1,32 @@
+# Build options of the layers, shared by all the projects. The Python module
+# is also configured on its own by setup.py, so PythonInterface includes this
+# file as well.
+if(SENSOR_OPTIONS_INCLUDED)
+	return()
+endif()
+set(SENSOR_OPTIONS_INCLUDED TRUE)
+
+# Layer debugger breakpoints compiled in the layers. The spike breakpoints
+# are always compiled in Debug builds.
+option(SENSOR_LAYER_DEBUGGER "Compile the layer debugger breakpoints" ON)
+option(SENSOR_DEBUG_SPIKES "Compile the layer debugger spike breakpoints" OFF)
+if(NOT SENSOR_LAYER_DEBUGGER)
+	add_definitions(-DLAYER_DEBUGGER_NONE)
+elseif(SENSOR_DEBUG_SPIKES)
+	add_definitions(-DLAYER_DEBUGGER_SPIKES)
+else()
+	set_property(DIRECTORY APPEND PROPERTY COMPILE_DEFINITIONS
+				 $<$<CONFIG:Debug>:LAYER_DEBUGGER_SPIKES>)
+endif()
+
+# Counters of the time spent in each phase of the simulation of the layers
+option(SENSOR_LAYER_PROFILER "Compile the layer phase counters" ON)
+if(NOT SENSOR_LAYER_PROFILER)
+	add_definitions(-DLAYER_PROFILER_NONE)
+endif()
+
+# Compact neurons, see Neuron.h
+option(SENSOR_COMPACT_NEURONS "Store the neuron periods in half precision" OFF)
+if(SENSOR_COMPACT_NEURONS)
+	add_definitions(-DCOMPACT_NEURONS)
+endif()
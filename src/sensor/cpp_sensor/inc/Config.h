@@ -1,130 +1,202 @@
-/** @file Config.h
- * This file contains parameters controlling different aspect of the
- * simulation
- *
- * @author Vincent de Ladurantaye
- */
-
-#pragma once
-#pragma warning(disable: 4244) // possible loss of data (double to float)
-#pragma warning(disable: 4267) // possible loss of data (size_t to uint)
-#pragma warning(disable: 4018) // '<': signed / unsigned mismatch
-
-#include <string>
-using namespace std;
-
-#include <boost/property_tree/ptree.hpp>
-
-//#define __APPLE__
-
-//=============================================================================
-//								   Typedefs
-//=============================================================================
-typedef unsigned int uint;
-
-//=============================================================================
-//									Config
-//=============================================================================
-/**
-* Contains all the parameters that can be modified. Parameters are stored as 
-* static variables, they are thus global and accessible anywhere in the code.
-*/
-class Config
-{
-public:
-
-	/**  Constructor
-	*/
-	Config()
-	{
-	}
-
-	//-------------------------------------------------------------------------
-	// General configuration parameters
-	//-------------------------------------------------------------------------
-	// Working directory where the program will look for files. This is used
-	// in the python interface so the working directory can be elsewhere than
-	// directly in the python directory
-	static string WORKING_DIR;
-	
-	//-------------------------------------------------------------------------
-	// Neuron potential parameters
-	//-------------------------------------------------------------------------
-	// Firing threshold of the neurons
-	static float POT_THRESHOLD;
-	// Tau in neuron equation
-	static float TAU;
-	// Global inibition value
-	static float GLOBAL_INHIB_VAL;
-	// Leader
-	static float CHARGING_LEADER;
-	// Follower
-	static float CHARGING_FOLLOWER;
-
-	//-------------------------------------------------------------------------
-	// Neural connexion parameters
-	//-------------------------------------------------------------------------
-	// Weight constant for segmentation
-	static float SEG_WEIGHT_MAX;
-	static float SEG_WEIGHT_SLOPE;
-	static float SEG_WEIGHT_OFFSET;
-
-	// Weight constant for matching
-	static float MATCHING_WEIGHT_MAX;
-	static float MATCHING_WEIGHT_SLOPE;
-	static float MATCHING_WEIGHT_OFFSET; 
-
-	//-------------------------------------------------------------------------
-	// General simulation parameters
-	//-------------------------------------------------------------------------
-	// Number of maximum segmentation cascades. Set to 0 to run until the net
-	static uint SEG_MAX_CASCADES;
-	// Number of maximum segmentation cycles
-	static uint SEG_MAX_CYCLES;
-
-	// Automaticaly trigger the spiking or all neurons within a segment when a
-	// neuron part of the segment spikes
-	static bool SEG_TRIGGER_SAME_LABEL_NEURONS;
-	// When two neurons of different segments synchronize, automaticly merge
-	// their respective segments
-	static bool SEG_MERGE_SEGMENTS;
-	// Maximal feature divergence for merging segments
-	static float SEG_MERGE_DELTA;
-
-	// Minimum number of neurons to have a valid segment
-	static uint MIN_SEGMENT_SIZE;
-
-	//-------------------------------------------------------------------------
-	// Input Image parameters
-	//-------------------------------------------------------------------------
-	// Determines if images are resised but keeping their aspect ratio
-	static bool RESIZE_IMG_KEEP_RATIO;
-	// Lenght of the longest size of the image. The smallest size will be
-	// adjusted to preserve the image ratio
-	static uint KEEP_RATIO_LONGEST_IMG_SIDE;
-	
-	// Determines if images are croped or enlarged to a specific size
-	static bool FIXED_INPUT_IMGS_SIZE;
-	static uint FIXED_INPUT_IMGS_WIDTH;
-	static uint FIXED_INPUT_IMGS_HEIGHT;
-
-	//-------------------------------------------------------------------------
-	// Pixel layer parameters
-	//-------------------------------------------------------------------------
-	static uint PIXEL_HOMOG_DELTA;
-	static uint PIXEL_HOMOG_RADIUS;
-	static float PIXEL_HOMOG_THRESHOLD;
-	static bool PIXEL_RANDOM_INIT;
-
-public:
-	static void SetConfig(const boost::property_tree::ptree& tree);
-	static bool LoadConfigFile(string file_name);
-	static void GenerateConfigFile(string file_name);
-
-	static inline string FromWorkingDir(const string& a_file)
-	{
-		if (Config::WORKING_DIR == "") return a_file;
-		return Config::WORKING_DIR + '/' + a_file;
-	}
-	
-};
+/** @file Config.h
+ * This file contains parameters controlling different aspect of the
+ * simulation
+ *
+ * @author Vincent de Ladurantaye
+ */
+
+#pragma once
+#pragma warning(disable: 4244) // possible loss of data (double to float)
+#pragma warning(disable: 4267) // possible loss of data (size_t to uint)
+#pragma warning(disable: 4018) // '<': signed / unsigned mismatch
+
+#include <string>
+using namespace std;
+
+#include <boost/property_tree/ptree.hpp>
+
+//#define __APPLE__
+
+//=============================================================================
+//								   Typedefs
+//=============================================================================
+typedef unsigned int uint;
+
+//=============================================================================
+//									Config
+//=============================================================================
+/**
+* Contains all the parameters that can be modified. Parameters are stored as 
+* static variables, they are thus global and accessible anywhere in the code.
+*/
+class Config
+{
+public:
+
+	/**  Constructor
+	*/
+	Config()
+	{
+	}
+
+	//-------------------------------------------------------------------------
+	// General configuration parameters
+	//-------------------------------------------------------------------------
+	// Working directory where the program will look for files. This is used
+	// in the python interface so the working directory can be elsewhere than
+	// directly in the python directory
+	static string WORKING_DIR;
+	
+	//-------------------------------------------------------------------------
+	// Neuron potential parameters
+	//-------------------------------------------------------------------------
+	// Firing threshold of the neurons
+	static float POT_THRESHOLD;
+	// Tau in neuron equation
+	static float TAU;
+	// Global inibition value
+	static float GLOBAL_INHIB_VAL;
+	// Leader
+	static float CHARGING_LEADER;
+	// Follower
+	static float CHARGING_FOLLOWER;
+
+	//-------------------------------------------------------------------------
+	// Neural connexion parameters
+	//-------------------------------------------------------------------------
+	// Weight constant for segmentation
+	static float SEG_WEIGHT_MAX;
+	static float SEG_WEIGHT_SLOPE;
+	static float SEG_WEIGHT_OFFSET;
+
+	// Weight constant for matching
+	static float MATCHING_WEIGHT_MAX;
+	static float MATCHING_WEIGHT_SLOPE;
+	static float MATCHING_WEIGHT_OFFSET; 
+
+	//-------------------------------------------------------------------------
+	// General simulation parameters
+	//-------------------------------------------------------------------------
+	// Number of maximum segmentation cascades. Set to 0 to run until the net
+	static uint SEG_MAX_CASCADES;
+	// Number of maximum segmentation cycles
+	static uint SEG_MAX_CYCLES;
+
+	// Automaticaly trigger the spiking or all neurons within a segment when a
+	// neuron part of the segment spikes
+	static bool SEG_TRIGGER_SAME_LABEL_NEURONS;
+	// When two neurons of different segments synchronize, automaticly merge
+	// their respective segments
+	static bool SEG_MERGE_SEGMENTS;
+	// Maximal feature divergence for merging segments
+	static float SEG_MERGE_DELTA;
+
+	// Minimum number of neurons to have a valid segment
+	static uint MIN_SEGMENT_SIZE;
+
+	// Precomputed intra-layer weight planes: 0 = off, 1 = on, 2 = computed
+	// once the layer spiked as many times as it has neurons
+	static uint SEG_WEIGHT_PLANES;
+	// Maximal memory of automatically enabled weight planes, in MB
+	static float SEG_WEIGHT_PLANES_MAX_MB;
+
+	// Memory layout of the neurons: 0 = row-major, 1 = square tiles
+	static uint SIM_NEURON_LAYOUT;
+	// Side of the tiles of the tiled neuron layout
+	static uint SIM_LAYOUT_TILE_SIZE;
+
+	// Collapse the stable segments into super-neurons where only the
+	// boundary neurons are simulated
+	// Off by default, the gain depends on the image: the segmentation of
+	// carGray.bmp is about 12% slower, the one of 512x512 synthetic images
+	// about 5% faster
+	static bool SEG_COARSEN_SEGMENTS;
+	// Maximal absolute delta period of the neurons of a stable segment
+	static float SEG_COARSEN_DELTA_PERIOD;
+	// Number of consecutive cycles a segment must be stable to be collapsed
+	static uint SEG_COARSEN_CYCLES;
+
+	// Number of levels of the coarse-to-fine pyramid segmentation, each
+	// level halving the image size. Set to 1 to segment at full resolution.
+	static uint SEG_PYRAMID_LEVELS;
+	// Maximum number of cycles simulated to refine each level initialized
+	// from the coarser one
+	static uint SEG_PYRAMID_REFINE_CYCLES;
+
+	// Maximal gray level change of a pixel between two video frames for its
+	// neuron to start from its state in the previous frame. Set to -1 to
+	// segment each frame from scratch, which lets the video workers segment
+	// the frames concurrently unless SEG_PARTIAL_RESEGMENTATION is set.
+	static int SEG_WARM_START_DELTA;
+	// Only segment again the tiles of a video frame that changed since the
+	// previous frame, plus a margin
+	static bool SEG_PARTIAL_RESEGMENTATION;
+	// Side of the tiles compared between video frames
+	static uint SEG_CHANGE_TILE_SIZE;
+	// Margin added around the changed tiles, in pixels
+	static uint SEG_CHANGE_MARGIN;
+
+	//-------------------------------------------------------------------------
+	// Matching parameters
+	//-------------------------------------------------------------------------
+	// Number of cascades simulated while coupling two segmented layers
+	static uint MATCHING_COUPLING_CASCADES;
+	// Number of threads used to match a probe against the gallery. Set to 0
+	// to use all the hardware threads
+	static uint MATCHING_NB_THREADS;
+
+	//-------------------------------------------------------------------------
+	// Video pipeline parameters
+	//-------------------------------------------------------------------------
+	// Number of threads segmenting the frames. Set to 0 to use all the
+	// hardware threads
+	static uint VIDEO_NB_WORKERS;
+	// Capacity of the queues between the pipeline stages, in frames
+	static uint VIDEO_QUEUE_SIZE;
+
+	//-------------------------------------------------------------------------
+	// Debugger parameters
+	//-------------------------------------------------------------------------
+	// Minimal time between two snapshots of a layer published to the 
+	// display in real-time debugging, in ms
+	static uint DEBUG_SNAPSHOT_PERIOD_MS;
+	// Number of events kept per thread by the layer tracer
+	static uint TRACE_BUFFER_SIZE;
+	// Flag indicating if the phase counters of the layers also count the
+	// hardware events of the CPU (Linux perf events)
+	static bool PROFILE_HW_COUNTERS;
+
+	//-------------------------------------------------------------------------
+	// Input Image parameters
+	//-------------------------------------------------------------------------
+	// Determines if images are resised but keeping their aspect ratio
+	static bool RESIZE_IMG_KEEP_RATIO;
+	// Lenght of the longest size of the image. The smallest size will be
+	// adjusted to preserve the image ratio
+	static uint KEEP_RATIO_LONGEST_IMG_SIDE;
+	
+	// Determines if images are croped or enlarged to a specific size
+	static bool FIXED_INPUT_IMGS_SIZE;
+	static uint FIXED_INPUT_IMGS_WIDTH;
+	static uint FIXED_INPUT_IMGS_HEIGHT;
+
+	//-------------------------------------------------------------------------
+	// Pixel layer parameters
+	//-------------------------------------------------------------------------
+	static uint PIXEL_HOMOG_DELTA;
+	static uint PIXEL_HOMOG_RADIUS;
+	static float PIXEL_HOMOG_THRESHOLD;
+	static bool PIXEL_RANDOM_INIT;
+
+public:
+	static void SetConfig(const boost::property_tree::ptree& tree);
+	static bool LoadConfigFile(string file_name);
+	static void GenerateConfigFile(string file_name);
+
+	static inline string FromWorkingDir(const string& a_file)
+	{
+		if (Config::WORKING_DIR == "") return a_file;
+		return Config::WORKING_DIR + '/' + a_file;
+	}
+	
+};
@@ -0,0 +1,137 @@
+/**
+* @file GalleryMatcher.h
+*
+* @authors Vincent de Ladurantaye
+*/
+#pragma once
+
+#include "PixelLayer.h"
+#include "LayerCoupler.h"
+
+#include <atomic>
+#include <mutex>
+
+
+/**
+* Result of the matching between the probe and one gallery image
+*/
+struct GalleryMatch
+{
+	// Index of the gallery image, in the order the images were added
+	uint gallery_id;
+	// Match score between the probe and the gallery image, in [0, 1]
+	float score;
+};
+
+
+//=============================================================================
+//								GalleryMatcher
+//=============================================================================
+/**
+* Matches a probe image against a gallery of images, as done for person
+* re-identification. The probe and the gallery images are segmented only
+* once, when they are set, and their segmented states are kept. Matching a
+* pair then only runs the coupling phase, the pairs being processed in
+* parallel. Each worker couples its own copy of the probe with the gallery
+* layer it took, and both layers are restored in place from their states
+* afterwards.
+*/
+class GalleryMatcher
+{
+public:
+
+	/**
+	* Constructor
+	*/
+	GalleryMatcher();
+
+	/**
+	* Sets and segments the probe image
+	*/
+	void SetProbe(const string& a_img_file);
+	void SetProbe(const cv::Mat& a_img);
+
+	/**
+	* Segments an image and adds it to the gallery. Returns the index of the
+	* image in the gallery.
+	*/
+	uint AddGalleryImage(const string& a_img_file);
+	uint AddGalleryImage(const cv::Mat& a_img);
+
+	/**
+	* Removes all the images from the gallery
+	*/
+	void ClearGallery();
+
+	/**
+	* Matches the probe against all the gallery images and returns the
+	* matches ranked from best to worst.
+	*
+	* @param a_top_k Number of best matches to return. The coupling of a pair
+	*	is abandoned as soon as it can no longer enter the current top k. Set
+	*	to 0 to rank the whole gallery.
+	*/
+	vector<GalleryMatch> Match(uint a_top_k = 0);
+
+	/// Get the number of images in the gallery
+	uint GetGallerySize() const { return gallery_layers_.size(); }
+	/// Get the number of couplings abandoned during the last Match() call
+	uint GetNbAbandoned() const { return n_abandoned_; }
+
+protected:
+
+	/**
+	* Worker function matching the gallery images until all images are
+	* processed. Each worker takes the next image that isn't processed yet.
+	*
+	* @param a_probe Copy of the probe layer owned by the worker
+	*/
+	void MatchWorker(PixelLayer* a_probe, uint a_top_k);
+
+	/**
+	* Adds a match to the results, keeping only the top k results if k is
+	* greater than 0.
+	*/
+	void AddResult(const GalleryMatch& a_match, uint a_top_k);
+
+	/**
+	* Creates a segmented layer from the given image data
+	*/
+	unique_ptr<PixelLayer> CreateSegmentedLayer(ImageData& a_img_data);
+
+protected:
+
+	// Segmented probe layer
+	unique_ptr<PixelLayer> probe_layer_;
+
+	// Segmented gallery layers
+	vector<unique_ptr<PixelLayer> > gallery_layers_;
+
+	// Binary states of the segmented layers, to restore them after the
+	// coupling
+	vector<char> probe_state_;
+	vector<vector<char> > gallery_states_;
+
+	// Index of the next gallery image to be processed by the workers
+	atomic<uint> next_gallery_id_;
+
+	// Score a match needs to reach to enter the top k results
+	atomic<float> min_score_;
+
+	// Results of the current match, sorted from best to worst
+	vector<GalleryMatch> results_;
+	mutex results_mutex_;
+
+	// Number of abandoned couplings
+	atomic<uint> n_abandoned_;
+
+
+//-----------------------------------------------------------------------------
+//							Configuration Parameters
+//-----------------------------------------------------------------------------
+public:
+
+	uint COUPLING_CASCADES;
+	uint NB_THREADS;
+
+};
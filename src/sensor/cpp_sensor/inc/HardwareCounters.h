@@ -0,0 +1,94 @@
+/** @file HardwareCounters.h
+*
+* Hardware event counters of the CPU, read through the Linux perf events.
+*
+*  @author Vincent de Ladurantaye
+*/
+
+#pragma once
+
+#include <cstdint>
+
+#include "Config.h"
+
+/**
+* Hardware events counted
+*/
+enum HwCounter
+{
+	HW_COUNTER_CYCLES = 0,		// CPU cycles
+	HW_COUNTER_INSTRUCTIONS,	// Instructions retired
+	HW_COUNTER_L1D_MISSES,		// L1 data cache read misses
+	HW_COUNTER_LLC_MISSES,		// Last level cache misses
+	HW_COUNTER_BRANCH_MISSES,	// Mispredicted branches
+	NB_HW_COUNTERS
+};
+
+//=============================================================================
+//							   HardwareCounters
+//=============================================================================
+/**
+* Counters of the hardware events of the calling thread, in user space. The
+* counters are opened as a single perf event group so that they are scheduled
+* together and their ratios (e.g. instructions per cycle) stay meaningful.
+* When the group shares the PMU with other events, it is multiplexed and the
+* values are extrapolated from the time it was running.
+*
+* Each counter that can't be opened is left out, and all of them are when perf
+* events aren't supported by the system, e.g. on other platforms, in virtual
+* machines without a virtual PMU, or in containers where the perf_event_open
+* system call is not permitted. Check GetAvailable() before using the values.
+*/
+class HardwareCounters
+{
+public:
+	/**
+	* Get the counters of the calling thread, opened on the first call and
+	* closed when the thread ends. Returns nullptr if no counter is available.
+	*/
+	static HardwareCounters* GetThreadCounters();
+
+	/**
+	* Destructor, closes the counters
+	*/
+	~HardwareCounters();
+
+	/**
+	* Reads the current value of all the counters, 0 for those unavailable.
+	* Returns the flags of the counters read, which are none while the group
+	* was never scheduled. Costs a system call.
+	*/
+	uint Read(uint64_t a_values[NB_HW_COUNTERS]) const;
+
+	/**
+	* Get the flags of the available counters, bit c being set if the counter
+	* c is available
+	*/
+	uint GetAvailable() const { return available_; }
+
+	/**
+	* Get the name of a counter
+	*/
+	static const char* GetCounterName(HwCounter a_counter);
+
+private:
+	/**
+	* Constructor, opens the counters of the calling thread
+	*/
+	HardwareCounters();
+
+	// Non-copyable, the counters are file descriptors
+	HardwareCounters(const HardwareCounters&);
+	HardwareCounters& operator=(const HardwareCounters&);
+
+private:
+	// File descriptor of each counter, -1 if unavailable. The first one
+	// opened leads the group.
+	int fds_[NB_HW_COUNTERS];
+	// Position of each counter in the values read from the group
+	int index_[NB_HW_COUNTERS];
+	// Number of counters opened
+	int nb_opened_;
+	// Flags of the available counters
+	uint available_;
+};
@@ -1,122 +1,152 @@
-/**
-* LayerCoupler.h
-*
-* @authors Vincent de Ladurantaye
-*/
-#pragma once
-
-#include "PixelLayer.h"
-
-#include <array>
-
-
-/** @class LayerCoupler
-* Handles the communications between 2 neural layers. This allows 
-* decoupling the layers so they don't reference each others.
-*/
-class LayerCoupler
-{
-public:
-
-	enum LayersId
-	{
-		L1,
-		L2
-	};
-
-	/**  
-	* Constructor
-	*/
-	LayerCoupler(NeuralLayer* layer1, NeuralLayer* layer2);
-
-	/**
-	* Destructor
-	*/
-	virtual ~LayerCoupler();
-
-	virtual void Layer1SpikeHandler(
-		uint neuron_id, uint layer_id, uint phase) = 0;
-
-	virtual void Layer2SpikeHandler(
-		uint neuron_id, uint layer_id, uint phase) = 0;
-
-
-//	virtual array<vector<Point>, 2> GetMatchingPoints() = 0;
-	
-protected:
-
-	/**
-	* Calculates the weights between two neurons in the layer
-	*/
-	virtual float ComputeWeigth(uint idLayer1, uint idLayer2);
-
-	/**
-	* Calculates the absolute value between the features of the neurons on both
-	* layers.
-	*/
-	virtual float ComputeFeatDiff(uint idLayer1, uint idLayer2) = 0;
-
-	/**
-	* Propagate a spike from layer 1 to layer 2
-	*/
-	void PropagateSpikeL1toL2(
-		const Neuron& n1,
-		Neuron& n2, 
-		int phase);
-
-	/**
-	* Propagate a spike from layer 2 to layer 1
-	*/
-	void PropagateSpikeL2toL1(
-		const Neuron& n2,
-		Neuron& n1,
-		int phase);
-		
-protected:
-
-	array<NeuralLayer*, 2> layers_;
-
-
-//------------------------------------------------------------------------------
-//							Configuration Parameters
-//------------------------------------------------------------------------------
-protected:
-
-	float WEIGHT_MAX_VALUE;
-	float WEIGHT_SLOPE;
-	float WEIGHT_OFFSET;
-
-	float SEG_MERGE_TRESHOLD;
-
-};
-
-
-//=============================================================================
-//								PixelLayerCoupler
-//=============================================================================
-class PixelLayerCoupler: public LayerCoupler
-{
-public:
-
-	/**  
-	* Constructor
-	*/
-	PixelLayerCoupler(PixelLayer* inLayer, PixelLayer* refLayer);
-
-	/** 
-	* Destructor
-	*/
-	virtual ~PixelLayerCoupler() {}
-
-	virtual void Layer1SpikeHandler(
-		uint neuron_id, uint layer_id, uint phase);
-
-	virtual void Layer2SpikeHandler(
-		uint neuron_id, uint layer_id, uint phase);
-
-	/**
-	* Calculates the absolute value between the pixel of each neuron
-	*/
-	virtual float ComputeFeatDiff(uint idLayer1, uint idLayer2);
-	
-};
+/**
+* LayerCoupler.h
+*
+* @authors Vincent de Ladurantaye
+*/
+#pragma once
+
+#include "PixelLayer.h"
+
+#include <array>
+#include <unordered_map>
+
+
+/** @class LayerCoupler
+* Handles the communications between 2 neural layers. This allows 
+* decoupling the layers so they don't reference each others.
+*/
+class LayerCoupler
+{
+public:
+
+	enum LayersId
+	{
+		L1,
+		L2
+	};
+
+	/**  
+	* Constructor
+	*/
+	LayerCoupler(NeuralLayer* layer1, NeuralLayer* layer2);
+
+	/**
+	* Destructor
+	*/
+	virtual ~LayerCoupler();
+
+	virtual void Layer1SpikeHandler(
+		uint neuron_id, uint layer_id, uint phase) = 0;
+
+	virtual void Layer2SpikeHandler(
+		uint neuron_id, uint layer_id, uint phase) = 0;
+
+	/**
+	* Runs both layers together for a given number of cascades so that their
+	* segments synchronize through the coupling connections, the labels of
+	* the segments propagating from one layer to the other. Returns the match
+	* score, which is the average over all cascades of the correspondence of
+	* the segments of both layers (see ComputeCorrespondence()).
+	*
+	* @param a_nb_cascades Number of coupled cascades to run
+	* @param a_min_score Minimal score the match has to reach. The coupling is
+	*	abandoned as soon as the score can no longer reach this value, in which
+	*	case -1 is returned.
+	*/
+	float RunCoupling(uint a_nb_cascades, float a_min_score = 0.0f);
+
+	/**
+	* Computes the correspondence of the segments of both layers, in [0, 1].
+	* Segments correspond when they share their label, one of them having
+	* taken the label of the other through the coupling. The correspondence
+	* is the intersection of the proportions of the layers covered by each
+	* shared label, 1 when both layers are partitioned in the same segments
+	* in the same proportions.
+	*/
+	float ComputeCorrespondence();
+
+
+//	virtual array<vector<Point>, 2> GetMatchingPoints() = 0;
+	
+protected:
+
+	/**
+	* Calculates the weights between two neurons in the layer
+	*/
+	virtual float ComputeWeigth(uint idLayer1, uint idLayer2);
+
+	/**
+	* Calculates the absolute value between the features of the neurons on both
+	* layers.
+	*/
+	virtual float ComputeFeatDiff(uint idLayer1, uint idLayer2) = 0;
+
+	/**
+	* Propagate a spike from layer 1 to layer 2. Like within a layer, the
+	* label only propagates to the neurons brought over the threshold.
+	*/
+	void PropagateSpikeL1toL2(
+		const Neuron& n1,
+		Neuron& n2, 
+		int phase);
+
+	/**
+	* Propagate a spike from layer 2 to layer 1
+	*/
+	void PropagateSpikeL2toL1(
+		const Neuron& n2,
+		Neuron& n1,
+		int phase);
+		
+protected:
+
+	array<NeuralLayer*, 2> layers_;
+
+	// Number of neurons of each label in both layers, kept between the
+	// cascades to avoid reallocating it
+	unordered_map<int, array<uint, 2> > label_counts_;
+
+
+//------------------------------------------------------------------------------
+//							Configuration Parameters
+//------------------------------------------------------------------------------
+protected:
+
+	float WEIGHT_MAX_VALUE;
+	float WEIGHT_SLOPE;
+	float WEIGHT_OFFSET;
+
+	float SEG_MERGE_TRESHOLD;
+
+};
+
+
+//=============================================================================
+//								PixelLayerCoupler
+//=============================================================================
+class PixelLayerCoupler: public LayerCoupler
+{
+public:
+
+	/**  
+	* Constructor
+	*/
+	PixelLayerCoupler(PixelLayer* inLayer, PixelLayer* refLayer);
+
+	/** 
+	* Destructor
+	*/
+	virtual ~PixelLayerCoupler() {}
+
+	virtual void Layer1SpikeHandler(
+		uint neuron_id, uint layer_id, uint phase);
+
+	virtual void Layer2SpikeHandler(
+		uint neuron_id, uint layer_id, uint phase);
+
+	/**
+	* Calculates the absolute value between the pixel of each neuron
+	*/
+	virtual float ComputeFeatDiff(uint idLayer1, uint idLayer2);
+	
+};
@@ -1,201 +1,313 @@
-/** @file LayerDebugger.h
-*
-* Debugger for steping into the network at different levels. Uses monitors to
-* display the state of neural layers.
-*
-*  @author Vincent de Ladurantaye
-*/
-
-#pragma once
-
-// Comment the LAYER_DEBUGGER definition to deactivate the debugger
-#define LAYER_DEBUGGER
-
-#include <list>
-#include <memory>
-
-#include <thread>
-#include <mutex>
-#include <condition_variable>
-
-#include <string>
-
-#include "Monitor.h"
-
-/**
-* Debug levels at which we can step in the code.
-*/
-enum DebugLevel
-{
-	DEBUG_LEVEL_SPIKE,
-	DEBUG_LEVEL_CASCADE,
-	DEBUG_LEVEL_CYCLE,
-	DEBUG_LEVEL_END
-};
-
-// Forward declaration
-class NeuralLayer;
-
-/**
-* Class for debugging neural layers. A debugger is created when calling 
-* AddDebugger(). Breakpoints are placed in the code using SetBreakpoint(). 
-*
-* Calls to the debugger are static so that they can be made from anywhere and
-* that the debugger objects don't have to be handled in the code.
-*
-* Different debug levels are used to identify different nesting levels. For 
-* example, if the global debug level is "CASCADE", all "SPIKE" level 
-* calls will be skipped.
-*
-* Unless displaying in real-time the function will wait for a key to be
-* pressed. The global debug level can be changed with different keys:
-*  Key	  Level					Description
-*	n:	1-(spike)		- Steps between each spike
-*	s:	2-(cascade)		- Steps between each firing step/cascade
-*	c:	3-(cycle)		- Steps between each firing cycle
-*	e:	4-(end)			- Steps to the end of the simulation
-*
-*	r:	Toggle real-time display
-*/
-class LayerDebugger
-{
-public:
-	/**
-	* Destructor
-	*/
-	~LayerDebugger();
-
-	/**
-	* Adds a debugger for the given layer
-	*/
-	static void AddDebugger(const NeuralLayer& layer, const std::string& name);
-
-	/**
-	* Displays the help message showing the debugger commands in the terminal
-	*/
-	static void DisplayHelp();
-
-	/**
-	* Places a breakpoint in the code. This function needs to be called at 
-	* location where we want the debugger to stop. 
-	*
-	* @param layer Layer from which the call is made
-	* @param debugLvl Specifies the debug level for which the function
-	*		 will wait when called. 
-	* @param progressId Number indicating the current progress in the 
-	*		 simulation. This is displayed in the console when breaking.
-	*/
-	static void SetBreakpoint(const NeuralLayer& layer,
-							  DebugLevel debugLvl, 
-							  int progressId = -1);
-
-	/**
-	* Changes the debug level to the given value.
-
-	* DEBUG_LEVEL_SPIKE: Steps between each spike
-	* DEBUG_LEVEL_CASCADE: Steps between each firing cascade
-	* DEBUG_LEVEL_CYCLE: Steps between each firing cycle
-	* DEBUG_LEVEL_END: Steps to the end of the simulation
-	*/
-	static void SetDebugLvl(DebugLevel a_debugLvl);
-	
-	/**
-	* Toggle real time display so that the programs doesn't wait for the user
-	* to press a key between each breakpoint.
-	*/
-	static void ToggleRealTimeDisplay(bool a_real_time);
-
-	/**
-	* If multithreading, this is called by the UI thread to wait for the worker
-	* threads. The UI thread will wait for notifications from worker threads
-	* to update monitor displays.
-	*/
-	static void WaitForWorkerThreads();
-
-
-	//-------------------------------------------------------------------------
-	//							 Non-Static members
-	//-------------------------------------------------------------------------
-	// These non-static members are specific to LayerDebugger objects which
-	// are created by AddDebugger(). Each object represents a layer being
-	// debugged.
-private:
-	/**
-	* Function called by SetBreakpoint() on the object corresponding to the 
-	* layer that set the breakpoint.
-	*/
-	void OnWait(DebugLevel debugLvl, int progressId);
-
-private:
-	// Reference to the layer being debugged
-	const NeuralLayer& layer_;
-
-	// Monitor for viewing layer state
-	LayerMonitor monitor_;
-
-	// Name of the layer used for outputs in the console
-	std::string name_;
-
-	// Flag used in multitreading to indicate the layer is ready to display
-	bool thread_ready_;
-
-	// Flag indicating if the layer is done with it's work. When all the layers
-	// set this flag to true, the UI thread will exit WaitForWorkerThreads().
-	//
-	// This is automatically set to true when reaching a breakpoint with a 
-	// debug level DEBUG_LEVEL_END.
-	bool work_done_;
-
-	//-------------------------------------------------------------------------
-	//							 Static members
-	//-------------------------------------------------------------------------
-private:
-	/**
-	* Constructor. Private because AddDebugger() needs to be called to add a
-	* debugger.
-	*/
-	LayerDebugger(const NeuralLayer& layer, const std::string& name);
-
-	/**
-	* Function called by WaitForWorkerThreads() to check if all worker threads
-	* are ready to display.
-	*/
-	static bool AreWorkerTreadsReady();
-
-	/**
-	* Function called by WaitForWorkerThreads() to check if all worker threads
-	* are done with their work.
-	*/
-	static bool AreWorkerTreadsDone();
-
-	/**
-	* Refreshes the monitors and wait for a given amount of time, allowing the
-	* windows to refresh. If wait time is 0, waits until a key is pressed.
-	*/
-	static void RefreshAndWait();
-
-    
-    // Fix for compiling in XCODE, which doesn't seem to support lambdas
-    static bool CondVariableFunctor() { return ui_ready_; }
-
-private:
-	// Current debug level
-	static DebugLevel debug_lvl_;
-
-	// Flag indicating if debugging steps are displayed in real-time
-	static bool real_time_display_;
-
-	// Global list of debuggers
-	static std::list<std::shared_ptr<LayerDebugger> > debuggers_;
-
-	// Id of the UI thread. We save it as only the UI thread can interact with
-	// monitors.
-	static std::thread::id ui_thread_id_;
-
-	static std::mutex display_mutex_;
-	static std::condition_variable display_condition_;
-
-	// Flag used in multithreading to indicate that the UI thread is done 
-	// displaying
-	static bool ui_ready_;
-};
+/** @file LayerDebugger.h
+*
+* Debugger for steping into the network at different levels. Uses monitors to
+* display the state of neural layers.
+*
+*  @author Vincent de Ladurantaye
+*/
+
+#pragma once
+
+// The breakpoints compiled in the layers are selected by the build (see the
+// SENSOR_LAYER_DEBUGGER and SENSOR_DEBUG_SPIKES CMake options):
+//	LAYER_DEBUGGER_NONE		No breakpoint at all
+//	(default)				Cascade, cycle and end breakpoints
+//	LAYER_DEBUGGER_SPIKES	Spike breakpoints as well
+#if !defined(LAYER_DEBUGGER_NONE)
+#define LAYER_DEBUGGER
+#else
+#undef LAYER_DEBUGGER_SPIKES
+#endif
+
+#include <atomic>
+#include <chrono>
+#include <list>
+#include <memory>
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include <string>
+
+#include "Monitor.h"
+#include "LayerSnapshot.h"
+
+/**
+* Debug levels at which we can step in the code.
+*/
+enum DebugLevel
+{
+	DEBUG_LEVEL_SPIKE,
+	DEBUG_LEVEL_CASCADE,
+	DEBUG_LEVEL_CYCLE,
+	DEBUG_LEVEL_END
+};
+
+// Forward declaration
+class NeuralLayer;
+
+/**
+* Class for debugging neural layers. A debugger is created when calling 
+* AddDebugger(). Breakpoints are placed in the code using SetBreakpoint(). 
+*
+* Calls to the debugger are static so that they can be made from anywhere and
+* that the debugger objects don't have to be handled in the code.
+*
+* Different debug levels are used to identify different nesting levels. For 
+* example, if the global debug level is "CASCADE", all "SPIKE" level 
+* calls will be skipped.
+*
+* Unless displaying in real-time the function will wait for a key to be
+* pressed. The global debug level can be changed with different keys:
+*  Key	  Level					Description
+*	n:	1-(spike)		- Steps between each spike
+*	s:	2-(cascade)		- Steps between each firing step/cascade
+*	c:	3-(cycle)		- Steps between each firing cycle
+*	e:	4-(end)			- Steps to the end of the simulation
+*
+*	r:	Toggle real-time display
+*
+* In real-time display, the layers simulated by worker threads don't wait for
+* the UI thread. At their breakpoints, the layers publish a snapshot of their
+* state at most every Config::DEBUG_SNAPSHOT_PERIOD_MS, and the UI thread 
+* only displays the latest snapshots, at its own pace in 
+* WaitForWorkerThreads() or at the breakpoints of its own layers.
+*/
+class LayerDebugger
+{
+public:
+	/**
+	* Destructor
+	*/
+	~LayerDebugger();
+
+	/**
+	* Adds a debugger for the given layer
+	*/
+	static void AddDebugger(const NeuralLayer& layer, const std::string& name);
+
+	/**
+	* Displays the help message showing the debugger commands in the terminal
+	*/
+	static void DisplayHelp();
+
+	/**
+	* Check if a debugger was added. The breakpoints of the layers test this
+	* flag first so that they cost a single predictable branch when nothing 
+	* is debugged.
+	*/
+	static inline bool IsActive()
+	{
+		return active_.load(std::memory_order_relaxed);
+	}
+
+	/**
+	* Places a breakpoint in the code. This function needs to be called at 
+	* location where we want the debugger to stop. 
+	*
+	* @param layer Layer from which the call is made
+	* @param debugLvl Specifies the debug level for which the function
+	*		 will wait when called. 
+	* @param progressId Number indicating the current progress in the 
+	*		 simulation. This is displayed in the console when breaking.
+	*/
+	static void SetBreakpoint(const NeuralLayer& layer,
+							  DebugLevel debugLvl, 
+							  int progressId = -1);
+
+	/**
+	* Changes the debug level to the given value.
+
+	* DEBUG_LEVEL_SPIKE: Steps between each spike
+	* DEBUG_LEVEL_CASCADE: Steps between each firing cascade
+	* DEBUG_LEVEL_CYCLE: Steps between each firing cycle
+	* DEBUG_LEVEL_END: Steps to the end of the simulation
+	*/
+	static void SetDebugLvl(DebugLevel a_debugLvl);
+	
+	/**
+	* Toggle real time display so that the programs doesn't wait for the user
+	* to press a key between each breakpoint.
+	*/
+	static void ToggleRealTimeDisplay(bool a_real_time);
+
+	/**
+	* If multithreading, this is called by the UI thread to wait for the worker
+	* threads. The UI thread will wait for notifications from worker threads
+	* to update monitor displays.
+	*/
+	static void WaitForWorkerThreads();
+
+
+	//-------------------------------------------------------------------------
+	//							 Non-Static members
+	//-------------------------------------------------------------------------
+	// These non-static members are specific to LayerDebugger objects which
+	// are created by AddDebugger(). Each object represents a layer being
+	// debugged.
+private:
+	/**
+	* Function called by SetBreakpoint() on the object corresponding to the 
+	* layer that set the breakpoint.
+	*/
+	void OnWait(DebugLevel debugLvl, int progressId);
+
+	/**
+	* Function called by OnWait() in real-time display. Publishes a snapshot
+	* of the layer if the snapshot period has elapsed, and returns true if it
+	* did.
+	*/
+	bool PublishSnapshot(DebugLevel debugLvl);
+
+	/**
+	* Check if the snapshot period has elapsed since the last display of the
+	* layer, and restarts the period if so
+	*/
+	bool IsSnapshotDue();
+
+private:
+	// Reference to the layer being debugged
+	const NeuralLayer& layer_;
+
+	// Monitor for viewing layer state
+	LayerMonitor monitor_;
+
+	// Snapshots of the layer published in real-time display
+	SnapshotBuffer snapshots_;
+
+	// Time of the last snapshot or display of the layer
+	std::chrono::steady_clock::time_point last_snapshot_;
+
+	// Name of the layer used for outputs in the console
+	std::string name_;
+
+	// Flag used in multitreading to indicate the layer is ready to display
+	bool thread_ready_;
+
+	// Flag indicating if the layer is done with it's work. When all the layers
+	// set this flag to true, the UI thread will exit WaitForWorkerThreads().
+	//
+	// This is automatically set to true when reaching a breakpoint with a 
+	// debug level DEBUG_LEVEL_END.
+	bool work_done_;
+
+	//-------------------------------------------------------------------------
+	//							 Static members
+	//-------------------------------------------------------------------------
+private:
+	/**
+	* Constructor. Private because AddDebugger() needs to be called to add a
+	* debugger.
+	*/
+	LayerDebugger(const NeuralLayer& layer, const std::string& name);
+
+	/**
+	* Function called by WaitForWorkerThreads() to check if all worker threads
+	* are ready to display.
+	*/
+	static bool AreWorkerTreadsReady();
+
+	/**
+	* Function called by WaitForWorkerThreads() to check if all worker threads
+	* are done with their work.
+	*/
+	static bool AreWorkerTreadsDone();
+
+	/**
+	* Refreshes the monitors and waits until a key is pressed. In real-time
+	* display, the layers may be running, so only the published snapshots are
+	* displayed and the windows are given a millisecond to refresh.
+	*/
+	static void RefreshAndWait();
+
+	/**
+	* Displays the snapshots published since the last call
+	*/
+	static void DisplaySnapshots();
+
+	/**
+	* Handles a key pressed in a monitor window, changing the debug level or
+	* the real-time display
+	*/
+	static void HandleKey(int a_key);
+
+    
+    // Fix for compiling in XCODE, which doesn't seem to support lambdas
+    static bool CondVariableFunctor() { return ui_ready_; }
+
+private:
+	// Flag indicating if at least one debugger was added
+	static std::atomic<bool> active_;
+
+	// Current debug level. Atomic since the worker threads check it while 
+	// the UI thread changes it.
+	static std::atomic<DebugLevel> debug_lvl_;
+
+	// Flag indicating if debugging steps are displayed in real-time. Atomic 
+	// since the worker threads check it without waiting for the UI thread.
+	static std::atomic<bool> real_time_display_;
+
+	// Global list of debuggers
+	static std::list<std::shared_ptr<LayerDebugger> > debuggers_;
+
+	// Id of the UI thread. We save it as only the UI thread can interact with
+	// monitors.
+	static std::thread::id ui_thread_id_;
+
+	static std::mutex display_mutex_;
+	static std::condition_variable display_condition_;
+
+	// Flag used in multithreading to indicate that the UI thread is done 
+	// displaying
+	static bool ui_ready_;
+};
+
+
+//=============================================================================
+//								  Debug hooks
+//=============================================================================
+/**
+* Instrumentation policy placing the debugger breakpoints in the layers. The
+* breakpoints of a disabled level compile to nothing, the others test
+* Debugger::IsActive() before looking for the debugger of the layer.
+*
+* @tparam Debugger Class of the static IsActive() and SetBreakpoint(), 
+*	LayerDebugger except in the tests of the policy
+*/
+template <bool STEPS, bool SPIKES, class Debugger = LayerDebugger>
+struct DebugHooks
+{
+	static inline void Spike(const NeuralLayer& a_layer, int a_neuron_id)
+	{
+		if (SPIKES && Debugger::IsActive())
+			Debugger::SetBreakpoint(a_layer, DEBUG_LEVEL_SPIKE, a_neuron_id);
+	}
+
+	static inline void Cascade(const NeuralLayer& a_layer, int a_cascade)
+	{
+		if (STEPS && Debugger::IsActive())
+			Debugger::SetBreakpoint(a_layer, DEBUG_LEVEL_CASCADE, a_cascade);
+	}
+
+	static inline void Cycle(const NeuralLayer& a_layer, int a_cycle)
+	{
+		if (STEPS && Debugger::IsActive())
+			Debugger::SetBreakpoint(a_layer, DEBUG_LEVEL_CYCLE, a_cycle);
+	}
+
+	static inline void End(const NeuralLayer& a_layer)
+	{
+		if (STEPS && Debugger::IsActive())
+			Debugger::SetBreakpoint(a_layer, DEBUG_LEVEL_END);
+	}
+};
+
+// Hooks selected by the build
+#if defined(LAYER_DEBUGGER_SPIKES)
+typedef DebugHooks<true, true> LayerDebugHooks;
+#elif defined(LAYER_DEBUGGER)
+typedef DebugHooks<true, false> LayerDebugHooks;
+#else
+typedef DebugHooks<false, false> LayerDebugHooks;
+#endif
@@ -0,0 +1,263 @@
+/** @file LayerProfiler.h
+*
+* Low overhead instrumentation of the phases of the simulation of the layers.
+*
+*  @author Vincent de Ladurantaye
+*/
+
+#pragma once
+
+// The instrumentation compiled in the layers is selected by the build (see
+// the SENSOR_LAYER_PROFILER CMake option):
+//	LAYER_PROFILER_NONE		No instrumentation at all
+//	(default)				Phase counters and LayerTracer events
+#if !defined(LAYER_PROFILER_NONE)
+#define LAYER_PROFILER
+#endif
+
+#include <chrono>
+#include <cstdint>
+
+#include "HardwareCounters.h"
+#include "LayerTracer.h"
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define PROFILE_CLOCK_TSC
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define PROFILE_CLOCK_TSC
+#endif
+
+/**
+* Phases of the simulation of a layer. The phases may be nested, e.g. the
+* segments are merged while firing the neurons, so the time of a phase
+* includes the time of the phases nested in it.
+*/
+enum SimPhase
+{
+	SIM_PHASE_FIND_TIME_STEP = 0,	// NeuralLayer::FindNextTimeStep()
+	SIM_PHASE_ADVANCE_TIME,			// NeuralLayer::AdvanceTime()
+	SIM_PHASE_FIRE_NEURONS,			// Each wave of NeuralLayer::FireNeurons()
+	SIM_PHASE_GLOBAL_INHIBITION,	// NeuralLayer::GlobalInhibition()
+	SIM_PHASE_STABILIZATION,		// NeuralLayer::GetCoefStabilization()
+	SIM_PHASE_CYCLE_CHECK,			// NeuralLayer::IsCycleCompleted()
+	SIM_PHASE_MERGE_SEGMENTS,		// SegmentationLayer::MergeSegments()
+	SIM_PHASE_TRIGGER_SAME_LABEL,	// Triggering the neurons of a segment
+	NB_SIM_PHASES
+};
+
+//=============================================================================
+//								 ProfileClock
+//=============================================================================
+/**
+* Clock of the instrumentation. Reads the time stamp counter of the CPU when
+* available, which is much cheaper than the system clocks, otherwise uses
+* std::chrono::steady_clock.
+*/
+class ProfileClock
+{
+public:
+	/**
+	* Get the current time, in ticks
+	*/
+	static inline uint64_t Now()
+	{
+#ifdef PROFILE_CLOCK_TSC
+		return __rdtsc();
+#else
+		return std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+	}
+
+	/**
+	* Get the number of ticks per millisecond. The frequency of the time stamp
+	* counter is calibrated against steady_clock since the start of the
+	* program, so it gets more precise as the program runs.
+	*/
+	static double GetTicksPerMs();
+};
+
+//=============================================================================
+//								 PhaseCounters
+//=============================================================================
+/**
+* Cumulative time and number of calls of each phase of the simulation of a
+* layer, and counts of the events of the simulation, since the creation of
+* the layer or the last call to Reset().
+*
+* When Config::PROFILE_HW_COUNTERS is set, the phases also count the hardware
+* events of the CPU. Reading them costs two system calls per phase, so the
+* times are inflated, mostly those of the short firing waves.
+*/
+struct PhaseCounters
+{
+	PhaseCounters() { Reset(); }
+
+	/**
+	* Sets all the counters to 0
+	*/
+	void Reset();
+
+	/**
+	* Get the cumulative time of a phase, in ms
+	*/
+	double GetTimeMs(SimPhase a_phase) const;
+
+	/**
+	* Get the name of a phase
+	*/
+	static const char* GetPhaseName(SimPhase a_phase);
+
+	// Cumulative time of each phase, in ticks of ProfileClock
+	uint64_t ticks[NB_SIM_PHASES];
+	// Number of calls of each phase
+	uint64_t calls[NB_SIM_PHASES];
+	// Cumulative hardware events of each phase
+	uint64_t hw[NB_SIM_PHASES][NB_HW_COUNTERS];
+	// Flags of the hardware counters which counted, see
+	// HardwareCounters::Read()
+	uint hw_available;
+
+	// Number of spikes
+	uint64_t spikes;
+	// Number of segments merged
+	uint64_t merges;
+};
+
+//=============================================================================
+//								  PhaseTimer
+//=============================================================================
+/**
+* Times the scope where it is declared and adds it to a phase of the phase
+* counters. Does nothing when disabled.
+*/
+template <bool ENABLED>
+class PhaseTimer
+{
+public:
+	PhaseTimer(PhaseCounters& a_counters, SimPhase a_phase) :
+		counters_(a_counters),
+		phase_(a_phase),
+		hw_counters_(Config::PROFILE_HW_COUNTERS ?
+					 HardwareCounters::GetThreadCounters() : nullptr)
+	{
+		if (hw_counters_) hw_read_ = hw_counters_->Read(hw_start_);
+		start_ = ProfileClock::Now();
+	}
+
+	~PhaseTimer()
+	{
+		counters_.ticks[phase_] += ProfileClock::Now() - start_;
+		++counters_.calls[phase_];
+
+		if (hw_counters_)
+		{
+			uint64_t hwEnd[NB_HW_COUNTERS];
+			uint hwRead = hw_read_ & hw_counters_->Read(hwEnd);
+			for (int c = 0; c < NB_HW_COUNTERS; ++c)
+			{
+				// Extrapolated values of a multiplexed group can decrease
+				if ((hwRead & (1u << c)) && hwEnd[c] > hw_start_[c])
+					counters_.hw[phase_][c] += hwEnd[c] - hw_start_[c];
+			}
+			counters_.hw_available |= hwRead;
+		}
+	}
+
+private:
+	PhaseCounters& counters_;
+	SimPhase phase_;
+	uint64_t start_;
+	// Counters of the thread, null when not counting the hardware events
+	HardwareCounters* hw_counters_;
+	uint64_t hw_start_[NB_HW_COUNTERS];
+	// Flags of the counters read at the start
+	uint hw_read_;
+};
+//-----------------------------------------------------------------------------
+template <>
+class PhaseTimer<false>
+{
+public:
+	PhaseTimer(PhaseCounters&, SimPhase)
+	{
+	}
+};
+
+//=============================================================================
+//								Profile hooks
+//=============================================================================
+/**
+* Instrumentation policy of the layers. When disabled, the timers are empty
+* and the counts and trace events compile to nothing. When enabled, the trace
+* events test LayerTracer::IsActive() before recording.
+*/
+template <bool ENABLED>
+struct ProfileHooks
+{
+	typedef PhaseTimer<ENABLED> Timer;
+
+	static inline void CountSpikes(PhaseCounters& a_counters, int a_spikes)
+	{
+		if (ENABLED) a_counters.spikes += a_spikes;
+	}
+
+	static inline void CountMerge(PhaseCounters& a_counters)
+	{
+		if (ENABLED) ++a_counters.merges;
+	}
+
+	static inline void TraceBegin(const char* a_name, uint a_layer_id,
+								  int a_arg)
+	{
+		if (ENABLED && LayerTracer::IsActive())
+			LayerTracer::Begin(a_name, a_layer_id, a_arg);
+	}
+
+	static inline void TraceEnd(const char* a_name, uint a_layer_id)
+	{
+		if (ENABLED && LayerTracer::IsActive())
+			LayerTracer::End(a_name, a_layer_id);
+	}
+
+	static inline void TraceCounter(const char* a_name, uint a_layer_id,
+									int a_value)
+	{
+		if (ENABLED && LayerTracer::IsActive())
+			LayerTracer::Counter(a_name, a_layer_id, a_value);
+	}
+
+	/**
+	* A cycle spans several cascades, so the cycle traced is kept in
+	* a_traced_cycle, -1 when none, to open its event with its first cascade
+	* and close it only once.
+	*/
+	static inline void TraceCycleBegin(uint a_layer_id, uint a_cycle,
+									   int& a_traced_cycle)
+	{
+		if (ENABLED && a_traced_cycle != (int)a_cycle &&
+			LayerTracer::IsActive())
+		{
+			LayerTracer::Begin("Cycle", a_layer_id, a_cycle);
+			a_traced_cycle = a_cycle;
+		}
+	}
+
+	static inline void TraceCycleEnd(uint a_layer_id, uint a_cycle,
+									 int& a_traced_cycle)
+	{
+		if (ENABLED && a_traced_cycle == (int)a_cycle)
+		{
+			if (LayerTracer::IsActive()) LayerTracer::End("Cycle", a_layer_id);
+			a_traced_cycle = -1;
+		}
+	}
+};
+
+// Hooks selected by the build
+#if defined(LAYER_PROFILER)
+typedef ProfileHooks<true> LayerProfileHooks;
+#else
+typedef ProfileHooks<false> LayerProfileHooks;
+#endif
@@ -0,0 +1,123 @@
+/**
+* @file LayerRenderer.h
+*
+* @authors Vincent de Ladurantaye
+*/
+#pragma once
+
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+
+#include "Config.h"
+
+// Forward declarations
+class NeuralLayer;
+struct LayerSnapshot;
+
+
+//=============================================================================
+//								 LayerRenderer
+//=============================================================================
+/**
+* Renders the state of a neural layer, or of a snapshot of it, to a color
+* image without any window, e.g. to compute overlays in batch. It produces
+* the same images as the layer monitors, which use it for drawing.
+*
+* The colors of the neurons are computed once per neuron of the rendered
+* region: labels and phases through a color lookup table, potentials through
+* a lookup table of the colormap. The zoom then replicates the neuron colors
+* with precomputed column indices and copies whole rows when consecutive
+* display rows show the same neurons.
+*
+* The destination image is only reallocated when it doesn't have the size and
+* type of the rendering, so it can be a buffer provided by the caller.
+*
+* The render functions take the following parameters:
+* @param a_dst Destination image, CV_8UC3
+* @param a_size Size of the rendering. Empty for the size of the region.
+* @param a_roi Region of the layer rendered. Empty for the whole layer.
+* @param a_zoom Number of display pixels per neuron. Null to fit the region
+*	in the rendering.
+*/
+class LayerRenderer
+{
+public:
+
+	/**
+	* Constructor
+	*/
+	LayerRenderer();
+
+	/**
+	* Renders the label of the neurons, in black for the neurons which never
+	* fired
+	*/
+	void RenderSegments(const NeuralLayer& a_layer, cv::Mat& a_dst,
+						cv::Size a_size = cv::Size(),
+						cv::Rect a_roi = cv::Rect(),
+						cv::Point2f a_zoom = cv::Point2f());
+	void RenderSegments(const LayerSnapshot& a_snapshot, cv::Mat& a_dst,
+						cv::Size a_size = cv::Size(),
+						cv::Rect a_roi = cv::Rect(),
+						cv::Point2f a_zoom = cv::Point2f());
+
+	/**
+	* Renders the phase of the last spike of the neurons, in black for the
+	* neurons which never fired
+	*/
+	void RenderPhases(const NeuralLayer& a_layer, cv::Mat& a_dst,
+					  cv::Size a_size = cv::Size(),
+					  cv::Rect a_roi = cv::Rect(),
+					  cv::Point2f a_zoom = cv::Point2f());
+	void RenderPhases(const LayerSnapshot& a_snapshot, cv::Mat& a_dst,
+					  cv::Size a_size = cv::Size(),
+					  cv::Rect a_roi = cv::Rect(),
+					  cv::Point2f a_zoom = cv::Point2f());
+
+	/**
+	* Renders the potential of the neurons with the jet colormap, on a log
+	* scale from the firing threshold since potentials bunch up near it
+	*/
+	void RenderPotentials(const NeuralLayer& a_layer, cv::Mat& a_dst,
+						  cv::Size a_size = cv::Size(),
+						  cv::Rect a_roi = cv::Rect(),
+						  cv::Point2f a_zoom = cv::Point2f());
+	void RenderPotentials(const LayerSnapshot& a_snapshot,
+						  float a_threshold, cv::Mat& a_dst,
+						  cv::Size a_size = cv::Size(),
+						  cv::Rect a_roi = cv::Rect(),
+						  cv::Point2f a_zoom = cv::Point2f());
+
+	/**
+	* Get the display color of a label or value. Colors repeat every 256
+	* values.
+	*/
+	inline cv::Vec3b GetColor(int a_val) const
+	{
+		return color_lut_[a_val & 255];
+	}
+
+private:
+
+	/**
+	* Renders the region of a layer of the given size, the neuron colors of
+	* each row of the region being computed by a_color_row(y, x, width, out).
+	*/
+	template <class ColorRow>
+	void Render(ColorRow a_color_row, cv::Size a_layer_size, cv::Mat& a_dst,
+				cv::Size a_size, cv::Rect a_roi, cv::Point2f a_zoom);
+
+private:
+	// Colors of the labels and phases
+	cv::Vec3b color_lut_[256];
+
+	// Colors of the potentials after the log scaling
+	cv::Vec3b potential_lut_[256];
+
+	// Column of the region shown by each column of the rendering
+	std::vector<int> col_map_;
+
+	// Colors of the neurons of the current row of the region
+	std::vector<cv::Vec3b> row_colors_;
+};
@@ -0,0 +1,117 @@
+/**
+* @file LayerSnapshot.h
+*
+* @authors Vincent de Ladurantaye
+*/
+#pragma once
+
+#include <atomic>
+
+#include <opencv2/core/core.hpp>
+
+#include "Config.h"
+
+
+//=============================================================================
+//								 LayerSnapshot
+//=============================================================================
+/**
+* Copy of the state of a neural layer at a given point of the simulation, for
+* displaying it while the layer keeps going. The maps are row-major whatever
+* the neuron layout of the layer (see NeuralLayer::CaptureSnapshot()).
+*/
+struct LayerSnapshot
+{
+	LayerSnapshot() :
+		layer_id(0),
+		cycle(0),
+		cascade(0),
+		sim_time(0)
+	{
+	}
+
+	// Id of the layer captured
+	uint layer_id;
+	// Progress of the simulation at the time of the capture
+	uint cycle;
+	uint cascade;
+	float sim_time;
+
+	// Potential of the neurons (CV_32F)
+	cv::Mat potentials;
+	// Label of the neurons (CV_32S)
+	cv::Mat labels;
+	// Phase of the neurons, negative when they didn't fire yet (CV_32S)
+	cv::Mat phases;
+};
+
+//=============================================================================
+//								SnapshotBuffer
+//=============================================================================
+/**
+* Lock-free triple buffer passing snapshots from a single producer, the thread
+* simulating a layer, to a single consumer, the UI thread. The producer always
+* has a snapshot to write into and the consumer one to read, the third one
+* being the latest published. Neither side ever waits for the other, the
+* consumer only sees the most recent snapshot and the older ones are
+* overwritten.
+*
+* Snapshots keep their buffers from one publication to the next, so capturing
+* into the write snapshot doesn't allocate once the sizes are settled.
+*/
+class SnapshotBuffer
+{
+public:
+
+	/**
+	* Constructor
+	*/
+	SnapshotBuffer();
+
+	/**
+	* Get the snapshot to capture into. Only the producer thread may call this.
+	*/
+	LayerSnapshot& GetWriteSnapshot() { return snapshots_[write_]; }
+
+	/**
+	* Publishes the write snapshot and takes the previous latest one to
+	* capture the next snapshot into. Only the producer thread may call this.
+	*/
+	void Publish();
+
+	/**
+	* Takes the latest published snapshot, if one was published since the last
+	* call. Returns false otherwise, and the read snapshot is unchanged. Only
+	* the consumer thread may call this.
+	*/
+	bool Consume();
+
+	/**
+	* Get the snapshot taken by the last successful call to Consume(). Only
+	* the consumer thread may call this.
+	*/
+	const LayerSnapshot& GetReadSnapshot() const { return snapshots_[read_]; }
+
+	/**
+	* Check if a snapshot was ever consumed
+	*/
+	bool HasSnapshot() const { return has_snapshot_; }
+
+private:
+
+	// Flag set on the index of the middle snapshot when it was published and
+	// not consumed yet
+	static const uint NEW_FLAG = 4;
+
+	LayerSnapshot snapshots_[3];
+
+	// Index of the snapshot owned by the producer
+	uint write_;
+	// Index of the snapshot owned by the consumer
+	uint read_;
+	// Index of the latest published snapshot, exchanged by both sides
+	std::atomic<uint> middle_;
+
+	// Flag indicating if the consumer ever took a snapshot
+	bool has_snapshot_;
+};
@@ -0,0 +1,338 @@
+/**
+* @file LayerState.h
+*
+* @authors Vincent de Ladurantaye
+*/
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Config.h"
+
+
+/**
+* Binary format of the complete state of a layer (see
+* NeuralLayer::SaveBinaryState()). The bytes are a LayerStateHeader, followed
+* by sections aligned on 64 bytes and by the table of the sections. The
+* sections are raw copies of the layer's memory, so they can be used in place
+* from a memory-mapped file, in the byte order of the machine which wrote
+* them.
+*
+* Readers skip the sections they don't know. LAYER_STATE_VERSION is
+* incremented whenever the content of an existing section changes, and
+* states of other versions are rejected.
+*/
+const uint32_t LAYER_STATE_VERSION = 2;
+
+/**
+* Sections of a layer state
+*/
+enum LayerStateSection
+{
+	// NeuralLayerState
+	STATE_LAYER = 1,
+	// Neurons in the memory order of the layer, see NeuronLayout
+	STATE_NEURONS = 2,
+	// One byte of NeuronStateFlags per neuron, in the same order
+	STATE_NEURON_FLAGS = 3,
+	// Active regions of the layer (cv::Rect)
+	STATE_ACTIVE_REGIONS = 4,
+	// PhaseCounters of the layer
+	STATE_PHASE_COUNTERS = 5,
+	// Gray image of the layer, row-major
+	STATE_IMAGE = 6,
+	// SegmentationLayerState
+	STATE_SEGMENTATION = 7,
+	// Segments of the layer (Segment)
+	STATE_SEGMENTS = 8,
+	// Number of stable cycles by label, as pairs of int
+	STATE_STABLE_CYCLES = 9,
+	// PixelLayerState
+	STATE_PIXEL_LAYER = 10,
+	// Regions of the images of a PackedPixelLayer (cv::Rect)
+	STATE_PACKED_IMAGES = 11,
+	// Distinct maximal charges of the neurons (float)
+	STATE_CHARGE_LEVELS = 12,
+	// Index of the maximal charge of each neuron, one byte per neuron in 
+	// the same order as STATE_NEURONS
+	STATE_CHARGE_IDS = 13
+};
+
+/**
+* Flags of the neurons stored in the layer's bitsets
+*/
+enum NeuronStateFlags
+{
+	NEURON_CYCLE_SPIKED = 1,
+	NEURON_SEGMENTED = 2
+};
+
+/**
+* Header at the start of a layer state
+*/
+struct LayerStateHeader
+{
+	// LAYER_STATE_MAGIC
+	char magic[8];
+	// LAYER_STATE_VERSION
+	uint32_t version;
+	// LAYER_STATE_BYTE_ORDER, as written by the machine
+	uint32_t byte_order;
+	// Size of a neuron, which depends on COMPACT_NEURONS
+	uint32_t neuron_size;
+	// Number of entries of the section table
+	uint32_t nb_sections;
+	// Offset of the section table
+	uint64_t table_offset;
+	// Size of the whole state, to detect truncated files
+	uint64_t total_size;
+};
+
+/**
+* Entry of the section table
+*/
+struct LayerStateSectionEntry
+{
+	uint32_t tag;
+	uint32_t reserved;
+	uint64_t offset;
+	uint64_t size;
+};
+
+/**
+* Scalar state and configuration of a NeuralLayer
+*/
+struct NeuralLayerState
+{
+	uint32_t width;
+	uint32_t height;
+	// Layout of the STATE_NEURONS and STATE_NEURON_FLAGS sections
+	uint32_t neuron_layout;
+	uint32_t tile_size;
+	// Id of the layer which was saved, for information only
+	uint32_t layer_id;
+
+	// Progress of the simulation
+	uint32_t n_cycles;
+	uint32_t n_cascades;
+	float sim_time;
+	uint64_t n_spikes;
+
+	// Configuration parameters
+	float pot_threshold;
+	float tau;
+	float global_inhib_val;
+	float charging_leader;
+	float charging_follow;
+	uint32_t reserved;
+};
+
+/**
+* Scalar state and configuration of a SegmentationLayer
+*/
+struct SegmentationLayerState
+{
+	// SegmentationState
+	uint32_t seg_state;
+	uint32_t stable_cascade_count;
+	float stabilization_coef;
+	uint32_t converged;
+	uint32_t n_super_neurons;
+
+	// Configuration parameters
+	uint32_t max_seg_cascades;
+	uint32_t max_seg_cycles;
+	uint32_t min_segment_size;
+	uint32_t trigger_same_label_neurons;
+	uint32_t merge_segments;
+	float seg_merge_treshold;
+	float weight_max_value;
+	float weight_slope;
+	float weight_offset;
+	uint32_t coarsen_segments;
+	float coarsen_delta_period;
+	uint32_t coarsen_cycles;
+	uint32_t reserved;
+};
+
+/**
+* Class of a PixelLayer, so that the same class is created again from the
+* state (see CreatePixelLayer())
+*/
+struct PixelLayerState
+{
+	// PixelLayerClass
+	uint32_t layer_class;
+	uint32_t reserved;
+};
+
+
+//=============================================================================
+//								LayerStateWriter
+//=============================================================================
+/**
+* Builds a layer state in a single buffer, so that it is written to a file
+* in one write or handed over as is, e.g. for pickling
+*/
+class LayerStateWriter
+{
+public:
+
+	/**
+	* Constructor
+	*
+	* @param a_capacity Expected size of the state, to allocate the buffer
+	*	once
+	*/
+	LayerStateWriter(size_t a_capacity = 0);
+
+	/**
+	* Adds a section of the given size and returns its bytes to fill. The
+	* pointer is only valid until the next section is added.
+	*/
+	char* AddSection(uint32_t a_tag, size_t a_size);
+	//-------------------------------------------------------------------------
+	// Copies the given bytes to the new section
+	void AddSection(uint32_t a_tag, const void* a_data, size_t a_size);
+
+	/**
+	* Get the bytes of a section already added, nullptr if there is none
+	*/
+	char* GetSection(uint32_t a_tag, size_t* a_size = nullptr);
+
+	/**
+	* Completes the header and the section table and moves out the state.
+	* The writer is empty afterwards.
+	*/
+	std::vector<char> Finish();
+
+private:
+
+	std::vector<char> bytes_;
+	std::vector<LayerStateSectionEntry> sections_;
+};
+
+
+//=============================================================================
+//								   MappedFile
+//=============================================================================
+/**
+* Read-only view of a whole file. The file is memory-mapped on POSIX
+* systems, so its pages are only read when accessed, and read into a buffer
+* elsewhere.
+*/
+class MappedFile
+{
+public:
+
+	MappedFile();
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	/**
+	* Opens the file, closing the previous one. Returns false if the file
+	* can't be read.
+	*/
+	bool Open(const std::string& a_filename);
+
+	/**
+	* Releases the file
+	*/
+	void Close();
+
+	/// Get the bytes of the file
+	const char* GetData() const { return data_; }
+	/// Get the size of the file
+	size_t GetSize() const { return size_; }
+	/// Check if the file is memory-mapped rather than read
+	bool IsMapped() const { return mapped_; }
+
+private:
+
+	const char* data_;
+	size_t size_;
+	bool mapped_;
+	// Content of the file when it isn't mapped
+	std::vector<char> buffer_;
+};
+
+
+//=============================================================================
+//								 LayerStateView
+//=============================================================================
+/**
+* Checked access to the sections of a layer state, without copying them. The
+* state is either bytes owned by the caller, which must outlive the view, or
+* a file mapped by the view.
+*/
+class LayerStateView
+{
+public:
+
+	LayerStateView();
+
+	/**
+	* Maps a state file and checks it, see Parse()
+	*/
+	bool Open(const std::string& a_filename);
+
+	/**
+	* Checks the header and the section table of a state. Returns false,
+	* with a message on cerr, if the bytes aren't a state of this version
+	* written by a compatible machine.
+	*/
+	bool Parse(const char* a_data, size_t a_size);
+
+	/**
+	* Get the bytes of a section, nullptr if there is none
+	*/
+	const char* GetSection(uint32_t a_tag, size_t* a_size = nullptr) const;
+
+	/**
+	* Get a section holding a single struct, nullptr if there is none or if
+	* its size doesn't match
+	*/
+	template<class T>
+	const T* GetStruct(uint32_t a_tag) const
+	{
+		size_t size;
+		const char* data = GetSection(a_tag, &size);
+		return (data && size == sizeof(T)) ? (const T*)data : nullptr;
+	}
+
+	/**
+	* Get a section holding an array and its number of elements, nullptr if
+	* there is none
+	*/
+	template<class T>
+	const T* GetArray(uint32_t a_tag, size_t* a_count) const
+	{
+		size_t size;
+		const char* data = GetSection(a_tag, &size);
+		*a_count = data ? size / sizeof(T) : 0;
+		return (const T*)data;
+	}
+
+	/// Get the bytes of the whole state
+	const char* GetData() const { return data_; }
+	size_t GetSize() const { return size_; }
+
+	/**
+	* Check if a file starts like a layer state
+	*/
+	static bool IsStateFile(const std::string& a_filename);
+
+private:
+
+	// File of the state, when opened from a file
+	MappedFile file_;
+
+	const char* data_;
+	size_t size_;
+	const LayerStateSectionEntry* sections_;
+	uint32_t nb_sections_;
+};
@@ -0,0 +1,123 @@
+/** @file LayerTracer.h
+*
+* Timeline of the simulation of the layers, exported in the Chrome trace event
+* format which can be opened in Perfetto (https://ui.perfetto.dev) or in
+* chrome://tracing.
+*
+*  @author Vincent de Ladurantaye
+*/
+
+#pragma once
+
+#include <atomic>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "Config.h"
+
+// Forward declaration
+struct ThreadTrace;
+
+/**
+* Records the cycles, cascades and firing waves of the layers, and their
+* spike counts as counter tracks, while tracing is started. Each thread
+* records in its own ring buffer of Config::TRACE_BUFFER_SIZE events, the
+* oldest events being overwritten when it is full, so that the threads never
+* wait for each other. Each thread gets its own track in the timeline.
+*
+* An event is only recorded when it ends, as a complete event with its
+* duration, so that overwriting the oldest events never leaves a begin
+* without its end in the timeline.
+*
+* The calls are static so that the layers can record from anywhere, like the
+* LayerDebugger. The events are recorded through LayerProfileHooks (see
+* LayerProfiler.h), and compiled out with the other instrumentation.
+*
+* Start(), Clear() and the exports must be called while no layer is being
+* simulated, e.g. before and after a batch of images.
+*/
+class LayerTracer
+{
+public:
+	/**
+	* Clears the events and starts recording
+	*/
+	static void Start();
+
+	/**
+	* Stops recording, the events are kept until the next call to Start()
+	*/
+	static void Stop();
+
+	/**
+	* Check if recording. The hooks of the layers test this flag first so that
+	* they cost a single predictable branch when not tracing.
+	*/
+	static inline bool IsActive()
+	{
+		return active_.load(std::memory_order_relaxed);
+	}
+
+	/**
+	* Clears the events of all the threads
+	*/
+	static void Clear();
+
+	/**
+	* Names the track of the calling thread in the timeline
+	*/
+	static void SetThreadName(const std::string& a_name);
+
+	/**
+	* Begins or ends an event of a layer on the calling thread. The events of
+	* a thread must be nested, an end closes the last event begun and records
+	* it. An end without a begin, e.g. of an event begun before the tracing
+	* started, or with another name or layer than the last event begun, is 
+	* ignored. The name must be a string literal, only its address is 
+	* recorded.
+	*/
+	static void Begin(const char* a_name, uint a_layer_id, int a_arg);
+	static void End(const char* a_name, uint a_layer_id);
+
+	/**
+	* Records the value of a counter of a layer
+	*/
+	static void Counter(const char* a_name, uint a_layer_id, int a_value);
+
+	/**
+	* Get the recorded events in the Chrome trace event JSON format
+	*/
+	static std::string GetChromeTrace();
+
+	/**
+	* Writes the recorded events to a JSON file in the Chrome trace event
+	* format. Returns false if the file can't be written.
+	*/
+	static bool WriteChromeTrace(const std::string& a_filename);
+
+private:
+	/**
+	* Get the buffer of the calling thread, created on its first event
+	*/
+	static ThreadTrace& GetThreadTrace();
+
+	/**
+	* Records an event on the calling thread, with its start time and its
+	* duration in ticks
+	*/
+	static void Record(char a_type, const char* a_name, uint a_layer_id,
+					   int a_value, uint64_t a_ticks, uint64_t a_duration);
+
+private:
+	// Flag indicating if recording
+	static std::atomic<bool> active_;
+
+	// Buffers of all the threads which recorded events. They are kept after
+	// the threads end so that their events can be exported.
+	static std::list<std::shared_ptr<ThreadTrace> > threads_;
+
+	// Mutex for creating and reading the buffers of the threads
+	static std::mutex mutex_;
+};
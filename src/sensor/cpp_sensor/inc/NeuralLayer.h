@@ -1,197 +1,444 @@
-/**
-* @file NeuralLayer.h
-*
-* @authors Vincent de Ladurantaye
-*/
-#pragma once
-
-#include "Neuron.h"
-#include "ImageData.h"
-
-
-/**
-* Abstract class for a layer of spiking neurons. Different implementations are
-* required for different type of neuron features.
-*/
-class NeuralLayer
-{
-public:
-
-	/**
-	* Constructor
-	*/
-	NeuralLayer(const ImageData& a_data, int a_layer_id = -1);
-
-	/**
-	* Virtual Destructor since this is an abstract class
-	*/
-	virtual ~NeuralLayer();
-
-
-	/**
-	* Find the neuron with the highest potential and returns the simulation
-	* time necessary to make it spike
-	*/
-	float FindNextTimeStep();
-
-	/**
-	* Advances time for all neurons on layer
-	*
-	* @param a_delta Amount of time to add to the simulation
-	*/
-	void AdvanceTime(float a_delta);
-
-	/**
-	* Fires the neurons with potential above the threshold.
-	*
-	* @param a_phase Phase of this firing episode, represented in the original
-	*	ODLM code by the counter of firing cascade
-	* @param a_sim_time Simulation time of the simulation, this is used to
-	*	calculate the network convergence.
-	*/
-	int FireNeurons(int a_phase, float a_sim_time);
-
-	/**
-	* Check if a complete cycle of spiking has occured in the network. A cycle
-	* is completed when all leader neurons have fired at least once.
-	*/
-	bool IsCycleCompleted();
-
-	/**
-	* Reset neuron's cycle spike flag for the next cycle.
-	*/
-	void ResetCycle();
-
-	/**
-	* Reduces the potential of the neurons that didn't fire
-	*/
-	virtual void GlobalInhibition();
-
-	/**
-	* Get the stabilization coefficient indicating if the network has 
-	* converged and neurons are firing in stable intervals.
-	*
-	* @param a_min_phase Minimum phase number to be considered. This is used
-	*	to avoid taking into account neurons that haven't fired.
-	*/
-	float GetCoefStabilization(int a_min_phase = 0);
-
-	/**
-	* Set the callback for propagating the spike out of the layer.
-	*/
-	void SetPropagateCallback(function< void(uint, uint, uint) > a_callback)
-	{
-		PropagateSpikeOutOfLayer = a_callback;
-	}
-
-	/**
-	* Save the layer's neuron state to file
-	*/
-	void SaveStateToFile(string a_filename);
-
-	/**
-	* Compares the layer to the state saved in the given file. Returns true if
-	* the layer is identical.
-	*/
-	bool ValidateLayerState(string a_filename);
-	
-	/**
-	* Check if the given position is within the layer
-	*/
-	inline bool IsInLayer(int a_x, int a_y)
-	{
-		return  (a_x >= 0 &&
-				 a_y >= 0 &&
-				 a_x < (int)width &&
-				 a_y < (int)height);
-	}
-
-	/// Get the number of cycles
-	uint GetNbCycles() { return n_cycles; }
-	/// Get the number of cascades
-	uint GetNbCascades() { return n_cascades; }
-	/// Get the number of spikes
-	unsigned long GetNbSpikes() { return n_spikes; }
-
-public:
-
-	// Vector of neurons
-	vector<Neuron> neurons;
-
-	// Width of the layer
-	uint width;
-	// Height of the layer
-	uint height;
-	// Size of the layer (width*height). Declared as a separate member for 
-	// readability and convenience.
-	uint size;
-
-	// Id of the layer
-	uint layer_id;
-
-protected:
-	
-	/**
-	* Calculates the weights between two neurons in the layer
-	*/
-	virtual float ComputeWeigth(float a_feat_diff) = 0;
-
-	/**
-	* Function called by FireNeurons() to propagate a spike to neighboring
-	* neurons on the same layer.
-	*/
-	virtual void PropagateSpike(int a_id, int a_phase) = 0;
-
-	/**
-	* Propagate a new label to a neuron.
-	*/
-	virtual void PropagateLabel(Neuron& a_n, int a_label, int a_phase) = 0;
-
-	// Callback to propagate spikes to other layers
-	function< void(uint neuron_id, uint layer_id, uint phase) >
-		PropagateSpikeOutOfLayer;
-
-protected:
-
-	// Image data represented by this layer
-	ImageData img_data_;
-
-	// Region where neurons neurons are processed. We have this so that we can
-	// concentrate on specific parts of the layer and ignore the rest.
-	cv::Rect active_reg_;
-
-	// Simulation time
-	float sim_time;
-	// Cycle counter
-	uint n_cycles;
-	// Cascade counter
-	uint n_cascades;
-	// Spike counter
-	unsigned long n_spikes;
-
-
-	// Static counter to give a unique ID to each layer
-	static uint layer_id_counter_;
-
-	// Static label counter for giving neurons unique labels throughout neurons
-	// of all layers
-	static uint label_counter_;
-
-
-//-----------------------------------------------------------------------------
-//							Configuration Parameters
-//-----------------------------------------------------------------------------
-public:
-
-	float POT_THRESHOLD;
-	float TAU;
-	float GLOBAL_INHIB_VAL;
-	float CHARGING_LEADER;
-	float CHARGING_FOLLOW;
-
-public:
-	friend class LayerDebugger;
-	friend class LayerCoupler;
-	friend class LayerMonitor;
-
-};
+/**
+* @file NeuralLayer.h
+*
+* @authors Vincent de Ladurantaye
+*/
+#pragma once
+
+#include "Neuron.h"
+#include "ImageData.h"
+#include "LayerProfiler.h"
+
+#include <atomic>
+#include <cstdint>
+
+// Forward declaration
+struct LayerSnapshot;
+struct NeuralLayerState;
+class LayerStateWriter;
+class LayerStateView;
+
+/**
+* Memory layouts of the neurons of a layer. With the row-major layout, the 
+* neighbors above and below a neuron are a whole layer row away, which misses
+* the cache on wide layers. The tiled layout stores the neurons tile by tile,
+* each tile being row-major, so that most neighbors are in the same tile.
+*/
+enum NeuronLayout
+{
+	LAYOUT_ROW_MAJOR = 0,
+	LAYOUT_TILED = 1
+};
+
+/**
+* Abstract class for a layer of spiking neurons. Different implementations are
+* required for different type of neuron features.
+*/
+class NeuralLayer
+{
+public:
+
+	/**
+	* Constructor
+	*/
+	NeuralLayer(const ImageData& a_data, int a_layer_id = -1);
+
+	/**
+	* Virtual Destructor since this is an abstract class
+	*/
+	virtual ~NeuralLayer();
+
+
+	/**
+	* Find the neuron with the highest potential and returns the simulation
+	* time necessary to make it spike
+	*/
+	float FindNextTimeStep();
+
+	/**
+	* Advances time for all neurons on layer
+	*
+	* @param a_delta Amount of time to add to the simulation
+	*/
+	void AdvanceTime(float a_delta);
+
+	/**
+	* Fires the neurons with potential above the threshold.
+	*
+	* @param a_phase Phase of this firing episode, represented in the original
+	*	ODLM code by the counter of firing cascade
+	* @param a_sim_time Simulation time of the simulation, this is used to
+	*	calculate the network convergence.
+	*/
+	int FireNeurons(int a_phase, float a_sim_time);
+
+	/**
+	* Check if a complete cycle of spiking has occured in the network. A cycle
+	* is completed when all leader neurons have fired at least once.
+	*/
+	bool IsCycleCompleted();
+
+	/**
+	* Reset neuron's cycle spike flag for the next cycle.
+	*/
+	void ResetCycle();
+
+	/**
+	* Reduces the potential of the neurons that didn't fire
+	*/
+	virtual void GlobalInhibition();
+
+	/**
+	* Get the stabilization coefficient indicating if the network has 
+	* converged and neurons are firing in stable intervals.
+	*
+	* @param a_min_phase Minimum phase number to be considered. This is used
+	*	to avoid taking into account neurons that haven't fired.
+	*/
+	float GetCoefStabilization(int a_min_phase = 0);
+
+	/**
+	* Restricts the simulation to the given regions of the layer, which may
+	* overlap. The neurons outside of the regions keep their state and
+	* spikes aren't propagated to them.
+	*/
+	void SetActiveRegions(const vector<cv::Rect>& a_regions);
+	void SetActiveRegion(const cv::Rect& a_region);
+
+	/**
+	* Makes the whole layer active again
+	*/
+	void ClearActiveRegions();
+
+	/// Get the active regions of the layer
+	const vector<cv::Rect>& GetActiveRegions() const { return active_regs_; }
+
+	/**
+	* Get the number of neurons simulated, in the active regions and not
+	* frozen
+	*/
+	uint GetNbActiveNeurons() const;
+
+	/**
+	* Set the callback for propagating the spike out of the layer.
+	*/
+	void SetPropagateCallback(function< void(uint, uint, uint) > a_callback)
+	{
+		PropagateSpikeOutOfLayer = a_callback;
+	}
+
+	/**
+	* Save the layer's neuron state to file
+	*/
+	void SaveStateToFile(string a_filename);
+
+	/**
+	* Compares the layer to the state saved in the given file, either by
+	* SaveStateToFile() or SaveBinaryState(). Returns true if the labels are
+	* identical and the potentials within 0.0005.
+	*/
+	bool ValidateLayerState(string a_filename);
+
+	/**
+	* Saves the complete state of the layer, with its configuration and
+	* counters, in the binary format of LayerState.h. The state is written
+	* in a single write and is much smaller and faster to load than the text
+	* state. Returns false if the file can't be written.
+	*/
+	bool SaveBinaryState(const string& a_filename) const;
+
+	/**
+	* Get the binary state of the layer, see SaveBinaryState()
+	*/
+	vector<char> GetBinaryState() const;
+
+	/**
+	* Restores the state saved by SaveBinaryState(), so that the simulation
+	* resumes where it was saved. The layer must have the size of the saved
+	* layer, but may have another neuron layout. The file is memory-mapped,
+	* so the neurons are copied directly from the file. Returns false, 
+	* leaving the layer unchanged, if the state can't be loaded.
+	*/
+	bool LoadBinaryState(const string& a_filename);
+	//-------------------------------------------------------------------------
+	// From a state already in memory
+	bool LoadBinaryState(const LayerStateView& a_state);
+
+	/**
+	* Compares the layer to a binary state, in place. Returns true if the
+	* labels and phases are identical and the potentials within the given
+	* tolerance.
+	*/
+	bool ValidateBinaryState(const LayerStateView& a_state,
+							 float a_pot_tolerance = 0.0005f) const;
+
+	/**
+	* Copies the potentials, labels and phases of the neurons to the given
+	* snapshot, in row-major order. The buffers of the snapshot are reused
+	* when they already have the size of the layer.
+	*/
+	void CaptureSnapshot(LayerSnapshot& a_snapshot) const;
+	
+	/**
+	* Check if the given position is within the layer
+	*/
+	inline bool IsInLayer(int a_x, int a_y)
+	{
+		return  (a_x >= 0 &&
+				 a_y >= 0 &&
+				 a_x < (int)width &&
+				 a_y < (int)height);
+	}
+
+	/**
+	* Get the index of a neuron of the layer
+	*/
+	inline uint GetNeuronId(const Neuron& a_n) const
+	{
+		return &a_n - neurons.data();
+	}
+
+	/**
+	* Get the index of the neuron at the given position. The neurons are not
+	* necessarily stored row-major (see NeuronLayout), so positions must 
+	* always be translated with this function.
+	*/
+	inline uint GetNeuronId(int a_x, int a_y) const
+	{
+		return GetNeuronId(a_x, a_y, width, height, NEURON_LAYOUT, TILE_SIZE);
+	}
+
+	/**
+	* Get the index of the neuron at the given position in a layer of the
+	* given size and layout
+	*/
+	static inline uint GetNeuronId(int a_x, int a_y, uint a_width,
+								   uint a_height, uint a_layout,
+								   uint a_tile_size)
+	{
+		if (a_layout == LAYOUT_ROW_MAJOR) return a_y * a_width + a_x;
+
+		// Tiles of the last column and row are truncated by the layer border
+		uint tileX = a_x / a_tile_size;
+		uint tileY = a_y / a_tile_size;
+		uint tileWidth = min(a_tile_size, a_width - tileX * a_tile_size);
+		uint tileHeight = min(a_tile_size, a_height - tileY * a_tile_size);
+
+		return tileY * a_tile_size * a_width +
+			tileX * a_tile_size * tileHeight +
+			(a_y - tileY * a_tile_size) * tileWidth + a_x - tileX * a_tile_size;
+	}
+
+	/**
+	* Get the position of a neuron in the layer from its index
+	*/
+	inline cv::Point GetNeuronPos(uint a_id) const
+	{
+		if (NEURON_LAYOUT == LAYOUT_ROW_MAJOR)
+			return cv::Point(a_id % width, a_id / width);
+
+		uint tileY = a_id / (TILE_SIZE * width);
+		uint tileHeight = min(TILE_SIZE, height - tileY * TILE_SIZE);
+		uint tileId = a_id - tileY * TILE_SIZE * width;
+		uint tileX = tileId / (TILE_SIZE * tileHeight);
+		uint tileWidth = min(TILE_SIZE, width - tileX * TILE_SIZE);
+		tileId -= tileX * TILE_SIZE * tileHeight;
+
+		return cv::Point(tileX * TILE_SIZE + tileId % tileWidth,
+						 tileY * TILE_SIZE + tileId / tileWidth);
+	}
+
+	/**
+	* Get the maximum potential a neuron can reach. This can exceed the 
+	* threshold to make a leader neuron that spikes on its own.
+	*/
+	inline float GetMaxCharge(uint a_id) const
+	{
+		return charge_levels_[charge_ids_[a_id]];
+	}
+
+	/**
+	* Sets the maximum potential of a neuron. A layer only uses a few distinct
+	* values, so each neuron stores the index of its value in a table of the
+	* layer, which holds up to 256 values.
+	*/
+	void SetMaxCharge(uint a_id, float a_max_charge);
+
+	/// Get the image data represented by the layer
+	const ImageData& GetImageData() const { return img_data_; }
+	/// Get the number of cycles
+	uint GetNbCycles() { return n_cycles; }
+	/// Get the number of cascades
+	uint GetNbCascades() { return n_cascades; }
+	/// Get the number of spikes
+	unsigned long GetNbSpikes() { return n_spikes; }
+
+	/**
+	* Get the time spent in each phase of the simulation and the counts of
+	* the simulation events, since the creation of the layer or the last call
+	* to ResetPhaseCounters(). The counters stay at 0 when the instrumentation
+	* isn't compiled (see LayerProfiler.h).
+	*/
+	const PhaseCounters& GetPhaseCounters() const { return phase_counters_; }
+	void ResetPhaseCounters() { phase_counters_.Reset(); }
+
+public:
+
+	// Vector of neurons
+	vector<Neuron> neurons;
+
+	// Indicates wether each neuron has fired in the current cycle or not
+	vector<bool> cycle_spiked;
+
+	// Indicates if each neuron is part of a segment or not
+	vector<bool> is_segmented;
+
+	// Width of the layer
+	uint width;
+	// Height of the layer
+	uint height;
+	// Size of the layer (width*height). Declared as a separate member for 
+	// readability and convenience.
+	uint size;
+
+	// Id of the layer
+	uint layer_id;
+
+protected:
+	
+	/**
+	* Calculates the weights between two neurons in the layer
+	*/
+	virtual float ComputeWeigth(float a_feat_diff) = 0;
+
+	/**
+	* Function called by FireNeurons() to propagate a spike to neighboring
+	* neurons on the same layer.
+	*/
+	virtual void PropagateSpike(int a_id, int a_phase) = 0;
+
+	/**
+	* Propagate a new label to a neuron.
+	*/
+	virtual void PropagateLabel(Neuron& a_n, int a_label, int a_phase) = 0;
+
+	/**
+	* Updates the index spans covering the active regions, excluding the
+	* frozen neurons. Must be called whenever the active regions or the 
+	* frozen neurons change.
+	*/
+	void UpdateActiveSpans();
+
+	// Range of contiguous neuron indices
+	struct NeuronSpan
+	{
+		uint begin;
+		uint end;
+	};
+
+	/**
+	* Fires the neurons of the given spans with potential above the
+	* threshold, see FireNeurons()
+	*/
+	int FireNeurons(int a_phase, float a_sim_time, 
+					const vector<NeuronSpan>& a_spans);
+
+	/**
+	* Adds the sections of the layer's state to a binary state. Child classes
+	* with more state add their own sections.
+	*/
+	virtual void WriteBinaryState(LayerStateWriter& a_writer) const;
+
+	/**
+	* Restores the layer from the sections of a binary state. Returns false
+	* if the state doesn't fit the layer.
+	*/
+	virtual bool ReadBinaryState(const LayerStateView& a_state);
+
+	/**
+	* Get the index of each neuron of the layer in the neuron sections of a
+	* binary state, empty if the state has the layout of the layer
+	*/
+	vector<uint> GetStateNeuronIds(const NeuralLayerState& a_state) const;
+
+	// Callback to propagate spikes to other layers
+	function< void(uint neuron_id, uint layer_id, uint phase) >
+		PropagateSpikeOutOfLayer;
+
+protected:
+
+	// Image data represented by this layer
+	ImageData img_data_;
+
+	// Distinct maximal charges of the neurons, and index of the maximal
+	// charge of each neuron, see GetMaxCharge()
+	vector<float> charge_levels_;
+	vector<uint8_t> charge_ids_;
+
+	// Regions where neurons neurons are processed. We have this so that we can
+	// concentrate on specific parts of the layer and ignore the rest. The
+	// regions may overlap.
+	vector<cv::Rect> active_regs_;
+
+	// Spans of the neurons of the active regions, in memory order. The layer
+	// loops iterate over these spans so that they follow the neuron layout.
+	vector<NeuronSpan> active_spans_;
+
+	// Neurons that aren't simulated, either outside of the active regions or
+	// frozen, so that spikes aren't propagated to them. Empty when all the
+	// neurons are simulated.
+	vector<bool> excluded_;
+
+	// Neurons excluded from the simulation, whose state is handled elsewhere
+	// (see SegmentationLayer::CoarsenStableSegments()). Empty if no neuron
+	// was ever frozen.
+	vector<bool> frozen_;
+	// Number of frozen neurons and sum of their absolute delta period at the
+	// time they were frozen, accounted for by GetCoefStabilization()
+	uint n_frozen_;
+	double frozen_delta_sum_;
+
+	// Simulation time
+	float sim_time;
+	// Cycle counter
+	uint n_cycles;
+	// Cascade counter
+	uint n_cascades;
+	// Spike counter
+	unsigned long n_spikes;
+
+	// Instrumentation of the simulation phases
+	PhaseCounters phase_counters_;
+
+
+	// Static counter to give a unique ID to each layer. Atomic since layers
+	// are created by several threads (see VideoPipeline).
+	static atomic<uint> layer_id_counter_;
+
+	// Static label counter for giving neurons unique labels throughout neurons
+	// of all layers
+	static atomic<uint> label_counter_;
+
+
+//-----------------------------------------------------------------------------
+//							Configuration Parameters
+//-----------------------------------------------------------------------------
+public:
+
+	float POT_THRESHOLD;
+	float TAU;
+	float GLOBAL_INHIB_VAL;
+	float CHARGING_LEADER;
+	float CHARGING_FOLLOW;
+
+	// Memory layout of the neurons, see NeuronLayout. Fixed at construction.
+	const uint NEURON_LAYOUT;
+	// Side of the tiles of the tiled layout
+	const uint TILE_SIZE;
+
+public:
+	friend class LayerDebugger;
+	friend class LayerCoupler;
+	friend class LayerMonitor;
+
+};
@@ -1,72 +1,76 @@
-/** @file Neuron.h
- *
- *  @author Vincent de Ladurantaye
- */
-
-#pragma once
-
-#include "Tools.h"
-
-
-/**
-* Integrate and fire neuron for ODLM type neural networks. Spikes when the
-* neural potential threshold is reached and propagates it's label. Each neuron
-* represents some type of feature(s).
-*
-*/
-class Neuron
-{
-public:
-
-	/**
-	* Constructor
-	*/
-	Neuron();
-
-	void Spike(int a_phase, float a_sim_time);
-
-	/**
-	* Comparison operator
-	*/
-	bool operator==(const Neuron& n) const;
-	bool operator!=(const Neuron& n) const;
-
-public:
-
-	// Neuron membrane potential
-	float pot;
-
-	// Last cascade number where the neuron fired
-	int phase;
-
-	// Maximum potential the neuron can reach. This can exceed the threshold to
-	// make a leader neuron that spikes on it's own.
-	float max_charge;
-
-	// Index of the neuron in the layer
-	uint id;
-
-	// Position of the neuron in the layer
-	cv::Point pos;
-
-	// Label used to identify segments
-	int label;
-
-	// Counter for the number of times the neuron has fired
-	uint nb_spikes;
-
-	// Indicates wether the neuron has fired in the current cycle or not
-	bool cycle_spiked;
-
-	// Indicates if neuron is part of a segment or not
-	bool is_segmented;
-        
-	// Time of last spike
-	float last_spike;
-	// Period between last two spikes
-	float fire_period;
-	// Variation in firing period
-	float delta_period;
-
-};
-
+/** @file Neuron.h
+ *
+ *  @author Vincent de Ladurantaye
+ */
+
+#pragma once
+
+#include "Tools.h"
+
+// COMPACT_NEURONS (CMake option SENSOR_COMPACT_NEURONS) selects the compact
+// neuron representation, where the firing period statistics are stored in
+// half precision and the spike counter is removed. This brings a neuron from
+// 28 to 20 bytes. Periods keep 11 significant bits, so fire_period and 
+// delta_period are within 0.05% of their full precision value, which can 
+// change the cascade where GetCoefStabilization() crosses the convergence
+// threshold.
+
+#ifdef COMPACT_NEURONS
+typedef Half PeriodType;
+#else
+typedef float PeriodType;
+#endif
+
+/**
+* Integrate and fire neuron for ODLM type neural networks. Spikes when the
+* neural potential threshold is reached and propagates it's label. Each neuron
+* represents some type of feature(s).
+*
+* The index of the neuron and its position are given by the layer (see 
+* NeuralLayer::GetNeuronId()), and its cycle and segment flags are stored in
+* bitsets in the layer to keep neurons as small as possible. So is its
+* maximal charge, which only takes a few distinct values in a layer (see
+* NeuralLayer::GetMaxCharge()).
+*/
+class Neuron
+{
+public:
+
+	/**
+	* Constructor
+	*/
+	Neuron();
+
+	void Spike(int a_phase, float a_sim_time);
+
+	/**
+	* Comparison operator
+	*/
+	bool operator==(const Neuron& n) const;
+	bool operator!=(const Neuron& n) const;
+
+public:
+
+	// Neuron membrane potential
+	float pot;
+
+	// Last cascade number where the neuron fired
+	int phase;
+
+	// Label used to identify segments
+	int label;
+
+#ifndef COMPACT_NEURONS
+	// Counter for the number of times the neuron has fired
+	uint nb_spikes;
+#endif
+
+	// Time of last spike
+	float last_spike;
+	// Period between last two spikes
+	PeriodType fire_period;
+	// Variation in firing period
+	PeriodType delta_period;
+
+};
+
@@ -0,0 +1,113 @@
+/**
+* @file PackedPixelLayer.h
+*
+* @authors Vincent de Ladurantaye
+*/
+#pragma once
+
+#include "PixelLayer.h"
+
+
+/**
+* Result of the segmentation of one image of a packed layer
+*/
+struct PackedImageResult
+{
+	// Labels of the image in row-major order
+	cv::Mat labels;
+	// Number of cycles and cascades simulated for this image
+	uint cycles;
+	uint cascades;
+	// Convergence measure reached, see GetCoefStabilization()
+	float convergence;
+	// Flag indicating if the image converged before reaching the limits
+	bool converged;
+};
+
+
+//=============================================================================
+//								PackedPixelLayer
+//=============================================================================
+/**
+* Pixel layer packing several small images side by side, separated by a 
+* column of inert neurons, so that the fixed cost of each cascade (finding
+* the next time step, the convergence checks, the calls from Python) is
+* shared by the whole batch. Each image keeps its own cycle and convergence
+* bookkeeping and is retired from the simulation once it converged or
+* reached the limits of the params.
+*/
+class PackedPixelLayer : public PixelLayer
+{
+public:
+
+	/**
+	* Constructor
+	*/
+	PackedPixelLayer(const vector<cv::Mat>& a_images,
+					 bool a_random_init = Config::PIXEL_RANDOM_INIT);
+
+	/**
+	* Segments all the images of the layer and returns their labels and
+	* statistics, in the order of the images
+	*/
+	vector<PackedImageResult> SegmentImages();
+
+	/// Get the number of images packed in the layer
+	uint GetNbImages() const { return (uint)image_regs_.size(); }
+
+	/// Get the region of the layer holding an image
+	const cv::Rect& GetImageRegion(uint a_image) const
+	{
+		return image_regs_[a_image];
+	}
+
+	/**
+	* Packs the gray images side by side with a separator column between
+	* them. The images shorter than the tallest one are padded at the bottom.
+	* The region of each image is returned in a_regions if given.
+	*/
+	static cv::Mat PackImages(const vector<cv::Mat>& a_images,
+							  vector<cv::Rect>* a_regions = nullptr);
+
+	/**
+	* Get the class of the layer
+	*/
+	PixelLayerClass GetLayerClass() const { return PIXEL_LAYER_PACKED; }
+
+protected:
+
+	/**
+	* Get the convergence measure of the neurons of an image, see 
+	* GetCoefStabilization()
+	*/
+	float GetImageStabilization(uint a_image) const;
+
+	/**
+	* Check if all the leader neurons of an image fired during the cycle
+	*/
+	bool IsImageCycleCompleted(uint a_image) const;
+
+	/**
+	* Resets the cycle spike flag of the neurons of an image
+	*/
+	void ResetImageCycle(uint a_image);
+
+	/**
+	* Adds the regions of the images to a binary state
+	*/
+	void WriteBinaryState(LayerStateWriter& a_writer) const;
+
+	/**
+	* Restores a binary state of a layer packing images of the same sizes
+	*/
+	bool ReadBinaryState(const LayerStateView& a_state);
+
+protected:
+
+	// Region of each image in the layer
+	vector<cv::Rect> image_regs_;
+
+	// Spans of the neurons of each image, in memory order
+	vector<vector<NeuronSpan> > image_spans_;
+
+};
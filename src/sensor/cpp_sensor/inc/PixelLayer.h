@@ -1,61 +1,167 @@
-/** @file PixelLayer.h
- *
- *  @author Vincent de Ladurantaye
- */
-#pragma once
-
-#include "SegmentationLayer.h"
-
- /**
- * Layer that does segmentation based on gray pixel values of images
- */
-class PixelLayer : public SegmentationLayer
-{
-public:
-
-	/**
-	* Constructor
-	*/
-	PixelLayer(const string& a_img_file,
-			   bool a_random_init = Config::PIXEL_RANDOM_INIT);
-	PixelLayer(const cv::Mat& a_img,
-			   bool a_random_init = Config::PIXEL_RANDOM_INIT);
-	PixelLayer(ImageData& a_img_data,
-			   bool a_random_init = Config::PIXEL_RANDOM_INIT);
-
-public:
-
-	// Pointer to image gray pixel values
-	const uchar* pixel_data;
-
-protected:
-	
-	/**
-	* Calculates the weights between two neurons in the layer
-	*/
-	float ComputeWeigth(int a_src_id, int a_dst_id,
-						NeuronRelPos a_dst_pos);
-
-	/**
-	* Calculates the homogeneity of pixel values in an area. Neurons in
-	* homogeneous areas will be leaders.
-	*/
-	double GetHomogeneity(int a_x, int a_y, int a_radius);
-
-
-//-----------------------------------------------------------------------------
-//							Configuration Parameters
-//-----------------------------------------------------------------------------
-public:
-	// Homogeneity tolerated pixel delta
-	int HOMOG_DELTA;
-	// Homogeneity area radius
-	int HOMOG_RADIUS;
-	// Homogeneity leader threshold
-	float HOMOG_THRESHOLD;
-
-	// Flag determining if inital neural potential is random or proportional
-	// to pixel value
-	const bool RANDOM_INIT;
-
-};
+/** @file PixelLayer.h
+ *
+ *  @author Vincent de Ladurantaye
+ */
+#pragma once
+
+#include "SegmentationLayer.h"
+
+/**
+* Classes of pixel layers, saved in the binary states so that the same class
+* is created again when a state is loaded
+*/
+enum PixelLayerClass
+{
+	// PixelLayer
+	PIXEL_LAYER_GENERIC = 0,
+	// SegmentationLayerT with a DynamicSize, see CreatePixelLayer()
+	PIXEL_LAYER_SPECIALIZED = 1,
+	// SegmentationLayerT with a FixedSize
+	PIXEL_LAYER_FIXED_SIZE = 2,
+	// PackedPixelLayer
+	PIXEL_LAYER_PACKED = 3
+};
+
+ /**
+ * Layer that does segmentation based on gray pixel values of images
+ */
+class PixelLayer : public SegmentationLayer
+{
+public:
+
+	/**
+	* Constructor
+	*/
+	PixelLayer(const string& a_img_file,
+			   bool a_random_init = Config::PIXEL_RANDOM_INIT);
+	PixelLayer(const cv::Mat& a_img,
+			   bool a_random_init = Config::PIXEL_RANDOM_INIT);
+	PixelLayer(ImageData& a_img_data,
+			   bool a_random_init = Config::PIXEL_RANDOM_INIT);
+
+	/**
+	* Initializes the layer from the segmented layer of the previous video
+	* frame. The neurons whose pixel changed by at most a_max_delta gray 
+	* levels start from their state in the previous frame, so that only the
+	* changed areas need to be segmented again and the labels stay stable
+	* from frame to frame. The neurons outside of the active regions always
+	* start from their previous state since they won't be simulated. Returns
+	* the number of neurons initialized.
+	*/
+	uint InitFromPreviousFrame(const PixelLayer& a_prev, int a_max_delta);
+
+	/**
+	* Loads the next video frame in the layer, in place of creating a layer
+	* for the frame and initializing it with InitFromPreviousFrame(). The 
+	* features are computed from the new pixels, the neurons whose pixel 
+	* changed by at most a_max_delta gray levels keep their state and the
+	* others start from scratch with new labels. The neurons outside of the
+	* active regions always keep their state, so the regions must be set
+	* first. When no neuron keeps its state, the simulation restarts from the
+	* start like in a new layer. The frame must have the size of the layer,
+	* otherwise std::invalid_argument is thrown. Returns the number of 
+	* neurons which kept their state.
+	*/
+	uint LoadFrame(const ImageData& a_frame_data, int a_max_delta);
+
+	/**
+	* Get the tiles of the layer where at least one pixel changed by more 
+	* than a_max_delta gray levels since the previous frame. The tiles are 
+	* grown by a_margin on each side so that the segments around the changes
+	* can adapt.
+	*/
+	vector<cv::Rect> FindChangedTiles(const PixelLayer& a_prev, 
+									  int a_max_delta, uint a_tile_size,
+									  uint a_margin) const;
+	//-------------------------------------------------------------------------
+	// Compares the pixels of the layer with the gray image of the next frame
+	vector<cv::Rect> FindChangedTiles(const cv::Mat& a_next_gray,
+									  int a_max_delta, uint a_tile_size,
+									  uint a_margin) const;
+
+	/**
+	* Get the class of the layer
+	*/
+	virtual PixelLayerClass GetLayerClass() const 
+	{ 
+		return PIXEL_LAYER_GENERIC; 
+	}
+
+public:
+
+	// Pointer to image gray pixel values
+	const uchar* pixel_data;
+
+protected:
+
+	/**
+	* Computes the features of the neurons from the image of the layer: the
+	* pixel values in the order of the neurons and the maximal charges
+	*/
+	void InitFeatures();
+
+	/**
+	* Sets the initial potential of a neuron
+	*/
+	void InitPotential(uint a_id);
+	
+	/**
+	* Calculates the weights between two neurons in the layer
+	*/
+	float ComputeWeigth(int a_src_id, int a_dst_id,
+						NeuronRelPos a_dst_pos);
+
+	/**
+	* Computes a weight plane. Pixel differences are integers, so the weights
+	* are looked up in a table of the 256 possible differences.
+	*/
+	void ComputeWeightPlane(NeuronRelPos a_dst_pos, float* a_plane);
+
+	/**
+	* Get the coarse neuron with the closest pixel value among the nearest 
+	* coarse neuron and its neighbors, so that the neurons along the segment
+	* boundaries take the label of their side of the boundary.
+	*/
+	uint GetCoarseNeuronId(const SegmentationLayer& a_coarse, int a_x,
+						   int a_y);
+
+	/**
+	* Adds the class of the layer to a binary state
+	*/
+	virtual void WriteBinaryState(LayerStateWriter& a_writer) const;
+
+	/**
+	* Calculates the homogeneity of pixel values in an area. Neurons in
+	* homogeneous areas will be leaders.
+	*/
+	double GetHomogeneity(int a_x, int a_y, int a_radius);
+	//-------------------------------------------------------------------------
+	// Only the pixels within a_bounds are considered
+	double GetHomogeneity(int a_x, int a_y, int a_radius, 
+						  const cv::Rect& a_bounds);
+
+protected:
+
+	// Pixel values in the memory order of the neurons, used when the neurons
+	// aren't stored row-major
+	cv::Mat neuron_pixels_;
+	// Gray pixels of the frames loaded by LoadFrame()
+	cv::Mat frame_gray_;
+
+
+//-----------------------------------------------------------------------------
+//							Configuration Parameters
+//-----------------------------------------------------------------------------
+public:
+	// Homogeneity tolerated pixel delta
+	int HOMOG_DELTA;
+	// Homogeneity area radius
+	int HOMOG_RADIUS;
+	// Homogeneity leader threshold
+	float HOMOG_THRESHOLD;
+
+	// Flag determining if inital neural potential is random or proportional
+	// to pixel value
+	const bool RANDOM_INIT;
+
+};
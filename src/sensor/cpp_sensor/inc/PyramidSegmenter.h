@@ -0,0 +1,83 @@
+/**
+* @file PyramidSegmenter.h
+*
+* @authors Vincent de Ladurantaye
+*/
+#pragma once
+
+#include "PixelLayer.h"
+
+
+/**
+* Statistics of the segmentation of one level of the pyramid
+*/
+struct PyramidLevelStats
+{
+	// Size of the layer of the level
+	uint width;
+	uint height;
+	// Number of cycles, cascades and spikes simulated at this level
+	uint cycles;
+	uint cascades;
+	unsigned long spikes;
+	// Wall time of the level, including the creation of the layer, in ms
+	double time_ms;
+};
+
+
+//=============================================================================
+//								PyramidSegmenter
+//=============================================================================
+/**
+* Coarse-to-fine segmentation. Labels propagate one neighbor per cascade, so
+* a large image needs many cycles before its segments are complete. The
+* image is first segmented at the lowest resolution of the pyramid, where 
+* the labels cross the image quickly. Each level is then initialized from 
+* the coarser one (see SegmentationLayer::InitFromCoarseLayer()) and only 
+* simulated for a few refinement cycles.
+*/
+class PyramidSegmenter
+{
+public:
+
+	/**
+	* Constructor
+	*/
+	PyramidSegmenter();
+
+	/**
+	* Segments an image and returns the segmented layer at full resolution
+	*/
+	unique_ptr<PixelLayer> Segment(const string& a_img_file);
+	unique_ptr<PixelLayer> Segment(const cv::Mat& a_img);
+	unique_ptr<PixelLayer> Segment(ImageData& a_img_data);
+
+	/**
+	* Get the statistics of each level of the last segmentation, from the
+	* coarsest to the full resolution level
+	*/
+	const vector<PyramidLevelStats>& GetLevelStats() const
+	{
+		return level_stats_;
+	}
+
+protected:
+
+	// Statistics of the levels of the last segmentation
+	vector<PyramidLevelStats> level_stats_;
+
+
+//-----------------------------------------------------------------------------
+//							Configuration Parameters
+//-----------------------------------------------------------------------------
+public:
+
+	// Number of levels, including the full resolution
+	uint NB_LEVELS;
+	// Maximum number of cycles of the levels initialized from a coarser one
+	uint REFINE_CYCLES;
+	// Minimal side of the coarsest level, levels that would be smaller are
+	// skipped
+	uint MIN_LEVEL_SIDE;
+
+};
@@ -0,0 +1,264 @@
+/**
+* @file RingBuffer.h
+*
+* @authors Vincent de Ladurantaye
+*/
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+using namespace std;
+
+
+//=============================================================================
+//								  RingBuffer
+//=============================================================================
+/**
+* Bounded lock-free queue, safe with several producer and consumer threads.
+* Each cell holds a sequence number telling if it is ready to be written or
+* read for the current turn of the buffer, so the producers and the consumers
+* only compete on their own position with a compare-and-swap. The capacity is
+* rounded up to a power of two.
+*/
+template <class T>
+class RingBuffer
+{
+public:
+
+	/**
+	* Constructor
+	*/
+	RingBuffer(size_t a_capacity) :
+		push_pos_(0),
+		pop_pos_(0)
+	{
+		size_t capacity = 1;
+		while (capacity < a_capacity) capacity *= 2;
+
+		cells_.reset(new Cell[capacity]);
+		mask_ = capacity - 1;
+
+		for (size_t i = 0; i < capacity; ++i)
+		{
+			cells_[i].sequence.store(i, memory_order_relaxed);
+		}
+	}
+
+	/**
+	* Adds an item at the end of the queue. Returns false if the queue is 
+	* full.
+	*/
+	bool TryPush(T a_item)
+	{
+		Cell* cell;
+		size_t pos = push_pos_.load(memory_order_relaxed);
+
+		for (;;)
+		{
+			cell = &cells_[pos & mask_];
+			size_t sequence = cell->sequence.load(memory_order_acquire);
+			intptr_t diff = (intptr_t)sequence - (intptr_t)pos;
+
+			// The cell is free for this turn, try to take it
+			if (diff == 0)
+			{
+				if (push_pos_.compare_exchange_weak(pos, pos + 1,
+													memory_order_relaxed))
+					break;
+			}
+			// The cell still holds the item of the previous turn
+			else if (diff < 0) return false;
+			// Another producer took the cell
+			else pos = push_pos_.load(memory_order_relaxed);
+		}
+
+		cell->item = move(a_item);
+		cell->sequence.store(pos + 1, memory_order_release);
+		return true;
+	}
+
+	/**
+	* Removes the item at the front of the queue. Returns false if the queue
+	* is empty.
+	*/
+	bool TryPop(T& a_item)
+	{
+		Cell* cell;
+		size_t pos = pop_pos_.load(memory_order_relaxed);
+
+		for (;;)
+		{
+			cell = &cells_[pos & mask_];
+			size_t sequence = cell->sequence.load(memory_order_acquire);
+			intptr_t diff = (intptr_t)sequence - (intptr_t)(pos + 1);
+
+			// The cell holds an item for this turn, try to take it
+			if (diff == 0)
+			{
+				if (pop_pos_.compare_exchange_weak(pos, pos + 1,
+												   memory_order_relaxed))
+					break;
+			}
+			// The cell wasn't written yet
+			else if (diff < 0) return false;
+			// Another consumer took the cell
+			else pos = pop_pos_.load(memory_order_relaxed);
+		}
+
+		a_item = move(cell->item);
+		cell->sequence.store(pos + mask_ + 1, memory_order_release);
+		return true;
+	}
+
+	/// Get the number of items the queue can hold
+	size_t GetCapacity() const { return mask_ + 1; }
+
+	/// Get the number of items in the queue, only approximate while other
+	/// threads use the queue
+	size_t GetSize() const
+	{
+		size_t push = push_pos_.load(memory_order_relaxed);
+		size_t pop = pop_pos_.load(memory_order_relaxed);
+		return push > pop ? push - pop : 0;
+	}
+
+protected:
+
+	// Item of the queue with its sequence number
+	struct Cell
+	{
+		atomic<size_t> sequence;
+		T item;
+	};
+
+	unique_ptr<Cell[]> cells_;
+	size_t mask_;
+
+	// Positions where the next item is pushed and popped, on separate cache 
+	// lines so that producers and consumers don't share them
+	atomic<size_t> push_pos_;
+	char padding_[64];
+	atomic<size_t> pop_pos_;
+
+};
+
+
+//=============================================================================
+//							   BlockingRingBuffer
+//=============================================================================
+/**
+* RingBuffer whose threads sleep while the queue is full or empty instead of
+* polling it. The items still go through the lock-free queue, the mutex only
+* guards the waits: a push or a pop only takes it to wake the threads when
+* some are waiting. Once closed, the consumers take the items left and are
+* then told that there won't be any more.
+*/
+template <class T>
+class BlockingRingBuffer : public RingBuffer<T>
+{
+public:
+
+	/**
+	* Constructor
+	*/
+	BlockingRingBuffer(size_t a_capacity) :
+		RingBuffer<T>(a_capacity),
+		closed_(false),
+		n_waiting_full_(0),
+		n_waiting_empty_(0)
+	{
+	}
+
+	/**
+	* Adds an item at the end of the queue, waiting for room if it is full
+	*/
+	void Push(const T& a_item)
+	{
+		if (!this->TryPush(a_item))
+		{
+			Wait(not_full_, n_waiting_full_, 
+				 [&]() { return this->TryPush(a_item); });
+		}
+		Notify(not_empty_, n_waiting_empty_);
+	}
+
+	/**
+	* Removes the item at the front of the queue, waiting for one if it is
+	* empty. Returns false once the queue is closed and empty.
+	*/
+	bool Pop(T& a_item)
+	{
+		bool popped = this->TryPop(a_item);
+		if (!popped)
+		{
+			Wait(not_empty_, n_waiting_empty_, [&]()
+			{
+				popped = this->TryPop(a_item);
+				return popped || closed_;
+			});
+		}
+		if (popped) Notify(not_full_, n_waiting_full_);
+		return popped;
+	}
+
+	/**
+	* Tells the consumers that no item will be added anymore
+	*/
+	void Close()
+	{
+		{
+			lock_guard<mutex> lock(mutex_);
+			closed_ = true;
+		}
+		not_empty_.notify_all();
+	}
+
+protected:
+
+	/**
+	* Sleeps on a condition until a_ready returns true. The thread is counted
+	* as waiting before it checks the queue, see Notify().
+	*/
+	template <class Predicate>
+	void Wait(condition_variable& a_condition, atomic<size_t>& a_nb_waiting,
+			  Predicate a_ready)
+	{
+		unique_lock<mutex> lock(mutex_);
+		a_nb_waiting.fetch_add(1);
+		atomic_thread_fence(memory_order_seq_cst);
+		a_condition.wait(lock, a_ready);
+		a_nb_waiting.fetch_sub(1);
+	}
+
+	/**
+	* Wakes the threads waiting on a condition, if any. With the fences, 
+	* either a thread about to wait sees the change of the queue, or it is
+	* already counted here. Taking the mutex then orders the change before 
+	* the waiters check the queue again, so none of them misses it.
+	*/
+	void Notify(condition_variable& a_condition, atomic<size_t>& a_nb_waiting)
+	{
+		atomic_thread_fence(memory_order_seq_cst);
+		if (a_nb_waiting.load(memory_order_relaxed) == 0) return;
+
+		{
+			lock_guard<mutex> lock(mutex_);
+		}
+		a_condition.notify_all();
+	}
+
+protected:
+
+	mutex mutex_;
+	condition_variable not_full_;
+	condition_variable not_empty_;
+	bool closed_;
+
+	// Number of threads waiting on not_full_ and on not_empty_
+	atomic<size_t> n_waiting_full_;
+	atomic<size_t> n_waiting_empty_;
+
+};
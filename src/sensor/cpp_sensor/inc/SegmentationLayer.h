@@ -1,147 +1,537 @@
-/**
-* @file NeuralLayer.h
-*
-* @authors Vincent de Ladurantaye
-*/
-#pragma once
-
-#include "NeuralLayer.h"
-
-/**
-* Neuron Relative Position, describing the position of a neuron relative to
-* another. Used for weights lookup table
-*/
-// Todo, rename without the N_ prefix so. To do so we have to remove references
-// to the other enum that defines the same terms
-enum NeuronRelPos
-{
-	N_LEFT = 0,
-	N_RIGHT = 1,
-	N_UP = 2,
-	N_DOWN = 3,
-	N_UP_R = 4,
-	N_DOWN_L = 5,
-	N_UP_L = 6,
-	N_DOWN_R = 7
-};
-
-struct Segment
-{
-	int id;
-	int phase;
-	int nbNeuron;
-	int perimeter;
-};
-
-
-//=============================================================================
-//								SegmentationLayer
-//=============================================================================
-/**
-* Layer that does ODLM inspired segmentation. Neurons are connected to their
-* immediate neighbors.
-*/
-class SegmentationLayer : public NeuralLayer
-{
-public:
-
-	/**
-	* Constructor
-	*/
-	SegmentationLayer(const cv::Mat& a_img);
-	SegmentationLayer(ImageData& a_img_data);
-
-	/**
-	* Destructor
-	*/
-	virtual ~SegmentationLayer();
-	   
-	/**
-	* Segments the layer until the network converges or until the number
-	* of cycles/cascades set in the params is reached
-	*/
-	virtual void SegmentLayer();
-
-	/**
-	* Removes segments that are too small
-	*/
-	void CountSegments();
-
-	/**
-	* Removes segments that are too small
-	*/
-	void ClearSmallSegments();
-
-	/**
-	* Removes segments that are too small
-	*/
-	//cv::Mat GetSegmentsImg();
-	cv::Mat GetImg();
-
-public:
-
-	// List of segments
-	vector<Segment> segments;
-
-protected:
-
-	/**
-	* Calculates the weights between two neurons in the layer
-	*/
-	virtual float ComputeWeigth(float a_feat_diff);
-
-	/**
-	* Calculates the weights between two adjacent neurons based on their
-	* relative position.
-	*/
-	virtual float ComputeWeigth(int a_src_id, int a_dst_id, 
-								NeuronRelPos a_dst_pos) = 0;
-
-	/**
-	* Function called by FireNeurons() to propagate a spike to neighboring
-	* neurons on the same layer.
-	*/
-	void PropagateSpike(int a_id, int a_phase);
-
-	/**
-	* Propagate a spike to a neighboring neuron
-	*/
-	void Propagate(int a_src_id, NeuronRelPos a_dst_pos, int a_phase);
-
-	/**
-	* Propagate a label to a neuron and merge the segments if necessary
-	*/
-	virtual void PropagateLabel(Neuron& a_n, int a_label, int a_phase);
-
-	/**
-	* Merge two segments by giving the first segment's label to the second
-	* segment.
-	*/
-	void MergeSegments(int a_src_label, int a_dst_label, int a_phase);
-
-
-	void TriggerSameLabelNeurons(int a_id, int a_phase);
-
-protected:
-
-	// Lookup Table for index offset based on neurons relative positions
-	int pos_offset_[8];
-
-
-	//-----------------------------------------------------------------------------
-	//							 Layer public parameters
-	//-----------------------------------------------------------------------------
-public:
-	uint MAX_SEG_CASCADES;
-	uint MAX_SEG_CYCLES;
-	uint MIN_SEGMENT_SIZE;
-
-	bool TRIGGER_SAME_LABEL_NEURONS;
-	bool MERGE_SEGMENTS;
-	float SEG_MERGE_TRESHOLD;
-
-	float WEIGHT_MAX_VALUE;
-	float WEIGHT_SLOPE;
-	float WEIGHT_OFFSET;
-
-};
+/**
+* @file NeuralLayer.h
+*
+* @authors Vincent de Ladurantaye
+*/
+#pragma once
+
+#include "NeuralLayer.h"
+
+#include <unordered_map>
+
+/**
+* Neuron Relative Position, describing the position of a neuron relative to
+* another. Used for weights lookup table
+*/
+// Todo, rename without the N_ prefix so. To do so we have to remove references
+// to the other enum that defines the same terms
+enum NeuronRelPos
+{
+	N_LEFT = 0,
+	N_RIGHT = 1,
+	N_UP = 2,
+	N_DOWN = 3,
+	N_UP_R = 4,
+	N_DOWN_L = 5,
+	N_UP_L = 6,
+	N_DOWN_R = 7
+};
+
+/**
+* Modes for the precomputed weight planes
+*/
+enum WeightPlanesMode
+{
+	WEIGHT_PLANES_OFF = 0,
+	WEIGHT_PLANES_ON = 1,
+	WEIGHT_PLANES_AUTO = 2
+};
+
+/**
+* States of the step-wise segmentation, see SegmentationLayer::Step()
+*/
+enum SegmentationState
+{
+	SEG_STATE_IDLE = 0,
+	SEG_STATE_RUNNING = 1,
+	SEG_STATE_DONE = 2
+};
+
+struct Segment
+{
+	int id;
+	int phase;
+	int nbNeuron;
+	int perimeter;
+};
+
+/**
+* Result of a segmentation with a deadline, see 
+* SegmentationLayer::SegmentWithDeadline()
+*/
+struct SegmentationResult
+{
+	// Labels of the neurons in row-major order, -1 for the neurons of the
+	// small segments when they are cleared
+	cv::Mat labels;
+	// Convergence measure reached, see GetCoefStabilization()
+	float convergence;
+	// Why the segmentation stopped
+	bool converged;
+	bool deadline_reached;
+	bool cancelled;
+
+	uint cycles;
+	uint cascades;
+	double time_ms;
+};
+
+/**
+* Flag used to cancel a segmentation from another thread
+*/
+class CancellationToken
+{
+public:
+	CancellationToken() : cancelled_(false) {}
+
+	void Cancel() { cancelled_.store(true, memory_order_relaxed); }
+	void Reset() { cancelled_.store(false, memory_order_relaxed); }
+	bool IsCancelled() const { return cancelled_.load(memory_order_relaxed); }
+
+private:
+	atomic<bool> cancelled_;
+};
+
+
+//=============================================================================
+//								SegmentationLayer
+//=============================================================================
+/**
+* Layer that does ODLM inspired segmentation. Neurons are connected to their
+* immediate neighbors.
+*/
+class SegmentationLayer : public NeuralLayer
+{
+public:
+
+	/**
+	* Constructor
+	*/
+	SegmentationLayer(const cv::Mat& a_img);
+	SegmentationLayer(ImageData& a_img_data);
+
+	/**
+	* Destructor
+	*/
+	virtual ~SegmentationLayer();
+	   
+	/**
+	* Segments the layer until the network converges or until the number
+	* of cycles/cascades set in the params is reached
+	*/
+	virtual void SegmentLayer();
+
+	/**
+	* Simulates a single spike cascade. The segmentation state is kept in the
+	* layer, so the segmentation can be done a few cascades at a time and
+	* several layers can be interleaved in one thread. The first step starts
+	* a new segmentation. Returns false once the segmentation is done.
+	*/
+	bool Step();
+
+	/**
+	* Simulates up to a_nb_cascades cascades, returns false once the 
+	* segmentation is done
+	*/
+	bool RunCascades(uint a_nb_cascades);
+
+	/**
+	* Simulates cascades until a_nb_cycles more cycles are completed, 
+	* returns false once the segmentation is done
+	*/
+	bool RunCycles(uint a_nb_cycles);
+
+	/**
+	* Segments the layer until it converges, until the limits set in the 
+	* params are reached, until a_time_budget_ms milliseconds elapsed or
+	* until a_cancel is cancelled. The deadline and the token are checked
+	* between cascades. Returns the labels reached so far, optionally after
+	* clearing the small segments. A budget of 0 means no deadline.
+	*/
+	SegmentationResult SegmentWithDeadline(
+		double a_time_budget_ms, 
+		const CancellationToken* a_cancel = nullptr,
+		bool a_clear_small_segments = false);
+
+	/**
+	* Makes the next step start a new segmentation, for instance after the
+	* active regions or the input of the layer changed
+	*/
+	void RestartSegmentation() { seg_state_ = SEG_STATE_IDLE; }
+
+	/// Check if the segmentation stopped because the network converged
+	bool IsConverged() const { return converged_; }
+
+	/// Check if the segmentation is done, converged or not
+	bool IsSegmentationDone() const { return seg_state_ == SEG_STATE_DONE; }
+
+	/// Get the convergence measure after the last cascade, see 
+	/// GetCoefStabilization()
+	float GetConvergence() const { return stabilization_coef_; }
+
+	/**
+	* Initializes the layer from a segmented layer of the same image at a
+	* lower resolution, for coarse-to-fine segmentation. The labels, phases,
+	* potentials and spike timing of the neurons are upsampled from the 
+	* coarse layer and the simulation continues from the coarse layer time.
+	* The delta periods are reset so that the convergence is measured again
+	* at this resolution.
+	*/
+	void InitFromCoarseLayer(const SegmentationLayer& a_coarse);
+
+	/**
+	* Removes segments that are too small
+	*/
+	void CountSegments();
+
+	/**
+	* Removes segments that are too small
+	*/
+	void ClearSmallSegments();
+
+	/**
+	* Removes segments that are too small
+	*/
+	//cv::Mat GetSegmentsImg();
+	cv::Mat GetImg();
+
+	/**
+	* Enables or disables the precomputed weight planes. When enabled, the
+	* weights between each neuron and its eight neighbors are computed once,
+	* in one plane per relative position, instead of at every spike.
+	*/
+	void SetWeightPlanes(bool a_enable);
+
+	/**
+	* Get the memory used by the weight planes, in bytes
+	*/
+	size_t GetWeightPlanesMemory() const;
+
+	/**
+	* Get the labels of the neurons as a row-major image (CV_32S)
+	*/
+	cv::Mat GetLabels() const;
+	//-------------------------------------------------------------------------
+	// Writes the labels in the given image, only reallocated if it doesn't
+	// have the size of the layer
+	void GetLabels(cv::Mat& a_labels) const;
+
+	/// Get the number of super-neurons created by the last segmentation
+	uint GetNbSuperNeurons() { return n_super_neurons_; }
+
+public:
+
+	// List of segments
+	vector<Segment> segments;
+
+protected:
+
+	/**
+	* Calculates the weights between two neurons in the layer
+	*/
+	virtual float ComputeWeigth(float a_feat_diff);
+
+	/**
+	* Calculates the weights between two adjacent neurons based on their
+	* relative position.
+	*/
+	virtual float ComputeWeigth(int a_src_id, int a_dst_id, 
+								NeuronRelPos a_dst_pos) = 0;
+
+	/**
+	* Enables the weight planes depending on WEIGHT_PLANES_MODE. Must be 
+	* called by child classes once ComputeWeigth() can be called.
+	*/
+	void InitWeightPlanes();
+
+	/**
+	* Computes the weight planes left to WEIGHT_PLANES_AUTO once the layer
+	* spiked enough for them to pay off. Called after each cascade.
+	*/
+	void UpdateWeightPlanes();
+
+	/**
+	* Computes the weights between every neuron and its neighbor at the given
+	* relative position. Entries of neurons without such neighbor are left
+	* untouched.
+	*/
+	virtual void ComputeWeightPlane(NeuronRelPos a_dst_pos, float* a_plane);
+
+	/**
+	* Function called by FireNeurons() to propagate a spike to neighboring
+	* neurons on the same layer.
+	*/
+	void PropagateSpike(int a_id, int a_phase);
+
+	/**
+	* Copies the state of a neuron of another layer of the same image, except
+	* its maximal charge. The delta period is reset so that the convergence
+	* is measured again in this layer.
+	*/
+	void CopyNeuronState(const SegmentationLayer& a_src, uint a_src_id,
+						 uint a_id);
+
+	/**
+	* Get the index of the neuron of a coarse layer from which the neuron at
+	* the given position is initialized by InitFromCoarseLayer(). Default is
+	* the nearest coarse neuron.
+	*/
+	virtual uint GetCoarseNeuronId(const SegmentationLayer& a_coarse,
+								   int a_x, int a_y);
+
+	/**
+	* Propagate a spike to a neighboring neuron
+	*/
+	void Propagate(int a_src_id, int a_dst_id, NeuronRelPos a_dst_pos,
+				   int a_phase);
+
+	/**
+	* Propagate a label to a neuron and merge the segments if necessary. 
+	* Defined inline so that specialized layers can inline it.
+	*/
+	virtual void PropagateLabel(Neuron& a_n, int a_label, int a_phase)
+	{
+		uint id = GetNeuronId(a_n);
+
+		// Propagate the label to this neuron
+		a_n.label = a_label;
+		// Set the new phase
+		a_n.phase = a_phase;
+		// Set as part of a segment
+		is_segmented[id] = true;
+
+		// A neuron of a super-neuron may have left its segment
+		if (n_frozen_ > 0 && super_of_[id] >= 0)
+			detached_neurons_.push_back(id);
+	}
+
+	/**
+	* Merge two segments by giving the first segment's label to the second
+	* segment.
+	*/
+	void MergeSegments(int a_src_label, int a_dst_label, int a_phase);
+
+
+	void TriggerSameLabelNeurons(int a_id, int a_phase);
+
+	/**
+	* Collapses the stable segments into super-neurons. A segment is stable
+	* when all its neurons fired in the same cascade with an absolute delta
+	* period below COARSEN_DELTA_PERIOD, for COARSEN_CYCLES consecutive 
+	* cycles. Only the boundary neurons of a super-neuron and a representative
+	* neuron keep being simulated, the interior neurons are frozen and fire
+	* with the super-neuron.
+	*/
+	void CoarsenStableSegments();
+
+	/**
+	* Triggers the simulated neurons of the super-neuron of a firing neuron,
+	* since the whole segment fires together
+	*/
+	void TriggerSuperNeuron(int a_id, int a_phase);
+
+	/**
+	* Removes the neurons that got another label from their super-neuron.
+	* Their frozen neighbors become boundary neurons and are simulated again.
+	*/
+	void DetachNeurons();
+
+	/**
+	* Unfreezes an interior neuron of a super-neuron. The neuron gets the 
+	* state it would have had by firing with the super-neuron.
+	*/
+	void UnfreezeNeuron(uint a_super_id, uint a_id);
+
+	/**
+	* Restores the interior neurons of all the super-neurons and removes them
+	*/
+	void ExpandSuperNeurons();
+
+	/**
+	* Removes all the super-neurons, once no neuron is frozen anymore
+	*/
+	void ClearSuperNeurons();
+
+	/**
+	* Sets the state the interior neuron a_id of a super-neuron gets when it
+	* is unfrozen, except its cycle flag
+	*/
+	void GetUnfrozenState(uint a_super_id, uint a_id, Neuron& a_n) const;
+
+	/**
+	* Adds the segmentation state to a binary state. The super-neurons aren't
+	* part of the state, their interior neurons are saved as if the 
+	* super-neurons were expanded (see ExpandSuperNeurons()), so the layer 
+	* saved doesn't change and the restored layer has no super-neuron.
+	*/
+	virtual void WriteBinaryState(LayerStateWriter& a_writer) const;
+
+	/**
+	* Restores the segmentation state from a binary state
+	*/
+	virtual bool ReadBinaryState(const LayerStateView& a_state);
+
+	/**
+	* Check if the neuron at the given position is inside the interior of the
+	* layer, where all of its neighbors can be reached without checking the
+	* boundaries. As in PropagateSpike(), the interior excludes the last two
+	* columns and rows.
+	*/
+	inline bool IsInInterior(int a_x, int a_y) const
+	{
+		return (a_x > 0 &&
+				a_y > 0 &&
+				a_x < (int)width - 2 &&
+				a_y < (int)height - 2);
+	}
+
+	/**
+	* Get the index offsets of the neighbors of an interior neuron, indexed by
+	* relative position, or nullptr if the neighbors must be located with
+	* GetNeighborId(). With the tiled layout, the offsets depend on the 
+	* position of the neuron in its tile and are only constant when the 
+	* neighboring tiles are complete.
+	*/
+	inline const int* GetNeighborOffsets(int a_x, int a_y) const
+	{
+		if (NEURON_LAYOUT == LAYOUT_ROW_MAJOR) return pos_offset_;
+
+		if (!use_tile_offsets_ || a_x + 1 >= full_tiles_width_ ||
+			a_y + 1 >= full_tiles_height_) return nullptr;
+
+		return tile_offsets_[GetTileClass(a_x % TILE_SIZE) * 3 +
+							 GetTileClass(a_y % TILE_SIZE)];
+	}
+
+	/**
+	* Get the index of the neighbor of the neuron at the given position
+	*/
+	inline int GetNeighborId(int a_x, int a_y, NeuronRelPos a_dst_pos) const
+	{
+		return GetNeuronId(a_x + neighbor_pos_[a_dst_pos].x,
+						   a_y + neighbor_pos_[a_dst_pos].y);
+	}
+
+	/**
+	* Class of a coordinate within a tile: 0 on the first row or column of
+	* the tile, 2 on the last and 1 inside.
+	*/
+	inline int GetTileClass(uint a_tile_coord) const
+	{
+		return a_tile_coord == 0 ? 0 : (a_tile_coord == TILE_SIZE - 1 ? 2 : 1);
+	}
+
+	/**
+	* Computes the neighbor offsets of each tile class for the tiled layout
+	*/
+	void InitTileOffsets();
+
+	/**
+	* Initializes the state of a new step-wise segmentation
+	*/
+	void StartSegmentation();
+
+	/**
+	* Completes the layer state once the segmentation is done
+	*/
+	void EndSegmentation();
+
+protected:
+
+	// Lookup Table for index offset based on neurons relative positions
+	int pos_offset_[8];
+
+	// Neighbor offsets of the tiled layout for each of the 9 tile classes
+	// (horizontal class * 3 + vertical class), see GetNeighborOffsets()
+	int tile_offsets_[9][8];
+	bool use_tile_offsets_;
+	// Width and height of the part of the layer made of complete tiles
+	int full_tiles_width_;
+	int full_tiles_height_;
+
+	// Order in which a spike is propagated to the neighbors
+	static const NeuronRelPos PROPAGATION_ORDER[8];
+
+	// Position of the neighbor for each relative position
+	cv::Point neighbor_pos_[8];
+
+	// Flag indicating if the weights are read from the weight planes
+	bool use_weight_planes_;
+
+	// Precomputed weights, one plane of the layer size per relative position.
+	// The weight from neuron i to its neighbor at position p is at
+	// weight_planes_[p * size + i]. The weights are stored as float so that
+	// the segmentation is identical to computing them at every spike; Half
+	// (see Tools.h) would halve the memory but round the weights.
+	vector<float> weight_planes_;
+
+	// Number of spikes of the layer at which the weight planes are computed
+	// in WEIGHT_PLANES_AUTO mode, 0 if they aren't pending
+	unsigned long weight_planes_spikes_;
+
+	// Stable segment collapsed into a single unit
+	struct SuperNeuron
+	{
+		int label;
+		// Last cascade where the super-neuron fired
+		int phase;
+		// Neuron simulated in place of the interior neurons
+		uint representative;
+		// Simulated neurons, the boundary neurons and the representative
+		vector<uint> members;
+		// Frozen neurons
+		vector<uint> interior;
+		// Sum of the absolute delta period of the interior neurons
+		double delta_sum;
+	};
+
+	// Super-neurons, expanded ones have no interior neurons left
+	vector<SuperNeuron> super_neurons_;
+	// Super-neuron of each neuron, -1 if none. Empty until the first collapse
+	vector<int> super_of_;
+	// Neurons of super-neurons that got a new label during the cascade
+	vector<uint> detached_neurons_;
+	// Number of consecutive stable cycles of the segments, by label
+	unordered_map<int, uint> stable_cycles_;
+	// Number of super-neurons created by the last segmentation
+	uint n_super_neurons_;
+
+	// Step-wise segmentation state, see Step()
+	SegmentationState seg_state_;
+	// Number of consecutive stable cascades
+	uint stable_cascade_count_;
+	// Convergence measure after the last cascade
+	float stabilization_coef_;
+	// Flag indicating if the last segmentation converged
+	bool converged_;
+	// Cycle whose trace event is open, -1 if none
+	int traced_cycle_;
+
+
+	//-----------------------------------------------------------------------------
+	//							 Layer public parameters
+	//-----------------------------------------------------------------------------
+public:
+	uint MAX_SEG_CASCADES;
+	uint MAX_SEG_CYCLES;
+	uint MIN_SEGMENT_SIZE;
+
+	bool TRIGGER_SAME_LABEL_NEURONS;
+	bool MERGE_SEGMENTS;
+	float SEG_MERGE_TRESHOLD;
+
+	float WEIGHT_MAX_VALUE;
+	float WEIGHT_SLOPE;
+	float WEIGHT_OFFSET;
+
+	// Precomputed weight planes mode, see WeightPlanesMode
+	uint WEIGHT_PLANES_MODE;
+	// Maximal memory of the weight planes when automatically enabled
+	float WEIGHT_PLANES_MAX_MB;
+
+	// Stable segments coarsening, see CoarsenStableSegments()
+	bool COARSEN_SEGMENTS;
+	float COARSEN_DELTA_PERIOD;
+	uint COARSEN_CYCLES;
+
+};
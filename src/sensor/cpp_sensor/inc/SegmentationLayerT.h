@@ -0,0 +1,385 @@
+/**
+* @file SegmentationLayerT.h
+*
+* Compile-time specialized segmentation layers. The feature type, the weight
+* function and the segmentation flags are template parameters so that the
+* whole spike propagation is resolved at compile time and can be inlined,
+* instead of going through the virtual ComputeWeigth() and PropagateLabel()
+* for every neighbor of every spike.
+*
+* @authors Vincent de Ladurantaye
+*/
+#pragma once
+
+#include "PixelLayer.h"
+#include "LayerState.h"
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+
+//=============================================================================
+//								 Feature policies
+//=============================================================================
+/**
+* Gray pixel value feature, used with PixelLayer.
+*/
+struct PixelFeature
+{
+	// Layer holding the features
+	typedef PixelLayer LayerType;
+
+	/**
+	* Absolute difference between the features of two neurons
+	*/
+	static inline float Diff(const LayerType& a_layer, int a_src_id,
+							 int a_dst_id)
+	{
+		return abs(a_layer.pixel_data[a_src_id] - a_layer.pixel_data[a_dst_id]);
+	}
+};
+
+
+//=============================================================================
+//								 Weight policies
+//=============================================================================
+/**
+* Decreasing sigmoid of the feature difference, same as
+* SegmentationLayer::ComputeWeigth(float).
+*/
+struct SigmoidWeight
+{
+	static inline float Compute(const SegmentationLayer& a_layer,
+								float a_feat_delta)
+	{
+		float deltaCoef = 1 - 1 / (1 + exp(-a_layer.WEIGHT_SLOPE *
+			(abs(a_feat_delta) - a_layer.WEIGHT_OFFSET)));
+		return a_layer.WEIGHT_MAX_VALUE * deltaCoef;
+	}
+};
+
+
+//=============================================================================
+//								  Size policies
+//=============================================================================
+/**
+* Layer size known at run time, any neuron layout
+*/
+struct DynamicSize
+{
+	static const bool FIXED = false;
+	static const uint WIDTH = 0;
+	static const uint HEIGHT = 0;
+};
+
+/**
+* Layer size known at compile time, row-major layout only. The neighbor 
+* offsets and the layer boundaries become constants.
+*/
+template <uint W, uint H>
+struct FixedSize
+{
+	static const bool FIXED = true;
+	static const uint WIDTH = W;
+	static const uint HEIGHT = H;
+};
+
+
+//=============================================================================
+//								SegmentationLayerT
+//=============================================================================
+/**
+* Segmentation layer specialized at compile time.
+*
+* The TRIGGER_SAME_LABEL and MERGE parameters replace the
+* TRIGGER_SAME_LABEL_NEURONS and MERGE_SEGMENTS members of the layer, which
+* are ignored by this class. Use CreatePixelLayer() to get the instantiation
+* matching the configuration.
+*
+* With a FixedSize policy, the layer must have the given size and the 
+* row-major neuron layout, otherwise the constructor throws 
+* std::invalid_argument. CreatePixelLayer() only creates fixed size layers
+* for the images of their size.
+*/
+template <class Feature, class Weight, bool TRIGGER_SAME_LABEL, bool MERGE,
+		  class Size = DynamicSize>
+class SegmentationLayerT : public Feature::LayerType
+{
+public:
+	typedef typename Feature::LayerType Base;
+
+	/**
+	* Constructor
+	*/
+	SegmentationLayerT(ImageData& a_img_data,
+					   bool a_random_init = Config::PIXEL_RANDOM_INIT) :
+		Base(a_img_data, a_random_init)
+	{
+		this->TRIGGER_SAME_LABEL_NEURONS = TRIGGER_SAME_LABEL;
+		this->MERGE_SEGMENTS = MERGE;
+
+		if (Size::FIXED && (this->width != Size::WIDTH ||
+							this->height != Size::HEIGHT ||
+							this->NEURON_LAYOUT != LAYOUT_ROW_MAJOR))
+		{
+			throw std::invalid_argument("Fixed size layer created for a " +
+				std::to_string(this->width) + "x" + 
+				std::to_string(this->height) + " image or a tiled layout");
+		}
+	}
+
+	/**
+	* Get the class of the layer
+	*/
+	PixelLayerClass GetLayerClass() const
+	{
+		return Size::FIXED ? PIXEL_LAYER_FIXED_SIZE : PIXEL_LAYER_SPECIALIZED;
+	}
+
+protected:
+
+	/**
+	* Restores a binary state, which must have the segmentation flags of the
+	* instantiation since the flags of the state can't change the class
+	*/
+	bool ReadBinaryState(const LayerStateView& a_state)
+	{
+		const SegmentationLayerState* state =
+			a_state.GetStruct<SegmentationLayerState>(STATE_SEGMENTATION);
+		if (state && ((state->trigger_same_label_neurons != 0) != 
+					  TRIGGER_SAME_LABEL || 
+					  (state->merge_segments != 0) != MERGE))
+		{
+			cerr << "Layer state has other segmentation flags than the "
+				"specialized layer\n";
+			return false;
+		}
+
+		return Base::ReadBinaryState(a_state);
+	}
+
+	/**
+	* Calculates the weights between two adjacent neurons using the policies
+	*/
+	float ComputeWeigth(int a_src_id, int a_dst_id,
+						NeuronRelPos a_dst_pos) final
+	{
+		return Weight::Compute(*this, Feature::Diff(*this, a_src_id, a_dst_id));
+	}
+
+	/**
+	* Propagates the spike to the neighbors, with all the calls resolved at
+	* compile time. Same boundaries as SegmentationLayer::PropagateSpike().
+	*/
+	void PropagateSpike(int a_id, int a_phase) final
+	{
+		if (Size::FIXED)
+		{
+			PropagateSpikeFixed(a_id, a_phase);
+		}
+		else
+		{
+			PropagateSpikeDynamic(a_id, a_phase);
+		}
+
+		if (TRIGGER_SAME_LABEL) this->TriggerSameLabelNeurons(a_id, a_phase);
+
+		if (this->n_frozen_ > 0) this->TriggerSuperNeuron(a_id, a_phase);
+	}
+
+	/**
+	* Propagates the spike to the neighbors of a layer of any size and 
+	* layout
+	*/
+	inline void PropagateSpikeDynamic(int a_id, int a_phase)
+	{
+		cv::Point pos = this->GetNeuronPos(a_id);
+		int neuronRow = pos.y;
+		int neuronCol = pos.x;
+
+		// Interior neurons propagate to all neighbors without checks
+		const int* offsets = this->IsInInterior(neuronCol, neuronRow) ?
+			this->GetNeighborOffsets(neuronCol, neuronRow) : nullptr;
+
+		if (offsets)
+		{
+			Propagate<N_UP_L>(a_id, a_id + offsets[N_UP_L], a_phase);
+			Propagate<N_UP>(a_id, a_id + offsets[N_UP], a_phase);
+			Propagate<N_UP_R>(a_id, a_id + offsets[N_UP_R], a_phase);
+			Propagate<N_LEFT>(a_id, a_id + offsets[N_LEFT], a_phase);
+			Propagate<N_RIGHT>(a_id, a_id + offsets[N_RIGHT], a_phase);
+			Propagate<N_DOWN_L>(a_id, a_id + offsets[N_DOWN_L], a_phase);
+			Propagate<N_DOWN>(a_id, a_id + offsets[N_DOWN], a_phase);
+			Propagate<N_DOWN_R>(a_id, a_id + offsets[N_DOWN_R], a_phase);
+		}
+		else
+		{
+			int lastCol = (int)this->width - 2;
+			int lastRow = (int)this->height - 2;
+
+			if (neuronRow > 0 && neuronCol > 0)
+				PropagateChecked<N_UP_L>(a_id, neuronCol, neuronRow, a_phase);
+			if (neuronRow > 0)
+				PropagateChecked<N_UP>(a_id, neuronCol, neuronRow, a_phase);
+			if (neuronRow > 0 && neuronCol < lastCol)
+				PropagateChecked<N_UP_R>(a_id, neuronCol, neuronRow, a_phase);
+			if (neuronCol > 0)
+				PropagateChecked<N_LEFT>(a_id, neuronCol, neuronRow, a_phase);
+			if (neuronCol < lastCol)
+				PropagateChecked<N_RIGHT>(a_id, neuronCol, neuronRow, a_phase);
+			if (neuronRow < lastRow && neuronCol > 0)
+				PropagateChecked<N_DOWN_L>(a_id, neuronCol, neuronRow, a_phase);
+			if (neuronRow < lastRow)
+				PropagateChecked<N_DOWN>(a_id, neuronCol, neuronRow, a_phase);
+			if (neuronRow < lastRow && neuronCol < lastCol)
+				PropagateChecked<N_DOWN_R>(a_id, neuronCol, neuronRow, a_phase);
+		}
+	}
+
+	/**
+	* Propagates the spike to the neighbors of a row-major layer of the size
+	* of the policy. The position, the boundaries and the neighbor offsets
+	* are computed from constants.
+	*/
+	inline void PropagateSpikeFixed(int a_id, int a_phase)
+	{
+		const int W = Size::WIDTH;
+		const int H = Size::HEIGHT;
+
+		int neuronRow = a_id / W;
+		int neuronCol = a_id - neuronRow * W;
+
+		if (neuronCol > 0 && neuronRow > 0 && 
+			neuronCol < W - 2 && neuronRow < H - 2)
+		{
+			Propagate<N_UP_L>(a_id, a_id - W - 1, a_phase);
+			Propagate<N_UP>(a_id, a_id - W, a_phase);
+			Propagate<N_UP_R>(a_id, a_id - W + 1, a_phase);
+			Propagate<N_LEFT>(a_id, a_id - 1, a_phase);
+			Propagate<N_RIGHT>(a_id, a_id + 1, a_phase);
+			Propagate<N_DOWN_L>(a_id, a_id + W - 1, a_phase);
+			Propagate<N_DOWN>(a_id, a_id + W, a_phase);
+			Propagate<N_DOWN_R>(a_id, a_id + W + 1, a_phase);
+		}
+		else
+		{
+			// Same boundaries as PropagateSpikeDynamic()
+			const int lastCol = W - 2;
+			const int lastRow = H - 2;
+
+			if (neuronRow > 0 && neuronCol > 0)
+				Propagate<N_UP_L>(a_id, a_id - W - 1, a_phase);
+			if (neuronRow > 0)
+				Propagate<N_UP>(a_id, a_id - W, a_phase);
+			if (neuronRow > 0 && neuronCol < lastCol)
+				Propagate<N_UP_R>(a_id, a_id - W + 1, a_phase);
+			if (neuronCol > 0)
+				Propagate<N_LEFT>(a_id, a_id - 1, a_phase);
+			if (neuronCol < lastCol)
+				Propagate<N_RIGHT>(a_id, a_id + 1, a_phase);
+			if (neuronRow < lastRow && neuronCol > 0)
+				Propagate<N_DOWN_L>(a_id, a_id + W - 1, a_phase);
+			if (neuronRow < lastRow)
+				Propagate<N_DOWN>(a_id, a_id + W, a_phase);
+			if (neuronRow < lastRow && neuronCol < lastCol)
+				Propagate<N_DOWN_R>(a_id, a_id + W + 1, a_phase);
+		}
+	}
+
+	/**
+	* Propagate a spike to a neighboring neuron located from its position
+	*/
+	template <NeuronRelPos DST_POS>
+	inline void PropagateChecked(int a_src_id, int a_x, int a_y, int a_phase)
+	{
+		Propagate<DST_POS>(a_src_id, this->GetNeighborId(a_x, a_y, DST_POS),
+						   a_phase);
+	}
+
+	/**
+	* Propagate a spike to a neighboring neuron
+	*/
+	template <NeuronRelPos DST_POS>
+	inline void Propagate(int a_src_id, int a_dst_id, int a_phase)
+	{
+		if (!this->excluded_.empty() && this->excluded_[a_dst_id]) return;
+
+		Neuron& n1 = this->neurons[a_src_id];
+		Neuron& n2 = this->neurons[a_dst_id];
+
+		if (TRIGGER_SAME_LABEL && n1.label == n2.label) return;
+
+		// The plane size is a constant for the fixed size layers
+		const uint planeSize = Size::FIXED ? 
+			Size::WIDTH * Size::HEIGHT : this->size;
+
+		float w = this->use_weight_planes_ ?
+			this->weight_planes_[DST_POS * planeSize + a_src_id] :
+			Weight::Compute(*this, Feature::Diff(*this, a_src_id, a_dst_id));
+		n2.pot += w;
+
+		if (n2.pot < this->POT_THRESHOLD) return;
+
+		if (n1.label == n2.label) return;
+
+		if (MERGE && this->is_segmented[a_dst_id] && w > this->SEG_MERGE_TRESHOLD)
+			this->MergeSegments(n1.label, n2.label, a_phase);
+
+		SegmentationLayer::PropagateLabel(n2, n1.label, a_phase);
+	}
+};
+
+
+//=============================================================================
+//								 FixedPixelLayer
+//=============================================================================
+/**
+* Pixel layer of a size known at compile time, for the inputs of fixed size
+* (see Config::FIXED_INPUT_IMGS_SIZE)
+*
+* Only the spike propagation uses the compile-time size. The neurons stay in
+* the vectors of the layer, allocated once per layer like for the other
+* layers, as the allocation is negligible next to the segmentation. The
+* segmentation of a 64x128 or 48x128 image is only a few percent faster than
+* with the specialized layer of any size (see BM_SegmentFixedSize).
+*/
+template <uint W, uint H, bool TRIGGER_SAME_LABEL = false, bool MERGE = false>
+using FixedPixelLayer = SegmentationLayerT<PixelFeature, SigmoidWeight, 
+										   TRIGGER_SAME_LABEL, MERGE,
+										   FixedSize<W, H> >;
+
+
+//=============================================================================
+//								   Dispatcher
+//=============================================================================
+/**
+* Creates the specialized pixel layer corresponding to the
+* SEG_TRIGGER_SAME_LABEL_NEURONS and SEG_MERGE_SEGMENTS configuration.
+* When FIXED_INPUT_IMGS_SIZE is set and the image has one of the fixed 
+* sizes instantiated (64x128 and 48x128), a FixedPixelLayer is created.
+*/
+unique_ptr<PixelLayer> CreatePixelLayer(
+	ImageData& a_img_data,
+	bool a_random_init = Config::PIXEL_RANDOM_INIT);
+unique_ptr<PixelLayer> CreatePixelLayer(
+	const string& a_img_file,
+	bool a_random_init = Config::PIXEL_RANDOM_INIT);
+//-----------------------------------------------------------------------------
+// With the given segmentation flags. The fixed size layers are only created
+// if a_fixed_size is set, with the conditions above.
+unique_ptr<PixelLayer> CreatePixelLayer(
+	ImageData& a_img_data,
+	bool a_random_init,
+	bool a_trigger_same_label,
+	bool a_merge,
+	bool a_fixed_size);
+
+/**
+* Creates the pixel layer saved in a binary state, of the same class, and
+* restores its state. The layer is created from the image saved in the 
+* state. Fixed size layers are created as dynamic size layers when the
+* configured neuron layout isn't row-major. Returns nullptr, with a message on
+* cerr, if the state can't be loaded.
+*/
+unique_ptr<PixelLayer> CreatePixelLayer(const LayerStateView& a_state);
@@ -0,0 +1,76 @@
+/**
+* @file SyntheticImage.h
+*
+* @authors Vincent de Ladurantaye
+*/
+#pragma once
+
+#include <opencv2/core/core.hpp>
+
+#include "Config.h"
+
+
+/**
+* Parameters of a synthetic image
+*/
+struct SyntheticImageParams
+{
+	SyntheticImageParams() :
+		width(256),
+		height(256),
+		nb_regions(64),
+		size_skew(0.0f),
+		noise(0.0f),
+		gradient(0.0f),
+		seed(0)
+	{
+	}
+
+	// Size of the image
+	int width;
+	int height;
+	// Number of regions, at most one per pixel
+	uint nb_regions;
+	// Unevenness of the sizes of the regions, from 0 for regions of about
+	// the same size to 1 for a heavy tailed distribution of many small
+	// regions and a few large ones
+	float size_skew;
+	// Standard deviation of the approximately gaussian noise added to the
+	// pixels, in gray levels
+	float noise;
+	// Change of gray level across each region along a random direction, 0
+	// for uniform regions
+	float gradient;
+	// Seed of the random numbers, the same seed gives the same image
+	uint seed;
+};
+
+
+//=============================================================================
+//								 SyntheticImage
+//=============================================================================
+/**
+* Generates a gray image of rectangular regions with controlled count, size
+* distribution, noise and gradients, for measuring how the cost of the
+* segmentation scales with the workload.
+*
+* The image is partitioned by splitting the regions in two until there are
+* nb_regions of them: the largest region is split, or with a probability of
+* size_skew a random one, which makes the sizes more uneven as small regions
+* get split further. Each region gets a random gray level, so neighbor
+* regions can have close levels and be segmented together.
+*
+* The random numbers are computed from the raw output of std::mt19937, which
+* is standardized, rather than with the standard distributions, which are
+* implementation defined. The noise and the gradients only use exact 
+* operations and sqrt() rather than the math library, so the images are the
+* same on every platform with IEEE 754 arithmetic done in the precision of
+* the types, without fused multiply-adds.
+*
+* @param a_params Parameters of the image
+* @param a_regions If not null, receives the index of the region of each
+*	pixel, CV_32S
+* @return The image, CV_8U
+*/
+cv::Mat GenerateSyntheticImage(const SyntheticImageParams& a_params,
+							   cv::Mat* a_regions = nullptr);
@@ -1,51 +1,129 @@
-/** @file Tools.h
- * This file contains different utility functions and structures as well
- * as generic include lines.
- *
- *  @author Vincent de Ladurantaye
- */
-#pragma once
-
-#include <vector>
-#include <list>
-#include <memory>
-using namespace std;
-
-#include "opencv2/core/core.hpp"
-#include "opencv2/imgproc/imgproc.hpp"
-#include "opencv2/highgui/highgui.hpp"
-#include "opencv2/features2d/features2d.hpp"
-using cv::Mat;
-//using namespace cv;
-
-#include "Config.h"
-
-
-
-//=============================================================================
-//								Generic Functions
-//=============================================================================
-/**
-* Display an image. Used to display images with standardised config.
-*/
-static void DisplayImage(const string& a_title, const Mat& a_image)
-{
-	//namedWindow(title, CV_WINDOW_NORMAL|CV_WINDOW_KEEPRATIO);
-	cv::namedWindow(a_title, CV_GUI_EXPANDED | CV_WINDOW_KEEPRATIO);
-
-	// If a window of the same name was previously used, resize the 
-	// window to this new image's dimensions
-	cv::resizeWindow(a_title, a_image.cols, a_image.rows);
-
-	// Display the image
-	cv::imshow(a_title, a_image);
-
-	// Allow the program to display right away
-	cv::waitKey(1);
-}
-
-//inline string FromWorkingDir(const string& a_file)
-//{
-//	if (Config::WORKING_DIR == "") return a_file;
-//	return Config::WORKING_DIR + '/' + a_file;
-//}
+/** @file Tools.h
+ * This file contains different utility functions and structures as well
+ * as generic include lines.
+ *
+ *  @author Vincent de Ladurantaye
+ */
+#pragma once
+
+#include <vector>
+#include <list>
+#include <memory>
+#include <cstring>
+using namespace std;
+
+#include "opencv2/core/core.hpp"
+#include "opencv2/imgproc/imgproc.hpp"
+#include "opencv2/highgui/highgui.hpp"
+#include "opencv2/features2d/features2d.hpp"
+using cv::Mat;
+//using namespace cv;
+
+#include "Config.h"
+
+
+
+//=============================================================================
+//								 Half precision
+//=============================================================================
+/**
+* IEEE 754 half precision float (1 sign, 5 exponent and 10 mantissa bits), 
+* used to store values that don't need full precision. Converts implicitly
+* to and from float, values are rounded to the nearest half.
+*/
+struct Half
+{
+	unsigned short bits;
+
+	Half() : bits(0) {}
+	Half(float a_val) : bits(FromFloat(a_val)) {}
+
+	operator float() const { return ToFloat(bits); }
+
+	static unsigned short FromFloat(float a_val)
+	{
+		unsigned int f;
+		memcpy(&f, &a_val, sizeof(f));
+
+		unsigned int sign = (f >> 16) & 0x8000;
+		int exponent = ((f >> 23) & 0xff) - 127 + 15;
+		unsigned int mantissa = f & 0x7fffff;
+
+		// Infinity or value too large, saturate to infinity
+		if (exponent >= 31) return sign | 0x7c00;
+
+		// Value too small for a normal half, make it a subnormal
+		if (exponent <= 0)
+		{
+			if (exponent < -10) return sign;
+			mantissa |= 0x800000;
+			int shift = 14 - exponent;
+			unsigned int half = mantissa >> shift;
+			// Round to nearest
+			if ((mantissa >> (shift - 1)) & 1) ++half;
+			return sign | half;
+		}
+
+		unsigned int half = sign | (exponent << 10) | (mantissa >> 13);
+		// Round to nearest, a carry in the exponent is still correct
+		if (mantissa & 0x1000) ++half;
+		return half;
+	}
+
+	static float ToFloat(unsigned short a_bits)
+	{
+		unsigned int sign = (a_bits & 0x8000) << 16;
+		int exponent = (a_bits >> 10) & 0x1f;
+		unsigned int mantissa = a_bits & 0x3ff;
+		unsigned int f;
+
+		if (exponent == 0)
+		{
+			// Zero or subnormal, value is mantissa * 2^-24
+			float val = mantissa / 16777216.0f;
+			return sign ? -val : val;
+		}
+		else if (exponent == 31)
+		{
+			// Infinity or NaN
+			f = sign | 0x7f800000 | (mantissa << 13);
+		}
+		else
+		{
+			f = sign | ((exponent - 15 + 127) << 23) | (mantissa << 13);
+		}
+
+		float val;
+		memcpy(&val, &f, sizeof(val));
+		return val;
+	}
+};
+
+
+//=============================================================================
+//								Generic Functions
+//=============================================================================
+/**
+* Display an image. Used to display images with standardised config.
+*/
+static void DisplayImage(const string& a_title, const Mat& a_image)
+{
+	//namedWindow(title, CV_WINDOW_NORMAL|CV_WINDOW_KEEPRATIO);
+	cv::namedWindow(a_title, CV_GUI_EXPANDED | CV_WINDOW_KEEPRATIO);
+
+	// If a window of the same name was previously used, resize the 
+	// window to this new image's dimensions
+	cv::resizeWindow(a_title, a_image.cols, a_image.rows);
+
+	// Display the image
+	cv::imshow(a_title, a_image);
+
+	// Allow the program to display right away
+	cv::waitKey(1);
+}
+
+//inline string FromWorkingDir(const string& a_file)
+//{
+//	if (Config::WORKING_DIR == "") return a_file;
+//	return Config::WORKING_DIR + '/' + a_file;
+//}
@@ -0,0 +1,220 @@
+/**
+* @file VideoPipeline.h
+*
+* @authors Vincent de Ladurantaye
+*/
+#pragma once
+
+#include "LayerRenderer.h"
+#include "RingBuffer.h"
+#include "VideoSegmenter.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <mutex>
+
+
+/**
+* Throughput and backpressure metrics of the video pipeline. The blocked
+* times are spent waiting for room in the next queue or for a free frame
+* buffer, meaning the following stages are too slow. The idle times are
+* spent waiting for frames from the previous stage, or by the workers for 
+* the previous frame of the stream to be segmented.
+*/
+struct VideoPipelineStats
+{
+	// Number of frames through each stage
+	uint frames_decoded;
+	uint frames_segmented;
+	uint frames_written;
+
+	// Wall time of the run and frames written per second
+	double time_ms;
+	double throughput_fps;
+
+	// Decode stage
+	double decode_blocked_ms;
+	// Segmentation stage, summed over the workers
+	double segment_blocked_ms;
+	double segment_idle_ms;
+	// Output stage
+	double write_idle_ms;
+
+	// Highest number of frames waiting in each queue
+	uint decoded_queue_max;
+	uint segmented_queue_max;
+};
+
+
+//=============================================================================
+//								 VideoPipeline
+//=============================================================================
+/**
+* Segments a video stream in three stages running concurrently: a decode
+* thread, a pool of segmentation workers and an output thread. The stages
+* are connected by bounded queues, on which the threads sleep while there is
+* nothing to do. The frames are decoded in buffers taken from a fixed pool
+* and their labels are written in buffers of a matching pool, both given back
+* once the frame is written, and the segmenters reuse their layer from frame
+* to frame (see VideoSegmenter), so no image or layer is allocated per frame
+* once the stream started.
+*
+* Each frame is warm-started from the previous frame of the stream, so the
+* frames are segmented one after the other by the segmenter of the stream:
+* the workers format their frames concurrently, then take turns in the order
+* of the stream. When the segmenter neither warm-starts nor re-segments the
+* changed areas only, the frames are independent and the workers segment
+* them concurrently. The output thread puts the frames back in order.
+*/
+class VideoPipeline
+{
+public:
+
+	// Function receiving the segmented frames, in order
+	typedef function<void(uint a_frame, const cv::Mat& a_image,
+						  const cv::Mat& a_labels)> OutputCallback;
+	// Function reading the next frame in the given buffer, returns false
+	// when there is no frame left
+	typedef function<bool(cv::Mat& a_frame)> FrameSource;
+
+	/**
+	* Constructor
+	*/
+	VideoPipeline();
+
+	/**
+	* Sets a video file as the source of the frames
+	*/
+	void SetVideoSource(const string& a_video_file);
+
+	/**
+	* Sets a function as the source of the frames, such as a camera
+	*/
+	void SetFrameSource(FrameSource a_source);
+
+	/**
+	* Sets the function receiving the segmented frames, called from the 
+	* output thread
+	*/
+	void SetOutputCallback(OutputCallback a_callback);
+
+	/**
+	* Writes the segments of the frames, in false colors, to a video file
+	*/
+	void SetOutputFile(const string& a_video_file, double a_fps);
+
+	/**
+	* Runs the pipeline until all the frames of the source are written and
+	* returns its metrics
+	*/
+	VideoPipelineStats Run();
+
+	/// Get the metrics of the last run
+	const VideoPipelineStats& GetStats() const { return stats_; }
+
+	/// Get the segmenter of the stream, to change its parameters before Run()
+	VideoSegmenter& GetSegmenter() { return segmenter_; }
+
+protected:
+
+	// Frame going through the pipeline
+	struct FrameJob
+	{
+		// Index of the frame in the stream
+		uint index;
+		// Pool buffers holding the frame and its labels
+		uint buffer_id;
+	};
+
+	/**
+	* Decode stage, reads the frames in free buffers
+	*/
+	void DecodeStage();
+
+	/**
+	* Segmentation stage, run by each worker
+	*/
+	void SegmentStage();
+
+	/**
+	* Check if the frames depend on the previous frame of the stream
+	*/
+	bool IsStreamOrdered() const;
+
+	/**
+	* Output stage, gives the frames in order to the output and recycles 
+	* their buffers
+	*/
+	void WriteStage();
+
+	/**
+	* Writes the labels in false colors to the output video
+	*/
+	void WriteLabels(const cv::Mat& a_labels);
+
+	/**
+	* Records the highest size of a queue
+	*/
+	static void UpdateMax(atomic<uint>& a_max, size_t a_size);
+
+protected:
+
+	// Source of the frames
+	FrameSource frame_source_;
+	cv::VideoCapture video_capture_;
+
+	// Output of the frames
+	OutputCallback output_callback_;
+	cv::VideoWriter video_writer_;
+	string output_file_;
+	double output_fps_;
+
+	// Colors of the labels and output image, reused for each frame
+	LayerRenderer renderer_;
+	cv::Mat display_;
+
+	// Frame and label buffers, and indices of the free ones
+	vector<cv::Mat> frame_buffers_;
+	vector<cv::Mat> label_buffers_;
+	unique_ptr<BlockingRingBuffer<uint> > free_buffers_;
+
+	// Queues between the stages
+	unique_ptr<BlockingRingBuffer<FrameJob> > decoded_queue_;
+	unique_ptr<BlockingRingBuffer<FrameJob> > segmented_queue_;
+
+	// Number of workers still running, the last one closes the queue of the 
+	// segmented frames
+	atomic<uint> n_running_workers_;
+
+	// Segmenter of the stream and index of the next frame it segments, 
+	// guarded by the mutex
+	VideoSegmenter segmenter_;
+	uint next_segment_;
+	mutex segment_mutex_;
+	condition_variable segment_turn_;
+
+	// Metrics, the times are in nanoseconds while running
+	atomic<uint> n_decoded_;
+	atomic<uint> n_segmented_;
+	atomic<uint> n_written_;
+	atomic<long long> decode_blocked_ns_;
+	atomic<long long> segment_blocked_ns_;
+	atomic<long long> segment_idle_ns_;
+	atomic<long long> write_idle_ns_;
+	atomic<uint> decoded_queue_max_;
+	atomic<uint> segmented_queue_max_;
+
+	VideoPipelineStats stats_;
+
+
+//-----------------------------------------------------------------------------
+//							Configuration Parameters
+//-----------------------------------------------------------------------------
+public:
+
+	uint NB_WORKERS;
+	uint QUEUE_SIZE;
+
+};
@@ -0,0 +1,142 @@
+/**
+* @file VideoSegmenter.h
+*
+* @authors Vincent de Ladurantaye
+*/
+#pragma once
+
+#include "PixelLayer.h"
+
+
+/**
+* Statistics of the segmentation of one video frame
+*/
+struct VideoFrameStats
+{
+	// Index of the frame, from the start of the stream
+	uint frame;
+	// Number of neurons initialized from the previous frame
+	uint warm_neurons;
+	// Number of neurons simulated, less than the frame size when only the
+	// changed areas are segmented again
+	uint active_neurons;
+	// Number of cycles, cascades and spikes simulated for this frame
+	uint cycles;
+	uint cascades;
+	unsigned long spikes;
+	// Wall time of the frame, including the loading of the layer, in ms
+	double time_ms;
+};
+
+
+//=============================================================================
+//								VideoSegmenter
+//=============================================================================
+/**
+* Segments the frames of a video stream one after the other. The layer of 
+* the first frame is reused for the next frames of the same size: each frame
+* is loaded in it and the neurons whose pixel changed little keep their 
+* state (see PixelLayer::LoadFrame()), so the simulation only runs until the
+* changed areas converge again and the labels of the static areas are kept 
+* from frame to frame.
+*
+* With partial re-segmentation, only the tiles that changed since the 
+* previous frame, or the dirty rectangles given by the caller, are simulated
+* (see NeuralLayer::SetActiveRegions()). The labels are kept as they are
+* everywhere else.
+*/
+class VideoSegmenter
+{
+public:
+
+	/**
+	* Constructor
+	*/
+	VideoSegmenter();
+
+	/**
+	* Opens a video file, the frames are then read by SegmentNextFrame()
+	*/
+	void SetVideoSource(const string& a_video_file);
+
+	/**
+	* Reads and segments the next frame of the video source. Returns false
+	* when there is no frame left.
+	*/
+	bool SegmentNextFrame();
+
+	/**
+	* Segments a frame given by the caller, as the next frame of the stream
+	*/
+	void SegmentFrame(const cv::Mat& a_frame);
+	void SegmentFrame(ImageData& a_frame_data);
+
+	/**
+	* Segments a frame given by the caller where only the given rectangles
+	* changed since the previous frame. Only the rectangles, grown by the
+	* change margin, are segmented again.
+	*/
+	void SegmentFrame(const cv::Mat& a_frame,
+					  const vector<cv::Rect>& a_dirty_rects);
+
+	/**
+	* Forgets the previous frame so that the next frame is segmented from
+	* scratch, for instance after a scene change. The layer is kept and
+	* reloaded by the next frame.
+	*/
+	void Reset();
+
+	/// Get the segmented layer of the last frame, null before the first frame
+	PixelLayer* GetLayer() const { return layer_.get(); }
+	/// Get the statistics of the last frame
+	const VideoFrameStats& GetFrameStats() const { return frame_stats_; }
+	/// Get the number of frames segmented since the stream started
+	uint GetNbFrames() const { return n_frames_; }
+
+protected:
+
+	/**
+	* Segments a frame, restricted to the given dirty rectangles if any
+	*/
+	void SegmentFrame(ImageData& a_frame_data,
+					  const vector<cv::Rect>* a_dirty_rects);
+
+protected:
+
+	// Video source and current frame
+	ImageData video_data_;
+	// Indicates if the current frame of the video source was segmented
+	bool frame_segmented_;
+
+	// Segmented layer of the last frame, reused for the next frame
+	unique_ptr<PixelLayer> layer_;
+
+	// Statistics of the last frame
+	VideoFrameStats frame_stats_;
+
+	// Number of frames segmented
+	uint n_frames_;
+
+	// Indicates if the next frame is segmented from scratch, see Reset()
+	bool from_scratch_;
+	// MAX_SEG_CASCADES of the layer for one frame
+	uint max_seg_cascades_;
+
+
+//-----------------------------------------------------------------------------
+//							Configuration Parameters
+//-----------------------------------------------------------------------------
+public:
+
+	// Maximal gray level change of a pixel for its neuron to be initialized
+	// from the previous frame, -1 to segment each frame from scratch
+	int WARM_START_DELTA;
+
+	// Only segment again the tiles that changed
+	bool PARTIAL_RESEGMENTATION;
+	// Side of the tiles compared between frames
+	uint CHANGE_TILE_SIZE;
+	// Margin added around the changed tiles and the dirty rectangles
+	uint CHANGE_MARGIN;
+
+};
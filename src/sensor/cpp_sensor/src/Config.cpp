@@ -1,211 +1,335 @@
-/** @file Config.cpp
- *
- *  @author Vincent de Ladurantaye
- */
-
-#include <iostream>
-#include <cstring>
-
-#include <boost/property_tree/ini_parser.hpp>
-//#include <boost/property_tree/json_parser.hpp>
-
-#include "Config.h"
-
-
-string Config::WORKING_DIR = "";
-
-float Config::POT_THRESHOLD = 1.0f;
-float Config::TAU = 1.0f;
-float Config::GLOBAL_INHIB_VAL = 0.002f;
-float Config::CHARGING_LEADER = 1.01f;
-float Config::CHARGING_FOLLOWER = 0.5f;
-
-float Config::SEG_WEIGHT_MAX = 0.01f;
-float Config::SEG_WEIGHT_SLOPE = 1.2f;
-float Config::SEG_WEIGHT_OFFSET = 0.0f;
-
-float Config::MATCHING_WEIGHT_MAX = 1.0f;
-float Config::MATCHING_WEIGHT_SLOPE = 1.0f;
-float Config::MATCHING_WEIGHT_OFFSET = 10.0f;
-
-uint Config::SEG_MAX_CASCADES = 0;
-uint Config::SEG_MAX_CYCLES = 50;
-
-bool Config::SEG_TRIGGER_SAME_LABEL_NEURONS = false;
-bool Config::SEG_MERGE_SEGMENTS = false;
-float Config::SEG_MERGE_DELTA = 2.0f;
-
-uint Config::MIN_SEGMENT_SIZE = 80;
-
-bool Config::RESIZE_IMG_KEEP_RATIO = false;
-uint Config::KEEP_RATIO_LONGEST_IMG_SIDE = 150;
-
-bool Config::FIXED_INPUT_IMGS_SIZE = false;
-uint Config::FIXED_INPUT_IMGS_WIDTH = 64;
-uint Config::FIXED_INPUT_IMGS_HEIGHT = 128;
-
-uint Config::PIXEL_HOMOG_DELTA = 55;
-uint Config::PIXEL_HOMOG_RADIUS = 4;
-float Config::PIXEL_HOMOG_THRESHOLD = 0.6f;
-bool Config::PIXEL_RANDOM_INIT = true;
-
-
-//=============================================================================
-//								Config File
-//=============================================================================
-void Config::SetConfig(const boost::property_tree::ptree& tree)
-{
-	//for (boost::property_tree::ptree::const_iterator it = tree.begin();
-	//	it != tree.end(); ++it)
- //   {
-	//	cout << '[' << it->first<< "]\n";
-	//	for (boost::property_tree::ptree::const_iterator s = 
-	//		 it->second.begin();
-	//	s != it->second.end(); ++s)
-	//	{
-	//		cout << s->first << "=" 
-	//			 << s->second.get_value<std::string>() << "\n";
-	//	}
- //   }
-
-	//-------------------------------------------------------------------------
-	// Neuron
-	//-------------------------------------------------------------------------
-	POT_THRESHOLD = tree.get<float>("Neuron.POT_THRESHOLD", POT_THRESHOLD);
-	TAU = tree.get<float>("Neuron.TAU", TAU);
-	GLOBAL_INHIB_VAL = tree.get<float>("Neuron.GLOBAL_INHIB_VAL",
-									   GLOBAL_INHIB_VAL);
-	CHARGING_LEADER = tree.get<float>("Neuron.CHARGING_LEADER",
-									  CHARGING_LEADER);
-	CHARGING_FOLLOWER = tree.get<float>("Neuron.CHARGING_FOLLOWER",
-										CHARGING_FOLLOWER);
-
-	//-------------------------------------------------------------------------
-	// Neural connexion parameters
-	//-------------------------------------------------------------------------
-	SEG_WEIGHT_MAX = tree.get<float>("NeuralConnexion.SEG_WEIGHT_MAX",
-									 SEG_WEIGHT_MAX);
-	SEG_WEIGHT_SLOPE = tree.get<float>("NeuralConnexion.SEG_WEIGHT_SLOPE",
-									   SEG_WEIGHT_SLOPE);
-	SEG_WEIGHT_OFFSET = tree.get<float>("NeuralConnexion.SEG_WEIGHT_OFFSET",
-										SEG_WEIGHT_OFFSET);
-
-	//-------------------------------------------------------------------------
-	// General simulation parameters
-	//-------------------------------------------------------------------------
-	SEG_MAX_CASCADES = tree.get<uint>("SimulationParams.SEG_MAX_CASCADES",
-									  SEG_MAX_CASCADES);
-	SEG_MAX_CYCLES = tree.get<uint>("SimulationParams.SEG_MAX_CYCLES",
-									SEG_MAX_CYCLES);
-
-	SEG_TRIGGER_SAME_LABEL_NEURONS =
-		tree.get<bool>("SimulationParams.SEG_TRIGGER_SAME_LABEL_NEURONS",
-					   SEG_TRIGGER_SAME_LABEL_NEURONS);
-	SEG_MERGE_SEGMENTS = tree.get<bool>("SimulationParams.SEG_MERGE_SEGMENTS",
-										SEG_MERGE_SEGMENTS);
-	SEG_MERGE_DELTA = tree.get<float>("SimulationParams.SEG_MERGE_DELTA",
-									  SEG_MERGE_DELTA);
-
-	MIN_SEGMENT_SIZE = tree.get<uint>("SimulationParams.MIN_SEGMENT_SIZE",
-									  MIN_SEGMENT_SIZE);
-	//cout << "Setup Max Cycles: " << Config::SEG_MAX_CYCLES << endl;
-
-	//-------------------------------------------------------------------------
-	// Input Image parameters
-	//-------------------------------------------------------------------------
-	RESIZE_IMG_KEEP_RATIO =
-		tree.get<bool>("InputImageParams.RESIZE_IMG_KEEP_RATIO",
-					   RESIZE_IMG_KEEP_RATIO);
-	KEEP_RATIO_LONGEST_IMG_SIDE =
-		tree.get<uint>("InputImageParams.KEEP_RATIO_LONGEST_IMG_SIDE",
-					   KEEP_RATIO_LONGEST_IMG_SIDE);
-	FIXED_INPUT_IMGS_SIZE =
-		tree.get<bool>("InputImageParams.FIXED_INPUT_IMGS_SIZE",
-					   FIXED_INPUT_IMGS_SIZE);
-	FIXED_INPUT_IMGS_WIDTH =
-		tree.get<uint>("InputImageParams.FIXED_INPUT_IMGS_WIDTH",
-					   FIXED_INPUT_IMGS_WIDTH);
-	FIXED_INPUT_IMGS_HEIGHT =
-		tree.get<uint>("InputImageParams.FIXED_INPUT_IMGS_HEIGHT",
-					   FIXED_INPUT_IMGS_HEIGHT);
-
-	//-------------------------------------------------------------------------
-	// Pixel layer parameters
-	//-------------------------------------------------------------------------
-	PIXEL_HOMOG_DELTA = tree.get<uint>("PixelsParams.PIXEL_HOMOG_DELTA",
-									   PIXEL_HOMOG_DELTA);
-	PIXEL_HOMOG_RADIUS = tree.get<uint>("PixelsParams.PIXEL_HOMOG_RADIUS",
-										PIXEL_HOMOG_RADIUS);
-	PIXEL_HOMOG_THRESHOLD =
-		tree.get<float>("PixelsParams.PIXEL_HOMOG_THRESHOLD",
-						PIXEL_HOMOG_THRESHOLD);
-	PIXEL_RANDOM_INIT = tree.get<bool>("PixelsParams.PIXEL_RANDOM_INIT",
-									   PIXEL_RANDOM_INIT);
-}
-
-//=============================================================================
-bool Config::LoadConfigFile(string filename)
-{
-	boost::property_tree::ptree tree;
-
-	cout << "\nLoading config file: " 
-		<< Config::FromWorkingDir(filename) << endl;
-
-	//try { boost::property_tree::json_parser::read_json(filename, tree); }
-	try { boost::property_tree::ini_parser::read_ini(filename, tree); }
-	catch (...)
-	{
-		Config::GenerateConfigFile(filename);
-		return false;
-	}
-
-	Config::SetConfig(tree);
-	return true;
-}
-
-//=============================================================================
-void Config::GenerateConfigFile(string filename)
-{
-	boost::property_tree::ptree tree;
-	
-	//-------------------------------------------------------------------------
-	// Neuron
-	//-------------------------------------------------------------------------
-	tree.put("Neuron.POT_THRESHOLD", POT_THRESHOLD);
-	tree.put("Neuron.TAU", TAU);
-	tree.put("Neuron.GLOBAL_INHIB_VAL", GLOBAL_INHIB_VAL);
-	tree.put("Neuron.CHARGING_LEADER", CHARGING_LEADER);
-	tree.put("Neuron.CHARGING_FOLLOWER", CHARGING_FOLLOWER);
-
-	//-------------------------------------------------------------------------
-	// Neural connexion parameters
-	//-------------------------------------------------------------------------
-	tree.put("NeuralConnexion.SEG_WEIGHT_MAX", SEG_WEIGHT_MAX);
-	tree.put("NeuralConnexion.SEG_WEIGHT_SLOPE", SEG_WEIGHT_SLOPE);
-	tree.put("NeuralConnexion.SEG_WEIGHT_OFFSET", SEG_WEIGHT_OFFSET);
-
-	//-------------------------------------------------------------------------
-	// General simulation parameters
-	//-------------------------------------------------------------------------
-	tree.put("SimulationParams.SEG_MAX_CASCADES", SEG_MAX_CASCADES);
-	tree.put("SimulationParams.SEG_MAX_CYCLES", SEG_MAX_CYCLES);
-	tree.put("SimulationParams.SEG_TRIGGER_SAME_LABEL_NEURONS", 
-			 SEG_TRIGGER_SAME_LABEL_NEURONS);
-	tree.put("SimulationParams.SEG_MERGE_SEGMENTS", SEG_MERGE_SEGMENTS);
-	tree.put("SimulationParams.SEG_MERGE_DELTA", SEG_MERGE_DELTA);
-
-	//-------------------------------------------------------------------------
-	// Pixel layer parameters
-	//-------------------------------------------------------------------------
-	tree.put("PixelsParams.PIXEL_HOMOG_DELTA", PIXEL_HOMOG_DELTA);
-	tree.put("PixelsParams.PIXEL_HOMOG_RADIUS", PIXEL_HOMOG_RADIUS);
-	tree.put("PixelsParams.PIXEL_HOMOG_THRESHOLD", PIXEL_HOMOG_THRESHOLD);
-	tree.put("PixelsParams.PIXEL_RANDOM_INIT", PIXEL_RANDOM_INIT);
-	
-
-	//try { boost::property_tree::json_parser::write_json(filename, tree); }
-	try { boost::property_tree::ini_parser::write_ini(
-		Config::FromWorkingDir(filename), tree); }
-	catch (...)	{}
-
-}
+/** @file Config.cpp
+ *
+ *  @author Vincent de Ladurantaye
+ */
+
+#include <iostream>
+#include <cstring>
+
+#include <boost/property_tree/ini_parser.hpp>
+//#include <boost/property_tree/json_parser.hpp>
+
+#include "Config.h"
+
+
+string Config::WORKING_DIR = "";
+
+float Config::POT_THRESHOLD = 1.0f;
+float Config::TAU = 1.0f;
+float Config::GLOBAL_INHIB_VAL = 0.002f;
+float Config::CHARGING_LEADER = 1.01f;
+float Config::CHARGING_FOLLOWER = 0.5f;
+
+float Config::SEG_WEIGHT_MAX = 0.01f;
+float Config::SEG_WEIGHT_SLOPE = 1.2f;
+float Config::SEG_WEIGHT_OFFSET = 0.0f;
+
+float Config::MATCHING_WEIGHT_MAX = 1.0f;
+float Config::MATCHING_WEIGHT_SLOPE = 1.0f;
+float Config::MATCHING_WEIGHT_OFFSET = 10.0f;
+
+uint Config::SEG_MAX_CASCADES = 0;
+uint Config::SEG_MAX_CYCLES = 50;
+
+bool Config::SEG_TRIGGER_SAME_LABEL_NEURONS = false;
+bool Config::SEG_MERGE_SEGMENTS = false;
+float Config::SEG_MERGE_DELTA = 2.0f;
+
+uint Config::MIN_SEGMENT_SIZE = 80;
+
+uint Config::SEG_WEIGHT_PLANES = 2;
+float Config::SEG_WEIGHT_PLANES_MAX_MB = 512.0f;
+uint Config::SIM_NEURON_LAYOUT = 0;
+uint Config::SIM_LAYOUT_TILE_SIZE = 16;
+bool Config::SEG_COARSEN_SEGMENTS = false;
+float Config::SEG_COARSEN_DELTA_PERIOD = 0.2f;
+uint Config::SEG_COARSEN_CYCLES = 1;
+uint Config::SEG_PYRAMID_LEVELS = 1;
+uint Config::SEG_PYRAMID_REFINE_CYCLES = 3;
+int Config::SEG_WARM_START_DELTA = 8;
+bool Config::SEG_PARTIAL_RESEGMENTATION = false;
+uint Config::SEG_CHANGE_TILE_SIZE = 32;
+uint Config::SEG_CHANGE_MARGIN = 8;
+
+uint Config::MATCHING_COUPLING_CASCADES = 100;
+uint Config::MATCHING_NB_THREADS = 0;
+
+uint Config::VIDEO_NB_WORKERS = 0;
+uint Config::VIDEO_QUEUE_SIZE = 8;
+
+uint Config::DEBUG_SNAPSHOT_PERIOD_MS = 33;
+uint Config::TRACE_BUFFER_SIZE = 262144;
+bool Config::PROFILE_HW_COUNTERS = false;
+
+bool Config::RESIZE_IMG_KEEP_RATIO = false;
+uint Config::KEEP_RATIO_LONGEST_IMG_SIDE = 150;
+
+bool Config::FIXED_INPUT_IMGS_SIZE = false;
+uint Config::FIXED_INPUT_IMGS_WIDTH = 64;
+uint Config::FIXED_INPUT_IMGS_HEIGHT = 128;
+
+uint Config::PIXEL_HOMOG_DELTA = 55;
+uint Config::PIXEL_HOMOG_RADIUS = 4;
+float Config::PIXEL_HOMOG_THRESHOLD = 0.6f;
+bool Config::PIXEL_RANDOM_INIT = true;
+
+
+//=============================================================================
+//								Config File
+//=============================================================================
+void Config::SetConfig(const boost::property_tree::ptree& tree)
+{
+	//for (boost::property_tree::ptree::const_iterator it = tree.begin();
+	//	it != tree.end(); ++it)
+ //   {
+	//	cout << '[' << it->first<< "]\n";
+	//	for (boost::property_tree::ptree::const_iterator s = 
+	//		 it->second.begin();
+	//	s != it->second.end(); ++s)
+	//	{
+	//		cout << s->first << "=" 
+	//			 << s->second.get_value<std::string>() << "\n";
+	//	}
+ //   }
+
+	//-------------------------------------------------------------------------
+	// Neuron
+	//-------------------------------------------------------------------------
+	POT_THRESHOLD = tree.get<float>("Neuron.POT_THRESHOLD", POT_THRESHOLD);
+	TAU = tree.get<float>("Neuron.TAU", TAU);
+	GLOBAL_INHIB_VAL = tree.get<float>("Neuron.GLOBAL_INHIB_VAL",
+									   GLOBAL_INHIB_VAL);
+	CHARGING_LEADER = tree.get<float>("Neuron.CHARGING_LEADER",
+									  CHARGING_LEADER);
+	CHARGING_FOLLOWER = tree.get<float>("Neuron.CHARGING_FOLLOWER",
+										CHARGING_FOLLOWER);
+
+	//-------------------------------------------------------------------------
+	// Neural connexion parameters
+	//-------------------------------------------------------------------------
+	SEG_WEIGHT_MAX = tree.get<float>("NeuralConnexion.SEG_WEIGHT_MAX",
+									 SEG_WEIGHT_MAX);
+	SEG_WEIGHT_SLOPE = tree.get<float>("NeuralConnexion.SEG_WEIGHT_SLOPE",
+									   SEG_WEIGHT_SLOPE);
+	SEG_WEIGHT_OFFSET = tree.get<float>("NeuralConnexion.SEG_WEIGHT_OFFSET",
+										SEG_WEIGHT_OFFSET);
+
+	//-------------------------------------------------------------------------
+	// General simulation parameters
+	//-------------------------------------------------------------------------
+	SEG_MAX_CASCADES = tree.get<uint>("SimulationParams.SEG_MAX_CASCADES",
+									  SEG_MAX_CASCADES);
+	SEG_MAX_CYCLES = tree.get<uint>("SimulationParams.SEG_MAX_CYCLES",
+									SEG_MAX_CYCLES);
+
+	SEG_TRIGGER_SAME_LABEL_NEURONS =
+		tree.get<bool>("SimulationParams.SEG_TRIGGER_SAME_LABEL_NEURONS",
+					   SEG_TRIGGER_SAME_LABEL_NEURONS);
+	SEG_MERGE_SEGMENTS = tree.get<bool>("SimulationParams.SEG_MERGE_SEGMENTS",
+										SEG_MERGE_SEGMENTS);
+	SEG_MERGE_DELTA = tree.get<float>("SimulationParams.SEG_MERGE_DELTA",
+									  SEG_MERGE_DELTA);
+
+	MIN_SEGMENT_SIZE = tree.get<uint>("SimulationParams.MIN_SEGMENT_SIZE",
+									  MIN_SEGMENT_SIZE);
+
+	SEG_WEIGHT_PLANES = tree.get<uint>("SimulationParams.SEG_WEIGHT_PLANES",
+									   SEG_WEIGHT_PLANES);
+	SEG_WEIGHT_PLANES_MAX_MB =
+		tree.get<float>("SimulationParams.SEG_WEIGHT_PLANES_MAX_MB",
+						SEG_WEIGHT_PLANES_MAX_MB);
+	SIM_NEURON_LAYOUT = tree.get<uint>("SimulationParams.SIM_NEURON_LAYOUT",
+									   SIM_NEURON_LAYOUT);
+	SIM_LAYOUT_TILE_SIZE =
+		tree.get<uint>("SimulationParams.SIM_LAYOUT_TILE_SIZE",
+					   SIM_LAYOUT_TILE_SIZE);
+	SEG_COARSEN_SEGMENTS =
+		tree.get<bool>("SimulationParams.SEG_COARSEN_SEGMENTS",
+					   SEG_COARSEN_SEGMENTS);
+	SEG_COARSEN_DELTA_PERIOD =
+		tree.get<float>("SimulationParams.SEG_COARSEN_DELTA_PERIOD",
+						SEG_COARSEN_DELTA_PERIOD);
+	SEG_COARSEN_CYCLES = tree.get<uint>("SimulationParams.SEG_COARSEN_CYCLES",
+										SEG_COARSEN_CYCLES);
+	SEG_PYRAMID_LEVELS = tree.get<uint>("SimulationParams.SEG_PYRAMID_LEVELS",
+										SEG_PYRAMID_LEVELS);
+	SEG_PYRAMID_REFINE_CYCLES =
+		tree.get<uint>("SimulationParams.SEG_PYRAMID_REFINE_CYCLES",
+					   SEG_PYRAMID_REFINE_CYCLES);
+	SEG_WARM_START_DELTA =
+		tree.get<int>("SimulationParams.SEG_WARM_START_DELTA",
+					  SEG_WARM_START_DELTA);
+	SEG_PARTIAL_RESEGMENTATION =
+		tree.get<bool>("SimulationParams.SEG_PARTIAL_RESEGMENTATION",
+					   SEG_PARTIAL_RESEGMENTATION);
+	SEG_CHANGE_TILE_SIZE =
+		tree.get<uint>("SimulationParams.SEG_CHANGE_TILE_SIZE",
+					   SEG_CHANGE_TILE_SIZE);
+	SEG_CHANGE_MARGIN = tree.get<uint>("SimulationParams.SEG_CHANGE_MARGIN",
+									   SEG_CHANGE_MARGIN);
+	//cout << "Setup Max Cycles: " << Config::SEG_MAX_CYCLES << endl;
+
+	//-------------------------------------------------------------------------
+	// Matching parameters
+	//-------------------------------------------------------------------------
+	MATCHING_COUPLING_CASCADES =
+		tree.get<uint>("MatchingParams.MATCHING_COUPLING_CASCADES",
+					   MATCHING_COUPLING_CASCADES);
+	MATCHING_NB_THREADS = tree.get<uint>("MatchingParams.MATCHING_NB_THREADS",
+										 MATCHING_NB_THREADS);
+
+	//-------------------------------------------------------------------------
+	// Video pipeline parameters
+	//-------------------------------------------------------------------------
+	VIDEO_NB_WORKERS = tree.get<uint>("VideoParams.VIDEO_NB_WORKERS",
+									  VIDEO_NB_WORKERS);
+	VIDEO_QUEUE_SIZE = tree.get<uint>("VideoParams.VIDEO_QUEUE_SIZE",
+									  VIDEO_QUEUE_SIZE);
+
+	//-------------------------------------------------------------------------
+	// Debugger parameters
+	//-------------------------------------------------------------------------
+	DEBUG_SNAPSHOT_PERIOD_MS = 
+		tree.get<uint>("DebugParams.DEBUG_SNAPSHOT_PERIOD_MS",
+					   DEBUG_SNAPSHOT_PERIOD_MS);
+	TRACE_BUFFER_SIZE = tree.get<uint>("DebugParams.TRACE_BUFFER_SIZE",
+									   TRACE_BUFFER_SIZE);
+	PROFILE_HW_COUNTERS = tree.get<bool>("DebugParams.PROFILE_HW_COUNTERS",
+										 PROFILE_HW_COUNTERS);
+
+	//-------------------------------------------------------------------------
+	// Input Image parameters
+	//-------------------------------------------------------------------------
+	RESIZE_IMG_KEEP_RATIO =
+		tree.get<bool>("InputImageParams.RESIZE_IMG_KEEP_RATIO",
+					   RESIZE_IMG_KEEP_RATIO);
+	KEEP_RATIO_LONGEST_IMG_SIDE =
+		tree.get<uint>("InputImageParams.KEEP_RATIO_LONGEST_IMG_SIDE",
+					   KEEP_RATIO_LONGEST_IMG_SIDE);
+	FIXED_INPUT_IMGS_SIZE =
+		tree.get<bool>("InputImageParams.FIXED_INPUT_IMGS_SIZE",
+					   FIXED_INPUT_IMGS_SIZE);
+	FIXED_INPUT_IMGS_WIDTH =
+		tree.get<uint>("InputImageParams.FIXED_INPUT_IMGS_WIDTH",
+					   FIXED_INPUT_IMGS_WIDTH);
+	FIXED_INPUT_IMGS_HEIGHT =
+		tree.get<uint>("InputImageParams.FIXED_INPUT_IMGS_HEIGHT",
+					   FIXED_INPUT_IMGS_HEIGHT);
+
+	//-------------------------------------------------------------------------
+	// Pixel layer parameters
+	//-------------------------------------------------------------------------
+	PIXEL_HOMOG_DELTA = tree.get<uint>("PixelsParams.PIXEL_HOMOG_DELTA",
+									   PIXEL_HOMOG_DELTA);
+	PIXEL_HOMOG_RADIUS = tree.get<uint>("PixelsParams.PIXEL_HOMOG_RADIUS",
+										PIXEL_HOMOG_RADIUS);
+	PIXEL_HOMOG_THRESHOLD =
+		tree.get<float>("PixelsParams.PIXEL_HOMOG_THRESHOLD",
+						PIXEL_HOMOG_THRESHOLD);
+	PIXEL_RANDOM_INIT = tree.get<bool>("PixelsParams.PIXEL_RANDOM_INIT",
+									   PIXEL_RANDOM_INIT);
+}
+
+//=============================================================================
+bool Config::LoadConfigFile(string filename)
+{
+	boost::property_tree::ptree tree;
+
+	cout << "\nLoading config file: " 
+		<< Config::FromWorkingDir(filename) << endl;
+
+	//try { boost::property_tree::json_parser::read_json(filename, tree); }
+	try { boost::property_tree::ini_parser::read_ini(filename, tree); }
+	catch (...)
+	{
+		Config::GenerateConfigFile(filename);
+		return false;
+	}
+
+	Config::SetConfig(tree);
+	return true;
+}
+
+//=============================================================================
+void Config::GenerateConfigFile(string filename)
+{
+	boost::property_tree::ptree tree;
+	
+	//-------------------------------------------------------------------------
+	// Neuron
+	//-------------------------------------------------------------------------
+	tree.put("Neuron.POT_THRESHOLD", POT_THRESHOLD);
+	tree.put("Neuron.TAU", TAU);
+	tree.put("Neuron.GLOBAL_INHIB_VAL", GLOBAL_INHIB_VAL);
+	tree.put("Neuron.CHARGING_LEADER", CHARGING_LEADER);
+	tree.put("Neuron.CHARGING_FOLLOWER", CHARGING_FOLLOWER);
+
+	//-------------------------------------------------------------------------
+	// Neural connexion parameters
+	//-------------------------------------------------------------------------
+	tree.put("NeuralConnexion.SEG_WEIGHT_MAX", SEG_WEIGHT_MAX);
+	tree.put("NeuralConnexion.SEG_WEIGHT_SLOPE", SEG_WEIGHT_SLOPE);
+	tree.put("NeuralConnexion.SEG_WEIGHT_OFFSET", SEG_WEIGHT_OFFSET);
+
+	//-------------------------------------------------------------------------
+	// General simulation parameters
+	//-------------------------------------------------------------------------
+	tree.put("SimulationParams.SEG_MAX_CASCADES", SEG_MAX_CASCADES);
+	tree.put("SimulationParams.SEG_MAX_CYCLES", SEG_MAX_CYCLES);
+	tree.put("SimulationParams.SEG_TRIGGER_SAME_LABEL_NEURONS", 
+			 SEG_TRIGGER_SAME_LABEL_NEURONS);
+	tree.put("SimulationParams.SEG_MERGE_SEGMENTS", SEG_MERGE_SEGMENTS);
+	tree.put("SimulationParams.SEG_MERGE_DELTA", SEG_MERGE_DELTA);
+	tree.put("SimulationParams.SEG_WEIGHT_PLANES", SEG_WEIGHT_PLANES);
+	tree.put("SimulationParams.SEG_WEIGHT_PLANES_MAX_MB",
+			 SEG_WEIGHT_PLANES_MAX_MB);
+	tree.put("SimulationParams.SIM_NEURON_LAYOUT", SIM_NEURON_LAYOUT);
+	tree.put("SimulationParams.SIM_LAYOUT_TILE_SIZE", SIM_LAYOUT_TILE_SIZE);
+	tree.put("SimulationParams.SEG_COARSEN_SEGMENTS", SEG_COARSEN_SEGMENTS);
+	tree.put("SimulationParams.SEG_COARSEN_DELTA_PERIOD",
+			 SEG_COARSEN_DELTA_PERIOD);
+	tree.put("SimulationParams.SEG_COARSEN_CYCLES", SEG_COARSEN_CYCLES);
+	tree.put("SimulationParams.SEG_PYRAMID_LEVELS", SEG_PYRAMID_LEVELS);
+	tree.put("SimulationParams.SEG_PYRAMID_REFINE_CYCLES",
+			 SEG_PYRAMID_REFINE_CYCLES);
+	tree.put("SimulationParams.SEG_WARM_START_DELTA", SEG_WARM_START_DELTA);
+	tree.put("SimulationParams.SEG_PARTIAL_RESEGMENTATION",
+			 SEG_PARTIAL_RESEGMENTATION);
+	tree.put("SimulationParams.SEG_CHANGE_TILE_SIZE", SEG_CHANGE_TILE_SIZE);
+	tree.put("SimulationParams.SEG_CHANGE_MARGIN", SEG_CHANGE_MARGIN);
+
+	//-------------------------------------------------------------------------
+	// Matching parameters
+	//-------------------------------------------------------------------------
+	tree.put("MatchingParams.MATCHING_COUPLING_CASCADES",
+			 MATCHING_COUPLING_CASCADES);
+	tree.put("MatchingParams.MATCHING_NB_THREADS", MATCHING_NB_THREADS);
+
+	//-------------------------------------------------------------------------
+	// Video pipeline parameters
+	//-------------------------------------------------------------------------
+	tree.put("VideoParams.VIDEO_NB_WORKERS", VIDEO_NB_WORKERS);
+	tree.put("VideoParams.VIDEO_QUEUE_SIZE", VIDEO_QUEUE_SIZE);
+
+	//-------------------------------------------------------------------------
+	// Debugger parameters
+	//-------------------------------------------------------------------------
+	tree.put("DebugParams.DEBUG_SNAPSHOT_PERIOD_MS", DEBUG_SNAPSHOT_PERIOD_MS);
+	tree.put("DebugParams.TRACE_BUFFER_SIZE", TRACE_BUFFER_SIZE);
+	tree.put("DebugParams.PROFILE_HW_COUNTERS", PROFILE_HW_COUNTERS);
+
+	//-------------------------------------------------------------------------
+	// Pixel layer parameters
+	//-------------------------------------------------------------------------
+	tree.put("PixelsParams.PIXEL_HOMOG_DELTA", PIXEL_HOMOG_DELTA);
+	tree.put("PixelsParams.PIXEL_HOMOG_RADIUS", PIXEL_HOMOG_RADIUS);
+	tree.put("PixelsParams.PIXEL_HOMOG_THRESHOLD", PIXEL_HOMOG_THRESHOLD);
+	tree.put("PixelsParams.PIXEL_RANDOM_INIT", PIXEL_RANDOM_INIT);
+	
+
+	//try { boost::property_tree::json_parser::write_json(filename, tree); }
+	try { boost::property_tree::ini_parser::write_ini(
+		Config::FromWorkingDir(filename), tree); }
+	catch (...)	{}
+
+}
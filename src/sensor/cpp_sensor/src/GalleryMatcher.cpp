@@ -0,0 +1,177 @@
+/** @file GalleryMatcher.cpp
+*
+*
+*  @author Vincent de Ladurantaye
+*/
+
+#include "GalleryMatcher.h"
+#include "LayerTracer.h"
+#include "SegmentationLayerT.h"
+
+#include <algorithm>
+#include <iostream>
+#include <thread>
+using namespace std;
+
+//=============================================================================
+//								GalleryMatcher
+//=============================================================================
+GalleryMatcher::GalleryMatcher() :
+	next_gallery_id_(0),
+	min_score_(0.0f),
+	n_abandoned_(0),
+	COUPLING_CASCADES(Config::MATCHING_COUPLING_CASCADES),
+	NB_THREADS(Config::MATCHING_NB_THREADS)
+{
+	if (NB_THREADS == 0) NB_THREADS = thread::hardware_concurrency();
+	if (NB_THREADS == 0) NB_THREADS = 1;
+}
+
+//=============================================================================
+void GalleryMatcher::SetProbe(const string& a_img_file)
+{
+	ImageData imgData(a_img_file);
+	probe_layer_ = CreateSegmentedLayer(imgData);
+	probe_state_ = probe_layer_->GetBinaryState();
+}
+//-----------------------------------------------------------------------------
+void GalleryMatcher::SetProbe(const cv::Mat& a_img)
+{
+	ImageData imgData(a_img);
+	probe_layer_ = CreateSegmentedLayer(imgData);
+	probe_state_ = probe_layer_->GetBinaryState();
+}
+
+//=============================================================================
+uint GalleryMatcher::AddGalleryImage(const string& a_img_file)
+{
+	ImageData imgData(a_img_file);
+	gallery_layers_.push_back(CreateSegmentedLayer(imgData));
+	gallery_states_.push_back(gallery_layers_.back()->GetBinaryState());
+	return gallery_layers_.size() - 1;
+}
+//-----------------------------------------------------------------------------
+uint GalleryMatcher::AddGalleryImage(const cv::Mat& a_img)
+{
+	ImageData imgData(a_img);
+	gallery_layers_.push_back(CreateSegmentedLayer(imgData));
+	gallery_states_.push_back(gallery_layers_.back()->GetBinaryState());
+	return gallery_layers_.size() - 1;
+}
+
+//=============================================================================
+void GalleryMatcher::ClearGallery()
+{
+	gallery_layers_.clear();
+	gallery_states_.clear();
+}
+
+//=============================================================================
+vector<GalleryMatch> GalleryMatcher::Match(uint a_top_k)
+{
+	results_.clear();
+
+	if (!probe_layer_)
+	{
+		cerr << "GalleryMatcher: no probe image set" << endl;
+		return results_;
+	}
+
+	next_gallery_id_ = 0;
+	min_score_ = 0.0f;
+	n_abandoned_ = 0;
+
+	// Copy the probe once per worker, with its class. The copies are created
+	// here as creating a layer from a state isn't thread safe.
+	uint nbThreads = min(NB_THREADS, GetGallerySize());
+	LayerStateView probeState;
+	probeState.Parse(probe_state_.data(), probe_state_.size());
+	vector<unique_ptr<PixelLayer> > probes;
+	for (uint t = 0; t < nbThreads; ++t)
+	{
+		probes.push_back(CreatePixelLayer(probeState));
+	}
+
+	// Match the gallery images in parallel, each worker taking the next
+	// image to process until they are all done
+	vector<thread> workers;
+	for (uint t = 0; t < nbThreads; ++t)
+	{
+		workers.push_back(thread(&GalleryMatcher::MatchWorker, this, 
+								 probes[t].get(), a_top_k));
+	}
+	for (auto& worker : workers)
+	{
+		worker.join();
+	}
+
+	return results_;
+}
+
+//=============================================================================
+//								Protected
+//=============================================================================
+void GalleryMatcher::MatchWorker(PixelLayer* a_probe, uint a_top_k)
+{
+	LayerTracer::SetThreadName("Gallery matcher");
+
+	LayerStateView probeState;
+	probeState.Parse(probe_state_.data(), probe_state_.size());
+
+	uint id;
+	while ((id = next_gallery_id_++) < GetGallerySize())
+	{
+		// Only look for matches that can enter the top k
+		float minScore = (a_top_k > 0) ? min_score_.load() : 0.0f;
+
+		GalleryMatch match;
+		match.gallery_id = id;
+		{
+			PixelLayerCoupler coupler(a_probe, gallery_layers_[id].get());
+			match.score = coupler.RunCoupling(COUPLING_CASCADES, minScore);
+		}
+
+		// The coupling modified both layers, restore their segmented states
+		// for the next matches. Only this worker uses this gallery layer.
+		LayerStateView galleryState;
+		galleryState.Parse(gallery_states_[id].data(), 
+						   gallery_states_[id].size());
+		a_probe->LoadBinaryState(probeState);
+		gallery_layers_[id]->LoadBinaryState(galleryState);
+
+		if (match.score < 0)
+		{
+			++n_abandoned_;
+			continue;
+		}
+
+		AddResult(match, a_top_k);
+	}
+}
+
+//=============================================================================
+void GalleryMatcher::AddResult(const GalleryMatch& a_match, uint a_top_k)
+{
+	lock_guard<mutex> lock(results_mutex_);
+
+	// Insert the match keeping the results sorted from best to worst
+	auto it = upper_bound(results_.begin(), results_.end(), a_match,
+		[](const GalleryMatch& a, const GalleryMatch& b)
+		{ return a.score > b.score; });
+	results_.insert(it, a_match);
+
+	if (a_top_k == 0) return;
+
+	// Keep only the top k, the worst of them setting the score to reach
+	if (results_.size() > a_top_k) results_.resize(a_top_k);
+	if (results_.size() == a_top_k) min_score_ = results_.back().score;
+}
+
+//=============================================================================
+unique_ptr<PixelLayer> GalleryMatcher::CreateSegmentedLayer(
+	ImageData& a_img_data)
+{
+	unique_ptr<PixelLayer> layer = CreatePixelLayer(a_img_data);
+	layer->SegmentLayer();
+	return layer;
+}
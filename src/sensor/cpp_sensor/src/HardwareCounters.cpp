@@ -0,0 +1,169 @@
+/** @file HardwareCounters.cpp
+*
+*  @author Vincent de Ladurantaye
+*/
+
+#include "HardwareCounters.h"
+
+#include <cstring>
+#include <memory>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define HW_COUNTERS_PERF
+#endif
+
+using namespace std;
+
+namespace
+{
+#ifdef HW_COUNTERS_PERF
+	// Perf event type and config of each counter
+	const uint32_t g_counter_types[NB_HW_COUNTERS] =
+	{
+		PERF_TYPE_HARDWARE,
+		PERF_TYPE_HARDWARE,
+		PERF_TYPE_HW_CACHE,
+		PERF_TYPE_HARDWARE,
+		PERF_TYPE_HARDWARE
+	};
+	const uint64_t g_counter_configs[NB_HW_COUNTERS] =
+	{
+		PERF_COUNT_HW_CPU_CYCLES,
+		PERF_COUNT_HW_INSTRUCTIONS,
+		PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+			(PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+		PERF_COUNT_HW_CACHE_MISSES,
+		PERF_COUNT_HW_BRANCH_MISSES
+	};
+
+	/**
+	* Opens a counter of the calling thread in the group of a_group_fd, or as
+	* the leader of a new group if -1. Returns -1 on failure.
+	*/
+	int OpenCounter(HwCounter a_counter, int a_group_fd)
+	{
+		perf_event_attr attr;
+		memset(&attr, 0, sizeof(attr));
+		attr.size = sizeof(attr);
+		attr.type = g_counter_types[a_counter];
+		attr.config = g_counter_configs[a_counter];
+		// The times tell if the group was multiplexed with other events
+		attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED |
+			PERF_FORMAT_TOTAL_TIME_RUNNING;
+		// Only count the simulation, which also lowers the required
+		// permissions
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+
+		return (int)syscall(SYS_perf_event_open, &attr, 0, -1, a_group_fd, 0);
+	}
+#endif
+}
+
+//=============================================================================
+//							   HardwareCounters
+//=============================================================================
+HardwareCounters* HardwareCounters::GetThreadCounters()
+{
+	static thread_local unique_ptr<HardwareCounters> t_counters;
+	if (!t_counters) t_counters.reset(new HardwareCounters);
+
+	return t_counters->available_ ? t_counters.get() : nullptr;
+}
+
+//=============================================================================
+HardwareCounters::HardwareCounters()
+{
+	nb_opened_ = 0;
+	available_ = 0;
+	for (int c = 0; c < NB_HW_COUNTERS; ++c)
+	{
+		fds_[c] = -1;
+		index_[c] = -1;
+	}
+
+#ifdef HW_COUNTERS_PERF
+	int groupFd = -1;
+	for (int c = 0; c < NB_HW_COUNTERS; ++c)
+	{
+		// A counter that doesn't exist or doesn't fit in the group is skipped
+		fds_[c] = OpenCounter((HwCounter)c, groupFd);
+		if (fds_[c] < 0) continue;
+
+		if (groupFd < 0) groupFd = fds_[c];
+		index_[c] = nb_opened_++;
+		available_ |= 1u << c;
+	}
+#endif
+}
+
+//=============================================================================
+HardwareCounters::~HardwareCounters()
+{
+#ifdef HW_COUNTERS_PERF
+	// Close the members of the group before its leader
+	for (int c = NB_HW_COUNTERS - 1; c >= 0; --c)
+	{
+		if (fds_[c] >= 0) close(fds_[c]);
+	}
+#endif
+}
+
+//=============================================================================
+uint HardwareCounters::Read(uint64_t a_values[NB_HW_COUNTERS]) const
+{
+	// Values of the group: the number of counters, the times the group was
+	// enabled and running, then the values in the order they were opened
+	uint64_t group[3 + NB_HW_COUNTERS] = { 0 };
+
+#ifdef HW_COUNTERS_PERF
+	for (int c = 0; c < NB_HW_COUNTERS; ++c)
+	{
+		if (fds_[c] < 0) continue;
+
+		// The leader reads the whole group
+		if (read(fds_[c], group, sizeof(group)) <= 0) group[0] = 0;
+		break;
+	}
+#endif
+
+	// The group never counted if it was never scheduled, e.g. when the PMU
+	// can't hold all its counters
+	uint64_t timeEnabled = group[1];
+	uint64_t timeRunning = group[2];
+	if (timeRunning == 0) group[0] = 0;
+
+	for (int c = 0; c < NB_HW_COUNTERS; ++c)
+	{
+		a_values[c] = 0;
+		if (index_[c] < 0 || index_[c] >= (int)group[0]) continue;
+
+		// When multiplexed, the group only counted a part of the time, so
+		// extrapolate to the whole time it was enabled
+		a_values[c] = group[3 + index_[c]];
+		if (timeRunning < timeEnabled)
+		{
+			a_values[c] = (uint64_t)((double)a_values[c] * timeEnabled /
+									 timeRunning);
+		}
+	}
+
+	return group[0] > 0 ? available_ : 0;
+}
+
+//=============================================================================
+const char* HardwareCounters::GetCounterName(HwCounter a_counter)
+{
+	switch (a_counter)
+	{
+	case HW_COUNTER_CYCLES:			return "cycles";
+	case HW_COUNTER_INSTRUCTIONS:	return "instructions";
+	case HW_COUNTER_L1D_MISSES:		return "l1d_misses";
+	case HW_COUNTER_LLC_MISSES:		return "llc_misses";
+	case HW_COUNTER_BRANCH_MISSES:	return "branch_misses";
+	default:						return "";
+	}
+}
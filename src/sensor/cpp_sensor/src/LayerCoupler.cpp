@@ -1,102 +1,191 @@
-/** @file MatchingNetwork.cpp
-*
-*
-*  @author Vincent de Ladurantaye
-*/
-
-#include "LayerCoupler.h"
-
-//=============================================================================
-//								LayerCoupler
-//=============================================================================
-LayerCoupler::LayerCoupler(NeuralLayer* layer1, NeuralLayer* layer2):
-	layers_{layer1,layer2},
-	WEIGHT_MAX_VALUE(Config::MATCHING_WEIGHT_MAX),
-	WEIGHT_SLOPE(Config::MATCHING_WEIGHT_SLOPE),
-	WEIGHT_OFFSET(Config::MATCHING_WEIGHT_OFFSET)
-{
-	layers_[L1]->SetPropagateCallback(
-		[&] (uint id, uint layer_id, uint phase) 
-		{ this->Layer1SpikeHandler(id, layer_id, phase); });
-
-	layers_[L2]->SetPropagateCallback(
-		[&] (uint id, uint layer_id, uint phase) 
-		{ this->Layer2SpikeHandler(id, layer_id, phase); });
-}
-
-//=============================================================================
-LayerCoupler::~LayerCoupler()
-{
-}
-
-//=============================================================================
-float LayerCoupler::ComputeWeigth(uint idLayer1, uint idLayer2)
-{
-	return 1 - 1/(1 + exp(-WEIGHT_SLOPE * 
-				  (ComputeFeatDiff(idLayer1, idLayer2) - WEIGHT_OFFSET)));
-}
-
-//=============================================================================
-void LayerCoupler::PropagateSpikeL1toL2(
-	const Neuron& n1,
-	Neuron& n2,
-	int phase)
-{	
-	n2.pot += WEIGHT_MAX_VALUE * ComputeWeigth(n1.id, n2.id);
-
-	layers_[L2]->PropagateLabel(n2, n1.label, phase);
-}
-
-//=============================================================================
-void LayerCoupler::PropagateSpikeL2toL1(
-	const Neuron& n2,
-	Neuron& n1,
-	int phase)
-{
-	n1.pot += WEIGHT_MAX_VALUE * ComputeWeigth(n1.id, n2.id);
-
-	layers_[L1]->PropagateLabel(n1, n2.label, phase);
-}
-
-
-//=============================================================================
-//								PixelLayerCoupler
-//=============================================================================
-PixelLayerCoupler::PixelLayerCoupler(
-	PixelLayer* inLayer,
-	PixelLayer* refLayer)
-	:
-	LayerCoupler(inLayer, refLayer)
-{
-}
-
-//=============================================================================
-void PixelLayerCoupler::Layer1SpikeHandler(uint neuron_id, 
-										   uint layer_id,
-										   uint phase)
-{
-	for (auto& n: layers_[L2]->neurons)
-	{
-		PropagateSpikeL1toL2(layers_[L1]->neurons[neuron_id], n, phase);
-	}
-}
-
-//=============================================================================
-void PixelLayerCoupler::Layer2SpikeHandler(uint neuron_id, 
-										   uint layer_id, 
-										   uint phase)
-{
-	for (auto& n: layers_[L1]->neurons)
-	{
-		PropagateSpikeL2toL1(layers_[L2]->neurons[neuron_id], n, phase);
-	}
-}
-
-//=============================================================================
-float PixelLayerCoupler::ComputeFeatDiff(uint idLayer1, uint idLayer2)
-{
-	return abs( (float)
-		static_cast<PixelLayer*>(layers_[L1])->pixel_data[idLayer1] -
-		static_cast<PixelLayer*>(layers_[L2])->pixel_data[idLayer2]);
-}
-
+/** @file MatchingNetwork.cpp
+*
+*
+*  @author Vincent de Ladurantaye
+*/
+
+#include "LayerCoupler.h"
+
+#include <algorithm>
+using namespace std;
+
+//=============================================================================
+//								LayerCoupler
+//=============================================================================
+LayerCoupler::LayerCoupler(NeuralLayer* layer1, NeuralLayer* layer2):
+	layers_{layer1,layer2},
+	WEIGHT_MAX_VALUE(Config::MATCHING_WEIGHT_MAX),
+	WEIGHT_SLOPE(Config::MATCHING_WEIGHT_SLOPE),
+	WEIGHT_OFFSET(Config::MATCHING_WEIGHT_OFFSET)
+{
+	layers_[L1]->SetPropagateCallback(
+		[&] (uint id, uint layer_id, uint phase) 
+		{ this->Layer1SpikeHandler(id, layer_id, phase); });
+
+	layers_[L2]->SetPropagateCallback(
+		[&] (uint id, uint layer_id, uint phase) 
+		{ this->Layer2SpikeHandler(id, layer_id, phase); });
+}
+
+//=============================================================================
+LayerCoupler::~LayerCoupler()
+{
+	// The layers may outlive the coupler
+	layers_[L1]->SetPropagateCallback(nullptr);
+	layers_[L2]->SetPropagateCallback(nullptr);
+}
+
+//=============================================================================
+float LayerCoupler::ComputeWeigth(uint idLayer1, uint idLayer2)
+{
+	return 1 - 1/(1 + exp(-WEIGHT_SLOPE * 
+				  (ComputeFeatDiff(idLayer1, idLayer2) - WEIGHT_OFFSET)));
+}
+
+//=============================================================================
+float LayerCoupler::RunCoupling(uint a_nb_cascades, float a_min_score)
+{
+	NeuralLayer& l1 = *layers_[L1];
+	NeuralLayer& l2 = *layers_[L2];
+
+	// Sum of the correspondence of every cascade
+	float sumCorrespondence = 0.0f;
+
+	for (uint c = 0; c < a_nb_cascades; ++c)
+	{
+		// Both layers share the same time, so the layer with the neuron the
+		// closest to the threshold sets the pace
+		float delta = min(l1.FindNextTimeStep(), l2.FindNextTimeStep());
+
+		l1.sim_time += delta;
+		l2.sim_time += delta;
+
+		l1.AdvanceTime(delta);
+		l2.AdvanceTime(delta);
+
+		// Spikes of a layer can make neurons of the other layer reach the 
+		// threshold, so fire both layers until neither of them spikes
+		int waveSpikes;
+		do
+		{
+			waveSpikes = l1.FireNeurons(l1.n_cascades, l1.sim_time);
+			waveSpikes += l2.FireNeurons(l2.n_cascades, l2.sim_time);
+		} while (waveSpikes > 0);
+
+		l1.GlobalInhibition();
+		l2.GlobalInhibition();
+
+		++l1.n_cascades;
+		++l2.n_cascades;
+
+		sumCorrespondence += ComputeCorrespondence();
+
+		// Best score still reachable if the segments of all remaining 
+		// cascades correspond perfectly
+		float maxScore = 
+			(sumCorrespondence + a_nb_cascades - c - 1) / a_nb_cascades;
+		if (maxScore < a_min_score) return -1.0f;
+	}
+
+	if (a_nb_cascades == 0) return 0.0f;
+
+	return sumCorrespondence / a_nb_cascades;
+}
+
+//=============================================================================
+float LayerCoupler::ComputeCorrespondence()
+{
+	for (auto& counts : label_counts_)
+	{
+		counts.second = { 0, 0 };
+	}
+	for (uint l = L1; l <= L2; ++l)
+	{
+		for (const Neuron& n : layers_[l]->neurons)
+		{
+			++label_counts_[n.label][l];
+		}
+	}
+
+	float correspondence = 0.0f;
+	for (auto& counts : label_counts_)
+	{
+		correspondence += min((float)counts.second[L1] / layers_[L1]->size,
+							  (float)counts.second[L2] / layers_[L2]->size);
+	}
+
+	return correspondence;
+}
+
+//=============================================================================
+void LayerCoupler::PropagateSpikeL1toL2(
+	const Neuron& n1,
+	Neuron& n2,
+	int phase)
+{	
+	n2.pot += WEIGHT_MAX_VALUE * 
+		ComputeWeigth(layers_[L1]->GetNeuronId(n1), 
+					  layers_[L2]->GetNeuronId(n2));
+
+	if (n2.pot < layers_[L2]->POT_THRESHOLD || n1.label == n2.label) return;
+
+	layers_[L2]->PropagateLabel(n2, n1.label, phase);
+}
+
+//=============================================================================
+void LayerCoupler::PropagateSpikeL2toL1(
+	const Neuron& n2,
+	Neuron& n1,
+	int phase)
+{
+	n1.pot += WEIGHT_MAX_VALUE * 
+		ComputeWeigth(layers_[L1]->GetNeuronId(n1),
+					  layers_[L2]->GetNeuronId(n2));
+
+	if (n1.pot < layers_[L1]->POT_THRESHOLD || n1.label == n2.label) return;
+
+	layers_[L1]->PropagateLabel(n1, n2.label, phase);
+}
+
+
+//=============================================================================
+//								PixelLayerCoupler
+//=============================================================================
+PixelLayerCoupler::PixelLayerCoupler(
+	PixelLayer* inLayer,
+	PixelLayer* refLayer)
+	:
+	LayerCoupler(inLayer, refLayer)
+{
+}
+
+//=============================================================================
+void PixelLayerCoupler::Layer1SpikeHandler(uint neuron_id, 
+										   uint layer_id,
+										   uint phase)
+{
+	for (auto& n: layers_[L2]->neurons)
+	{
+		PropagateSpikeL1toL2(layers_[L1]->neurons[neuron_id], n, phase);
+	}
+}
+
+//=============================================================================
+void PixelLayerCoupler::Layer2SpikeHandler(uint neuron_id, 
+										   uint layer_id, 
+										   uint phase)
+{
+	for (auto& n: layers_[L1]->neurons)
+	{
+		PropagateSpikeL2toL1(layers_[L2]->neurons[neuron_id], n, phase);
+	}
+}
+
+//=============================================================================
+float PixelLayerCoupler::ComputeFeatDiff(uint idLayer1, uint idLayer2)
+{
+	return abs( (float)
+		static_cast<PixelLayer*>(layers_[L1])->pixel_data[idLayer1] -
+		static_cast<PixelLayer*>(layers_[L2])->pixel_data[idLayer2]);
+}
+
@@ -0,0 +1,78 @@
+/** @file LayerProfiler.cpp
+*
+*  @author Vincent de Ladurantaye
+*/
+
+#include "LayerProfiler.h"
+
+#include <algorithm>
+using namespace std;
+
+//=============================================================================
+//								 ProfileClock
+//=============================================================================
+namespace
+{
+	// Reference times for calibrating the time stamp counter, taken when the
+	// program starts
+	const uint64_t g_start_ticks = ProfileClock::Now();
+	const chrono::steady_clock::time_point g_start_time =
+		chrono::steady_clock::now();
+}
+
+//=============================================================================
+double ProfileClock::GetTicksPerMs()
+{
+#ifdef PROFILE_CLOCK_TSC
+	// Make sure the calibration spans a few milliseconds
+	chrono::steady_clock::time_point now = chrono::steady_clock::now();
+	while (now - g_start_time < chrono::milliseconds(10))
+	{
+		now = chrono::steady_clock::now();
+	}
+	uint64_t ticks = Now();
+
+	double elapsedMs =
+		chrono::duration<double, milli>(now - g_start_time).count();
+	return (ticks - g_start_ticks) / elapsedMs;
+#else
+	typedef chrono::steady_clock::period Period;
+	return (double)Period::den / Period::num / 1000.0;
+#endif
+}
+
+//=============================================================================
+//								 PhaseCounters
+//=============================================================================
+void PhaseCounters::Reset()
+{
+	fill(ticks, ticks + NB_SIM_PHASES, 0);
+	fill(calls, calls + NB_SIM_PHASES, 0);
+	fill(&hw[0][0], &hw[0][0] + NB_SIM_PHASES * NB_HW_COUNTERS, 0);
+	hw_available = 0;
+	spikes = 0;
+	merges = 0;
+}
+
+//=============================================================================
+double PhaseCounters::GetTimeMs(SimPhase a_phase) const
+{
+	return ticks[a_phase] / ProfileClock::GetTicksPerMs();
+}
+
+//=============================================================================
+const char* PhaseCounters::GetPhaseName(SimPhase a_phase)
+{
+	switch (a_phase)
+	{
+	case SIM_PHASE_FIND_TIME_STEP:		return "FindNextTimeStep";
+	case SIM_PHASE_ADVANCE_TIME:		return "AdvanceTime";
+	case SIM_PHASE_FIRE_NEURONS:		return "FireNeurons";
+	case SIM_PHASE_GLOBAL_INHIBITION:	return "GlobalInhibition";
+	case SIM_PHASE_STABILIZATION:		return "GetCoefStabilization";
+	case SIM_PHASE_CYCLE_CHECK:			return "IsCycleCompleted";
+	case SIM_PHASE_MERGE_SEGMENTS:		return "MergeSegments";
+	case SIM_PHASE_TRIGGER_SAME_LABEL:	return "TriggerSameLabelNeurons";
+	default:							return "";
+	}
+}
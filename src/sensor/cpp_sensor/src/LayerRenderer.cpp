@@ -0,0 +1,209 @@
+/**
+* @file LayerRenderer.cpp
+*
+* @authors Vincent de Ladurantaye
+*/
+
+#include "LayerRenderer.h"
+#include "LayerSnapshot.h"
+#include "NeuralLayer.h"
+
+#include <opencv2/imgproc/imgproc.hpp>
+
+#include <cmath>
+#include <cstring>
+using namespace std;
+
+//=============================================================================
+//								 LayerRenderer
+//=============================================================================
+LayerRenderer::LayerRenderer()
+{
+	for (int val = 0; val < 256; ++val)
+	{
+		color_lut_[val].val[0] = ((val + 299) * 37) % 256;
+		color_lut_[val].val[1] = ((val + 199) * 27) % 256;
+		color_lut_[val].val[2] = (val * 13) % 256;
+	}
+
+	// Colormap of each 8 bits value
+	cv::Mat ramp(1, 256, CV_8U);
+	for (int val = 0; val < 256; ++val)
+	{
+		ramp.at<uchar>(0, val) = val;
+	}
+	cv::Mat colors;
+	cv::applyColorMap(ramp, colors, cv::COLORMAP_JET);
+	for (int val = 0; val < 256; ++val)
+	{
+		potential_lut_[val] = colors.at<cv::Vec3b>(0, val);
+	}
+}
+
+//=============================================================================
+template <class ColorRow>
+void LayerRenderer::Render(ColorRow a_color_row, cv::Size a_layer_size,
+						   cv::Mat& a_dst, cv::Size a_size, cv::Rect a_roi,
+						   cv::Point2f a_zoom)
+{
+	if (a_roi.width <= 0 || a_roi.height <= 0)
+		a_roi = cv::Rect(0, 0, a_layer_size.width, a_layer_size.height);
+	a_roi &= cv::Rect(0, 0, a_layer_size.width, a_layer_size.height);
+	if (a_size.width <= 0 || a_size.height <= 0)
+		a_size = cv::Size(a_roi.width, a_roi.height);
+	if (a_zoom.x <= 0 || a_zoom.y <= 0)
+		a_zoom = cv::Point2f((float)a_size.width / a_roi.width,
+							 (float)a_size.height / a_roi.height);
+
+	// Does nothing when the buffer already has the right size
+	a_dst.create(a_size.height, a_size.width, CV_8UC3);
+	if (a_roi.width <= 0 || a_roi.height <= 0 || a_size.width <= 0) return;
+
+	// Same mapping as the monitors, whose last columns and rows may show
+	// the neurons just past the region, clamped to the layer
+	int maxX = a_layer_size.width - 1 - a_roi.x;
+	int maxY = a_layer_size.height - 1 - a_roi.y;
+	col_map_.resize(a_size.width);
+	for (int x = 0; x < a_size.width; ++x)
+	{
+		col_map_[x] = min((int)floor(x / a_zoom.x), maxX);
+	}
+	int nbCols = col_map_.back() + 1;
+	row_colors_.resize(nbCols);
+
+	size_t rowBytes = a_size.width * sizeof(cv::Vec3b);
+	int prevY = -1;
+	for (int y = 0; y < a_size.height; ++y)
+	{
+		cv::Vec3b* disp = a_dst.ptr<cv::Vec3b>(y);
+
+		int roiY = min((int)floor(y / a_zoom.y), maxY);
+		if (roiY == prevY)
+		{
+			memcpy(disp, a_dst.ptr<cv::Vec3b>(y - 1), rowBytes);
+			continue;
+		}
+		prevY = roiY;
+
+		a_color_row(a_roi.y + roiY, a_roi.x, nbCols, row_colors_.data());
+
+		const cv::Vec3b* colors = row_colors_.data();
+		const int* cols = col_map_.data();
+		for (int x = 0; x < a_size.width; ++x)
+		{
+			disp[x] = colors[cols[x]];
+		}
+	}
+}
+
+//=============================================================================
+void LayerRenderer::RenderSegments(const NeuralLayer& a_layer, cv::Mat& a_dst,
+								   cv::Size a_size, cv::Rect a_roi,
+								   cv::Point2f a_zoom)
+{
+	const cv::Vec3b black(0, 0, 0);
+	auto colorRow = [&](int a_y, int a_x, int a_width, cv::Vec3b* a_out)
+	{
+		for (int x = 0; x < a_width; ++x)
+		{
+			const Neuron& n = 
+				a_layer.neurons[a_layer.GetNeuronId(a_x + x, a_y)];
+			a_out[x] = n.phase >= 0 ? GetColor(n.label) : black;
+		}
+	};
+	Render(colorRow, cv::Size(a_layer.width, a_layer.height), a_dst,
+		   a_size, a_roi, a_zoom);
+}
+//-----------------------------------------------------------------------------
+void LayerRenderer::RenderSegments(const LayerSnapshot& a_snapshot,
+								   cv::Mat& a_dst, cv::Size a_size,
+								   cv::Rect a_roi, cv::Point2f a_zoom)
+{
+	const cv::Vec3b black(0, 0, 0);
+	auto colorRow = [&](int a_y, int a_x, int a_width, cv::Vec3b* a_out)
+	{
+		const int* label = a_snapshot.labels.ptr<int>(a_y) + a_x;
+		const int* phase = a_snapshot.phases.ptr<int>(a_y) + a_x;
+		for (int x = 0; x < a_width; ++x)
+		{
+			a_out[x] = phase[x] >= 0 ? GetColor(label[x]) : black;
+		}
+	};
+	Render(colorRow, cv::Size(a_snapshot.labels.cols, a_snapshot.labels.rows),
+		   a_dst, a_size, a_roi, a_zoom);
+}
+
+//=============================================================================
+void LayerRenderer::RenderPhases(const NeuralLayer& a_layer, cv::Mat& a_dst,
+								 cv::Size a_size, cv::Rect a_roi,
+								 cv::Point2f a_zoom)
+{
+	const cv::Vec3b black(0, 0, 0);
+	auto colorRow = [&](int a_y, int a_x, int a_width, cv::Vec3b* a_out)
+	{
+		for (int x = 0; x < a_width; ++x)
+		{
+			const Neuron& n = 
+				a_layer.neurons[a_layer.GetNeuronId(a_x + x, a_y)];
+			a_out[x] = n.phase >= 0 ? GetColor(n.phase * 153) : black;
+		}
+	};
+	Render(colorRow, cv::Size(a_layer.width, a_layer.height), a_dst,
+		   a_size, a_roi, a_zoom);
+}
+//-----------------------------------------------------------------------------
+void LayerRenderer::RenderPhases(const LayerSnapshot& a_snapshot,
+								 cv::Mat& a_dst, cv::Size a_size,
+								 cv::Rect a_roi, cv::Point2f a_zoom)
+{
+	const cv::Vec3b black(0, 0, 0);
+	auto colorRow = [&](int a_y, int a_x, int a_width, cv::Vec3b* a_out)
+	{
+		const int* phase = a_snapshot.phases.ptr<int>(a_y) + a_x;
+		for (int x = 0; x < a_width; ++x)
+		{
+			a_out[x] = phase[x] >= 0 ? GetColor(phase[x] * 153) : black;
+		}
+	};
+	Render(colorRow, cv::Size(a_snapshot.phases.cols, a_snapshot.phases.rows),
+		   a_dst, a_size, a_roi, a_zoom);
+}
+
+//=============================================================================
+void LayerRenderer::RenderPotentials(const NeuralLayer& a_layer,
+									 cv::Mat& a_dst, cv::Size a_size,
+									 cv::Rect a_roi, cv::Point2f a_zoom)
+{
+	float threshold = a_layer.POT_THRESHOLD;
+	auto colorRow = [&](int a_y, int a_x, int a_width, cv::Vec3b* a_out)
+	{
+		for (int x = 0; x < a_width; ++x)
+		{
+			const Neuron& n = 
+				a_layer.neurons[a_layer.GetNeuronId(a_x + x, a_y)];
+			float val = -(log10(threshold - n.pot) - 1) * 128;
+			a_out[x] = potential_lut_[cv::saturate_cast<uchar>(val)];
+		}
+	};
+	Render(colorRow, cv::Size(a_layer.width, a_layer.height), a_dst,
+		   a_size, a_roi, a_zoom);
+}
+//-----------------------------------------------------------------------------
+void LayerRenderer::RenderPotentials(const LayerSnapshot& a_snapshot,
+									 float a_threshold, cv::Mat& a_dst,
+									 cv::Size a_size, cv::Rect a_roi,
+									 cv::Point2f a_zoom)
+{
+	auto colorRow = [&](int a_y, int a_x, int a_width, cv::Vec3b* a_out)
+	{
+		const float* pot = a_snapshot.potentials.ptr<float>(a_y) + a_x;
+		for (int x = 0; x < a_width; ++x)
+		{
+			float val = -(log10(a_threshold - pot[x]) - 1) * 128;
+			a_out[x] = potential_lut_[cv::saturate_cast<uchar>(val)];
+		}
+	};
+	Render(colorRow,
+		   cv::Size(a_snapshot.potentials.cols, a_snapshot.potentials.rows),
+		   a_dst, a_size, a_roi, a_zoom);
+}
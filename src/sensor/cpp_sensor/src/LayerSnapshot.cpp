@@ -0,0 +1,38 @@
+/**
+* @file LayerSnapshot.cpp
+*
+* @authors Vincent de Ladurantaye
+*/
+
+#include "LayerSnapshot.h"
+
+using namespace std;
+
+//=============================================================================
+//								SnapshotBuffer
+//=============================================================================
+SnapshotBuffer::SnapshotBuffer() :
+	write_(0),
+	read_(1),
+	middle_(2),
+	has_snapshot_(false)
+{
+}
+
+//=============================================================================
+void SnapshotBuffer::Publish()
+{
+	// The release makes the capture visible to the consumer taking the
+	// snapshot, the acquire makes sure it is done reading the one we get back
+	write_ = middle_.exchange(write_ | NEW_FLAG, memory_order_acq_rel) & 3;
+}
+
+//=============================================================================
+bool SnapshotBuffer::Consume()
+{
+	if ((middle_.load(memory_order_relaxed) & NEW_FLAG) == 0) return false;
+
+	read_ = middle_.exchange(read_, memory_order_acq_rel) & 3;
+	has_snapshot_ = true;
+	return true;
+}
@@ -0,0 +1,303 @@
+/**
+* @file LayerState.cpp
+*
+* @authors Vincent de Ladurantaye
+*/
+#include "LayerState.h"
+#include "Neuron.h"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#if defined(__linux__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define LAYER_STATE_MMAP
+#endif
+
+using namespace std;
+
+namespace
+{
+	const char LAYER_STATE_MAGIC[8] = { 'S', 'N', 'S', 'R', 'L', 'Y', 'R', 0 };
+	const uint32_t LAYER_STATE_BYTE_ORDER = 0x01020304;
+
+	// Alignment of the sections
+	const size_t SECTION_ALIGN = 64;
+
+	inline size_t AlignSection(size_t a_offset)
+	{
+		return (a_offset + SECTION_ALIGN - 1) / SECTION_ALIGN * SECTION_ALIGN;
+	}
+}
+
+//=============================================================================
+//								LayerStateWriter
+//=============================================================================
+LayerStateWriter::LayerStateWriter(size_t a_capacity)
+{
+	bytes_.reserve(AlignSection(sizeof(LayerStateHeader)) + a_capacity);
+	bytes_.resize(sizeof(LayerStateHeader), 0);
+}
+
+//=============================================================================
+char* LayerStateWriter::AddSection(uint32_t a_tag, size_t a_size)
+{
+	LayerStateSectionEntry entry;
+	entry.tag = a_tag;
+	entry.reserved = 0;
+	entry.offset = AlignSection(bytes_.size());
+	entry.size = a_size;
+	sections_.push_back(entry);
+
+	bytes_.resize(entry.offset + a_size, 0);
+	return bytes_.data() + entry.offset;
+}
+//-----------------------------------------------------------------------------
+
+void LayerStateWriter::AddSection(uint32_t a_tag, const void* a_data,
+								  size_t a_size)
+{
+	char* section = AddSection(a_tag, a_size);
+	if (a_size > 0) memcpy(section, a_data, a_size);
+}
+
+//=============================================================================
+char* LayerStateWriter::GetSection(uint32_t a_tag, size_t* a_size)
+{
+	for (const LayerStateSectionEntry& entry : sections_)
+	{
+		if (entry.tag != a_tag) continue;
+
+		if (a_size) *a_size = entry.size;
+		return bytes_.data() + entry.offset;
+	}
+
+	return nullptr;
+}
+
+//=============================================================================
+vector<char> LayerStateWriter::Finish()
+{
+	// The section table is at the end so that the sections can be added
+	// without knowing how many there will be
+	size_t tableSize = sections_.size() * sizeof(LayerStateSectionEntry);
+	size_t tableOffset = AlignSection(bytes_.size());
+	bytes_.resize(tableOffset + tableSize, 0);
+	if (tableSize > 0)
+		memcpy(bytes_.data() + tableOffset, sections_.data(), tableSize);
+
+	LayerStateHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, LAYER_STATE_MAGIC, sizeof(header.magic));
+	header.version = LAYER_STATE_VERSION;
+	header.byte_order = LAYER_STATE_BYTE_ORDER;
+	header.neuron_size = sizeof(Neuron);
+	header.nb_sections = (uint32_t)sections_.size();
+	header.table_offset = tableOffset;
+	header.total_size = bytes_.size();
+	memcpy(bytes_.data(), &header, sizeof(header));
+
+	vector<char> state;
+	state.swap(bytes_);
+	sections_.clear();
+	bytes_.resize(sizeof(LayerStateHeader), 0);
+
+	return state;
+}
+
+//=============================================================================
+//								   MappedFile
+//=============================================================================
+MappedFile::MappedFile() :
+	data_(nullptr),
+	size_(0),
+	mapped_(false)
+{
+}
+
+//=============================================================================
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+//=============================================================================
+bool MappedFile::Open(const string& a_filename)
+{
+	Close();
+
+#ifdef LAYER_STATE_MMAP
+	int fd = open(a_filename.c_str(), O_RDONLY);
+	if (fd < 0) return false;
+
+	struct stat fileStat;
+	if (fstat(fd, &fileStat) != 0)
+	{
+		close(fd);
+		return false;
+	}
+
+	// Empty files can't be mapped, they are read like on other systems
+	if (fileStat.st_size > 0)
+	{
+		void* data = mmap(nullptr, (size_t)fileStat.st_size, PROT_READ,
+						  MAP_PRIVATE, fd, 0);
+		close(fd);
+		if (data == MAP_FAILED) return false;
+
+		data_ = (const char*)data;
+		size_ = (size_t)fileStat.st_size;
+		mapped_ = true;
+		return true;
+	}
+	close(fd);
+#endif
+
+	ifstream inFile(a_filename, ios::binary | ios::ate);
+	if (!inFile) return false;
+
+	buffer_.resize((size_t)inFile.tellg());
+	inFile.seekg(0);
+	if (!inFile.read(buffer_.data(), buffer_.size()))
+	{
+		vector<char>().swap(buffer_);
+		return false;
+	}
+
+	data_ = buffer_.data();
+	size_ = buffer_.size();
+	return true;
+}
+
+//=============================================================================
+void MappedFile::Close()
+{
+#ifdef LAYER_STATE_MMAP
+	if (mapped_) munmap((void*)data_, size_);
+#endif
+	vector<char>().swap(buffer_);
+
+	data_ = nullptr;
+	size_ = 0;
+	mapped_ = false;
+}
+
+//=============================================================================
+//								 LayerStateView
+//=============================================================================
+LayerStateView::LayerStateView() :
+	data_(nullptr),
+	size_(0),
+	sections_(nullptr),
+	nb_sections_(0)
+{
+}
+
+//=============================================================================
+bool LayerStateView::Open(const string& a_filename)
+{
+	if (!file_.Open(a_filename))
+	{
+		cerr << "Failed to open layer state " << a_filename << '\n';
+		return false;
+	}
+
+	return Parse(file_.GetData(), file_.GetSize());
+}
+
+//=============================================================================
+bool LayerStateView::Parse(const char* a_data, size_t a_size)
+{
+	data_ = nullptr;
+	size_ = 0;
+	sections_ = nullptr;
+	nb_sections_ = 0;
+
+	if (a_size < sizeof(LayerStateHeader) ||
+		memcmp(a_data, LAYER_STATE_MAGIC, sizeof(LAYER_STATE_MAGIC)) != 0)
+	{
+		cerr << "Not a layer state\n";
+		return false;
+	}
+
+	// The sections are used in place, so they must be aligned like they
+	// were when written
+	if ((uintptr_t)a_data % alignof(uint64_t) != 0)
+	{
+		cerr << "Layer state isn't aligned in memory\n";
+		return false;
+	}
+
+	const LayerStateHeader* header = (const LayerStateHeader*)a_data;
+	if (header->version != LAYER_STATE_VERSION)
+	{
+		cerr << "Layer state version " << header->version
+			<< " isn't supported, expected " << LAYER_STATE_VERSION << '\n';
+		return false;
+	}
+	if (header->byte_order != LAYER_STATE_BYTE_ORDER ||
+		header->neuron_size != sizeof(Neuron))
+	{
+		cerr << "Layer state was written by an incompatible build\n";
+		return false;
+	}
+
+	size_t tableSize = header->nb_sections * sizeof(LayerStateSectionEntry);
+	if (header->total_size != a_size ||
+		header->table_offset % alignof(LayerStateSectionEntry) != 0 ||
+		header->table_offset > a_size ||
+		tableSize > a_size - header->table_offset)
+	{
+		cerr << "Layer state is truncated or corrupted\n";
+		return false;
+	}
+
+	const LayerStateSectionEntry* sections =
+		(const LayerStateSectionEntry*)(a_data + header->table_offset);
+	for (uint32_t s = 0; s < header->nb_sections; ++s)
+	{
+		if (sections[s].offset % SECTION_ALIGN != 0 ||
+			sections[s].offset > a_size ||
+			sections[s].size > a_size - sections[s].offset)
+		{
+			cerr << "Layer state is truncated or corrupted\n";
+			return false;
+		}
+	}
+
+	data_ = a_data;
+	size_ = a_size;
+	sections_ = sections;
+	nb_sections_ = header->nb_sections;
+	return true;
+}
+
+//=============================================================================
+const char* LayerStateView::GetSection(uint32_t a_tag, size_t* a_size) const
+{
+	for (uint32_t s = 0; s < nb_sections_; ++s)
+	{
+		if (sections_[s].tag != a_tag) continue;
+
+		if (a_size) *a_size = (size_t)sections_[s].size;
+		return data_ + sections_[s].offset;
+	}
+
+	if (a_size) *a_size = 0;
+	return nullptr;
+}
+
+//=============================================================================
+bool LayerStateView::IsStateFile(const string& a_filename)
+{
+	ifstream inFile(a_filename, ios::binary);
+
+	char magic[sizeof(LAYER_STATE_MAGIC)];
+	if (!inFile.read(magic, sizeof(magic))) return false;
+
+	return memcmp(magic, LAYER_STATE_MAGIC, sizeof(magic)) == 0;
+}
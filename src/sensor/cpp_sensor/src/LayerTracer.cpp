@@ -0,0 +1,264 @@
+/** @file LayerTracer.cpp
+*
+*  @author Vincent de Ladurantaye
+*/
+
+#include "LayerTracer.h"
+#include "LayerProfiler.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <vector>
+using namespace std;
+
+//=============================================================================
+//								  ThreadTrace
+//=============================================================================
+/**
+* Event recorded by the tracer
+*/
+struct TraceEvent
+{
+	// Time of the event, in ticks of ProfileClock
+	uint64_t ticks;
+	// Duration of a complete event, in ticks
+	uint64_t duration;
+	// Name of the event, a string literal
+	const char* name;
+	// Layer of the event
+	uint layer_id;
+	// Argument of a begin event, value of a counter event
+	int value;
+	// Type of the event in the trace event format: 'X' or 'C'
+	char type;
+};
+
+/**
+* Ring buffer of the events of a thread
+*/
+struct ThreadTrace
+{
+	// Id of the track of the thread
+	uint tid;
+	// Name of the track of the thread
+	string name;
+
+	vector<TraceEvent> events;
+	// Position of the next event
+	size_t next;
+	// Flag indicating if the oldest events were overwritten
+	bool wrapped;
+
+	// Events begun and not ended yet, the innermost last
+	vector<TraceEvent> open;
+};
+
+//=============================================================================
+//						Static members declarations
+//=============================================================================
+atomic<bool> LayerTracer::active_(false);
+list<shared_ptr<ThreadTrace> > LayerTracer::threads_;
+mutex LayerTracer::mutex_;
+
+//=============================================================================
+//								  LayerTracer
+//=============================================================================
+void LayerTracer::Start()
+{
+	Clear();
+	active_.store(true, memory_order_relaxed);
+}
+
+//=============================================================================
+void LayerTracer::Stop()
+{
+	active_.store(false, memory_order_relaxed);
+}
+
+//=============================================================================
+void LayerTracer::Clear()
+{
+	lock_guard<mutex> lock(mutex_);
+	for (auto& thread : threads_)
+	{
+		if (!thread->events.empty())
+			thread->events.resize(max(1u, Config::TRACE_BUFFER_SIZE));
+		thread->next = 0;
+		thread->wrapped = false;
+		thread->open.clear();
+	}
+}
+
+//=============================================================================
+void LayerTracer::SetThreadName(const string& a_name)
+{
+	ThreadTrace& trace = GetThreadTrace();
+
+	lock_guard<mutex> lock(mutex_);
+	trace.name = a_name;
+}
+
+//=============================================================================
+void LayerTracer::Begin(const char* a_name, uint a_layer_id, int a_arg)
+{
+	ThreadTrace& trace = GetThreadTrace();
+
+	TraceEvent event;
+	event.ticks = ProfileClock::Now();
+	event.duration = 0;
+	event.name = a_name;
+	event.layer_id = a_layer_id;
+	event.value = a_arg;
+	event.type = 'X';
+	trace.open.push_back(event);
+}
+
+//=============================================================================
+void LayerTracer::End(const char* a_name, uint a_layer_id)
+{
+	ThreadTrace& trace = GetThreadTrace();
+	if (trace.open.empty()) return;
+
+	// An end of another event than the last one begun would record the 
+	// wrong event, it is dropped
+	const TraceEvent& event = trace.open.back();
+	if (event.layer_id != a_layer_id || strcmp(event.name, a_name) != 0)
+		return;
+
+	Record('X', event.name, event.layer_id, event.value, event.ticks,
+		   ProfileClock::Now() - event.ticks);
+	trace.open.pop_back();
+}
+
+//=============================================================================
+void LayerTracer::Counter(const char* a_name, uint a_layer_id, int a_value)
+{
+	Record('C', a_name, a_layer_id, a_value, ProfileClock::Now(), 0);
+}
+
+//=============================================================================
+ThreadTrace& LayerTracer::GetThreadTrace()
+{
+	static thread_local ThreadTrace* t_trace = nullptr;
+	if (t_trace) return *t_trace;
+
+	lock_guard<mutex> lock(mutex_);
+	shared_ptr<ThreadTrace> trace(new ThreadTrace);
+	trace->tid = threads_.size() + 1;
+	trace->name = "Thread";
+	trace->next = 0;
+	trace->wrapped = false;
+	threads_.push_back(trace);
+
+	t_trace = trace.get();
+	return *t_trace;
+}
+
+//=============================================================================
+void LayerTracer::Record(char a_type, const char* a_name, uint a_layer_id,
+						 int a_value, uint64_t a_ticks, uint64_t a_duration)
+{
+	ThreadTrace& trace = GetThreadTrace();
+
+	// The buffer is allocated with the first event of the thread
+	if (trace.events.empty())
+		trace.events.resize(max(1u, Config::TRACE_BUFFER_SIZE));
+
+	TraceEvent& event = trace.events[trace.next];
+	event.ticks = a_ticks;
+	event.duration = a_duration;
+	event.name = a_name;
+	event.layer_id = a_layer_id;
+	event.value = a_value;
+	event.type = a_type;
+
+	if (++trace.next == trace.events.size())
+	{
+		trace.next = 0;
+		trace.wrapped = true;
+	}
+}
+
+//=============================================================================
+string LayerTracer::GetChromeTrace()
+{
+	lock_guard<mutex> lock(mutex_);
+
+	// Times are given in microseconds from the first event. The events are
+	// recorded when they end, so the first one isn't necessarily the oldest.
+	uint64_t firstTicks = UINT64_MAX;
+	for (auto& thread : threads_)
+	{
+		size_t nbEvents = thread->wrapped ? thread->events.size()
+										  : thread->next;
+		for (size_t e = 0; e < nbEvents; ++e)
+		{
+			firstTicks = min(firstTicks, thread->events[e].ticks);
+		}
+	}
+	double ticksPerUs = ProfileClock::GetTicksPerMs() / 1000.0;
+
+	ostringstream json;
+	json << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+	bool firstEvent = true;
+	char ts[32];
+	for (auto& thread : threads_)
+	{
+		if (!thread->wrapped && thread->next == 0) continue;
+
+		// Name of the track
+		if (!firstEvent) json << ',';
+		firstEvent = false;
+		json << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+			<< thread->tid << ",\"args\":{\"name\":\"" << thread->name << ' '
+			<< thread->tid << "\"}}";
+
+		size_t nbEvents = thread->wrapped ? thread->events.size()
+										  : thread->next;
+		size_t first = thread->wrapped ? thread->next : 0;
+		for (size_t e = 0; e < nbEvents; ++e)
+		{
+			const TraceEvent& event =
+				thread->events[(first + e) % thread->events.size()];
+
+			snprintf(ts, sizeof(ts), "%.3f",
+					 (event.ticks - firstTicks) / ticksPerUs);
+
+			json << ",\n{\"name\":\"" << event.name;
+			// Counters of different layers are on separate tracks
+			if (event.type == 'C') json << " (layer " << event.layer_id << ')';
+			json << "\",\"ph\":\"" << event.type << "\",\"ts\":" << ts
+				<< ",\"pid\":1,\"tid\":" << thread->tid;
+
+			switch (event.type)
+			{
+			case 'X':
+				snprintf(ts, sizeof(ts), "%.3f", event.duration / ticksPerUs);
+				json << ",\"dur\":" << ts << ",\"args\":{\"layer\":"
+					<< event.layer_id << ",\"n\":" << event.value << '}';
+				break;
+			case 'C':
+				json << ",\"args\":{\"value\":" << event.value << '}';
+				break;
+			}
+			json << '}';
+		}
+	}
+
+	json << "\n]}\n";
+	return json.str();
+}
+
+//=============================================================================
+bool LayerTracer::WriteChromeTrace(const string& a_filename)
+{
+	ofstream file(a_filename.c_str(), ios::binary);
+	if (!file) return false;
+
+	file << GetChromeTrace();
+	return file.good();
+}
@@ -1,288 +1,697 @@
-/** @file NeuralLayer.cpp
-*
-*
-*  @author Vincent de Ladurantaye
-*/
-
-#include "NeuralLayer.h"
-#include "LayerDebugger.h"
-
-#include <iostream>
-#include <fstream>
-using namespace std;
-
-//=============================================================================
-//						Static members declarations
-//=============================================================================
-uint NeuralLayer::layer_id_counter_ = 0;
-uint NeuralLayer::label_counter_ = 0;
-
-//=============================================================================
-//									NeuralLayer
-//=============================================================================
-NeuralLayer::NeuralLayer(const ImageData& a_data, int a_layer_id):
-	width(a_data.cols),
-	height(a_data.rows),
-	size(a_data.size),
-	layer_id(a_layer_id),
-	img_data_(a_data),
-	active_reg_(0, 0, 0, 0),
-	sim_time(0.0f),
-	n_cycles(0),
-	n_cascades(0),
-	n_spikes(0),
-	POT_THRESHOLD(Config::POT_THRESHOLD),
-	TAU(Config::TAU),
-	GLOBAL_INHIB_VAL(Config::GLOBAL_INHIB_VAL),
-	CHARGING_LEADER(Config::CHARGING_LEADER),
-	CHARGING_FOLLOW(Config::CHARGING_FOLLOWER)
-{
-	if (a_layer_id == -1) layer_id = layer_id_counter_++;
-
-	// Set the layer size
-	width = a_data.cols;
-	height = a_data.rows;
-	size = a_data.size;
-
-	// Set the layer active region as the whole layer
-	active_reg_.x = 0;
-	active_reg_.y = 0;
-	active_reg_.width = width;
-	active_reg_.height = height;
-
-	// Create the neurons using std::vector::assign()
-	neurons.assign(width*height, Neuron());
-	for (int i = 0; i < size; ++i)
-	{
-		neurons[i].id = i;
-		neurons[i].pos.x = i % width;
-		neurons[i].pos.y = i / width;
-		neurons[i].label = label_counter_++;
-	}
-
-}
-
-//=============================================================================
-NeuralLayer::~NeuralLayer()
-{
-}
-
-//=============================================================================
-float NeuralLayer::FindNextTimeStep()
-{
-	int id;
-	float max = 0;
-	// Iterate through all neurons
-	for (auto& n: neurons)
-	{
-		// Find the max neuron that has a charging potential greater than the 
-		// threshold
-		if (n.max_charge > POT_THRESHOLD && n.pot > max)
-		{
-			max = n.pot;
-			id = n.id;
-		}
-	}
-
-	if (max >= POT_THRESHOLD) return 0;
-
-	// Calculate the charging time statically to calculate it only once. 
-	// Charging time is the time needed for a neuron with 0 potential to spike.
-	static float chargingTime = TAU * log(CHARGING_LEADER
-										  / (CHARGING_LEADER - POT_THRESHOLD));
-	// Return the time needed for the max neuron to spike
-	return chargingTime - TAU * log(CHARGING_LEADER / (CHARGING_LEADER -max));
-}
-
-//=============================================================================
-void NeuralLayer::AdvanceTime(float a_delta)
-{
-	if (a_delta == 0) return;
-
-	// Calculate the exponential of delta before the loop
-	float expDelta = exp(-a_delta /TAU);
-
-	// Iterate through all neurons
-	for (int y=active_reg_.y; y<active_reg_.height; ++y) for 
-		(int x=active_reg_.x; x<active_reg_.width; ++x)
-	{
-		int i = y*width + x;
-
-		// If the potential is negative, set it to 0
-		if (neurons[i].pot < 0) neurons[i].pot = 0;
-
-		// Set the new potential
-		neurons[i].pot = neurons[i].max_charge - expDelta *
-			(neurons[i].max_charge - neurons[i].pot);
-	}
-}
-
-//=============================================================================
-int NeuralLayer::FireNeurons(int a_phase, float a_sim_time)
-{
-	int spikeCount = 0; // Counter for the number of spikes
-
-	// Iterate through all neurons in the active region of the layer
-	for (int y=active_reg_.y; y<active_reg_.height; ++y)
-	for (int x=active_reg_.x; x<active_reg_.width; ++x)
-	{
-		int i = y*width + x;
-
-		Neuron& neuron = neurons[i];
-		// If the potential is above the threshold
-		if (neuron.pot >= POT_THRESHOLD)
-		{
-			// Increment the number of spikes
-			spikeCount++;
-
-			// Propagate the spike within the layer
-			PropagateSpike(i, a_phase);
-
-			// Propagate the spike out of the layer
-			if (PropagateSpikeOutOfLayer) 
-				PropagateSpikeOutOfLayer(i, layer_id, a_phase);
-
-			neuron.Spike(a_phase, a_sim_time);
-
-#ifdef LAYER_DEBUGGER
-			LayerDebugger::SetBreakpoint(*this, DEBUG_LEVEL_SPIKE, i);
-#endif
-		}
-	}
-
-	n_spikes += spikeCount;
-	return spikeCount;
-}
-
-//=============================================================================
-bool NeuralLayer::IsCycleCompleted()
-{
-	// Iterate through all neurons
-	for (int y=active_reg_.y; y<active_reg_.height; ++y)
-	for (int x=active_reg_.x; x<active_reg_.width; ++x)
-	{
-		int i = y*width + x;
-
-		if (neurons[i].max_charge == CHARGING_LEADER
-			&& neurons[i].cycle_spiked == false)
-			return false;
-	}
-
-	return true;
-}
-
-//=============================================================================
-void NeuralLayer::ResetCycle()
-{
-	for (int i=0; i<size; ++i)
-	{
-		neurons[i].cycle_spiked = false;
-	}
-}
-
-//=============================================================================
-void NeuralLayer::GlobalInhibition()
-{
-	// Iterate through all neurons
-	for (int y=active_reg_.y; y<active_reg_.height; ++y)
-	for (int x=active_reg_.x; x<active_reg_.width; ++x)
-	{
-		int i = y*width + x;
-
-		// Inhibate the neuron that didn't fire
-		if (neurons[i].pot > 0) neurons[i].pot -= GLOBAL_INHIB_VAL;
-
-		// If the potential is negative, set it to 0
-		if (neurons[i].pot < 0) neurons[i].pot = 0;
-	}
-}
-
-//=============================================================================
-float NeuralLayer::GetCoefStabilization(int a_min_phase)
-{
-	double sumDP; // Sum of all deltaPeriod for regions higher than minRegion
-	int    qtyDP; // How many deltaPeriod added
-
-	sumDP = 0.0;
-	qtyDP = 0;
-
-	// Iterate through all neurons
-	for (int y = active_reg_.y; y < active_reg_.height; ++y)
-	for (int x = active_reg_.x; x < active_reg_.width; ++x)
-	{
-		int i = y * width + x;
-
-		Neuron& neuron = neurons[i];
-
-		if (neuron.phase > a_min_phase)
-		{
-			qtyDP++;
-			sumDP += fabs(neuron.delta_period);
-		}
-	}
-
-	if (qtyDP > 0)
-	{
-		return (sumDP / qtyDP);
-	}
-	else
-	{
-		return (1.0);
-	}
-}
-
-//=============================================================================
-void NeuralLayer::SaveStateToFile(string a_filename)
-{
-	// Open the output file
-	ofstream outFile(a_filename);
-	// Check if we were able to open it
-	if (!outFile)
-	{
-		cerr << "Failed open file " << a_filename << '\n';
-		return;
-	}
-
-	outFile << "id" << '\t' << "label" << '\t' << "potential" << endl;
-
-	for (auto& n: neurons)
-	{
-		outFile << n.id << '\t' << n.label << '\t' << n.pot << endl;
-	}
-
-	outFile.close();
-}
-
-//=============================================================================
-bool NeuralLayer::ValidateLayerState(string a_validationFilename)
-{
-	// Open the validation file
-	ifstream inFile(a_validationFilename);
-
-	// Check if we were able to open it
-	if (!inFile)
-	{
-		cerr << "Failed to load validation file: " << a_validationFilename
-			<< '\n';
-		return false;
-	}
-
-	// Get the first line which doesn't contain neuron data
-	string line;
-	getline(inFile, line);
-
-	int id, label;
-	float pot;
-	for (auto& n : neurons)
-	{
-		//getline(inFile, line);
-		inFile >> id >> label >> pot;
-
-		if (id != n.id || label != n.label || abs(pot - n.pot) > 0.0005f)
-		{
-			return false;
-		}
-	}
-
-	return true;
-}
+/** @file NeuralLayer.cpp
+*
+*
+*  @author Vincent de Ladurantaye
+*/
+
+#include "NeuralLayer.h"
+#include "LayerDebugger.h"
+#include "LayerSnapshot.h"
+#include "LayerState.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <fstream>
+#include <stdexcept>
+using namespace std;
+
+//=============================================================================
+//						Static members declarations
+//=============================================================================
+atomic<uint> NeuralLayer::layer_id_counter_(0);
+atomic<uint> NeuralLayer::label_counter_(0);
+
+//=============================================================================
+//									NeuralLayer
+//=============================================================================
+NeuralLayer::NeuralLayer(const ImageData& a_data, int a_layer_id):
+	width(a_data.cols),
+	height(a_data.rows),
+	size(a_data.size),
+	layer_id(a_layer_id),
+	img_data_(a_data),
+	n_frozen_(0),
+	frozen_delta_sum_(0.0),
+	sim_time(0.0f),
+	n_cycles(0),
+	n_cascades(0),
+	n_spikes(0),
+	POT_THRESHOLD(Config::POT_THRESHOLD),
+	TAU(Config::TAU),
+	GLOBAL_INHIB_VAL(Config::GLOBAL_INHIB_VAL),
+	CHARGING_LEADER(Config::CHARGING_LEADER),
+	CHARGING_FOLLOW(Config::CHARGING_FOLLOWER),
+	NEURON_LAYOUT(Config::SIM_NEURON_LAYOUT),
+	TILE_SIZE(max(1u, Config::SIM_LAYOUT_TILE_SIZE))
+{
+	if (a_layer_id == -1) layer_id = layer_id_counter_++;
+
+	// Set the layer size
+	width = a_data.cols;
+	height = a_data.rows;
+	size = a_data.size;
+
+	// Set the layer active region as the whole layer
+	active_regs_.push_back(cv::Rect(0, 0, width, height));
+	UpdateActiveSpans();
+
+	// Create the neurons using std::vector::assign(). The labels of the
+	// layer are reserved at once.
+	neurons.assign(width*height, Neuron());
+	uint firstLabel = label_counter_.fetch_add(size);
+	for (int i = 0; i < size; ++i)
+	{
+		neurons[i].label = firstLabel + i;
+	}
+
+	cycle_spiked.assign(size, false);
+	is_segmented.assign(size, false);
+
+	// The neurons don't charge until their features are known
+	charge_levels_.assign(1, 0.0f);
+	charge_ids_.assign(size, 0);
+}
+
+//=============================================================================
+NeuralLayer::~NeuralLayer()
+{
+}
+
+//=============================================================================
+float NeuralLayer::FindNextTimeStep()
+{
+	LayerProfileHooks::Timer timer(phase_counters_, SIM_PHASE_FIND_TIME_STEP);
+
+	const float* levels = charge_levels_.data();
+	const uint8_t* chargeIds = charge_ids_.data();
+
+	float max = 0;
+	// Iterate through the neurons of the active region, in memory order
+	for (auto& span : active_spans_)
+	for (uint i = span.begin; i < span.end; ++i)
+	{
+		const Neuron& n = neurons[i];
+
+		// Find the max neuron that has a charging potential greater than the 
+		// threshold
+		if (levels[chargeIds[i]] > POT_THRESHOLD && n.pot > max)
+		{
+			max = n.pot;
+		}
+	}
+
+	if (max >= POT_THRESHOLD) return 0;
+
+	// Calculate the charging time statically to calculate it only once. 
+	// Charging time is the time needed for a neuron with 0 potential to spike.
+	static float chargingTime = TAU * log(CHARGING_LEADER
+										  / (CHARGING_LEADER - POT_THRESHOLD));
+	// Return the time needed for the max neuron to spike
+	return chargingTime - TAU * log(CHARGING_LEADER / (CHARGING_LEADER -max));
+}
+
+//=============================================================================
+void NeuralLayer::AdvanceTime(float a_delta)
+{
+	if (a_delta == 0) return;
+
+	LayerProfileHooks::Timer timer(phase_counters_, SIM_PHASE_ADVANCE_TIME);
+
+	// Calculate the exponential of delta before the loop
+	float expDelta = exp(-a_delta /TAU);
+
+	const float* levels = charge_levels_.data();
+	const uint8_t* chargeIds = charge_ids_.data();
+
+	// Iterate through the neurons of the active region, in memory order
+	for (auto& span : active_spans_)
+	for (uint i = span.begin; i < span.end; ++i)
+	{
+		// If the potential is negative, set it to 0
+		if (neurons[i].pot < 0) neurons[i].pot = 0;
+
+		// Set the new potential
+		float maxCharge = levels[chargeIds[i]];
+		neurons[i].pot = maxCharge - expDelta * (maxCharge - neurons[i].pot);
+	}
+}
+
+//=============================================================================
+int NeuralLayer::FireNeurons(int a_phase, float a_sim_time)
+{
+	return FireNeurons(a_phase, a_sim_time, active_spans_);
+}
+//-----------------------------------------------------------------------------
+int NeuralLayer::FireNeurons(int a_phase, float a_sim_time,
+							 const vector<NeuronSpan>& a_spans)
+{
+	LayerProfileHooks::Timer timer(phase_counters_, SIM_PHASE_FIRE_NEURONS);
+	LayerProfileHooks::TraceBegin("Wave", layer_id, a_phase);
+
+	int spikeCount = 0; // Counter for the number of spikes
+
+	// Iterate through the neurons of the spans, in memory order
+	for (auto& span : a_spans)
+	for (uint i = span.begin; i < span.end; ++i)
+	{
+		Neuron& neuron = neurons[i];
+		// If the potential is above the threshold
+		if (neuron.pot >= POT_THRESHOLD)
+		{
+			// Increment the number of spikes
+			spikeCount++;
+
+			// Propagate the spike within the layer
+			PropagateSpike(i, a_phase);
+
+			// Propagate the spike out of the layer
+			if (PropagateSpikeOutOfLayer) 
+				PropagateSpikeOutOfLayer(i, layer_id, a_phase);
+
+			neuron.Spike(a_phase, a_sim_time);
+			cycle_spiked[i] = true;
+
+			LayerDebugHooks::Spike(*this, i);
+		}
+	}
+
+	n_spikes += spikeCount;
+	LayerProfileHooks::CountSpikes(phase_counters_, spikeCount);
+	LayerProfileHooks::TraceEnd("Wave", layer_id);
+	LayerProfileHooks::TraceCounter("Spikes", layer_id, spikeCount);
+	return spikeCount;
+}
+
+//=============================================================================
+bool NeuralLayer::IsCycleCompleted()
+{
+	LayerProfileHooks::Timer timer(phase_counters_, SIM_PHASE_CYCLE_CHECK);
+
+	// Iterate through the neurons of the active region, in memory order
+	for (auto& span : active_spans_)
+	for (uint i = span.begin; i < span.end; ++i)
+	{
+		if (GetMaxCharge(i) == CHARGING_LEADER && cycle_spiked[i] == false)
+			return false;
+	}
+
+	return true;
+}
+
+//=============================================================================
+void NeuralLayer::SetMaxCharge(uint a_id, float a_max_charge)
+{
+	auto level = find(charge_levels_.begin(), charge_levels_.end(),
+					  a_max_charge);
+	if (level == charge_levels_.end())
+	{
+		if (charge_levels_.size() > UINT8_MAX)
+		{
+			throw runtime_error("A layer can't have more than 256 distinct "
+								"maximal charges");
+		}
+		level = charge_levels_.insert(level, a_max_charge);
+	}
+
+	charge_ids_[a_id] = (uint8_t)(level - charge_levels_.begin());
+}
+
+//=============================================================================
+void NeuralLayer::ResetCycle()
+{
+	// Bitset assignment, equivalent to a memset
+	cycle_spiked.assign(size, false);
+}
+
+//=============================================================================
+void NeuralLayer::GlobalInhibition()
+{
+	LayerProfileHooks::Timer timer(phase_counters_, 
+								   SIM_PHASE_GLOBAL_INHIBITION);
+
+	// Iterate through the neurons of the active region, in memory order
+	for (auto& span : active_spans_)
+	for (uint i = span.begin; i < span.end; ++i)
+	{
+		// Inhibate the neuron that didn't fire
+		if (neurons[i].pot > 0) neurons[i].pot -= GLOBAL_INHIB_VAL;
+
+		// If the potential is negative, set it to 0
+		if (neurons[i].pot < 0) neurons[i].pot = 0;
+	}
+}
+
+//=============================================================================
+float NeuralLayer::GetCoefStabilization(int a_min_phase)
+{
+	LayerProfileHooks::Timer timer(phase_counters_, SIM_PHASE_STABILIZATION);
+
+	double sumDP; // Sum of all deltaPeriod for regions higher than minRegion
+	int    qtyDP; // How many deltaPeriod added
+
+	// Frozen neurons are stable, they count with their delta period from the
+	// time they were frozen
+	sumDP = frozen_delta_sum_;
+	qtyDP = n_frozen_;
+
+	// Iterate through the neurons of the active region, in memory order
+	for (auto& span : active_spans_)
+	for (uint i = span.begin; i < span.end; ++i)
+	{
+		Neuron& neuron = neurons[i];
+
+		if (neuron.phase > a_min_phase)
+		{
+			qtyDP++;
+			sumDP += fabs(neuron.delta_period);
+		}
+	}
+
+	if (qtyDP > 0)
+	{
+		return (sumDP / qtyDP);
+	}
+	else
+	{
+		return (1.0);
+	}
+}
+
+//=============================================================================
+void NeuralLayer::SetActiveRegions(const vector<cv::Rect>& a_regions)
+{
+	active_regs_ = a_regions;
+	UpdateActiveSpans();
+}
+//-----------------------------------------------------------------------------
+void NeuralLayer::SetActiveRegion(const cv::Rect& a_region)
+{
+	SetActiveRegions(vector<cv::Rect>(1, a_region));
+}
+
+//=============================================================================
+void NeuralLayer::ClearActiveRegions()
+{
+	SetActiveRegion(cv::Rect(0, 0, width, height));
+}
+
+//=============================================================================
+uint NeuralLayer::GetNbActiveNeurons() const
+{
+	uint nbActive = 0;
+	for (auto& span : active_spans_)
+	{
+		nbActive += span.end - span.begin;
+	}
+	return nbActive;
+}
+
+//=============================================================================
+void NeuralLayer::UpdateActiveSpans()
+{
+	active_spans_.clear();
+
+	cv::Rect layerReg(0, 0, width, height);
+
+	bool wholeLayer = false;
+	for (auto& reg : active_regs_)
+	{
+		if ((reg & layerReg) == layerReg) wholeLayer = true;
+	}
+
+	// The whole layer is a single span whatever the layout
+	if (wholeLayer && n_frozen_ == 0)
+	{
+		vector<bool>().swap(excluded_);
+		active_spans_.push_back({ 0, size });
+		return;
+	}
+
+	// Flag the neurons that aren't simulated. The neurons of a region are 
+	// not contiguous in memory, whatever the layout, and the regions may
+	// overlap, so the spans are built from the flags.
+	excluded_.assign(size, !wholeLayer);
+	if (!wholeLayer)
+	{
+		for (auto& reg : active_regs_)
+		{
+			cv::Rect clipped = reg & layerReg;
+			for (int y = clipped.y; y < clipped.y + clipped.height; ++y)
+			for (int x = clipped.x; x < clipped.x + clipped.width; ++x)
+			{
+				excluded_[GetNeuronId(x, y)] = false;
+			}
+		}
+	}
+	if (n_frozen_ > 0)
+	{
+		for (uint i = 0; i < size; ++i)
+		{
+			if (frozen_[i]) excluded_[i] = true;
+		}
+	}
+
+	// Spans of consecutive simulated neurons, in memory order
+	uint begin = 0;
+	for (uint i = 0; i < size; ++i)
+	{
+		if (!excluded_[i]) continue;
+		if (i > begin) active_spans_.push_back({ begin, i });
+		begin = i + 1;
+	}
+	if (size > begin) active_spans_.push_back({ begin, size });
+}
+
+//=============================================================================
+void NeuralLayer::SaveStateToFile(string a_filename)
+{
+	// Open the output file
+	ofstream outFile(a_filename);
+	// Check if we were able to open it
+	if (!outFile)
+	{
+		cerr << "Failed open file " << a_filename << '\n';
+		return;
+	}
+
+	outFile << "id" << '\t' << "label" << '\t' << "potential" << '\n';
+
+	// Neurons are saved in row-major order whatever the layout. The lines
+	// aren't flushed one by one, the file is flushed when closed.
+	for (uint i = 0; i < size; ++i)
+	{
+		const Neuron& n = neurons[GetNeuronId(i % width, i / width)];
+		outFile << i << '\t' << n.label << '\t' << n.pot << '\n';
+	}
+
+	outFile.close();
+}
+
+//=============================================================================
+bool NeuralLayer::ValidateLayerState(string a_validationFilename)
+{
+	// Binary states are compared in place
+	if (LayerStateView::IsStateFile(a_validationFilename))
+	{
+		LayerStateView state;
+		return state.Open(a_validationFilename) && ValidateBinaryState(state);
+	}
+
+	// Open the validation file
+	ifstream inFile(a_validationFilename);
+
+	// Check if we were able to open it
+	if (!inFile)
+	{
+		cerr << "Failed to load validation file: " << a_validationFilename
+			<< '\n';
+		return false;
+	}
+
+	// Get the first line which doesn't contain neuron data
+	string line;
+	getline(inFile, line);
+
+	int id, label;
+	float pot;
+	for (uint i = 0; i < size; ++i)
+	{
+		const Neuron& n = neurons[GetNeuronId(i % width, i / width)];
+
+		//getline(inFile, line);
+		inFile >> id >> label >> pot;
+
+		if (id != i || label != n.label || abs(pot - n.pot) > 0.0005f)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+//=============================================================================
+bool NeuralLayer::SaveBinaryState(const string& a_filename) const
+{
+	vector<char> state = GetBinaryState();
+
+	ofstream outFile(a_filename, ios::binary);
+	if (!outFile)
+	{
+		cerr << "Failed open file " << a_filename << '\n';
+		return false;
+	}
+
+	// The whole state is written at once
+	outFile.write(state.data(), state.size());
+	outFile.close();
+
+	return !outFile.fail();
+}
+
+//=============================================================================
+vector<char> NeuralLayer::GetBinaryState() const
+{
+	// The neurons, their flags and charges and the image take most of the
+	// space
+	LayerStateWriter writer(size * (sizeof(Neuron) + 3) + 4096);
+	WriteBinaryState(writer);
+
+	return writer.Finish();
+}
+
+//=============================================================================
+bool NeuralLayer::LoadBinaryState(const string& a_filename)
+{
+	LayerStateView state;
+	return state.Open(a_filename) && LoadBinaryState(state);
+}
+//-----------------------------------------------------------------------------
+
+bool NeuralLayer::LoadBinaryState(const LayerStateView& a_state)
+{
+	return ReadBinaryState(a_state);
+}
+
+//=============================================================================
+bool NeuralLayer::ValidateBinaryState(const LayerStateView& a_state,
+									  float a_pot_tolerance) const
+{
+	const NeuralLayerState* state =
+		a_state.GetStruct<NeuralLayerState>(STATE_LAYER);
+	size_t nbNeurons;
+	const Neuron* stateNeurons = 
+		a_state.GetArray<Neuron>(STATE_NEURONS, &nbNeurons);
+
+	if (!state || state->width != width || state->height != height ||
+		nbNeurons != size)
+	{
+		return false;
+	}
+
+	vector<uint> stateIds = GetStateNeuronIds(*state);
+	for (uint i = 0; i < size; ++i)
+	{
+		const Neuron& n = neurons[i];
+		const Neuron& stateN = stateNeurons[stateIds.empty() ? i : stateIds[i]];
+
+		if (n.label != stateN.label || n.phase != stateN.phase ||
+			!(abs(n.pot - stateN.pot) <= a_pot_tolerance))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+//=============================================================================
+void NeuralLayer::WriteBinaryState(LayerStateWriter& a_writer) const
+{
+	NeuralLayerState state;
+	memset(&state, 0, sizeof(state));
+	state.width = width;
+	state.height = height;
+	state.neuron_layout = NEURON_LAYOUT;
+	state.tile_size = TILE_SIZE;
+	state.layer_id = layer_id;
+	state.n_cycles = n_cycles;
+	state.n_cascades = n_cascades;
+	state.sim_time = sim_time;
+	state.n_spikes = n_spikes;
+	state.pot_threshold = POT_THRESHOLD;
+	state.tau = TAU;
+	state.global_inhib_val = GLOBAL_INHIB_VAL;
+	state.charging_leader = CHARGING_LEADER;
+	state.charging_follow = CHARGING_FOLLOW;
+	a_writer.AddSection(STATE_LAYER, &state, sizeof(state));
+
+	// The neurons are copied as is, in memory order
+	a_writer.AddSection(STATE_NEURONS, neurons.data(), size * sizeof(Neuron));
+	a_writer.AddSection(STATE_CHARGE_LEVELS, charge_levels_.data(),
+						charge_levels_.size() * sizeof(float));
+	a_writer.AddSection(STATE_CHARGE_IDS, charge_ids_.data(), size);
+
+	char* flags = a_writer.AddSection(STATE_NEURON_FLAGS, size);
+	for (uint i = 0; i < size; ++i)
+	{
+		flags[i] = (cycle_spiked[i] ? NEURON_CYCLE_SPIKED : 0) |
+			(is_segmented[i] ? NEURON_SEGMENTED : 0);
+	}
+
+	a_writer.AddSection(STATE_ACTIVE_REGIONS, active_regs_.data(),
+						active_regs_.size() * sizeof(cv::Rect));
+	a_writer.AddSection(STATE_PHASE_COUNTERS, &phase_counters_,
+						sizeof(PhaseCounters));
+
+	// The gray image, so that the layer can be created again from its state
+	const cv::Mat& gray = img_data_.gray_image_;
+	if (gray.type() == CV_8U && gray.cols == (int)width &&
+		gray.rows == (int)height)
+	{
+		char* image = a_writer.AddSection(STATE_IMAGE, size);
+		for (uint y = 0; y < height; ++y)
+		{
+			memcpy(image + y * width, gray.ptr(y), width);
+		}
+	}
+}
+
+//=============================================================================
+bool NeuralLayer::ReadBinaryState(const LayerStateView& a_state)
+{
+	const NeuralLayerState* state =
+		a_state.GetStruct<NeuralLayerState>(STATE_LAYER);
+	if (!state)
+	{
+		cerr << "Layer state has no layer section\n";
+		return false;
+	}
+	if (state->width != width || state->height != height)
+	{
+		cerr << "Layer state of size " << state->width << "x" 
+			<< state->height << " doesn't fit a layer of size " << width
+			<< "x" << height << '\n';
+		return false;
+	}
+
+	size_t nbNeurons, nbFlags, nbRegions, nbLevels, nbChargeIds;
+	const Neuron* stateNeurons = 
+		a_state.GetArray<Neuron>(STATE_NEURONS, &nbNeurons);
+	const uchar* flags = a_state.GetArray<uchar>(STATE_NEURON_FLAGS, &nbFlags);
+	const cv::Rect* regions = 
+		a_state.GetArray<cv::Rect>(STATE_ACTIVE_REGIONS, &nbRegions);
+	const float* levels = 
+		a_state.GetArray<float>(STATE_CHARGE_LEVELS, &nbLevels);
+	const uint8_t* chargeIds =
+		a_state.GetArray<uint8_t>(STATE_CHARGE_IDS, &nbChargeIds);
+	if (nbNeurons != size || nbFlags != size)
+	{
+		cerr << "Layer state has no neurons\n";
+		return false;
+	}
+	if (nbLevels == 0 || nbLevels > UINT8_MAX + 1 || nbChargeIds != size ||
+		*max_element(chargeIds, chargeIds + size) >= nbLevels)
+	{
+		cerr << "Layer state has no maximal charges\n";
+		return false;
+	}
+
+	// The neurons are copied at once when the layouts match
+	vector<uint> stateIds = GetStateNeuronIds(*state);
+	if (stateIds.empty())
+	{
+		memcpy(neurons.data(), stateNeurons, size * sizeof(Neuron));
+		memcpy(charge_ids_.data(), chargeIds, size);
+	}
+	charge_levels_.assign(levels, levels + nbLevels);
+	for (uint i = 0; i < size; ++i)
+	{
+		uint stateId = stateIds.empty() ? i : stateIds[i];
+		if (!stateIds.empty())
+		{
+			neurons[i] = stateNeurons[stateId];
+			charge_ids_[i] = chargeIds[stateId];
+		}
+
+		cycle_spiked[i] = (flags[stateId] & NEURON_CYCLE_SPIKED) != 0;
+		is_segmented[i] = (flags[stateId] & NEURON_SEGMENTED) != 0;
+	}
+
+	n_cycles = state->n_cycles;
+	n_cascades = state->n_cascades;
+	sim_time = state->sim_time;
+	n_spikes = state->n_spikes;
+	POT_THRESHOLD = state->pot_threshold;
+	TAU = state->tau;
+	GLOBAL_INHIB_VAL = state->global_inhib_val;
+	CHARGING_LEADER = state->charging_leader;
+	CHARGING_FOLLOW = state->charging_follow;
+
+	// Counters of a build with other counters are dropped
+	const PhaseCounters* counters =
+		a_state.GetStruct<PhaseCounters>(STATE_PHASE_COUNTERS);
+	if (counters) phase_counters_ = *counters;
+	else phase_counters_.Reset();
+
+	// States have no frozen neurons (see SegmentationLayer)
+	frozen_.clear();
+	n_frozen_ = 0;
+	frozen_delta_sum_ = 0.0;
+
+	if (regions)
+		SetActiveRegions(vector<cv::Rect>(regions, regions + nbRegions));
+	else ClearActiveRegions();
+
+	return true;
+}
+
+//=============================================================================
+vector<uint> NeuralLayer::GetStateNeuronIds(
+	const NeuralLayerState& a_state) const
+{
+	vector<uint> stateIds;
+
+	bool sameLayout = a_state.neuron_layout == NEURON_LAYOUT &&
+		(NEURON_LAYOUT == LAYOUT_ROW_MAJOR || a_state.tile_size == TILE_SIZE);
+	if (sameLayout) return stateIds;
+
+	stateIds.resize(size);
+	for (uint y = 0; y < height; ++y)
+	for (uint x = 0; x < width; ++x)
+	{
+		stateIds[GetNeuronId(x, y)] = GetNeuronId(x, y, width, height,
+			a_state.neuron_layout, max(1u, a_state.tile_size));
+	}
+
+	return stateIds;
+}
+
+//=============================================================================
+void NeuralLayer::CaptureSnapshot(LayerSnapshot& a_snapshot) const
+{
+	a_snapshot.layer_id = layer_id;
+	a_snapshot.cycle = n_cycles;
+	a_snapshot.cascade = n_cascades;
+	a_snapshot.sim_time = sim_time;
+
+	// Does nothing when the buffers already have the right size
+	a_snapshot.potentials.create(height, width, CV_32F);
+	a_snapshot.labels.create(height, width, CV_32S);
+	a_snapshot.phases.create(height, width, CV_32S);
+
+	for (uint y = 0; y < height; ++y)
+	{
+		float* pot = a_snapshot.potentials.ptr<float>(y);
+		int* label = a_snapshot.labels.ptr<int>(y);
+		int* phase = a_snapshot.phases.ptr<int>(y);
+		for (uint x = 0; x < width; ++x)
+		{
+			const Neuron& n = neurons[GetNeuronId(x, y)];
+			pot[x] = n.pot;
+			label[x] = n.label;
+			phase[x] = n.phase;
+		}
+	}
+}
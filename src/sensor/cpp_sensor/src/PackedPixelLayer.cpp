@@ -0,0 +1,297 @@
+/**
+* @file PackedPixelLayer.cpp
+*
+* @authors Vincent de Ladurantaye
+*/
+
+#include "PackedPixelLayer.h"
+#include "LayerState.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+using namespace std;
+
+
+//=============================================================================
+//								PackedPixelLayer
+//=============================================================================
+PackedPixelLayer::PackedPixelLayer(const vector<cv::Mat>& a_images,
+								   bool a_random_init) :
+	PixelLayer(PackImages(a_images), a_random_init)
+{
+	// The regions are computed again since the members are initialized
+	// after the base class
+	PackImages(a_images, &image_regs_);
+
+	// Image of each column of the layer, -1 for the separators
+	vector<int> colImage(width, -1);
+	for (uint k = 0; k < image_regs_.size(); ++k)
+	{
+		const cv::Rect& reg = image_regs_[k];
+		for (int x = reg.x; x < reg.x + reg.width; ++x) colImage[x] = k;
+	}
+
+	// The leaders are found again without looking across the images, and 
+	// the neurons outside of the images never charge
+	for (uint i = 0; i < size; ++i)
+	{
+		Neuron& n = neurons[i];
+		cv::Point pos = GetNeuronPos(i);
+		int k = colImage[pos.x];
+
+		if (k < 0 || pos.y >= image_regs_[k].height)
+		{
+			SetMaxCharge(i, 0.0f);
+			n.pot = 0.0f;
+		}
+		else if (GetHomogeneity(pos.x, pos.y, HOMOG_RADIUS, image_regs_[k])
+				 > HOMOG_THRESHOLD)
+		{
+			SetMaxCharge(i, CHARGING_LEADER);
+		}
+		else
+		{
+			SetMaxCharge(i, CHARGING_FOLLOW);
+		}
+	}
+
+	// Spans of each image, whatever the neuron layout
+	image_spans_.resize(image_regs_.size());
+	for (uint k = 0; k < image_regs_.size(); ++k)
+	{
+		const cv::Rect& reg = image_regs_[k];
+		vector<uint> ids;
+		for (int y = reg.y; y < reg.y + reg.height; ++y)
+		for (int x = reg.x; x < reg.x + reg.width; ++x)
+		{
+			ids.push_back(GetNeuronId(x, y));
+		}
+		sort(ids.begin(), ids.end());
+
+		for (uint i = 0; i < ids.size(); ++i)
+		{
+			if (i > 0 && ids[i] == ids[i - 1] + 1)
+			{
+				image_spans_[k].back().end = ids[i] + 1;
+			}
+			else image_spans_[k].push_back({ ids[i], ids[i] + 1 });
+		}
+	}
+
+	// Spikes are never propagated to the neurons outside of the images
+	SetActiveRegions(image_regs_);
+}
+
+//=============================================================================
+cv::Mat PackedPixelLayer::PackImages(const vector<cv::Mat>& a_images,
+									 vector<cv::Rect>* a_regions)
+{
+	vector<cv::Rect> regions;
+
+	int packedWidth = 0;
+	int packedHeight = 0;
+	for (auto& img : a_images)
+	{
+		if (!regions.empty()) ++packedWidth;
+		regions.push_back(cv::Rect(packedWidth, 0, img.cols, img.rows));
+		packedWidth += img.cols;
+		packedHeight = max(packedHeight, img.rows);
+	}
+
+	cv::Mat packed(max(1, packedHeight), max(1, packedWidth), CV_8U,
+				   cv::Scalar(0));
+	for (uint k = 0; k < a_images.size(); ++k)
+	{
+		// The images are converted to gray as the layer would do
+		ImageData imgData(a_images[k]);
+		cv::Mat dst = packed(regions[k]);
+		imgData.gray_image_.copyTo(dst);
+	}
+
+	if (a_regions) *a_regions = regions;
+	return packed;
+}
+
+//=============================================================================
+vector<PackedImageResult> PackedPixelLayer::SegmentImages()
+{
+	vector<PackedImageResult> results(image_regs_.size());
+	for (auto& result : results)
+	{
+		result.cycles = 0;
+		result.cascades = 0;
+		result.convergence = 1.0f;
+		result.converged = false;
+	}
+
+	// Images still simulated
+	vector<uint> running;
+	for (uint k = 0; k < image_regs_.size(); ++k) running.push_back(k);
+
+	SetActiveRegions(image_regs_);
+
+	while (!running.empty())
+	{
+		// A single cascade for all the images
+		LayerProfileHooks::TraceBegin("Cascade", layer_id, n_cascades);
+		float delta = FindNextTimeStep();
+
+		sim_time += delta;
+
+		AdvanceTime(delta);
+
+		// The spikes don't cross the separators, so only the images where
+		// neurons fired in the last pass can have new spikes
+		vector<uint> firing = running;
+		vector<uint> stillFiring;
+		while (!firing.empty())
+		{
+			stillFiring.clear();
+			for (uint k : firing)
+			{
+				if (FireNeurons(n_cascades, sim_time, image_spans_[k]) > 0)
+					stillFiring.push_back(k);
+			}
+			firing.swap(stillFiring);
+		}
+
+		GlobalInhibition();
+		UpdateWeightPlanes();
+
+		LayerProfileHooks::TraceEnd("Cascade", layer_id);
+		++n_cascades;
+
+		// Per image bookkeeping, the images that are done are retired
+		bool retired = false;
+		for (uint r = 0; r < running.size(); )
+		{
+			uint k = running[r];
+			PackedImageResult& result = results[k];
+			bool done = false;
+
+			++result.cascades;
+			result.convergence = GetImageStabilization(k);
+
+			if (result.convergence < 0.4)
+			{
+				result.converged = true;
+				done = true;
+			}
+			else if (MAX_SEG_CASCADES > 0 && 
+					 result.cascades >= MAX_SEG_CASCADES)
+			{
+				done = true;
+			}
+			else if (IsImageCycleCompleted(k))
+			{
+				++result.cycles;
+				ResetImageCycle(k);
+				done = result.cycles >= MAX_SEG_CYCLES;
+			}
+
+			if (done)
+			{
+				running.erase(running.begin() + r);
+				retired = true;
+			}
+			else ++r;
+		}
+
+		if (retired)
+		{
+			vector<cv::Rect> regions;
+			for (uint k : running) regions.push_back(image_regs_[k]);
+			SetActiveRegions(regions);
+		}
+	}
+
+	n_cycles = 0;
+	for (auto& result : results) n_cycles = max(n_cycles, result.cycles);
+
+	SetActiveRegions(image_regs_);
+
+	cv::Mat labels = GetLabels();
+	for (uint k = 0; k < image_regs_.size(); ++k)
+	{
+		results[k].labels = labels(image_regs_[k]).clone();
+	}
+
+	return results;
+}
+
+//=============================================================================
+float PackedPixelLayer::GetImageStabilization(uint a_image) const
+{
+	double sumDP = 0.0;
+	int qtyDP = 0;
+
+	for (auto& span : image_spans_[a_image])
+	for (uint i = span.begin; i < span.end; ++i)
+	{
+		const Neuron& neuron = neurons[i];
+
+		if (neuron.phase > 0)
+		{
+			qtyDP++;
+			sumDP += fabs(neuron.delta_period);
+		}
+	}
+
+	if (qtyDP > 0)
+	{
+		return (sumDP / qtyDP);
+	}
+	else
+	{
+		return (1.0);
+	}
+}
+
+//=============================================================================
+bool PackedPixelLayer::IsImageCycleCompleted(uint a_image) const
+{
+	for (auto& span : image_spans_[a_image])
+	for (uint i = span.begin; i < span.end; ++i)
+	{
+		if (GetMaxCharge(i) == CHARGING_LEADER && cycle_spiked[i] == false)
+			return false;
+	}
+
+	return true;
+}
+
+//=============================================================================
+void PackedPixelLayer::ResetImageCycle(uint a_image)
+{
+	for (auto& span : image_spans_[a_image])
+	for (uint i = span.begin; i < span.end; ++i)
+	{
+		cycle_spiked[i] = false;
+	}
+}
+
+//=============================================================================
+void PackedPixelLayer::WriteBinaryState(LayerStateWriter& a_writer) const
+{
+	PixelLayer::WriteBinaryState(a_writer);
+
+	a_writer.AddSection(STATE_PACKED_IMAGES, image_regs_.data(),
+						image_regs_.size() * sizeof(cv::Rect));
+}
+
+//=============================================================================
+bool PackedPixelLayer::ReadBinaryState(const LayerStateView& a_state)
+{
+	size_t nbImages;
+	const cv::Rect* regions =
+		a_state.GetArray<cv::Rect>(STATE_PACKED_IMAGES, &nbImages);
+	if (!regions || nbImages != image_regs_.size() ||
+		!equal(image_regs_.begin(), image_regs_.end(), regions))
+	{
+		cerr << "Layer state doesn't pack the images of the layer\n";
+		return false;
+	}
+
+	return PixelLayer::ReadBinaryState(a_state);
+}
@@ -1,96 +1,393 @@
-/** @file PixelLayer.cpp
- *
- *
- *  @author Vincent de Ladurantaye
- */
-
-#include "PixelLayer.h"
-
-
-
-//=============================================================================
-//								PixelLayer
-//=============================================================================
-PixelLayer::PixelLayer(const string& a_img_file, bool a_random_init):
-PixelLayer(ImageData(a_img_file), a_random_init)
-{
-}
-
-//-----------------------------------------------------------------------------
-PixelLayer::PixelLayer(const cv::Mat& a_img, bool a_random_init):
-	PixelLayer(ImageData(a_img), a_random_init)
-{
-}
-
-//-----------------------------------------------------------------------------
-PixelLayer::PixelLayer(ImageData& a_img_data, bool a_random_init):
-	SegmentationLayer(a_img_data),
-	HOMOG_DELTA(Config::PIXEL_HOMOG_DELTA),
-	HOMOG_RADIUS(Config::PIXEL_HOMOG_RADIUS),
-	HOMOG_THRESHOLD(Config::PIXEL_HOMOG_THRESHOLD),
-	RANDOM_INIT(a_random_init)
-{
-	// Keep a ptr to the image pixel data
-	pixel_data = img_data_.gray_image_.data;
-
-	for (auto& n : neurons)
-	{
-		if (GetHomogeneity(n.pos.x, n.pos.y, HOMOG_RADIUS) > HOMOG_THRESHOLD)
-		{
-			n.max_charge = CHARGING_LEADER;
-		}
-		else
-		{
-			n.max_charge = CHARGING_FOLLOW;
-		}
-
-		if (RANDOM_INIT)
-		{
-			n.pot = ((float)rand() / RAND_MAX) * POT_THRESHOLD;
-		}
-		else
-		{
-			n.pot = 0.99 * POT_THRESHOLD * (pixel_data[n.id] / 255.0f);
-		}
-	}
-}
-
-//=============================================================================
-float PixelLayer::ComputeWeigth(int a_src_id, int a_dst_id,
-								NeuronRelPos a_dst_pos)
-{
-	int featDiff = abs(pixel_data[a_src_id] - pixel_data[a_dst_id]);
-	
-	return SegmentationLayer::ComputeWeigth(featDiff);
-}
-
-//=============================================================================
-double PixelLayer::GetHomogeneity(int a_x, int a_y, int a_radius)
-{
-	double similarNeighbor; // How many surrounding neurons are similar
-	double totalNeighbor;   // How many surrounding neurons are in image
-
-	similarNeighbor = 0.0;
-	totalNeighbor = 0.0;
-
-	const uchar* dataPtr = pixel_data + a_y*width;
-
-	for (int dy = -a_radius; dy <= a_radius; dy++)
-	{
-		const uchar* deltaPtr = pixel_data + (a_y + dy)*width;
-
-		for (int dx = -a_radius; dx <= a_radius; dx++)
-		{
-			if (IsInLayer(a_x + dx, a_y + dy) && ((dy * dy) + (dx * dx)))
-			{
-				if (fabs(dataPtr[a_x] - deltaPtr[a_x + dx]) < HOMOG_DELTA)
-				{
-					similarNeighbor += 1.0;
-				}
-				totalNeighbor += 1.0;
-			}
-		}
-	}
-	return (similarNeighbor / totalNeighbor);
-}
-
+/** @file PixelLayer.cpp
+ *
+ *
+ *  @author Vincent de Ladurantaye
+ */
+
+#include "PixelLayer.h"
+#include "LayerState.h"
+
+#include <stdexcept>
+
+
+
+//=============================================================================
+//								PixelLayer
+//=============================================================================
+PixelLayer::PixelLayer(const string& a_img_file, bool a_random_init):
+PixelLayer(ImageData(a_img_file), a_random_init)
+{
+}
+
+//-----------------------------------------------------------------------------
+PixelLayer::PixelLayer(const cv::Mat& a_img, bool a_random_init):
+	PixelLayer(ImageData(a_img), a_random_init)
+{
+}
+
+//-----------------------------------------------------------------------------
+PixelLayer::PixelLayer(ImageData& a_img_data, bool a_random_init):
+	SegmentationLayer(a_img_data),
+	HOMOG_DELTA(Config::PIXEL_HOMOG_DELTA),
+	HOMOG_RADIUS(Config::PIXEL_HOMOG_RADIUS),
+	HOMOG_THRESHOLD(Config::PIXEL_HOMOG_THRESHOLD),
+	RANDOM_INIT(a_random_init)
+{
+	InitFeatures();
+
+	for (uint i = 0; i < size; ++i)
+	{
+		InitPotential(i);
+	}
+
+	InitWeightPlanes();
+}
+
+//=============================================================================
+void PixelLayer::InitFeatures()
+{
+	// Keep a ptr to the image pixel data
+	pixel_data = img_data_.gray_image_.data;
+
+	// Pixel values are indexed like the neurons, so reorder them when the
+	// neurons aren't stored row-major
+	if (NEURON_LAYOUT != LAYOUT_ROW_MAJOR)
+	{
+		neuron_pixels_.create(1, size, CV_8U);
+		for (uint i = 0; i < size; ++i)
+		{
+			cv::Point pos = GetNeuronPos(i);
+			neuron_pixels_.data[i] = pixel_data[pos.y * width + pos.x];
+		}
+		pixel_data = neuron_pixels_.data;
+	}
+
+	for (uint i = 0; i < size; ++i)
+	{
+		cv::Point pos = GetNeuronPos(i);
+
+		if (GetHomogeneity(pos.x, pos.y, HOMOG_RADIUS) > HOMOG_THRESHOLD)
+		{
+			SetMaxCharge(i, CHARGING_LEADER);
+		}
+		else
+		{
+			SetMaxCharge(i, CHARGING_FOLLOW);
+		}
+	}
+}
+
+//=============================================================================
+void PixelLayer::InitPotential(uint a_id)
+{
+	if (RANDOM_INIT)
+	{
+		neurons[a_id].pot = ((float)rand() / RAND_MAX) * POT_THRESHOLD;
+	}
+	else
+	{
+		neurons[a_id].pot = 0.99 * POT_THRESHOLD * (pixel_data[a_id] / 255.0f);
+	}
+}
+
+//=============================================================================
+float PixelLayer::ComputeWeigth(int a_src_id, int a_dst_id,
+								NeuronRelPos a_dst_pos)
+{
+	int featDiff = abs(pixel_data[a_src_id] - pixel_data[a_dst_id]);
+	
+	return SegmentationLayer::ComputeWeigth(featDiff);
+}
+
+//=============================================================================
+void PixelLayer::ComputeWeightPlane(NeuronRelPos a_dst_pos, float* a_plane)
+{
+	// Plane rows are only contiguous with the row-major layout
+	if (NEURON_LAYOUT != LAYOUT_ROW_MAJOR)
+	{
+		SegmentationLayer::ComputeWeightPlane(a_dst_pos, a_plane);
+		return;
+	}
+
+	// Weights of all the possible pixel differences
+	float weights[256];
+	for (int d = 0; d < 256; ++d)
+	{
+		weights[d] = SegmentationLayer::ComputeWeigth(d);
+	}
+
+	cv::Point delta = neighbor_pos_[a_dst_pos];
+	int offset = pos_offset_[a_dst_pos];
+
+	// Range of the neurons that have a neighbor at this position
+	int xStart = max(0, -delta.x);
+	int xEnd = min((int)width, (int)width - delta.x);
+	int yStart = max(0, -delta.y);
+	int yEnd = min((int)height, (int)height - delta.y);
+
+	for (int y = yStart; y < yEnd; ++y)
+	{
+		const uchar* src = pixel_data + y * width;
+		const uchar* dst = src + offset;
+		float* plane = a_plane + y * width;
+
+		for (int x = xStart; x < xEnd; ++x)
+		{
+			plane[x] = weights[abs(src[x] - dst[x])];
+		}
+	}
+}
+
+//=============================================================================
+uint PixelLayer::InitFromPreviousFrame(const PixelLayer& a_prev,
+									   int a_max_delta)
+{
+	if (a_prev.width != width || a_prev.height != height) return 0;
+
+	const cv::Mat& prevGray = a_prev.img_data_.gray_image_;
+	const cv::Mat& gray = img_data_.gray_image_;
+	uint nbInit = 0;
+
+	for (int y = 0; y < (int)height; ++y)
+	{
+		const uchar* prevRow = prevGray.ptr<uchar>(y);
+		const uchar* row = gray.ptr<uchar>(y);
+		for (int x = 0; x < (int)width; ++x)
+		{
+			uint id = GetNeuronId(x, y);
+			bool excluded = !excluded_.empty() && excluded_[id];
+
+			if (!excluded && abs(row[x] - prevRow[x]) > a_max_delta) continue;
+
+			CopyNeuronState(a_prev, a_prev.GetNeuronId(x, y), id);
+			++nbInit;
+		}
+	}
+
+	// Continue the simulation where the previous frame stopped so that the
+	// phases and spike times stay consistent
+	sim_time = a_prev.sim_time;
+	n_cascades = a_prev.n_cascades;
+
+	return nbInit;
+}
+
+//=============================================================================
+uint PixelLayer::LoadFrame(const ImageData& a_frame_data, int a_max_delta)
+{
+	const cv::Mat& nextGray = a_frame_data.gray_image_;
+	if (nextGray.rows != (int)height || nextGray.cols != (int)width)
+	{
+		throw std::invalid_argument("Frame of another size than the layer");
+	}
+
+	// Neurons simulated whose pixel changed too much to keep their state
+	const cv::Mat& gray = img_data_.gray_image_;
+	vector<uint> resetIds;
+	for (int y = 0; y < (int)height; ++y)
+	{
+		const uchar* row = gray.ptr<uchar>(y);
+		const uchar* nextRow = nextGray.ptr<uchar>(y);
+		for (int x = 0; x < (int)width; ++x)
+		{
+			uint id = GetNeuronId(x, y);
+			bool excluded = !excluded_.empty() && excluded_[id];
+
+			if (!excluded && abs(nextRow[x] - row[x]) > a_max_delta)
+				resetIds.push_back(id);
+		}
+	}
+
+	// The pixels are copied in the layer's own buffer, allocated by the 
+	// first frame loaded, as the caller may reuse its image for the next
+	// frame
+	nextGray.copyTo(frame_gray_);
+	img_data_ = a_frame_data;
+	img_data_.gray_image_ = frame_gray_;
+	InitFeatures();
+
+	for (uint i = 0; i < size; ++i)
+	{
+		neurons[i].delta_period = -1;
+	}
+
+	// The labels of the neurons starting from scratch are reserved at once
+	uint firstLabel = label_counter_.fetch_add((uint)resetIds.size());
+	for (size_t r = 0; r < resetIds.size(); ++r)
+	{
+		uint id = resetIds[r];
+		neurons[id] = Neuron();
+		neurons[id].label = firstLabel + r;
+		InitPotential(id);
+		cycle_spiked[id] = false;
+		is_segmented[id] = false;
+	}
+
+	// The counters are those of the frame, the simulation time and the 
+	// cascades continue from the previous frame like with 
+	// InitFromPreviousFrame(), unless the whole frame starts from scratch
+	uint nbKept = size - (uint)resetIds.size();
+	if (nbKept == 0)
+	{
+		sim_time = 0.0f;
+		n_cascades = 0;
+	}
+	n_cycles = 0;
+	n_spikes = 0;
+	phase_counters_.Reset();
+	stable_cycles_.clear();
+	seg_state_ = SEG_STATE_IDLE;
+
+	// The weights depend on the pixels
+	InitWeightPlanes();
+
+	return nbKept;
+}
+
+//=============================================================================
+vector<cv::Rect> PixelLayer::FindChangedTiles(const PixelLayer& a_prev,
+											  int a_max_delta,
+											  uint a_tile_size,
+											  uint a_margin) const
+{
+	if (a_prev.width != width || a_prev.height != height)
+	{
+		return vector<cv::Rect>(1, cv::Rect(0, 0, width, height));
+	}
+
+	return a_prev.FindChangedTiles(img_data_.gray_image_, a_max_delta,
+								   a_tile_size, a_margin);
+}
+//-----------------------------------------------------------------------------
+vector<cv::Rect> PixelLayer::FindChangedTiles(const cv::Mat& a_next_gray,
+											  int a_max_delta,
+											  uint a_tile_size,
+											  uint a_margin) const
+{
+	vector<cv::Rect> tiles;
+	if (a_next_gray.rows != (int)height || a_next_gray.cols != (int)width)
+	{
+		tiles.push_back(cv::Rect(0, 0, width, height));
+		return tiles;
+	}
+
+	const cv::Mat& prevGray = img_data_.gray_image_;
+	const cv::Mat& gray = a_next_gray;
+	cv::Rect layerReg(0, 0, width, height);
+	a_tile_size = max(1u, a_tile_size);
+
+	for (uint tileY = 0; tileY < height; tileY += a_tile_size)
+	for (uint tileX = 0; tileX < width; tileX += a_tile_size)
+	{
+		cv::Rect tile = cv::Rect(tileX, tileY, a_tile_size, a_tile_size) &
+			layerReg;
+
+		// Stop at the first changed pixel of the tile
+		bool changed = false;
+		for (int y = tile.y; y < tile.y + tile.height && !changed; ++y)
+		{
+			const uchar* prevRow = prevGray.ptr<uchar>(y);
+			const uchar* row = gray.ptr<uchar>(y);
+			for (int x = tile.x; x < tile.x + tile.width; ++x)
+			{
+				if (abs(row[x] - prevRow[x]) > a_max_delta)
+				{
+					changed = true;
+					break;
+				}
+			}
+		}
+		if (!changed) continue;
+
+		tile = cv::Rect(tile.x - a_margin, tile.y - a_margin,
+						tile.width + 2 * a_margin, tile.height + 2 * a_margin);
+		tiles.push_back(tile & layerReg);
+	}
+
+	return tiles;
+}
+
+//=============================================================================
+uint PixelLayer::GetCoarseNeuronId(const SegmentationLayer& a_coarse,
+								   int a_x, int a_y)
+{
+	const cv::Mat& coarseGray = a_coarse.GetImageData().gray_image_;
+	int value = img_data_.gray_image_.at<uchar>(a_y, a_x);
+
+	int nearestX = min(a_x * (int)a_coarse.width / (int)width,
+					   (int)a_coarse.width - 1);
+	int nearestY = min(a_y * (int)a_coarse.height / (int)height,
+					   (int)a_coarse.height - 1);
+
+	// The nearest neuron wins the ties
+	int bestX = nearestX;
+	int bestY = nearestY;
+	int bestDiff = abs(coarseGray.at<uchar>(nearestY, nearestX) - value);
+
+	for (int y = max(nearestY - 1, 0);
+		 y <= min(nearestY + 1, (int)a_coarse.height - 1); ++y)
+	for (int x = max(nearestX - 1, 0);
+		 x <= min(nearestX + 1, (int)a_coarse.width - 1); ++x)
+	{
+		int diff = abs(coarseGray.at<uchar>(y, x) - value);
+		if (diff < bestDiff)
+		{
+			bestDiff = diff;
+			bestX = x;
+			bestY = y;
+		}
+	}
+
+	return a_coarse.GetNeuronId(bestX, bestY);
+}
+
+//=============================================================================
+void PixelLayer::WriteBinaryState(LayerStateWriter& a_writer) const
+{
+	SegmentationLayer::WriteBinaryState(a_writer);
+
+	PixelLayerState state;
+	state.layer_class = GetLayerClass();
+	state.reserved = 0;
+	a_writer.AddSection(STATE_PIXEL_LAYER, &state, sizeof(state));
+}
+
+//=============================================================================
+double PixelLayer::GetHomogeneity(int a_x, int a_y, int a_radius)
+{
+	return GetHomogeneity(a_x, a_y, a_radius, cv::Rect(0, 0, width, height));
+}
+//-----------------------------------------------------------------------------
+double PixelLayer::GetHomogeneity(int a_x, int a_y, int a_radius,
+								  const cv::Rect& a_bounds)
+{
+	double similarNeighbor; // How many surrounding neurons are similar
+	double totalNeighbor;   // How many surrounding neurons are in image
+
+	similarNeighbor = 0.0;
+	totalNeighbor = 0.0;
+
+	// Use the image since the pixel data follows the neuron layout
+	const uchar* image = img_data_.gray_image_.data;
+	const uchar* dataPtr = image + a_y*width;
+
+	for (int dy = -a_radius; dy <= a_radius; dy++)
+	{
+		const uchar* deltaPtr = image + (a_y + dy)*width;
+
+		for (int dx = -a_radius; dx <= a_radius; dx++)
+		{
+			if (a_bounds.contains(cv::Point(a_x + dx, a_y + dy)) 
+				&& ((dy * dy) + (dx * dx)))
+			{
+				if (fabs(dataPtr[a_x] - deltaPtr[a_x + dx]) < HOMOG_DELTA)
+				{
+					similarNeighbor += 1.0;
+				}
+				totalNeighbor += 1.0;
+			}
+		}
+	}
+	return (similarNeighbor / totalNeighbor);
+}
+
@@ -0,0 +1,87 @@
+/** @file PyramidSegmenter.cpp
+*
+*
+*  @author Vincent de Ladurantaye
+*/
+
+#include "PyramidSegmenter.h"
+#include "SegmentationLayerT.h"
+
+#include <chrono>
+using namespace std;
+
+//=============================================================================
+//								PyramidSegmenter
+//=============================================================================
+PyramidSegmenter::PyramidSegmenter() :
+	NB_LEVELS(max(1u, Config::SEG_PYRAMID_LEVELS)),
+	REFINE_CYCLES(Config::SEG_PYRAMID_REFINE_CYCLES),
+	MIN_LEVEL_SIDE(16)
+{
+}
+
+//=============================================================================
+unique_ptr<PixelLayer> PyramidSegmenter::Segment(const string& a_img_file)
+{
+	ImageData imgData(a_img_file);
+	return Segment(imgData);
+}
+//-----------------------------------------------------------------------------
+unique_ptr<PixelLayer> PyramidSegmenter::Segment(const cv::Mat& a_img)
+{
+	ImageData imgData(a_img);
+	return Segment(imgData);
+}
+//-----------------------------------------------------------------------------
+unique_ptr<PixelLayer> PyramidSegmenter::Segment(ImageData& a_img_data)
+{
+	level_stats_.clear();
+
+	// Downsample the image for each level, the full resolution being last
+	vector<ImageData> levels(1, a_img_data);
+	while (levels.size() < NB_LEVELS)
+	{
+		const ImageData& finer = levels.front();
+		if (finer.rows / 2 < MIN_LEVEL_SIDE || finer.cols / 2 < MIN_LEVEL_SIDE)
+			break;
+		levels.insert(levels.begin(), finer.GetDownsampled(2));
+	}
+
+	unique_ptr<PixelLayer> coarseLayer;
+	unique_ptr<PixelLayer> layer;
+
+	for (auto& level : levels)
+	{
+		auto start = chrono::steady_clock::now();
+
+		layer = CreatePixelLayer(level);
+
+		uint startCascade = 0;
+		if (coarseLayer)
+		{
+			layer->InitFromCoarseLayer(*coarseLayer);
+			layer->MAX_SEG_CYCLES = REFINE_CYCLES;
+
+			// The cascade counter continues from the coarse layer
+			startCascade = coarseLayer->GetNbCascades();
+			if (layer->MAX_SEG_CASCADES > 0)
+				layer->MAX_SEG_CASCADES += startCascade;
+		}
+
+		layer->SegmentLayer();
+
+		PyramidLevelStats stats;
+		stats.width = layer->width;
+		stats.height = layer->height;
+		stats.cycles = layer->GetNbCycles();
+		stats.cascades = layer->GetNbCascades() - startCascade;
+		stats.spikes = layer->GetNbSpikes();
+		stats.time_ms = chrono::duration<double, milli>(
+			chrono::steady_clock::now() - start).count();
+		level_stats_.push_back(stats);
+
+		coarseLayer = move(layer);
+	}
+
+	return coarseLayer;
+}
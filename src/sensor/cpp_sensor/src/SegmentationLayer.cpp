@@ -1,363 +1,1131 @@
-/** @file NeuralLayer.cpp
-*
-*
-*  @author Vincent de Ladurantaye
-*/
-
-#include "SegmentationLayer.h"
-#include "LayerDebugger.h"
-
-#include <iostream>
-#include <fstream>
-using namespace std;
-
-//=============================================================================
-//								 SegmentationLayer
-//=============================================================================
-SegmentationLayer::SegmentationLayer(const cv::Mat& a_img) :
-	SegmentationLayer(ImageData(a_img))
-{
-}
-//-----------------------------------------------------------------------------
-
-SegmentationLayer::SegmentationLayer(ImageData& a_img_data) :
-	NeuralLayer(a_img_data),
-	MAX_SEG_CASCADES(Config::SEG_MAX_CASCADES),
-	MAX_SEG_CYCLES(Config::SEG_MAX_CYCLES),
-	MIN_SEGMENT_SIZE(Config::MIN_SEGMENT_SIZE),
-	TRIGGER_SAME_LABEL_NEURONS(Config::SEG_TRIGGER_SAME_LABEL_NEURONS),
-	MERGE_SEGMENTS(Config::SEG_MERGE_SEGMENTS),
-	WEIGHT_MAX_VALUE(Config::SEG_WEIGHT_MAX),
-	WEIGHT_SLOPE(Config::SEG_WEIGHT_SLOPE),
-	WEIGHT_OFFSET(Config::SEG_WEIGHT_OFFSET)
-{
-	SEG_MERGE_TRESHOLD = ComputeWeigth(Config::SEG_MERGE_DELTA);
-
-	pos_offset_[N_UP_L] = -(int)width - 1; // using type cast to avoid warning:
-	pos_offset_[N_UP] = -(int)width;	   // minus applied to unsigned type
-	pos_offset_[N_UP_R] = -(int)width + 1;
-	pos_offset_[N_LEFT] = -1;
-	pos_offset_[N_RIGHT] = +1;
-	pos_offset_[N_DOWN_L] = width - 1;
-	pos_offset_[N_DOWN] = width;
-	pos_offset_[N_DOWN_R] = width + 1;
-
-}
-
-//=============================================================================
-SegmentationLayer::~SegmentationLayer()
-{
-}
-
-//=============================================================================
-void SegmentationLayer::SegmentLayer()
-{
-	int stableCascadeCount = 0;
-	float stabilizationCoef = 0.0f;
-	while (n_cycles < MAX_SEG_CYCLES)
-	{
-
-#ifdef LAYER_DEBUGGER
-		LayerDebugger::SetBreakpoint(*this, DEBUG_LEVEL_CASCADE,
-									 n_cascades);
-#endif
-		float delta = FindNextTimeStep();
-
-		sim_time += delta;
-
-		AdvanceTime(delta);
-
-		while (FireNeurons(n_cascades, sim_time) > 0)
-		{
-		}
-
-		GlobalInhibition();
-
-		++n_cascades;
-
-		// Check if spikes are stable
-		stabilizationCoef = GetCoefStabilization(0);
-		if (stabilizationCoef < 0.4)
-		{
-			++stableCascadeCount;
-		}
-		else stableCascadeCount = 0;
-
-		// If enough consecutive cascades were stable, stop the simulation
-		if (stableCascadeCount >= 1)
-		{
-			break;
-		}
-
-		// If we have a max number of cascade to do, check if we reached it
-		if (MAX_SEG_CASCADES > 0 && n_cascades >= MAX_SEG_CASCADES) break;
-
-		// Check if cycle is completed
-		if (IsCycleCompleted() == false)
-		{
-			// If not, continue this cycle
-			continue;
-		}
-
-#ifdef LAYER_DEBUGGER
-		LayerDebugger::SetBreakpoint(*this, DEBUG_LEVEL_CYCLE, n_cycles);
-#endif
-
-		++n_cycles;
-		ResetCycle();
-	}
-	
-	//ClearSmallSegments();
-
-	cout << "\nCycle: " << n_cycles << "\tCascade: " << n_cascades
-		<< "\tSpikes: " << n_spikes 
-		<< "\tConvergence: " << stabilizationCoef<< endl;
-
-#ifdef LAYER_DEBUGGER
-	LayerDebugger::SetBreakpoint(*this, DEBUG_LEVEL_END);
-#endif
-}
-
-//=============================================================================
-void SegmentationLayer::CountSegments()
-{
-	segments.clear();
-
-	vector<int> segmentCounts(size);
-
-	for (uint i = 0; i < size; ++i)
-	{
-		segmentCounts[i] = 0;
-	}
-
-	// Iterate through all neurons to count neurons with the same labels
-	for (auto& neuron : neurons)
-	{
-		// If the phase is higher than 0, we have a neuron part of a segment
-		if (neuron.phase > 0)
-		{
-			// Check if the segment already exist
-			bool segmentFound = false;
-			for (auto& segment : segments)
-			{
-				if (segment.id == neuron.label)
-				{
-					++segment.nbNeuron;
-					segmentFound = true;
-				}
-			}
-
-			// If we didn't find the segment, create it
-			if (segmentFound == false)
-			{
-				Segment seg;
-				seg.id = neuron.label;
-				seg.phase = neuron.phase;
-				seg.nbNeuron = 1;
-
-				segments.push_back(seg);
-			}
-		}
-	}
-
-	cout << "Number of segments: " << segments.size() << endl;
-}
-
-//=============================================================================
-void SegmentationLayer::ClearSmallSegments()
-{
-	if (segments.empty()) CountSegments();
-
-	// Iterate through segments and set to 0 the phase of neurons part of 
-	// small segments so that they have the same phase as neurons
-	// that didn't fire.
-	for (auto& segment : segments)
-	{
-		if (segment.nbNeuron < MIN_SEGMENT_SIZE)
-		{
-			for (auto& neuron : neurons)
-			{
-				if (neuron.label == segment.id)
-				{
-					neuron.phase = 0;
-				}
-			}
-		}
-	}
-}
-
-//=============================================================================
-cv::Mat SegmentationLayer::GetImg()
-{
-	cout << "TEST: "
-		<< "rows: " << img_data_.image_.rows << " "
-		<< "cols: " << img_data_.image_.cols << endl;
-	return img_data_.image_.clone();
-}
-
-//=============================================================================
-//								Protected
-//=============================================================================
-float SegmentationLayer::ComputeWeigth(float a_feat_delta)
-{
-	//return WEIGHT_MAX_VALUE * exp(-WEIGHT_SLOPE * a_feat_delta);
-
-	float deltaCoef = 1 - 1 / (1 + exp(-WEIGHT_SLOPE * (abs(a_feat_delta) -
-														WEIGHT_OFFSET)));
-	return WEIGHT_MAX_VALUE * deltaCoef;
-}
-
-//=============================================================================
-void SegmentationLayer::PropagateSpike(int a_id, int a_phase)
-{
-	// Calculate the row and column of the current index
-	int neuronRow = neurons[a_id].pos.y;
-	int neuronCol = neurons[a_id].pos.x;
-
-	//-------------------------------------------------------------------------
-	// Propagate the spike among neirghbors
-	//-------------------------------------------------------------------------
-	// Add weights to neighbors and propagate the neuron ID
-	if (neuronRow > 0 && neuronCol > 0)
-	{
-		Propagate(a_id, N_UP_L, a_phase);
-	}
-
-	if (neuronRow > 0)
-	{
-		Propagate(a_id, N_UP, a_phase);
-	}
-
-	if (neuronRow > 0 && neuronCol < width - 2)
-	{
-		Propagate(a_id, N_UP_R, a_phase);
-	}
-
-	if (neuronCol > 0)
-	{
-		Propagate(a_id, N_LEFT, a_phase);
-	}
-
-	if (neuronCol < width - 2)
-	{
-		Propagate(a_id, N_RIGHT, a_phase);
-	}
-
-	if (neuronRow < height - 2 && neuronCol > 0)
-	{
-		Propagate(a_id, N_DOWN_L, a_phase);
-	}
-
-	if (neuronRow < height - 2)
-	{
-		Propagate(a_id, N_DOWN, a_phase);
-	}
-
-	if (neuronRow < height - 2 && neuronCol < width - 2)
-	{
-		Propagate(a_id, N_DOWN_R, a_phase);
-	}
-
-	//-------------------------------------------------------------------------
-	// Trigger neurons with the same label
-	//-------------------------------------------------------------------------
-	if (TRIGGER_SAME_LABEL_NEURONS) TriggerSameLabelNeurons(a_id, a_phase);
-
-}
-
-//=============================================================================
-void SegmentationLayer::Propagate(int a_src_id,
-								  NeuronRelPos a_dst_pos,
-								  int a_phase)
-{
-	Neuron& n1 = neurons[a_src_id];
-	Neuron& n2 = neurons[a_src_id + pos_offset_[a_dst_pos]];
-
-	// Return immediatly if both neuron have the same label as they fire 
-	// together anyway, so the destination neuron is sure to fire, no point in
-	// increasing the potential
-	if (TRIGGER_SAME_LABEL_NEURONS && n1.label == n2.label) return;
-
-	// Add the weight to the potential
-	float w = ComputeWeigth(a_src_id, n2.id, a_dst_pos);
-	n2.pot += w;
-
-	// Don't propagate receiving neuron isn't over the threshold
-	if (n2.pot < POT_THRESHOLD) return;
-
-	// If already the same label, no need to propagate
-	if (n1.label == n2.label) return;
-
-	// If the connection strengh is strong enough, merge the segments
-	if (MERGE_SEGMENTS && n2.is_segmented && w > SEG_MERGE_TRESHOLD)
-		MergeSegments(n1.label, n2.label, a_phase);
-
-	PropagateLabel(n2, n1.label, a_phase);
-
-}
-
-//=============================================================================
-void SegmentationLayer::PropagateLabel(Neuron& a_n, int a_label, int a_phase)
-{
-	// Propagate the label to this neuron
-	a_n.label = a_label;
-	// Set the new phase
-	a_n.phase = a_phase;
-	// Set as part of a segment
-	a_n.is_segmented = true;
-}
-
-//=============================================================================
-void SegmentationLayer::MergeSegments(int a_src_label, 
-									  int a_dst_label, 
-									  int a_phase)
-{
-	// Make all the neurons with the destination neuron label fire
-	// Iterate through all neurons
-	for (int y = active_reg_.y; y < active_reg_.height; ++y) for
-		(int x = active_reg_.x; x < active_reg_.width; ++x)
-	{
-		int i = y * width + x;
-
-		// If it has the destination neuron label
-		if (neurons[i].label == a_dst_label)
-		{
-			// Rise the potential to the firing threshold
-			neurons[i].pot = POT_THRESHOLD;
-			// Set their new label
-			neurons[i].label = a_src_label;
-			// Set the new phase
-			neurons[i].phase = a_phase;
-		}
-	}
-}
-
-//=============================================================================
-void SegmentationLayer::TriggerSameLabelNeurons(int a_id, int a_new_phase)
-{
-	// Check if the phase is the same as the new phase and skip if so.
-	if (neurons[a_id].phase == a_new_phase) return;
-	// If the phase is different from the new phase, this means this neuron is
-	// the first of his segment to spike. After this function is done, all 
-	// neurons with the same label as this neuron will be set to the new phase
-	// and will thus skip this function executing it only once per segment.
-
-	// Trigger all neurons with same ID
-	for (int y = active_reg_.y; y < active_reg_.height; ++y) for 
-		(int x = active_reg_.x; x < active_reg_.width; ++x)
-	{
-		int i = y * width + x;
-		Neuron& tmpN = neurons[i];
-
-		if (i != a_id // If not the current neuron
-			&& tmpN.label == neurons[a_id].label // And has same label
-			&& tmpN.phase != a_new_phase) // And hasn't fired yet
-		{
-			// Rise the potential to the firing threshold
-			tmpN.pot = POT_THRESHOLD;
-			// Set their new Phase now so it doesn't redo this 
-			// loop when the neuron fires.
-			tmpN.phase = a_new_phase;
-		}
-	}
-}
+/** @file NeuralLayer.cpp
+*
+*
+*  @author Vincent de Ladurantaye
+*/
+
+#include "SegmentationLayer.h"
+#include "LayerDebugger.h"
+#include "LayerState.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <unordered_set>
+#include <fstream>
+using namespace std;
+
+//=============================================================================
+//						Static members declarations
+//=============================================================================
+const NeuronRelPos SegmentationLayer::PROPAGATION_ORDER[8] = 
+{
+	N_UP_L, N_UP, N_UP_R, N_LEFT, N_RIGHT, N_DOWN_L, N_DOWN, N_DOWN_R
+};
+
+//=============================================================================
+//								 SegmentationLayer
+//=============================================================================
+SegmentationLayer::SegmentationLayer(const cv::Mat& a_img) :
+	SegmentationLayer(ImageData(a_img))
+{
+}
+//-----------------------------------------------------------------------------
+
+SegmentationLayer::SegmentationLayer(ImageData& a_img_data) :
+	NeuralLayer(a_img_data),
+	MAX_SEG_CASCADES(Config::SEG_MAX_CASCADES),
+	MAX_SEG_CYCLES(Config::SEG_MAX_CYCLES),
+	MIN_SEGMENT_SIZE(Config::MIN_SEGMENT_SIZE),
+	TRIGGER_SAME_LABEL_NEURONS(Config::SEG_TRIGGER_SAME_LABEL_NEURONS),
+	MERGE_SEGMENTS(Config::SEG_MERGE_SEGMENTS),
+	WEIGHT_MAX_VALUE(Config::SEG_WEIGHT_MAX),
+	WEIGHT_SLOPE(Config::SEG_WEIGHT_SLOPE),
+	WEIGHT_OFFSET(Config::SEG_WEIGHT_OFFSET),
+	WEIGHT_PLANES_MODE(Config::SEG_WEIGHT_PLANES),
+	WEIGHT_PLANES_MAX_MB(Config::SEG_WEIGHT_PLANES_MAX_MB),
+	COARSEN_SEGMENTS(Config::SEG_COARSEN_SEGMENTS),
+	COARSEN_DELTA_PERIOD(Config::SEG_COARSEN_DELTA_PERIOD),
+	COARSEN_CYCLES(Config::SEG_COARSEN_CYCLES)
+{
+	SEG_MERGE_TRESHOLD = ComputeWeigth(Config::SEG_MERGE_DELTA);
+
+	pos_offset_[N_UP_L] = -(int)width - 1; // using type cast to avoid warning:
+	pos_offset_[N_UP] = -(int)width;	   // minus applied to unsigned type
+	pos_offset_[N_UP_R] = -(int)width + 1;
+	pos_offset_[N_LEFT] = -1;
+	pos_offset_[N_RIGHT] = +1;
+	pos_offset_[N_DOWN_L] = width - 1;
+	pos_offset_[N_DOWN] = width;
+	pos_offset_[N_DOWN_R] = width + 1;
+
+	// Neighbor position of each relative position
+	neighbor_pos_[N_UP_L] = cv::Point(-1, -1);
+	neighbor_pos_[N_UP] = cv::Point(0, -1);
+	neighbor_pos_[N_UP_R] = cv::Point(1, -1);
+	neighbor_pos_[N_LEFT] = cv::Point(-1, 0);
+	neighbor_pos_[N_RIGHT] = cv::Point(1, 0);
+	neighbor_pos_[N_DOWN_L] = cv::Point(-1, 1);
+	neighbor_pos_[N_DOWN] = cv::Point(0, 1);
+	neighbor_pos_[N_DOWN_R] = cv::Point(1, 1);
+
+	InitTileOffsets();
+
+	use_weight_planes_ = false;
+	weight_planes_spikes_ = 0;
+	n_super_neurons_ = 0;
+
+	seg_state_ = SEG_STATE_IDLE;
+	stable_cascade_count_ = 0;
+	stabilization_coef_ = 0.0f;
+	converged_ = false;
+	traced_cycle_ = -1;
+}
+
+//=============================================================================
+SegmentationLayer::~SegmentationLayer()
+{
+}
+
+//=============================================================================
+void SegmentationLayer::SegmentLayer()
+{
+	StartSegmentation();
+
+	while (Step())
+	{
+	}
+}
+
+//=============================================================================
+void SegmentationLayer::StartSegmentation()
+{
+	stable_cascade_count_ = 0;
+	stabilization_coef_ = 0.0f;
+	converged_ = false;
+	n_super_neurons_ = 0;
+	traced_cycle_ = -1;
+	seg_state_ = SEG_STATE_RUNNING;
+
+	// Nothing to simulate if all the neurons are outside of the active regions
+	if (active_spans_.empty()) seg_state_ = SEG_STATE_DONE;
+}
+
+//=============================================================================
+bool SegmentationLayer::Step()
+{
+	if (seg_state_ == SEG_STATE_IDLE) StartSegmentation();
+	if (seg_state_ == SEG_STATE_DONE) return false;
+
+	if (n_cycles >= MAX_SEG_CYCLES)
+	{
+		EndSegmentation();
+		return false;
+	}
+
+	LayerDebugHooks::Cascade(*this, n_cascades);
+	LayerProfileHooks::TraceCycleBegin(layer_id, n_cycles, traced_cycle_);
+	LayerProfileHooks::TraceBegin("Cascade", layer_id, n_cascades);
+
+	float delta = FindNextTimeStep();
+
+	sim_time += delta;
+
+	AdvanceTime(delta);
+
+	while (FireNeurons(n_cascades, sim_time) > 0)
+	{
+	}
+
+	GlobalInhibition();
+	UpdateWeightPlanes();
+
+	// Update the super-neurons whose segment changed during the cascade
+	if (!detached_neurons_.empty()) DetachNeurons();
+
+	++n_cascades;
+
+	// Check if spikes are stable
+	stabilization_coef_ = GetCoefStabilization(0);
+	if (stabilization_coef_ < 0.4)
+	{
+		++stable_cascade_count_;
+	}
+	else stable_cascade_count_ = 0;
+
+	LayerProfileHooks::TraceEnd("Cascade", layer_id);
+
+	// If enough consecutive cascades were stable, stop the simulation
+	if (stable_cascade_count_ >= 1)
+	{
+		converged_ = true;
+		EndSegmentation();
+		return false;
+	}
+
+	// If we have a max number of cascade to do, check if we reached it
+	if (MAX_SEG_CASCADES > 0 && n_cascades >= MAX_SEG_CASCADES)
+	{
+		EndSegmentation();
+		return false;
+	}
+
+	// Check if cycle is completed, if not, continue this cycle
+	if (IsCycleCompleted())
+	{
+		LayerDebugHooks::Cycle(*this, n_cycles);
+		LayerProfileHooks::TraceCycleEnd(layer_id, n_cycles, traced_cycle_);
+
+		++n_cycles;
+		ResetCycle();
+
+		// Collapse the segments that became stable during the cycle
+		if (COARSEN_SEGMENTS) CoarsenStableSegments();
+
+		if (n_cycles >= MAX_SEG_CYCLES)
+		{
+			EndSegmentation();
+			return false;
+		}
+	}
+
+	return true;
+}
+
+//=============================================================================
+bool SegmentationLayer::RunCascades(uint a_nb_cascades)
+{
+	for (uint i = 0; i < a_nb_cascades; ++i)
+	{
+		if (!Step()) return false;
+	}
+
+	return true;
+}
+
+//=============================================================================
+bool SegmentationLayer::RunCycles(uint a_nb_cycles)
+{
+	uint lastCycle = n_cycles + a_nb_cycles;
+	while (n_cycles < lastCycle)
+	{
+		if (!Step()) return false;
+	}
+
+	return true;
+}
+
+//=============================================================================
+SegmentationResult SegmentationLayer::SegmentWithDeadline(
+	double a_time_budget_ms,
+	const CancellationToken* a_cancel,
+	bool a_clear_small_segments)
+{
+	using namespace std::chrono;
+	steady_clock::time_point tStart = steady_clock::now();
+	steady_clock::time_point deadline = tStart + 
+		duration_cast<steady_clock::duration>(
+			duration<double, milli>(a_time_budget_ms));
+
+	SegmentationResult result;
+	result.deadline_reached = false;
+	result.cancelled = false;
+
+	StartSegmentation();
+
+	while (Step())
+	{
+		if (a_cancel && a_cancel->IsCancelled())
+		{
+			result.cancelled = true;
+		}
+		else if (a_time_budget_ms > 0 && steady_clock::now() >= deadline)
+		{
+			result.deadline_reached = true;
+		}
+		else continue;
+
+		// Complete the layer state with the labels reached so far
+		EndSegmentation();
+		break;
+	}
+
+	result.labels = GetLabels();
+
+	if (a_clear_small_segments)
+	{
+		CountSegments();
+		ClearSmallSegments();
+
+		unordered_set<int> smallSegments;
+		for (auto& segment : segments)
+		{
+			if (segment.nbNeuron < (int)MIN_SEGMENT_SIZE)
+				smallSegments.insert(segment.id);
+		}
+		for (int y = 0; y < result.labels.rows; ++y)
+		{
+			int* row = result.labels.ptr<int>(y);
+			for (int x = 0; x < result.labels.cols; ++x)
+			{
+				if (smallSegments.count(row[x])) row[x] = -1;
+			}
+		}
+	}
+
+	result.convergence = stabilization_coef_;
+	result.converged = converged_;
+	result.cycles = n_cycles;
+	result.cascades = n_cascades;
+	result.time_ms = duration<double, milli>(
+		steady_clock::now() - tStart).count();
+
+	return result;
+}
+
+//=============================================================================
+void SegmentationLayer::EndSegmentation()
+{
+	seg_state_ = SEG_STATE_DONE;
+	LayerProfileHooks::TraceCycleEnd(layer_id, n_cycles, traced_cycle_);
+
+	// Restore all the neurons so that the layer state is complete
+	if (n_frozen_ > 0) ExpandSuperNeurons();
+	
+	//ClearSmallSegments();
+
+	cout << "\nCycle: " << n_cycles << "\tCascade: " << n_cascades
+		<< "\tSpikes: " << n_spikes 
+		<< "\tConvergence: " << stabilization_coef_ << endl;
+
+	LayerDebugHooks::End(*this);
+}
+
+//=============================================================================
+void SegmentationLayer::InitFromCoarseLayer(const SegmentationLayer& a_coarse)
+{
+	for (uint y = 0; y < height; ++y)
+	for (uint x = 0; x < width; ++x)
+	{
+		CopyNeuronState(a_coarse, GetCoarseNeuronId(a_coarse, x, y),
+						GetNeuronId(x, y));
+	}
+
+	// Continue the simulation where the coarse layer stopped so that the
+	// phases and spike times stay consistent
+	sim_time = a_coarse.sim_time;
+	n_cascades = a_coarse.n_cascades;
+}
+
+//=============================================================================
+void SegmentationLayer::CountSegments()
+{
+	segments.clear();
+
+	vector<int> segmentCounts(size);
+
+	for (uint i = 0; i < size; ++i)
+	{
+		segmentCounts[i] = 0;
+	}
+
+	// Iterate through all neurons to count neurons with the same labels. 
+	// Neurons are visited in row-major order whatever the layout so that the
+	// segments are listed in the same order.
+	for (uint y = 0; y < height; ++y)
+	for (uint x = 0; x < width; ++x)
+	{
+		const Neuron& neuron = neurons[GetNeuronId(x, y)];
+
+		// If the phase is higher than 0, we have a neuron part of a segment
+		if (neuron.phase > 0)
+		{
+			// Check if the segment already exist
+			bool segmentFound = false;
+			for (auto& segment : segments)
+			{
+				if (segment.id == neuron.label)
+				{
+					++segment.nbNeuron;
+					segmentFound = true;
+				}
+			}
+
+			// If we didn't find the segment, create it
+			if (segmentFound == false)
+			{
+				Segment seg;
+				seg.id = neuron.label;
+				seg.phase = neuron.phase;
+				seg.nbNeuron = 1;
+
+				segments.push_back(seg);
+			}
+		}
+	}
+
+	cout << "Number of segments: " << segments.size() << endl;
+}
+
+//=============================================================================
+void SegmentationLayer::ClearSmallSegments()
+{
+	if (segments.empty()) CountSegments();
+
+	// Iterate through segments and set to 0 the phase of neurons part of 
+	// small segments so that they have the same phase as neurons
+	// that didn't fire.
+	for (auto& segment : segments)
+	{
+		if (segment.nbNeuron < MIN_SEGMENT_SIZE)
+		{
+			for (auto& neuron : neurons)
+			{
+				if (neuron.label == segment.id)
+				{
+					neuron.phase = 0;
+				}
+			}
+		}
+	}
+}
+
+//=============================================================================
+void SegmentationLayer::SetWeightPlanes(bool a_enable)
+{
+	use_weight_planes_ = a_enable;
+	weight_planes_spikes_ = 0;
+
+	if (!a_enable)
+	{
+		// Release the memory
+		vector<float>().swap(weight_planes_);
+		return;
+	}
+
+	weight_planes_.assign(8 * size, 0.0f);
+	for (int p = 0; p < 8; ++p)
+	{
+		ComputeWeightPlane((NeuronRelPos)p, &weight_planes_[p * size]);
+	}
+}
+
+//=============================================================================
+size_t SegmentationLayer::GetWeightPlanesMemory() const
+{
+	return weight_planes_.size() * sizeof(float);
+}
+
+//=============================================================================
+cv::Mat SegmentationLayer::GetLabels() const
+{
+	cv::Mat labels;
+	GetLabels(labels);
+	return labels;
+}
+//-----------------------------------------------------------------------------
+void SegmentationLayer::GetLabels(cv::Mat& a_labels) const
+{
+	a_labels.create(height, width, CV_32S);
+
+	for (int y = 0; y < (int)height; ++y)
+	{
+		int* row = a_labels.ptr<int>(y);
+		for (int x = 0; x < (int)width; ++x)
+		{
+			row[x] = neurons[GetNeuronId(x, y)].label;
+		}
+	}
+}
+
+//=============================================================================
+cv::Mat SegmentationLayer::GetImg()
+{
+	cout << "TEST: "
+		<< "rows: " << img_data_.image_.rows << " "
+		<< "cols: " << img_data_.image_.cols << endl;
+	return img_data_.image_.clone();
+}
+
+//=============================================================================
+//								Protected
+//=============================================================================
+float SegmentationLayer::ComputeWeigth(float a_feat_delta)
+{
+	//return WEIGHT_MAX_VALUE * exp(-WEIGHT_SLOPE * a_feat_delta);
+
+	float deltaCoef = 1 - 1 / (1 + exp(-WEIGHT_SLOPE * (abs(a_feat_delta) -
+														WEIGHT_OFFSET)));
+	return WEIGHT_MAX_VALUE * deltaCoef;
+}
+
+//=============================================================================
+void SegmentationLayer::CopyNeuronState(const SegmentationLayer& a_src,
+										uint a_src_id, uint a_id)
+{
+	const Neuron& srcN = a_src.neurons[a_src_id];
+	Neuron& n = neurons[a_id];
+
+	// The maximal charge comes from this layer's features
+	n.pot = srcN.pot;
+	n.phase = srcN.phase;
+	n.label = srcN.label;
+	n.last_spike = srcN.last_spike;
+	n.fire_period = srcN.fire_period;
+	n.delta_period = -1;
+
+	cycle_spiked[a_id] = a_src.cycle_spiked[a_src_id];
+	is_segmented[a_id] = a_src.is_segmented[a_src_id];
+}
+
+//=============================================================================
+uint SegmentationLayer::GetCoarseNeuronId(const SegmentationLayer& a_coarse,
+										  int a_x, int a_y)
+{
+	uint coarseX = min(a_x * a_coarse.width / width, a_coarse.width - 1);
+	uint coarseY = min(a_y * a_coarse.height / height, a_coarse.height - 1);
+	return a_coarse.GetNeuronId(coarseX, coarseY);
+}
+
+//=============================================================================
+void SegmentationLayer::InitWeightPlanes()
+{
+	size_t memory = 8 * (size_t)size * sizeof(float);
+	bool enable = false;
+
+	switch (WEIGHT_PLANES_MODE)
+	{
+	case WEIGHT_PLANES_ON:
+		enable = true;
+		break;
+
+	case WEIGHT_PLANES_AUTO:
+		// A spike computes the weights to the eight neighbors, so the planes
+		// cost as many weights as every neuron spiking once. The number of
+		// spikes isn't known in advance: a warm-started frame spikes less
+		// than the layer size, a segmentation from scratch many times more.
+		// The planes are computed once the spikes have computed as many
+		// weights as the planes hold, so the weights are computed at most
+		// about twice, and only if they fit in the memory budget.
+		SetWeightPlanes(false);
+		if (memory <= WEIGHT_PLANES_MAX_MB * 1024 * 1024)
+			weight_planes_spikes_ = n_spikes + size;
+		return;
+
+	case WEIGHT_PLANES_OFF:
+	default:
+		break;
+	}
+
+	SetWeightPlanes(enable);
+}
+
+//=============================================================================
+void SegmentationLayer::UpdateWeightPlanes()
+{
+	if (weight_planes_spikes_ > 0 && n_spikes >= weight_planes_spikes_)
+		SetWeightPlanes(true);
+}
+
+//=============================================================================
+void SegmentationLayer::InitTileOffsets()
+{
+	use_tile_offsets_ = false;
+	full_tiles_width_ = width / TILE_SIZE * TILE_SIZE;
+	full_tiles_height_ = height / TILE_SIZE * TILE_SIZE;
+
+	// The offsets are measured in the second tile of the second row of tiles,
+	// so the layer needs at least three complete tiles in each direction
+	if (NEURON_LAYOUT == LAYOUT_ROW_MAJOR ||
+		full_tiles_width_ < 3 * (int)TILE_SIZE ||
+		full_tiles_height_ < 3 * (int)TILE_SIZE) return;
+
+	// Coordinate within the tile of each tile class
+	int classCoord[3] = { 0, min(1, (int)TILE_SIZE - 1), (int)TILE_SIZE - 1 };
+
+	for (int cx = 0; cx < 3; ++cx)
+	for (int cy = 0; cy < 3; ++cy)
+	{
+		int x = TILE_SIZE + classCoord[cx];
+		int y = TILE_SIZE + classCoord[cy];
+		int id = GetNeuronId(x, y);
+
+		for (int p = 0; p < 8; ++p)
+		{
+			tile_offsets_[cx * 3 + cy][p] =
+				GetNeighborId(x, y, (NeuronRelPos)p) - id;
+		}
+	}
+
+	use_tile_offsets_ = true;
+}
+
+//=============================================================================
+void SegmentationLayer::ComputeWeightPlane(NeuronRelPos a_dst_pos, 
+										   float* a_plane)
+{
+	cv::Point delta = neighbor_pos_[a_dst_pos];
+
+	for (int y = 0; y < (int)height; ++y)
+	for (int x = 0; x < (int)width; ++x)
+	{
+		if (!IsInLayer(x + delta.x, y + delta.y)) continue;
+
+		int i = GetNeuronId(x, y);
+		a_plane[i] = ComputeWeigth(i, GetNeighborId(x, y, a_dst_pos),
+								   a_dst_pos);
+	}
+}
+
+//=============================================================================
+void SegmentationLayer::PropagateSpike(int a_id, int a_phase)
+{
+	// Calculate the row and column of the current index
+	cv::Point pos = GetNeuronPos(a_id);
+	int neuronRow = pos.y;
+	int neuronCol = pos.x;
+
+	//-------------------------------------------------------------------------
+	// Propagate the spike among neirghbors
+	//-------------------------------------------------------------------------
+	// Neurons inside the interior of the layer have all their neighbors, so
+	// the spike is propagated without checking the layer boundaries
+	const int* offsets = IsInInterior(neuronCol, neuronRow) ?
+		GetNeighborOffsets(neuronCol, neuronRow) : nullptr;
+
+	if (offsets)
+	{
+		for (int p = 0; p < 8; ++p)
+		{
+			NeuronRelPos dstPos = PROPAGATION_ORDER[p];
+			Propagate(a_id, a_id + offsets[dstPos], dstPos, a_phase);
+		}
+	}
+	else
+	{
+		// Add weights to neighbors and propagate the neuron ID
+		if (neuronRow > 0 && neuronCol > 0)
+		{
+			Propagate(a_id, GetNeighborId(neuronCol, neuronRow, N_UP_L),
+					  N_UP_L, a_phase);
+		}
+
+		if (neuronRow > 0)
+		{
+			Propagate(a_id, GetNeighborId(neuronCol, neuronRow, N_UP),
+					  N_UP, a_phase);
+		}
+
+		if (neuronRow > 0 && neuronCol < width - 2)
+		{
+			Propagate(a_id, GetNeighborId(neuronCol, neuronRow, N_UP_R),
+					  N_UP_R, a_phase);
+		}
+
+		if (neuronCol > 0)
+		{
+			Propagate(a_id, GetNeighborId(neuronCol, neuronRow, N_LEFT),
+					  N_LEFT, a_phase);
+		}
+
+		if (neuronCol < width - 2)
+		{
+			Propagate(a_id, GetNeighborId(neuronCol, neuronRow, N_RIGHT),
+					  N_RIGHT, a_phase);
+		}
+
+		if (neuronRow < height - 2 && neuronCol > 0)
+		{
+			Propagate(a_id, GetNeighborId(neuronCol, neuronRow, N_DOWN_L),
+					  N_DOWN_L, a_phase);
+		}
+
+		if (neuronRow < height - 2)
+		{
+			Propagate(a_id, GetNeighborId(neuronCol, neuronRow, N_DOWN),
+					  N_DOWN, a_phase);
+		}
+
+		if (neuronRow < height - 2 && neuronCol < width - 2)
+		{
+			Propagate(a_id, GetNeighborId(neuronCol, neuronRow, N_DOWN_R),
+					  N_DOWN_R, a_phase);
+		}
+	}
+
+	//-------------------------------------------------------------------------
+	// Trigger neurons with the same label
+	//-------------------------------------------------------------------------
+	if (TRIGGER_SAME_LABEL_NEURONS) TriggerSameLabelNeurons(a_id, a_phase);
+
+	if (n_frozen_ > 0) TriggerSuperNeuron(a_id, a_phase);
+}
+
+//=============================================================================
+void SegmentationLayer::Propagate(int a_src_id,
+								  int a_dst_id,
+								  NeuronRelPos a_dst_pos,
+								  int a_phase)
+{
+	// Frozen neurons only fire with their super-neuron
+	if (!excluded_.empty() && excluded_[a_dst_id]) return;
+
+	Neuron& n1 = neurons[a_src_id];
+	Neuron& n2 = neurons[a_dst_id];
+
+	// Return immediatly if both neuron have the same label as they fire 
+	// together anyway, so the destination neuron is sure to fire, no point in
+	// increasing the potential
+	if (TRIGGER_SAME_LABEL_NEURONS && n1.label == n2.label) return;
+
+	// Add the weight to the potential
+	float w = use_weight_planes_ ? weight_planes_[a_dst_pos * size + a_src_id]
+		: ComputeWeigth(a_src_id, a_dst_id, a_dst_pos);
+	n2.pot += w;
+
+	// Don't propagate receiving neuron isn't over the threshold
+	if (n2.pot < POT_THRESHOLD) return;
+
+	// If already the same label, no need to propagate
+	if (n1.label == n2.label) return;
+
+	// If the connection strengh is strong enough, merge the segments
+	if (MERGE_SEGMENTS && is_segmented[a_dst_id] && w > SEG_MERGE_TRESHOLD)
+		MergeSegments(n1.label, n2.label, a_phase);
+
+	PropagateLabel(n2, n1.label, a_phase);
+
+}
+
+//=============================================================================
+void SegmentationLayer::MergeSegments(int a_src_label, 
+									  int a_dst_label, 
+									  int a_phase)
+{
+	LayerProfileHooks::Timer timer(phase_counters_, SIM_PHASE_MERGE_SEGMENTS);
+	LayerProfileHooks::CountMerge(phase_counters_);
+
+	// Make all the neurons with the destination neuron label fire
+	// Iterate through the neurons of the active region
+	for (auto& span : active_spans_)
+	for (uint i = span.begin; i < span.end; ++i)
+	{
+		// If it has the destination neuron label
+		if (neurons[i].label == a_dst_label)
+		{
+			// Rise the potential to the firing threshold
+			neurons[i].pot = POT_THRESHOLD;
+			// Set their new label
+			neurons[i].label = a_src_label;
+			// Set the new phase
+			neurons[i].phase = a_phase;
+		}
+	}
+
+	// Relabel the frozen neurons of the super-neurons of the segment
+	if (n_frozen_ == 0) return;
+	for (auto& superNeuron : super_neurons_)
+	{
+		if (superNeuron.label != a_dst_label) continue;
+
+		superNeuron.label = a_src_label;
+		for (uint id : superNeuron.interior)
+		{
+			neurons[id].label = a_src_label;
+		}
+	}
+}
+
+//=============================================================================
+void SegmentationLayer::TriggerSameLabelNeurons(int a_id, int a_new_phase)
+{
+	// Check if the phase is the same as the new phase and skip if so.
+	if (neurons[a_id].phase == a_new_phase) return;
+	// If the phase is different from the new phase, this means this neuron is
+	// the first of his segment to spike. After this function is done, all 
+	// neurons with the same label as this neuron will be set to the new phase
+	// and will thus skip this function executing it only once per segment.
+
+	LayerProfileHooks::Timer timer(phase_counters_, 
+								   SIM_PHASE_TRIGGER_SAME_LABEL);
+
+	// Trigger all neurons with same ID
+	for (auto& span : active_spans_)
+	for (uint i = span.begin; i < span.end; ++i)
+	{
+		Neuron& tmpN = neurons[i];
+
+		if (i != (uint)a_id // If not the current neuron
+			&& tmpN.label == neurons[a_id].label // And has same label
+			&& tmpN.phase != a_new_phase) // And hasn't fired yet
+		{
+			// Rise the potential to the firing threshold
+			tmpN.pot = POT_THRESHOLD;
+			// Set their new Phase now so it doesn't redo this 
+			// loop when the neuron fires.
+			tmpN.phase = a_new_phase;
+		}
+	}
+}
+
+//=============================================================================
+void SegmentationLayer::CoarsenStableSegments()
+{
+	// Neurons of a segment and stability of the segment during the cycle
+	struct SegmentState
+	{
+		vector<uint> ids;
+		int phase;
+		bool stable;
+		double delta_sum;
+	};
+
+	// Group the simulated neurons that aren't part of a super-neuron by 
+	// segment
+	unordered_map<int, SegmentState> segmentStates;
+	for (auto& span : active_spans_)
+	for (uint i = span.begin; i < span.end; ++i)
+	{
+		if (n_frozen_ > 0 && super_of_[i] >= 0) continue;
+
+		const Neuron& n = neurons[i];
+		auto it = segmentStates.find(n.label);
+		if (it == segmentStates.end())
+		{
+			it = segmentStates.insert({ n.label, { {}, n.phase, true, 0.0 } })
+				.first;
+		}
+		SegmentState& state = it->second;
+
+		// All the neurons must have fired together, at stable intervals on
+		// average
+		state.ids.push_back(i);
+		state.stable = state.stable && n.phase >= 0 && n.phase == state.phase
+			&& n.fire_period > 0;
+		state.delta_sum += fabs(n.delta_period);
+	}
+
+	// Count the consecutive stable cycles, forgetting the segments that 
+	// aren't stable anymore, and collapse the ones that were stable long 
+	// enough
+	unordered_map<int, uint> stableCycles;
+	bool collapsed = false;
+	for (auto& it : segmentStates)
+	{
+		SegmentState& state = it.second;
+		if (!state.stable || state.ids.size() < 3 ||
+			state.delta_sum / state.ids.size() > COARSEN_DELTA_PERIOD) continue;
+
+		auto prev = stable_cycles_.find(it.first);
+		uint nbCycles = (prev == stable_cycles_.end()) ? 1 : prev->second + 1;
+		if (nbCycles < COARSEN_CYCLES)
+		{
+			stableCycles[it.first] = nbCycles;
+			continue;
+		}
+
+		// Separate the boundary neurons, which have a neighbor of another
+		// segment, from the interior neurons
+		SuperNeuron superNeuron;
+		superNeuron.label = it.first;
+		superNeuron.phase = state.phase;
+		superNeuron.delta_sum = 0.0;
+		for (uint id : state.ids)
+		{
+			cv::Point pos = GetNeuronPos(id);
+			bool boundary = false;
+			for (int p = 0; p < 8 && !boundary; ++p)
+			{
+				cv::Point nPos = pos + neighbor_pos_[p];
+				boundary = IsInLayer(nPos.x, nPos.y) && 
+					neurons[GetNeuronId(nPos.x, nPos.y)].label != it.first;
+			}
+
+			if (boundary) superNeuron.members.push_back(id);
+			else superNeuron.interior.push_back(id);
+		}
+
+		// Not worth it if there's no neuron to freeze
+		if (superNeuron.interior.size() < 2) continue;
+
+		// The interior neuron with the highest charge represents the interior
+		// so that segments with leaders keep firing on their own
+		auto rep = max_element(superNeuron.interior.begin(),
+							   superNeuron.interior.end(),
+							   [this](uint a, uint b)
+			{ return GetMaxCharge(a) < GetMaxCharge(b); });
+		superNeuron.representative = *rep;
+		superNeuron.members.push_back(*rep);
+		superNeuron.interior.erase(rep);
+
+		if (super_of_.empty())
+		{
+			super_of_.assign(size, -1);
+			frozen_.assign(size, false);
+		}
+
+		int superId = super_neurons_.size();
+		for (uint id : superNeuron.members)
+		{
+			super_of_[id] = superId;
+		}
+		for (uint id : superNeuron.interior)
+		{
+			super_of_[id] = superId;
+			frozen_[id] = true;
+			superNeuron.delta_sum += fabs(neurons[id].delta_period);
+		}
+
+		n_frozen_ += superNeuron.interior.size();
+		frozen_delta_sum_ += superNeuron.delta_sum;
+		super_neurons_.push_back(move(superNeuron));
+		++n_super_neurons_;
+		collapsed = true;
+	}
+	stable_cycles_.swap(stableCycles);
+
+	if (collapsed) UpdateActiveSpans();
+}
+
+//=============================================================================
+void SegmentationLayer::TriggerSuperNeuron(int a_id, int a_phase)
+{
+	int superId = super_of_[a_id];
+	if (superId < 0) return;
+
+	// Trigger the members only once per cascade
+	SuperNeuron& superNeuron = super_neurons_[superId];
+	if (superNeuron.phase == a_phase) return;
+	superNeuron.phase = a_phase;
+
+	for (uint id : superNeuron.members)
+	{
+		Neuron& n = neurons[id];
+
+		// Rise the potential of the members that haven't fired yet and are
+		// still part of the segment
+		if (n.phase != a_phase && n.label == superNeuron.label)
+		{
+			n.pot = POT_THRESHOLD;
+		}
+	}
+}
+
+//=============================================================================
+void SegmentationLayer::DetachNeurons()
+{
+	bool unfrozen = false;
+
+	for (uint id : detached_neurons_)
+	{
+		int superId = super_of_[id];
+		if (superId < 0 || neurons[id].label == super_neurons_[superId].label)
+			continue;
+
+		super_of_[id] = -1;
+
+		// The frozen neighbors are now on the boundary of the segment
+		cv::Point pos = GetNeuronPos(id);
+		for (int p = 0; p < 8; ++p)
+		{
+			cv::Point nPos = pos + neighbor_pos_[p];
+			if (!IsInLayer(nPos.x, nPos.y)) continue;
+
+			uint nId = GetNeuronId(nPos.x, nPos.y);
+			if (!frozen_[nId] || super_of_[nId] != superId) continue;
+
+			UnfreezeNeuron(superId, nId);
+			super_neurons_[superId].members.push_back(nId);
+			unfrozen = true;
+		}
+	}
+	detached_neurons_.clear();
+
+	// Without frozen neuron left, the remaining members would keep a stale
+	// super-neuron that isn't checked anymore
+	if (unfrozen && n_frozen_ == 0) ClearSuperNeurons();
+
+	if (unfrozen) UpdateActiveSpans();
+}
+
+//=============================================================================
+void SegmentationLayer::UnfreezeNeuron(uint a_super_id, uint a_id)
+{
+	SuperNeuron& superNeuron = super_neurons_[a_super_id];
+	Neuron& n = neurons[a_id];
+
+	// Remove the neuron from the stabilization accounting
+	double delta = fabs(n.delta_period);
+	superNeuron.delta_sum -= delta;
+	frozen_delta_sum_ -= delta;
+	--n_frozen_;
+	frozen_[a_id] = false;
+
+	GetUnfrozenState(a_super_id, a_id, n);
+	cycle_spiked[a_id] = cycle_spiked[superNeuron.representative];
+}
+
+//=============================================================================
+void SegmentationLayer::GetUnfrozenState(uint a_super_id, uint a_id,
+										 Neuron& a_n) const
+{
+	const SuperNeuron& superNeuron = super_neurons_[a_super_id];
+	const Neuron& rep = neurons[superNeuron.representative];
+	float repCharge = GetMaxCharge(superNeuron.representative);
+
+	// The neuron fired with the super-neuron. Neurons charging from the same
+	// time have potentials proportional to their maximal charge, so scale 
+	// the potential of the representative.
+	a_n.label = superNeuron.label;
+	a_n.phase = superNeuron.phase;
+	a_n.pot = (repCharge > 0) ?
+		max(rep.pot, 0.0f) * GetMaxCharge(a_id) / repCharge : 0.0f;
+	a_n.last_spike = rep.last_spike;
+	a_n.fire_period = rep.fire_period;
+}
+
+//=============================================================================
+void SegmentationLayer::ExpandSuperNeurons()
+{
+	for (uint s = 0; s < super_neurons_.size(); ++s)
+	{
+		for (uint id : super_neurons_[s].interior)
+		{
+			if (frozen_[id]) UnfreezeNeuron(s, id);
+		}
+	}
+
+	ClearSuperNeurons();
+
+	UpdateActiveSpans();
+}
+
+//=============================================================================
+void SegmentationLayer::ClearSuperNeurons()
+{
+	super_neurons_.clear();
+	if (!super_of_.empty()) super_of_.assign(size, -1);
+	detached_neurons_.clear();
+	n_frozen_ = 0;
+	frozen_delta_sum_ = 0.0;
+}
+
+//=============================================================================
+void SegmentationLayer::WriteBinaryState(LayerStateWriter& a_writer) const
+{
+	NeuralLayer::WriteBinaryState(a_writer);
+
+	// Save the interior neurons of the super-neurons as if they were
+	// unfrozen
+	if (n_frozen_ > 0)
+	{
+		Neuron* stateNeurons = (Neuron*)a_writer.GetSection(STATE_NEURONS);
+		char* flags = a_writer.GetSection(STATE_NEURON_FLAGS);
+
+		for (uint s = 0; s < super_neurons_.size(); ++s)
+		{
+			const SuperNeuron& superNeuron = super_neurons_[s];
+			bool spiked = cycle_spiked[superNeuron.representative];
+
+			for (uint id : superNeuron.interior)
+			{
+				if (!frozen_[id]) continue;
+
+				GetUnfrozenState(s, id, stateNeurons[id]);
+				flags[id] = spiked ? flags[id] | NEURON_CYCLE_SPIKED :
+					flags[id] & ~NEURON_CYCLE_SPIKED;
+			}
+		}
+	}
+
+	SegmentationLayerState state;
+	memset(&state, 0, sizeof(state));
+	state.seg_state = seg_state_;
+	state.stable_cascade_count = stable_cascade_count_;
+	state.stabilization_coef = stabilization_coef_;
+	state.converged = converged_;
+	state.n_super_neurons = n_super_neurons_;
+	state.max_seg_cascades = MAX_SEG_CASCADES;
+	state.max_seg_cycles = MAX_SEG_CYCLES;
+	state.min_segment_size = MIN_SEGMENT_SIZE;
+	state.trigger_same_label_neurons = TRIGGER_SAME_LABEL_NEURONS;
+	state.merge_segments = MERGE_SEGMENTS;
+	state.seg_merge_treshold = SEG_MERGE_TRESHOLD;
+	state.weight_max_value = WEIGHT_MAX_VALUE;
+	state.weight_slope = WEIGHT_SLOPE;
+	state.weight_offset = WEIGHT_OFFSET;
+	state.coarsen_segments = COARSEN_SEGMENTS;
+	state.coarsen_delta_period = COARSEN_DELTA_PERIOD;
+	state.coarsen_cycles = COARSEN_CYCLES;
+	a_writer.AddSection(STATE_SEGMENTATION, &state, sizeof(state));
+
+	a_writer.AddSection(STATE_SEGMENTS, segments.data(),
+						segments.size() * sizeof(Segment));
+
+	int* stableCycles = (int*)a_writer.AddSection(STATE_STABLE_CYCLES,
+		stable_cycles_.size() * 2 * sizeof(int));
+	for (auto& stable : stable_cycles_)
+	{
+		*stableCycles++ = stable.first;
+		*stableCycles++ = (int)stable.second;
+	}
+}
+
+//=============================================================================
+bool SegmentationLayer::ReadBinaryState(const LayerStateView& a_state)
+{
+	const SegmentationLayerState* state = 
+		a_state.GetStruct<SegmentationLayerState>(STATE_SEGMENTATION);
+	if (!state)
+	{
+		cerr << "Layer state isn't the state of a segmentation layer\n";
+		return false;
+	}
+
+	if (!NeuralLayer::ReadBinaryState(a_state)) return false;
+
+	bool weightsChanged = WEIGHT_MAX_VALUE != state->weight_max_value ||
+		WEIGHT_SLOPE != state->weight_slope ||
+		WEIGHT_OFFSET != state->weight_offset;
+
+	seg_state_ = (SegmentationState)state->seg_state;
+	stable_cascade_count_ = state->stable_cascade_count;
+	stabilization_coef_ = state->stabilization_coef;
+	converged_ = state->converged != 0;
+	n_super_neurons_ = state->n_super_neurons;
+	MAX_SEG_CASCADES = state->max_seg_cascades;
+	MAX_SEG_CYCLES = state->max_seg_cycles;
+	MIN_SEGMENT_SIZE = state->min_segment_size;
+	TRIGGER_SAME_LABEL_NEURONS = state->trigger_same_label_neurons != 0;
+	MERGE_SEGMENTS = state->merge_segments != 0;
+	SEG_MERGE_TRESHOLD = state->seg_merge_treshold;
+	WEIGHT_MAX_VALUE = state->weight_max_value;
+	WEIGHT_SLOPE = state->weight_slope;
+	WEIGHT_OFFSET = state->weight_offset;
+	COARSEN_SEGMENTS = state->coarsen_segments != 0;
+	COARSEN_DELTA_PERIOD = state->coarsen_delta_period;
+	COARSEN_CYCLES = state->coarsen_cycles;
+
+	// The weight planes were computed with the previous weights
+	if (use_weight_planes_ && weightsChanged) SetWeightPlanes(true);
+
+	// The super-neurons were expanded in the state
+	ClearSuperNeurons();
+	traced_cycle_ = -1;
+
+	size_t nbSegments, nbStable;
+	const Segment* stateSegments = 
+		a_state.GetArray<Segment>(STATE_SEGMENTS, &nbSegments);
+	segments.assign(stateSegments, stateSegments + nbSegments);
+
+	const int* stableCycles = 
+		a_state.GetArray<int>(STATE_STABLE_CYCLES, &nbStable);
+	stable_cycles_.clear();
+	for (size_t i = 0; i + 1 < nbStable; i += 2)
+	{
+		stable_cycles_[stableCycles[i]] = (uint)stableCycles[i + 1];
+	}
+
+	return true;
+}
@@ -0,0 +1,185 @@
+/** @file SegmentationLayerT.cpp
+*
+*
+*  @author Vincent de Ladurantaye
+*/
+
+#include "SegmentationLayerT.h"
+#include "PackedPixelLayer.h"
+
+
+namespace
+{
+	/**
+	* Disables the formatting of the input images while it exists. The image
+	* of a layer state was already formatted when the layer was created, so
+	* it must be used as is.
+	*/
+	class RawImagesScope
+	{
+	public:
+		RawImagesScope() :
+			resize_(Config::RESIZE_IMG_KEEP_RATIO),
+			fixed_size_(Config::FIXED_INPUT_IMGS_SIZE)
+		{
+			Config::RESIZE_IMG_KEEP_RATIO = false;
+			Config::FIXED_INPUT_IMGS_SIZE = false;
+		}
+		~RawImagesScope()
+		{
+			Config::RESIZE_IMG_KEEP_RATIO = resize_;
+			Config::FIXED_INPUT_IMGS_SIZE = fixed_size_;
+		}
+
+	private:
+		bool resize_;
+		bool fixed_size_;
+	};
+}
+
+
+//=============================================================================
+//								   Dispatcher
+//=============================================================================
+/**
+* Creates the specialized pixel layer of a given size policy corresponding to
+* the segmentation flags
+*/
+template <class Size>
+PixelLayer* CreateSizedPixelLayer(ImageData& a_img_data, bool a_random_init,
+								  bool a_trigger, bool a_merge)
+{
+	if (a_trigger && a_merge)
+		return new SegmentationLayerT<PixelFeature, SigmoidWeight, true, true,
+									  Size>(a_img_data, a_random_init);
+	else if (a_trigger)
+		return new SegmentationLayerT<PixelFeature, SigmoidWeight, true, false,
+									  Size>(a_img_data, a_random_init);
+	else if (a_merge)
+		return new SegmentationLayerT<PixelFeature, SigmoidWeight, false, true,
+									  Size>(a_img_data, a_random_init);
+	else
+		return new SegmentationLayerT<PixelFeature, SigmoidWeight, false, false,
+									  Size>(a_img_data, a_random_init);
+}
+
+//=============================================================================
+unique_ptr<PixelLayer> CreatePixelLayer(ImageData& a_img_data,
+										bool a_random_init)
+{
+	return CreatePixelLayer(a_img_data, a_random_init,
+							Config::SEG_TRIGGER_SAME_LABEL_NEURONS,
+							Config::SEG_MERGE_SEGMENTS,
+							Config::FIXED_INPUT_IMGS_SIZE);
+}
+//-----------------------------------------------------------------------------
+unique_ptr<PixelLayer> CreatePixelLayer(const string& a_img_file,
+										bool a_random_init)
+{
+	ImageData imgData(a_img_file);
+	return CreatePixelLayer(imgData, a_random_init);
+}
+//-----------------------------------------------------------------------------
+unique_ptr<PixelLayer> CreatePixelLayer(ImageData& a_img_data,
+										bool a_random_init,
+										bool a_trigger_same_label,
+										bool a_merge,
+										bool a_fixed_size)
+{
+	// Fixed size layers for the standard input sizes
+	if (a_fixed_size && Config::SIM_NEURON_LAYOUT == LAYOUT_ROW_MAJOR)
+	{
+		if (a_img_data.cols == 64 && a_img_data.rows == 128)
+			return unique_ptr<PixelLayer>(
+				CreateSizedPixelLayer<FixedSize<64, 128> >(
+					a_img_data, a_random_init, a_trigger_same_label, a_merge));
+		if (a_img_data.cols == 48 && a_img_data.rows == 128)
+			return unique_ptr<PixelLayer>(
+				CreateSizedPixelLayer<FixedSize<48, 128> >(
+					a_img_data, a_random_init, a_trigger_same_label, a_merge));
+	}
+
+	return unique_ptr<PixelLayer>(
+		CreateSizedPixelLayer<DynamicSize>(a_img_data, a_random_init,
+										   a_trigger_same_label, a_merge));
+}
+
+//=============================================================================
+unique_ptr<PixelLayer> CreatePixelLayer(const LayerStateView& a_state)
+{
+	const NeuralLayerState* layerState = 
+		a_state.GetStruct<NeuralLayerState>(STATE_LAYER);
+	const SegmentationLayerState* segState =
+		a_state.GetStruct<SegmentationLayerState>(STATE_SEGMENTATION);
+	size_t imageSize;
+	const char* image = a_state.GetSection(STATE_IMAGE, &imageSize);
+	if (!layerState || !segState || !image ||
+		imageSize != (size_t)layerState->width * layerState->height)
+	{
+		cerr << "Layer state has no image\n";
+		return nullptr;
+	}
+
+	// States without class were created by CreatePixelLayer()
+	const PixelLayerState* pixelState = 
+		a_state.GetStruct<PixelLayerState>(STATE_PIXEL_LAYER);
+	uint layerClass = pixelState ? 
+		pixelState->layer_class : PIXEL_LAYER_SPECIALIZED;
+
+	cv::Mat gray(layerState->height, layerState->width, CV_8U, 
+				 (void*)image);
+	RawImagesScope rawImages;
+	unique_ptr<PixelLayer> layer;
+
+	switch (layerClass)
+	{
+	case PIXEL_LAYER_GENERIC:
+	{
+		ImageData imgData(gray.clone());
+		layer.reset(new PixelLayer(imgData, false));
+		break;
+	}
+
+	case PIXEL_LAYER_SPECIALIZED:
+	case PIXEL_LAYER_FIXED_SIZE:
+	{
+		ImageData imgData(gray.clone());
+		layer = CreatePixelLayer(imgData, false,
+								 segState->trigger_same_label_neurons != 0,
+								 segState->merge_segments != 0,
+								 layerClass == PIXEL_LAYER_FIXED_SIZE);
+		break;
+	}
+
+	case PIXEL_LAYER_PACKED:
+	{
+		// The images are cut out of the packed image
+		size_t nbImages;
+		const cv::Rect* regions =
+			a_state.GetArray<cv::Rect>(STATE_PACKED_IMAGES, &nbImages);
+		cv::Rect layerReg(0, 0, gray.cols, gray.rows);
+		vector<cv::Mat> images;
+		for (size_t k = 0; k < nbImages; ++k)
+		{
+			if ((regions[k] & layerReg) != regions[k]) break;
+			images.push_back(gray(regions[k]).clone());
+		}
+		if (images.empty() || images.size() != nbImages)
+		{
+			cerr << "Layer state has no packed images\n";
+			return nullptr;
+		}
+		layer.reset(new PackedPixelLayer(images, false));
+		break;
+	}
+
+	default:
+		cerr << "Layer state has an unknown pixel layer class " 
+			<< layerClass << '\n';
+		return nullptr;
+	}
+
+	if (!layer->LoadBinaryState(a_state)) return nullptr;
+
+	return layer;
+}
@@ -0,0 +1,179 @@
+/**
+* @file SyntheticImage.cpp
+*
+* @authors Vincent de Ladurantaye
+*/
+#include "SyntheticImage.h"
+
+#include <algorithm>
+#include <cmath>
+#include <queue>
+#include <random>
+#include <vector>
+using namespace std;
+
+
+namespace
+{
+	/**
+	* Random numbers of the generator, independent of the implementation of
+	* the standard distributions. Only exact operations and sqrt(), which is
+	* correctly rounded, are used, so that the values don't depend on the
+	* math library of the platform.
+	*/
+	class SyntheticRng
+	{
+	public:
+		SyntheticRng(uint a_seed) : engine_(a_seed) {}
+
+		/// Uniform in [0, 1)
+		double Uniform()
+		{
+			return engine_() / 4294967296.0;
+		}
+
+		/// Uniform integer in [a_min, a_max]
+		int UniformInt(int a_min, int a_max)
+		{
+			return a_min + (int)(Uniform() * (a_max - a_min + 1));
+		}
+
+		/// Approximately standard normal, as the sum of 12 uniforms which is
+		/// exact in double precision
+		double Normal()
+		{
+			double sum = 0.0;
+			for (int i = 0; i < 12; ++i)
+			{
+				sum += Uniform();
+			}
+			return sum - 6.0;
+		}
+
+		/// Uniform direction, as a unit vector
+		void Direction(double& a_x, double& a_y)
+		{
+			// Uniform in the unit disk, by rejection
+			double norm2;
+			do
+			{
+				a_x = 2.0 * Uniform() - 1.0;
+				a_y = 2.0 * Uniform() - 1.0;
+				norm2 = a_x * a_x + a_y * a_y;
+			} while (norm2 > 1.0 || norm2 == 0.0);
+
+			double norm = sqrt(norm2);
+			a_x /= norm;
+			a_y /= norm;
+		}
+
+	private:
+		mt19937 engine_;
+	};
+}
+
+//=============================================================================
+cv::Mat GenerateSyntheticImage(const SyntheticImageParams& a_params,
+							   cv::Mat* a_regions)
+{
+	int width = max(1, a_params.width);
+	int height = max(1, a_params.height);
+	uint nbRegions = max(1u, min(a_params.nb_regions, (uint)(width * height)));
+
+	SyntheticRng rng(a_params.seed);
+
+	//-------------------------------------------------------------------------
+	// Partition the image
+	//-------------------------------------------------------------------------
+	// Areas and negated indices of the regions in a max-heap, so that the
+	// first region wins ties. A region only gets smaller, so the entries of
+	// its previous areas are skipped when they reach the top.
+	typedef pair<int, int> AreaEntry;
+	priority_queue<AreaEntry> largestRegions;
+	vector<cv::Rect> regions(1, cv::Rect(0, 0, width, height));
+	largestRegions.push({ regions[0].area(), 0 });
+	while (regions.size() < nbRegions)
+	{
+		while (largestRegions.top().first !=
+			   regions[-largestRegions.top().second].area())
+		{
+			largestRegions.pop();
+		}
+		size_t largest = -largestRegions.top().second;
+
+		// Single pixels can't be split, the largest region always can
+		size_t r = largest;
+		if (rng.Uniform() < a_params.size_skew)
+		{
+			size_t pick = rng.UniformInt(0, (int)regions.size() - 1);
+			if (regions[pick].area() > 1) r = pick;
+		}
+
+		// Split across the longer side, around the middle
+		cv::Rect region = regions[r];
+		cv::Rect split = region;
+		if (region.width >= region.height)
+		{
+			int w = (int)(region.width * (0.25 + 0.5 * rng.Uniform()));
+			region.width = max(1, min(region.width - 1, w));
+			split.x += region.width;
+			split.width -= region.width;
+		}
+		else
+		{
+			int h = (int)(region.height * (0.25 + 0.5 * rng.Uniform()));
+			region.height = max(1, min(region.height - 1, h));
+			split.y += region.height;
+			split.height -= region.height;
+		}
+		regions[r] = region;
+		regions.push_back(split);
+		largestRegions.push({ region.area(), -(int)r });
+		largestRegions.push({ split.area(), -(int)(regions.size() - 1) });
+	}
+
+	//-------------------------------------------------------------------------
+	// Fill the regions with their gray level and gradient
+	//-------------------------------------------------------------------------
+	vector<float> pixels(width * height);
+	cv::Mat regionIds;
+	if (a_regions) regionIds.create(height, width, CV_32S);
+
+	for (size_t r = 0; r < regions.size(); ++r)
+	{
+		const cv::Rect& region = regions[r];
+		float gray = (float)rng.UniformInt(0, 255);
+		double dirX, dirY;
+		rng.Direction(dirX, dirY);
+
+		// Gray level step per pixel, so that the level changes by the
+		// gradient from one side of the region to the other
+		float dx = (float)(a_params.gradient * dirX / region.width);
+		float dy = (float)(a_params.gradient * dirY / region.height);
+		float cx = region.x + (region.width - 1) * 0.5f;
+		float cy = region.y + (region.height - 1) * 0.5f;
+
+		for (int y = region.y; y < region.y + region.height; ++y)
+		for (int x = region.x; x < region.x + region.width; ++x)
+		{
+			pixels[y * width + x] = gray + (x - cx) * dx + (y - cy) * dy;
+			if (a_regions) regionIds.at<int>(y, x) = (int)r;
+		}
+	}
+
+	//-------------------------------------------------------------------------
+	// Add the noise
+	//-------------------------------------------------------------------------
+	cv::Mat img(height, width, CV_8U);
+	for (int y = 0; y < height; ++y)
+	for (int x = 0; x < width; ++x)
+	{
+		float val = pixels[y * width + x];
+		if (a_params.noise > 0) val += (float)(a_params.noise * rng.Normal());
+
+		img.at<uchar>(y, x) = (uchar)min(255.0f, max(0.0f, floor(val + 0.5f)));
+	}
+
+	if (a_regions) *a_regions = regionIds;
+	return img;
+}
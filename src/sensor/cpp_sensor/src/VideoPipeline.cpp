@@ -0,0 +1,317 @@
+/** @file VideoPipeline.cpp
+*
+*
+*  @author Vincent de Ladurantaye
+*/
+
+#include "VideoPipeline.h"
+#include "LayerTracer.h"
+
+#include <chrono>
+#include <iostream>
+#include <thread>
+using namespace std;
+
+typedef chrono::steady_clock Clock;
+
+//-----------------------------------------------------------------------------
+static long long ElapsedNs(Clock::time_point a_start)
+{
+	return chrono::duration_cast<chrono::nanoseconds>(
+		Clock::now() - a_start).count();
+}
+
+//=============================================================================
+//								 VideoPipeline
+//=============================================================================
+VideoPipeline::VideoPipeline() :
+	output_fps_(30.0),
+	next_segment_(0),
+	stats_(),
+	NB_WORKERS(Config::VIDEO_NB_WORKERS),
+	QUEUE_SIZE(max(1u, Config::VIDEO_QUEUE_SIZE))
+{
+	if (NB_WORKERS == 0) NB_WORKERS = thread::hardware_concurrency();
+	if (NB_WORKERS == 0) NB_WORKERS = 1;
+}
+
+//=============================================================================
+void VideoPipeline::SetVideoSource(const string& a_video_file)
+{
+	video_capture_.open(a_video_file);
+
+	if (!video_capture_.isOpened())
+	{
+		cout << "Error opening video" << endl;
+		exit(-1);
+	}
+
+	frame_source_ = [this](cv::Mat& a_frame)
+	{
+		// Reading in the same buffer reuses its memory
+		return video_capture_.read(a_frame) && !a_frame.empty();
+	};
+}
+
+//=============================================================================
+void VideoPipeline::SetFrameSource(FrameSource a_source)
+{
+	frame_source_ = a_source;
+}
+
+//=============================================================================
+void VideoPipeline::SetOutputCallback(OutputCallback a_callback)
+{
+	output_callback_ = a_callback;
+}
+
+//=============================================================================
+void VideoPipeline::SetOutputFile(const string& a_video_file, double a_fps)
+{
+	output_file_ = a_video_file;
+	output_fps_ = a_fps;
+}
+
+//=============================================================================
+VideoPipelineStats VideoPipeline::Run()
+{
+	stats_ = VideoPipelineStats();
+
+	if (!frame_source_)
+	{
+		cerr << "VideoPipeline: no frame source set" << endl;
+		return stats_;
+	}
+
+	// Enough buffers to fill both queues while each worker holds a frame
+	uint nbBuffers = 2 * QUEUE_SIZE + NB_WORKERS;
+	frame_buffers_.assign(nbBuffers, cv::Mat());
+	label_buffers_.assign(nbBuffers, cv::Mat());
+	free_buffers_.reset(new BlockingRingBuffer<uint>(nbBuffers));
+	for (uint i = 0; i < nbBuffers; ++i)
+	{
+		free_buffers_->TryPush(i);
+	}
+
+	decoded_queue_.reset(new BlockingRingBuffer<FrameJob>(QUEUE_SIZE));
+	segmented_queue_.reset(new BlockingRingBuffer<FrameJob>(QUEUE_SIZE));
+
+	// The stream starts over
+	segmenter_.Reset();
+	next_segment_ = 0;
+
+	n_running_workers_ = NB_WORKERS;
+	n_decoded_ = 0;
+	n_segmented_ = 0;
+	n_written_ = 0;
+	decode_blocked_ns_ = 0;
+	segment_blocked_ns_ = 0;
+	segment_idle_ns_ = 0;
+	write_idle_ns_ = 0;
+	decoded_queue_max_ = 0;
+	segmented_queue_max_ = 0;
+
+	auto start = Clock::now();
+
+	thread decoder(&VideoPipeline::DecodeStage, this);
+	vector<thread> workers;
+	for (uint w = 0; w < NB_WORKERS; ++w)
+	{
+		workers.push_back(thread(&VideoPipeline::SegmentStage, this));
+	}
+	thread writer(&VideoPipeline::WriteStage, this);
+
+	decoder.join();
+	for (auto& worker : workers)
+	{
+		worker.join();
+	}
+	writer.join();
+
+	if (video_writer_.isOpened()) video_writer_.release();
+
+	stats_.frames_decoded = n_decoded_;
+	stats_.frames_segmented = n_segmented_;
+	stats_.frames_written = n_written_;
+	stats_.time_ms = ElapsedNs(start) / 1e6;
+	stats_.throughput_fps = stats_.time_ms > 0 ?
+		1000.0 * stats_.frames_written / stats_.time_ms : 0.0;
+	stats_.decode_blocked_ms = decode_blocked_ns_ / 1e6;
+	stats_.segment_blocked_ms = segment_blocked_ns_ / 1e6;
+	stats_.segment_idle_ms = segment_idle_ns_ / 1e6;
+	stats_.write_idle_ms = write_idle_ns_ / 1e6;
+	stats_.decoded_queue_max = decoded_queue_max_;
+	stats_.segmented_queue_max = segmented_queue_max_;
+
+	return stats_;
+}
+
+//=============================================================================
+//								Protected
+//=============================================================================
+void VideoPipeline::DecodeStage()
+{
+	for (uint index = 0; ; ++index)
+	{
+		// Wait for a buffer to be recycled by the output stage
+		FrameJob job;
+		job.index = index;
+		auto waitStart = Clock::now();
+		free_buffers_->Pop(job.buffer_id);
+		decode_blocked_ns_ += ElapsedNs(waitStart);
+
+		if (!frame_source_(frame_buffers_[job.buffer_id]))
+		{
+			free_buffers_->Push(job.buffer_id);
+			break;
+		}
+		++n_decoded_;
+
+		// Wait for room in the queue if the workers are late
+		waitStart = Clock::now();
+		decoded_queue_->Push(job);
+		decode_blocked_ns_ += ElapsedNs(waitStart);
+		UpdateMax(decoded_queue_max_, decoded_queue_->GetSize());
+	}
+
+	decoded_queue_->Close();
+}
+
+//=============================================================================
+void VideoPipeline::SegmentStage()
+{
+	LayerTracer::SetThreadName("Video segmenter");
+
+	// Segmenter of the independent frames, with the parameters of the 
+	// segmenter of the stream
+	VideoSegmenter segmenter;
+	segmenter.WARM_START_DELTA = segmenter_.WARM_START_DELTA;
+	segmenter.PARTIAL_RESEGMENTATION = segmenter_.PARTIAL_RESEGMENTATION;
+	bool ordered = IsStreamOrdered();
+
+	for (;;)
+	{
+		// Wait for a frame, until the decoder is done
+		FrameJob job;
+		auto waitStart = Clock::now();
+		bool hasJob = decoded_queue_->Pop(job);
+		segment_idle_ns_ += ElapsedNs(waitStart);
+
+		if (!hasJob) break;
+
+		ImageData frameData(frame_buffers_[job.buffer_id]);
+		cv::Mat& labels = label_buffers_[job.buffer_id];
+
+		if (ordered)
+		{
+			// Wait for the previous frame of the stream to be segmented
+			waitStart = Clock::now();
+			unique_lock<mutex> lock(segment_mutex_);
+			segment_turn_.wait(lock, [&]()
+			{
+				return next_segment_ == job.index;
+			});
+			segment_idle_ns_ += ElapsedNs(waitStart);
+
+			segmenter_.SegmentFrame(frameData);
+			segmenter_.GetLayer()->GetLabels(labels);
+			++next_segment_;
+			lock.unlock();
+			segment_turn_.notify_all();
+		}
+		else
+		{
+			segmenter.Reset();
+			segmenter.SegmentFrame(frameData);
+			segmenter.GetLayer()->GetLabels(labels);
+		}
+		++n_segmented_;
+
+		// Wait for room in the queue if the output is late
+		waitStart = Clock::now();
+		segmented_queue_->Push(job);
+		segment_blocked_ns_ += ElapsedNs(waitStart);
+		UpdateMax(segmented_queue_max_, segmented_queue_->GetSize());
+	}
+
+	if (--n_running_workers_ == 0) segmented_queue_->Close();
+}
+
+//=============================================================================
+bool VideoPipeline::IsStreamOrdered() const
+{
+	return segmenter_.WARM_START_DELTA >= 0 ||
+		segmenter_.PARTIAL_RESEGMENTATION;
+}
+
+//=============================================================================
+void VideoPipeline::WriteStage()
+{
+	// Frames segmented ahead of the next frame to write
+	map<uint, FrameJob> pending;
+	uint nextIndex = 0;
+
+	for (;;)
+	{
+		// Wait for a frame, until the workers are done
+		FrameJob job;
+		auto waitStart = Clock::now();
+		bool hasJob = segmented_queue_->Pop(job);
+		write_idle_ns_ += ElapsedNs(waitStart);
+
+		if (!hasJob) break;
+
+		pending[job.index] = job;
+
+		// Write the frames that are next in order
+		for (auto it = pending.begin();
+			 it != pending.end() && it->first == nextIndex;
+			 it = pending.erase(it), ++nextIndex)
+		{
+			uint bufferId = it->second.buffer_id;
+			const cv::Mat& image = frame_buffers_[bufferId];
+			const cv::Mat& labels = label_buffers_[bufferId];
+
+			if (output_callback_) output_callback_(it->first, image, labels);
+			if (!output_file_.empty()) WriteLabels(labels);
+
+			free_buffers_->Push(bufferId);
+			++n_written_;
+		}
+	}
+}
+
+//=============================================================================
+void VideoPipeline::WriteLabels(const cv::Mat& a_labels)
+{
+	if (!video_writer_.isOpened())
+	{
+		video_writer_.open(output_file_,
+						   cv::VideoWriter::fourcc('M', 'J', 'P', 'G'),
+						   output_fps_, a_labels.size(), true);
+	}
+
+	// Same false colors as the layer monitors
+	display_.create(a_labels.rows, a_labels.cols, CV_8UC3);
+	for (int y = 0; y < a_labels.rows; ++y)
+	{
+		const int* labels = a_labels.ptr<int>(y);
+		cv::Vec3b* disp = display_.ptr<cv::Vec3b>(y);
+		for (int x = 0; x < a_labels.cols; ++x)
+		{
+			disp[x] = renderer_.GetColor(labels[x]);
+		}
+	}
+
+	video_writer_.write(display_);
+}
+
+//=============================================================================
+void VideoPipeline::UpdateMax(atomic<uint>& a_max, size_t a_size)
+{
+	uint current = a_max;
+	while (a_size > current &&
+		   !a_max.compare_exchange_weak(current, (uint)a_size))
+	{
+	}
+}
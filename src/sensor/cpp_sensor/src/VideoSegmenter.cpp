@@ -0,0 +1,144 @@
+/** @file VideoSegmenter.cpp
+*
+*
+*  @author Vincent de Ladurantaye
+*/
+
+#include "VideoSegmenter.h"
+#include "SegmentationLayerT.h"
+
+#include <chrono>
+using namespace std;
+
+//=============================================================================
+//								VideoSegmenter
+//=============================================================================
+VideoSegmenter::VideoSegmenter() :
+	frame_segmented_(false),
+	frame_stats_(),
+	n_frames_(0),
+	from_scratch_(false),
+	max_seg_cascades_(0),
+	WARM_START_DELTA(Config::SEG_WARM_START_DELTA),
+	PARTIAL_RESEGMENTATION(Config::SEG_PARTIAL_RESEGMENTATION),
+	CHANGE_TILE_SIZE(Config::SEG_CHANGE_TILE_SIZE),
+	CHANGE_MARGIN(Config::SEG_CHANGE_MARGIN)
+{
+}
+
+//=============================================================================
+void VideoSegmenter::SetVideoSource(const string& a_video_file)
+{
+	// Opening the video reads its first frame
+	video_data_.SetVideoSource(a_video_file);
+	frame_segmented_ = false;
+}
+
+//=============================================================================
+bool VideoSegmenter::SegmentNextFrame()
+{
+	if (frame_segmented_ && !video_data_.NextFrame()) return false;
+
+	SegmentFrame(video_data_);
+	frame_segmented_ = true;
+	return true;
+}
+
+//=============================================================================
+void VideoSegmenter::SegmentFrame(const cv::Mat& a_frame)
+{
+	ImageData frameData(a_frame);
+	SegmentFrame(frameData, nullptr);
+}
+//-----------------------------------------------------------------------------
+void VideoSegmenter::SegmentFrame(ImageData& a_frame_data)
+{
+	SegmentFrame(a_frame_data, nullptr);
+}
+//-----------------------------------------------------------------------------
+void VideoSegmenter::SegmentFrame(const cv::Mat& a_frame,
+								  const vector<cv::Rect>& a_dirty_rects)
+{
+	ImageData frameData(a_frame);
+	SegmentFrame(frameData, &a_dirty_rects);
+}
+
+//=============================================================================
+//								Protected
+//=============================================================================
+void VideoSegmenter::SegmentFrame(ImageData& a_frame_data,
+								  const vector<cv::Rect>* a_dirty_rects)
+{
+	auto start = chrono::steady_clock::now();
+
+	const cv::Mat& gray = a_frame_data.gray_image_;
+	uint warmNeurons = 0;
+	if (layer_ && (int)layer_->width == gray.cols &&
+		(int)layer_->height == gray.rows)
+	{
+		// The layer of the previous frame is reused. The active regions must
+		// be set first so that the neurons outside of them keep their state.
+		if (from_scratch_)
+		{
+			layer_->ClearActiveRegions();
+		}
+		else if (a_dirty_rects)
+		{
+			vector<cv::Rect> regions;
+			for (auto& rect : *a_dirty_rects)
+			{
+				regions.push_back(cv::Rect(rect.x - CHANGE_MARGIN,
+					rect.y - CHANGE_MARGIN, rect.width + 2 * CHANGE_MARGIN,
+					rect.height + 2 * CHANGE_MARGIN));
+			}
+			layer_->SetActiveRegions(regions);
+		}
+		else if (PARTIAL_RESEGMENTATION)
+		{
+			layer_->SetActiveRegions(layer_->FindChangedTiles(gray,
+				WARM_START_DELTA, CHANGE_TILE_SIZE, CHANGE_MARGIN));
+		}
+		else
+		{
+			layer_->ClearActiveRegions();
+		}
+
+		warmNeurons = layer_->LoadFrame(a_frame_data,
+										from_scratch_ ? -1 : WARM_START_DELTA);
+	}
+	else
+	{
+		// The layer shares the pixels of the image data, which the caller or
+		// the video capture may reuse for the next frame. Give it its own 
+		// copy so that the next frame is compared with the right pixels.
+		ImageData frameData(a_frame_data);
+		frameData.gray_image_ = gray.clone();
+
+		layer_ = CreatePixelLayer(frameData);
+		max_seg_cascades_ = layer_->MAX_SEG_CASCADES;
+	}
+	from_scratch_ = false;
+
+	// The cascade counter continues from the previous frame
+	uint startCascade = layer_->GetNbCascades();
+	if (max_seg_cascades_ > 0)
+		layer_->MAX_SEG_CASCADES = max_seg_cascades_ + startCascade;
+
+	layer_->SegmentLayer();
+
+	frame_stats_.frame = n_frames_++;
+	frame_stats_.warm_neurons = warmNeurons;
+	frame_stats_.active_neurons = layer_->GetNbActiveNeurons();
+	frame_stats_.cycles = layer_->GetNbCycles();
+	frame_stats_.cascades = layer_->GetNbCascades() - startCascade;
+	frame_stats_.spikes = layer_->GetNbSpikes();
+	frame_stats_.time_ms = chrono::duration<double, milli>(
+		chrono::steady_clock::now() - start).count();
+}
+
+//=============================================================================
+void VideoSegmenter::Reset()
+{
+	// The layer is kept for the next frame, which reloads all its neurons
+	if (layer_) from_scratch_ = true;
+}
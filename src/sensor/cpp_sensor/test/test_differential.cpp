@@ -0,0 +1,564 @@
+/** @file test_differential.cpp
+*
+* Differential tests: the alternative implementations of the pixel layer
+* (specialized and fixed size layers, weight planes, single tile layout,
+* deadline) must reproduce the reference PixelLayer cascade by cascade, over
+* random configs and synthetic images. The variants which change the order
+* of the spikes (tiled layout, coarsening of the stable segments, packed
+* layers, warm start) must reach nearly the same partitions.
+*
+* @authors Vincent de Ladurantaye
+*/
+#include "test_differential.h"
+#include "PackedPixelLayer.h"
+#include "SegmentationLayerT.h"
+#include "SyntheticImage.h"
+
+#include <cmath>
+#include <random>
+#include <sstream>
+using namespace::std;
+
+
+//=============================================================================
+//								LayerDivergence
+//=============================================================================
+string LayerDivergence::ToString() const
+{
+	if (!diverged) return "No divergence";
+
+	ostringstream str;
+	str << "Diverged after " << cascade << " cascades on ";
+	if (neuron.x >= 0)
+		str << "neuron (" << neuron.x << ", " << neuron.y << ") ";
+	str << field << ": reference " << ref_value << ", alternative "
+		<< alt_value;
+	return str.str();
+}
+
+//=============================================================================
+//								LayerDiffRunner
+//=============================================================================
+LayerDiffRunner::LayerDiffRunner(SegmentationLayer& a_ref,
+								 SegmentationLayer& a_alt,
+								 float a_pot_tolerance) :
+	ref_(a_ref),
+	alt_(a_alt),
+	pot_tolerance_(a_pot_tolerance),
+	nb_cascades_(0)
+{
+}
+
+//=============================================================================
+LayerDivergence LayerDiffRunner::Run(uint a_max_cascades)
+{
+	nb_cascades_ = 0;
+
+	LayerDivergence divergence = Compare();
+	while (!divergence.diverged && nb_cascades_ < a_max_cascades)
+	{
+		bool refRunning = ref_.Step();
+		bool altRunning = alt_.Step();
+
+		// The last steps only complete the state of the layers
+		divergence = Compare();
+		if (!refRunning && !altRunning) break;
+
+		++nb_cascades_;
+	}
+
+	return divergence;
+}
+
+//=============================================================================
+LayerDivergence LayerDiffRunner::Compare()
+{
+	LayerDivergence divergence;
+	divergence.cascade = ref_.GetNbCascades();
+
+	if (ref_.width != alt_.width || ref_.height != alt_.height)
+	{
+		divergence.diverged = true;
+		divergence.field = "size";
+		divergence.ref_value = ref_.size;
+		divergence.alt_value = alt_.size;
+		return divergence;
+	}
+
+	// Neurons in row-major order, so the first divergence is the same
+	// whatever the layouts
+	for (uint y = 0; y < ref_.height; ++y)
+	for (uint x = 0; x < ref_.width; ++x)
+	{
+		const Neuron& refNeuron = ref_.neurons[ref_.GetNeuronId(x, y)];
+		const Neuron& altNeuron = alt_.neurons[alt_.GetNeuronId(x, y)];
+
+		divergence.neuron = cv::Point(x, y);
+		if (!IsSameLabel(refNeuron.label, altNeuron.label))
+		{
+			auto altToRef = alt_to_ref_.find(altNeuron.label);
+			divergence.diverged = true;
+			divergence.field = "label";
+			divergence.ref_value = refNeuron.label;
+			divergence.alt_value = altToRef != alt_to_ref_.end() ?
+				altToRef->second : altNeuron.label;
+			return divergence;
+		}
+		if (refNeuron.phase != altNeuron.phase)
+		{
+			divergence.diverged = true;
+			divergence.field = "phase";
+			divergence.ref_value = refNeuron.phase;
+			divergence.alt_value = altNeuron.phase;
+			return divergence;
+		}
+		if (!(fabs(refNeuron.pot - altNeuron.pot) <= pot_tolerance_))
+		{
+			divergence.diverged = true;
+			divergence.field = "pot";
+			divergence.ref_value = refNeuron.pot;
+			divergence.alt_value = altNeuron.pot;
+			return divergence;
+		}
+	}
+	divergence.neuron = cv::Point(-1, -1);
+
+	// Counters of the layers
+	const char* fields[] = { "cascades", "cycles", "spikes", "done" };
+	double refValues[] = { (double)ref_.GetNbCascades(),
+						   (double)ref_.GetNbCycles(),
+						   (double)ref_.GetNbSpikes(),
+						   (double)ref_.IsSegmentationDone() };
+	double altValues[] = { (double)alt_.GetNbCascades(),
+						   (double)alt_.GetNbCycles(),
+						   (double)alt_.GetNbSpikes(),
+						   (double)alt_.IsSegmentationDone() };
+	for (int f = 0; f < 4; ++f)
+	{
+		if (refValues[f] != altValues[f])
+		{
+			divergence.diverged = true;
+			divergence.field = fields[f];
+			divergence.ref_value = refValues[f];
+			divergence.alt_value = altValues[f];
+			return divergence;
+		}
+	}
+
+	return divergence;
+}
+
+//=============================================================================
+LayerDivergence LayerDiffRunner::ComparePartitions(const cv::Mat& a_ref_labels,
+												   const cv::Mat& a_alt_labels)
+{
+	LayerDivergence divergence;
+
+	if (a_ref_labels.rows != a_alt_labels.rows ||
+		a_ref_labels.cols != a_alt_labels.cols)
+	{
+		divergence.diverged = true;
+		divergence.field = "size";
+		divergence.ref_value = a_ref_labels.total();
+		divergence.alt_value = a_alt_labels.total();
+		return divergence;
+	}
+
+	unordered_map<int, int> refToAlt;
+	unordered_map<int, int> altToRef;
+	for (int y = 0; y < a_ref_labels.rows; ++y)
+	for (int x = 0; x < a_ref_labels.cols; ++x)
+	{
+		int refLabel = a_ref_labels.at<int>(y, x);
+		int altLabel = a_alt_labels.at<int>(y, x);
+		if (IsSameLabel(refLabel, altLabel, refToAlt, altToRef)) continue;
+
+		auto altRef = altToRef.find(altLabel);
+		divergence.diverged = true;
+		divergence.neuron = cv::Point(x, y);
+		divergence.field = "label";
+		divergence.ref_value = refLabel;
+		divergence.alt_value = altRef != altToRef.end() ? 
+			altRef->second : altLabel;
+		return divergence;
+	}
+
+	return divergence;
+}
+
+//=============================================================================
+float LayerDiffRunner::GetPartitionAgreement(const cv::Mat& a_ref_labels,
+											 const cv::Mat& a_alt_labels)
+{
+	if (a_ref_labels.rows != a_alt_labels.rows ||
+		a_ref_labels.cols != a_alt_labels.cols)
+		return 0.0f;
+
+	// Pairs of each pixel with its right and bottom neighbours
+	uint nbPairs = 0;
+	uint nbAgreeing = 0;
+	const int offsets[2][2] = { { 1, 0 }, { 0, 1 } };
+	for (int y = 0; y < a_ref_labels.rows; ++y)
+	for (int x = 0; x < a_ref_labels.cols; ++x)
+	for (const int* offset : offsets)
+	{
+		int nx = x + offset[0];
+		int ny = y + offset[1];
+		if (nx >= a_ref_labels.cols || ny >= a_ref_labels.rows) continue;
+
+		bool refJoined = 
+			a_ref_labels.at<int>(y, x) == a_ref_labels.at<int>(ny, nx);
+		bool altJoined = 
+			a_alt_labels.at<int>(y, x) == a_alt_labels.at<int>(ny, nx);
+		++nbPairs;
+		if (refJoined == altJoined) ++nbAgreeing;
+	}
+
+	return nbPairs > 0 ? (float)nbAgreeing / nbPairs : 1.0f;
+}
+
+//=============================================================================
+bool LayerDiffRunner::IsSameLabel(int a_ref_label, int a_alt_label)
+{
+	return IsSameLabel(a_ref_label, a_alt_label, ref_to_alt_, alt_to_ref_);
+}
+//-----------------------------------------------------------------------------
+bool LayerDiffRunner::IsSameLabel(int a_ref_label, int a_alt_label,
+								  unordered_map<int, int>& a_ref_to_alt,
+								  unordered_map<int, int>& a_alt_to_ref)
+{
+	auto refToAlt = a_ref_to_alt.find(a_ref_label);
+	auto altToRef = a_alt_to_ref.find(a_alt_label);
+
+	if (refToAlt == a_ref_to_alt.end() && altToRef == a_alt_to_ref.end())
+	{
+		a_ref_to_alt[a_ref_label] = a_alt_label;
+		a_alt_to_ref[a_alt_label] = a_ref_label;
+		return true;
+	}
+
+	return refToAlt != a_ref_to_alt.end() && refToAlt->second == a_alt_label;
+}
+
+//=============================================================================
+//							  TestOdlmPixelDiff
+//=============================================================================
+void TestOdlmPixelDiff::SetUp()
+{
+	Config::LoadConfigFile("SensorPixel.ini");
+
+	trigger_same_label_ = Config::SEG_TRIGGER_SAME_LABEL_NEURONS;
+	merge_segments_ = Config::SEG_MERGE_SEGMENTS;
+	weight_planes_ = Config::SEG_WEIGHT_PLANES;
+	neuron_layout_ = Config::SIM_NEURON_LAYOUT;
+	tile_size_ = Config::SIM_LAYOUT_TILE_SIZE;
+	fixed_size_ = Config::FIXED_INPUT_IMGS_SIZE;
+	max_cycles_ = Config::SEG_MAX_CYCLES;
+	coarsen_segments_ = Config::SEG_COARSEN_SEGMENTS;
+}
+
+//=============================================================================
+void TestOdlmPixelDiff::TearDown()
+{
+	Config::SEG_TRIGGER_SAME_LABEL_NEURONS = trigger_same_label_;
+	Config::SEG_MERGE_SEGMENTS = merge_segments_;
+	Config::SEG_WEIGHT_PLANES = weight_planes_;
+	Config::SIM_NEURON_LAYOUT = neuron_layout_;
+	Config::SIM_LAYOUT_TILE_SIZE = tile_size_;
+	Config::FIXED_INPUT_IMGS_SIZE = fixed_size_;
+	Config::SEG_MAX_CYCLES = max_cycles_;
+	Config::SEG_COARSEN_SEGMENTS = coarsen_segments_;
+}
+
+//=============================================================================
+//									TESTS
+//=============================================================================
+TEST_F(TestOdlmPixelDiff, RandomConfigs)
+{
+	const uint nbTrials = 12;
+	for (uint trial = 0; trial < nbTrials; ++trial)
+	{
+		mt19937 rng(trial);
+
+		// Random image, a third of them of the sizes of the fixed size layers
+		SyntheticImageParams params;
+		bool fixedSize = rng() % 3 == 0;
+		if (fixedSize)
+		{
+			params.width = rng() % 2 == 0 ? 64 : 48;
+			params.height = 128;
+		}
+		else
+		{
+			params.width = 24 + rng() % 73;
+			params.height = 24 + rng() % 73;
+		}
+		params.nb_regions = 1 + rng() % 64;
+		params.size_skew = (rng() % 101) / 100.0f;
+		params.noise = (float)(rng() % 9);
+		params.gradient = (float)(rng() % 33);
+		params.seed = rng();
+		ImageData imgData(GenerateSyntheticImage(params));
+
+		// Random simulation flags, the reference being the generic layer
+		Config::SEG_TRIGGER_SAME_LABEL_NEURONS = rng() % 2 != 0;
+		Config::SEG_MERGE_SEGMENTS = rng() % 2 != 0;
+		Config::SEG_MAX_CYCLES = 3 + rng() % 5;
+		Config::SEG_WEIGHT_PLANES = 0;
+		Config::SIM_NEURON_LAYOUT = LAYOUT_ROW_MAJOR;
+		Config::FIXED_INPUT_IMGS_SIZE = false;
+		PixelLayer reference(imgData, false);
+
+		// Random optimizations of the alternative layer, which must not
+		// change the results. The tiled layout only gives the same results
+		// with a single tile.
+		Config::SEG_WEIGHT_PLANES = rng() % 3;
+		Config::FIXED_INPUT_IMGS_SIZE = rng() % 2 != 0;
+		if (rng() % 2 != 0)
+		{
+			Config::SIM_NEURON_LAYOUT = LAYOUT_TILED;
+			Config::SIM_LAYOUT_TILE_SIZE = 128;
+		}
+		unique_ptr<PixelLayer> alternative = CreatePixelLayer(imgData, false);
+
+		LayerDiffRunner runner(reference, *alternative);
+		LayerDivergence divergence = runner.Run();
+
+		EXPECT_FALSE(divergence.diverged)
+			<< "Trial " << trial << ", " << params.width << "x"
+			<< params.height << " image, trigger "
+			<< Config::SEG_TRIGGER_SAME_LABEL_NEURONS << ", merge "
+			<< Config::SEG_MERGE_SEGMENTS << ", weight planes "
+			<< Config::SEG_WEIGHT_PLANES << ", fixed size "
+			<< Config::FIXED_INPUT_IMGS_SIZE << ", layout "
+			<< Config::SIM_NEURON_LAYOUT << ": " << divergence.ToString();
+		EXPECT_TRUE(reference.IsSegmentationDone());
+		EXPECT_GT(runner.GetNbCascadesCompared(), 0u);
+	}
+}
+
+//=============================================================================
+TEST_F(TestOdlmPixelDiff, FirstDivergence)
+{
+	ImageData carData("carGray.bmp");
+	ImageData imgData(carData.gray_image_(cv::Rect(100, 0, 60, 50)));
+
+	// Identical layers, except for the potential of one neuron
+	PixelLayer reference(imgData, false);
+	PixelLayer alternative(imgData, false);
+	alternative.neurons[alternative.GetNeuronId(5, 7)].pot += 0.01f;
+
+	LayerDiffRunner runner(reference, alternative);
+	LayerDivergence divergence = runner.Run();
+	ASSERT_TRUE(divergence.diverged);
+	EXPECT_EQ(0u, divergence.cascade);
+	EXPECT_EQ(cv::Point(5, 7), divergence.neuron);
+	EXPECT_EQ("pot", divergence.field);
+	EXPECT_NE(string::npos, divergence.ToString().find("(5, 7) pot"));
+
+	// Tolerated until the difference changes the firing of the neurons
+	PixelLayer tolerantAlt(imgData, false);
+	tolerantAlt.neurons[tolerantAlt.GetNeuronId(5, 7)].pot += 0.01f;
+	PixelLayer tolerantRef(imgData, false);
+	LayerDiffRunner tolerantRunner(tolerantRef, tolerantAlt, 0.02f);
+	EXPECT_FALSE(tolerantRunner.Compare().diverged);
+
+	// A segment must stay the same segment in both layers
+	PixelLayer labelRef(imgData, false);
+	PixelLayer labelAlt(imgData, false);
+	LayerDiffRunner labelRunner(labelRef, labelAlt);
+	EXPECT_FALSE(labelRunner.Compare().diverged);
+	labelAlt.neurons[labelAlt.GetNeuronId(3, 3)].label =
+		labelAlt.neurons[labelAlt.GetNeuronId(4, 3)].label;
+	divergence = labelRunner.Compare();
+	ASSERT_TRUE(divergence.diverged);
+	EXPECT_EQ("label", divergence.field);
+	EXPECT_EQ(cv::Point(3, 3), divergence.neuron);
+
+	// The partitions are compared whatever the labels
+	cv::Mat refLabels = labelRef.GetLabels();
+	cv::Mat altLabels = refLabels.clone();
+	for (int y = 0; y < altLabels.rows; ++y)
+	for (int x = 0; x < altLabels.cols; ++x)
+	{
+		altLabels.at<int>(y, x) += 1000;
+	}
+	EXPECT_FALSE(LayerDiffRunner::ComparePartitions(refLabels, altLabels)
+		.diverged);
+	EXPECT_EQ(1.0f, 
+			  LayerDiffRunner::GetPartitionAgreement(refLabels, altLabels));
+	altLabels.at<int>(3, 4) = altLabels.at<int>(3, 3);
+	divergence = LayerDiffRunner::ComparePartitions(refLabels, altLabels);
+	ASSERT_TRUE(divergence.diverged);
+	EXPECT_EQ(cv::Point(4, 3), divergence.neuron);
+	EXPECT_LT(LayerDiffRunner::GetPartitionAgreement(refLabels, altLabels),
+			  1.0f);
+}
+
+//=============================================================================
+TEST_F(TestOdlmPixelDiff, FixedSizes)
+{
+	// Both fixed size layers, with all the segmentation flags
+	for (uint width : { 64u, 48u })
+	for (uint flags = 0; flags < 4; ++flags)
+	{
+		SyntheticImageParams params;
+		params.width = width;
+		params.height = 128;
+		params.nb_regions = 12;
+		params.noise = 4.0f;
+		params.seed = width + flags;
+		ImageData imgData(GenerateSyntheticImage(params));
+
+		Config::SEG_TRIGGER_SAME_LABEL_NEURONS = (flags & 1) != 0;
+		Config::SEG_MERGE_SEGMENTS = (flags & 2) != 0;
+		Config::FIXED_INPUT_IMGS_SIZE = false;
+		PixelLayer reference(imgData, false);
+		Config::FIXED_INPUT_IMGS_SIZE = true;
+		unique_ptr<PixelLayer> fixed = CreatePixelLayer(imgData, false);
+		ASSERT_EQ(PIXEL_LAYER_FIXED_SIZE, fixed->GetLayerClass());
+
+		LayerDiffRunner runner(reference, *fixed);
+		LayerDivergence divergence = runner.Run();
+		EXPECT_FALSE(divergence.diverged)
+			<< width << "x128, flags " << flags << ": " 
+			<< divergence.ToString();
+	}
+}
+
+//=============================================================================
+TEST_F(TestOdlmPixelDiff, Deadline)
+{
+	ImageData carData("carGray.bmp");
+	ImageData imgData(carData.gray_image_(cv::Rect(100, 0, 60, 50)));
+
+	// Without deadline, the segmentation is the reference one
+	PixelLayer reference(imgData, false);
+	reference.SegmentLayer();
+	PixelLayer unlimited(imgData, false);
+	SegmentationResult result = unlimited.SegmentWithDeadline(0);
+	EXPECT_EQ(reference.GetNbCascades(), result.cascades);
+	LayerDivergence divergence = 
+		LayerDiffRunner::ComparePartitions(reference.GetLabels(), 
+										   result.labels);
+	EXPECT_FALSE(divergence.diverged) << divergence.ToString();
+
+	// Stopped by the deadline, the layer is the reference one after as many
+	// cascades, except that its segmentation is done
+	PixelLayer stopped(imgData, false);
+	result = stopped.SegmentWithDeadline(0.5);
+	ASSERT_TRUE(result.deadline_reached);
+	PixelLayer partial(imgData, false);
+	while (partial.GetNbCascades() < result.cascades && partial.Step()) {}
+	LayerDiffRunner runner(partial, stopped);
+	divergence = runner.Compare();
+	EXPECT_TRUE(!divergence.diverged || divergence.field == "done")
+		<< divergence.ToString();
+}
+
+//=============================================================================
+TEST_F(TestOdlmPixelDiff, TiledPartitions)
+{
+	ImageData carData("carGray.bmp");
+
+	Config::SIM_NEURON_LAYOUT = LAYOUT_ROW_MAJOR;
+	PixelLayer reference(carData, false);
+	reference.SegmentLayer();
+	cv::Mat refLabels = reference.GetLabels();
+
+	// Tiles change the order of the spikes within the waves, so the labels
+	// reached by the neurons at the boundaries of the segments may differ,
+	// but the partitions must be nearly the same
+	Config::SIM_NEURON_LAYOUT = LAYOUT_TILED;
+	for (uint tileSize : { 16u, 32u, 64u })
+	{
+		Config::SIM_LAYOUT_TILE_SIZE = tileSize;
+		PixelLayer tiled(carData, false);
+		tiled.SegmentLayer();
+		EXPECT_TRUE(tiled.IsSegmentationDone());
+		EXPECT_GT(LayerDiffRunner::GetPartitionAgreement(refLabels,
+			tiled.GetLabels()), 0.99f) << "Tile size " << tileSize;
+	}
+}
+
+//=============================================================================
+TEST_F(TestOdlmPixelDiff, CoarsenedPartitions)
+{
+	ImageData carData("carGray.bmp");
+
+	Config::SEG_COARSEN_SEGMENTS = false;
+	PixelLayer reference(carData, false);
+	reference.SegmentLayer();
+
+	// The frozen segments are expanded at the end of the segmentation
+	Config::SEG_COARSEN_SEGMENTS = true;
+	PixelLayer coarsened(carData, false);
+	coarsened.COARSEN_DELTA_PERIOD = 0.5f;
+	coarsened.COARSEN_CYCLES = 1;
+	coarsened.SegmentLayer();
+	EXPECT_GT(coarsened.GetNbSuperNeurons(), 0u);
+	EXPECT_GT(LayerDiffRunner::GetPartitionAgreement(reference.GetLabels(),
+		coarsened.GetLabels()), 0.99f);
+}
+
+//=============================================================================
+TEST_F(TestOdlmPixelDiff, PackedPartitions)
+{
+	ImageData carData("carGray.bmp");
+	vector<cv::Mat> images;
+	images.push_back(carData.gray_image_(cv::Rect(0, 0, 48, 100)).clone());
+	images.push_back(carData.gray_image_(cv::Rect(100, 20, 40, 64)).clone());
+
+	// The images of a packed layer share the time of the simulation, so
+	// they are segmented in other cascades than on their own
+	PackedPixelLayer packed(images, false);
+	vector<PackedImageResult> results = packed.SegmentImages();
+	ASSERT_EQ(images.size(), results.size());
+	for (uint k = 0; k < images.size(); ++k)
+	{
+		ImageData imgData(images[k]);
+		PixelLayer reference(imgData, false);
+		reference.SegmentLayer();
+		EXPECT_GT(LayerDiffRunner::GetPartitionAgreement(
+			reference.GetLabels(), results[k].labels), 0.95f) 
+			<< "Image " << k;
+	}
+}
+
+//=============================================================================
+TEST_F(TestOdlmPixelDiff, WarmStartPartitions)
+{
+	ImageData carData("carGray.bmp");
+	PixelLayer previous(carData, false);
+	previous.SegmentLayer();
+
+	// A frame warm-started from the same frame stays nearly the same
+	PixelLayer warm(carData, false);
+	EXPECT_EQ(warm.size, warm.InitFromPreviousFrame(previous, 0));
+	warm.SegmentLayer();
+	EXPECT_GT(LayerDiffRunner::GetPartitionAgreement(previous.GetLabels(),
+		warm.GetLabels()), 0.99f);
+
+	// Without warm start, the frame is segmented like the reference
+	PixelLayer reference(carData, false);
+	PixelLayer cold(carData, false);
+	EXPECT_EQ(0u, cold.InitFromPreviousFrame(previous, -1));
+	reference.SegmentLayer();
+	cold.SegmentLayer();
+	LayerDivergence divergence = LayerDiffRunner::ComparePartitions(
+		reference.GetLabels(), cold.GetLabels());
+	EXPECT_FALSE(divergence.diverged) << divergence.ToString();
+
+	// Same with the frame loaded in the segmented layer
+	cv::Mat previousLabels = previous.GetLabels();
+	EXPECT_EQ(previous.size, previous.LoadFrame(carData, 0));
+	previous.SegmentLayer();
+	EXPECT_GT(LayerDiffRunner::GetPartitionAgreement(previousLabels,
+		previous.GetLabels()), 0.99f);
+
+	EXPECT_EQ(0u, previous.LoadFrame(carData, -1));
+	previous.SegmentLayer();
+	divergence = LayerDiffRunner::ComparePartitions(reference.GetLabels(),
+													previous.GetLabels());
+	EXPECT_FALSE(divergence.diverged) << divergence.ToString();
+}
@@ -0,0 +1,175 @@
+/** @file test_differential.h
+*
+* @authors Vincent de Ladurantaye
+*/
+#pragma once
+
+#include "gtest/gtest.h"
+
+#include "SegmentationLayer.h"
+
+#include <climits>
+#include <string>
+#include <unordered_map>
+
+
+//=============================================================================
+//								LayerDivergence
+//=============================================================================
+/**
+* First difference found between the states of two layers
+*/
+struct LayerDivergence
+{
+	LayerDivergence() :
+		diverged(false),
+		cascade(0),
+		neuron(-1, -1),
+		ref_value(0),
+		alt_value(0)
+	{
+	}
+
+	/**
+	* Get a description of the divergence for the test reports
+	*/
+	std::string ToString() const;
+
+	// Flag indicating if the layers diverged
+	bool diverged;
+	// Number of cascades simulated when the states were found different
+	uint cascade;
+	// Position of the neuron that differs, (-1, -1) for the layer counters
+	cv::Point neuron;
+	// Field that differs: "label", "phase" or "pot" for a neuron, "cascades",
+	// "cycles", "spikes" or "done" for the layer
+	std::string field;
+	// Values of the field in the reference and alternative layers. Labels
+	// are given as the label of the alternative layer mapped to the
+	// reference label of the same segment.
+	double ref_value;
+	double alt_value;
+};
+
+
+//=============================================================================
+//								LayerDiffRunner
+//=============================================================================
+/**
+* Runs a reference layer and an alternative implementation of the simulation
+* side by side, one cascade at a time, and compares their states after each
+* cascade until they diverge or both segmentations are done.
+*
+* The neurons are compared by position, so the layers can have different
+* memory layouts. Each layer has its own labels, so the labels are compared
+* through a one to one mapping between the labels of both layers, built as
+* they are first seen and kept for the whole run: a segment of the reference
+* layer must always be the same segment in the alternative layer.
+*/
+class LayerDiffRunner
+{
+public:
+	/**
+	* Constructor
+	*
+	* @param a_ref Reference layer
+	* @param a_alt Alternative layer, of the same size
+	* @param a_pot_tolerance Largest absolute difference of potential
+	*	accepted, 0 for identical results
+	*/
+	LayerDiffRunner(SegmentationLayer& a_ref, SegmentationLayer& a_alt,
+					float a_pot_tolerance = 0.0f);
+
+	/**
+	* Segments both layers, comparing them before the first cascade and after
+	* each cascade. Stops at the first divergence or when both segmentations
+	* are done, or after a_max_cascades. Returns the first divergence.
+	*/
+	LayerDivergence Run(uint a_max_cascades = UINT_MAX);
+
+	/**
+	* Compares the current states of both layers
+	*/
+	LayerDivergence Compare();
+
+	/// Get the number of cascades compared by the last run
+	uint GetNbCascadesCompared() const { return nb_cascades_; }
+
+	/**
+	* Compares two segmentations, given as label images, up to the
+	* relabelling of their segments. Returns the first pixel, in row-major
+	* order, where the partitions differ, as a divergence of the "label"
+	* field.
+	*/
+	static LayerDivergence ComparePartitions(const cv::Mat& a_ref_labels,
+											 const cv::Mat& a_alt_labels);
+
+	/**
+	* Get the agreement of two segmentations, given as label images: the
+	* proportion of the pairs of adjacent pixels which are either in the same
+	* segment in both or in different segments in both. It is 1 when the
+	* partitions are the same, whatever the labels.
+	*
+	* The variants which don't reproduce the reference cascade by cascade,
+	* like the tiled layout or the coarsening of the stable segments, are
+	* compared this way.
+	*/
+	static float GetPartitionAgreement(const cv::Mat& a_ref_labels,
+									   const cv::Mat& a_alt_labels);
+
+private:
+	/**
+	* Check if two labels are the same segment, recording the mapping when
+	* they are first seen
+	*/
+	bool IsSameLabel(int a_ref_label, int a_alt_label);
+	//-------------------------------------------------------------------------
+	// With the given mapping
+	static bool IsSameLabel(int a_ref_label, int a_alt_label,
+							std::unordered_map<int, int>& a_ref_to_alt,
+							std::unordered_map<int, int>& a_alt_to_ref);
+
+private:
+	SegmentationLayer& ref_;
+	SegmentationLayer& alt_;
+	float pot_tolerance_;
+
+	// Mapping between the labels of both layers, in both directions
+	std::unordered_map<int, int> ref_to_alt_;
+	std::unordered_map<int, int> alt_to_ref_;
+
+	// Number of cascades compared
+	uint nb_cascades_;
+};
+
+
+//=============================================================================
+//							  TestOdlmPixelDiff
+//=============================================================================
+/**
+* Class for the differential tests of the alternative implementations of the
+* pixel layer against the reference PixelLayer.
+*/
+class TestOdlmPixelDiff: public ::testing::Test
+{
+public:
+	/**
+	* Loads the config and saves the parameters changed by the tests
+	*/
+	virtual void SetUp();
+
+	/**
+	* Restores the parameters changed by the tests
+	*/
+	virtual void TearDown();
+
+private:
+	bool trigger_same_label_;
+	bool merge_segments_;
+	uint weight_planes_;
+	uint neuron_layout_;
+	uint tile_size_;
+	bool fixed_size_;
+	uint max_cycles_;
+	bool coarsen_segments_;
+};
@@ -1,129 +1,1582 @@
-/** @file test_odlm.cpp
-*
-* @authors Vincent de Ladurantaye
-*/
-#include "test_pixel.h"
-#include "LayerCoupler.h"
-
-#include "LayerDebugger.h"
-#include "Monitor.h"
-
-#include <chrono>
-#include <fstream>
-using namespace::std;
-
-
-const int DISPLAY_TIME = 1000;
-
-//=============================================================================
-//								  TestOdlmPixel
-//=============================================================================
-TestOdlmPixel::TestOdlmPixel()
-{
-}
-
-//=============================================================================
-void TestOdlmPixel::SetUp()
-{
-	Config::LoadConfigFile("SensorPixel.ini");
-}
-
-//=============================================================================
-void TestOdlmPixel::TearDown()
-{
-
-}
-
-//=============================================================================
-//									TESTS
-//=============================================================================
-TEST_F(TestOdlmPixel, DISABLED_Segmentation)
-{
-	bool randomInit = true;
-	bool regenerateValidationFile = false;
-	
-	string imgFilename = "carGray.bmp";
-	ImageData imgData(imgFilename);
-
-	PixelLayer pixelSegLayer(imgData, randomInit);
-	
-	SegmentLayerMonitor label_monitor("Segment Monitor",
-									  &pixelSegLayer,
-									  imgData, DSM_MONITOR_SEGMENTS);
-
-	using namespace std::chrono;
-	high_resolution_clock::time_point tStart, tEnd;
-	tStart = high_resolution_clock::now();
-
-	pixelSegLayer.SegmentLayer();
-
-	tEnd = std::chrono::high_resolution_clock::now();
-	duration<double> time_span =
-		duration_cast<duration<double>>(tEnd - tStart);
-	cout << "Segmentation time: " << time_span.count() << " seconds" << endl;
-
-	string validFilename = "test/TEST_Segmentation_" + 
-		imgFilename.substr(0, imgFilename.find('.')) +
-		(randomInit ? "_randInit": "") +
-		".valid";
-
-	if (regenerateValidationFile)
-		pixelSegLayer.SaveStateToFile(validFilename);
-	else
-		EXPECT_TRUE(pixelSegLayer.ValidateLayerState(validFilename));
-
-	label_monitor.Display();
-
-	cv::waitKey(DISPLAY_TIME);
-}
-
-//=============================================================================
-TEST_F(TestOdlmPixel, DISABLED_SegmentationDebugger)
-{
-	ImageData imgData("carGray.bmp");
-
-	PixelLayer pixelSegLayer(imgData);
-
-	//pixelSegLayer.TRIGGER_SAME_LABEL_NEURONS = true;
-	//pixelSegLayer.MERGE_SEGMENTS = true;
-	
-	SegmentLayerMonitor potentials_monitor("Potentials Monitor",
-										   &pixelSegLayer,
-										   imgData, DSM_MONITOR_POTENTIAL);
-	SegmentLayerMonitor label_monitor("Segment Monitor",
-									  &pixelSegLayer,
-									  imgData, DSM_MONITOR_SEGMENTS);
-
-
-	LayerDebugger::AddDebugger(pixelSegLayer, "Pixels");
-	LayerDebugger::SetDebugLvl(DEBUG_LEVEL_CASCADE);
-	
-	pixelSegLayer.SegmentLayer();
-
-	//cv::waitKey(DISPLAY_TIME);
-	cv::waitKey(0);
-}
-
-//=============================================================================
-TEST_F(TestOdlmPixel, Misc_Test)
-{
-	bool randomInit = true;
-	bool regenerateValidationFile = false;
-
-	string imgFilename = "small.bmp";
-	ImageData imgData(imgFilename);
-
-	PixelLayer pixelSegLayer(ImageData(imgFilename), randomInit);
-
-	//{
-		SegmentLayerMonitor label_monitor("Segment Monitor", pixelSegLayer);
-		label_monitor.Display();
-		LayerDebugger::AddDebugger(pixelSegLayer, "Debug");
-	//}
-
-
-	pixelSegLayer.SegmentLayer();
-	
-
-	cv::waitKey(DISPLAY_TIME);
+/** @file test_odlm.cpp
+*
+* @authors Vincent de Ladurantaye
+*/
+#include "test_pixel.h"
+#include "GalleryMatcher.h"
+#include "LayerCoupler.h"
+#include "LayerRenderer.h"
+#include "LayerSnapshot.h"
+#include "LayerState.h"
+#include "LayerTracer.h"
+#include "PackedPixelLayer.h"
+#include "PyramidSegmenter.h"
+#include "SegmentationLayerT.h"
+#include "SyntheticImage.h"
+#include "VideoPipeline.h"
+#include "VideoSegmenter.h"
+
+#include "LayerDebugger.h"
+#include "Monitor.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <set>
+#include <thread>
+#include <type_traits>
+#include <typeinfo>
+using namespace::std;
+
+
+const int DISPLAY_TIME = 1000;
+
+//=============================================================================
+//								  TestOdlmPixel
+//=============================================================================
+TestOdlmPixel::TestOdlmPixel()
+{
+}
+
+//=============================================================================
+void TestOdlmPixel::SetUp()
+{
+	Config::LoadConfigFile("SensorPixel.ini");
+}
+
+//=============================================================================
+void TestOdlmPixel::TearDown()
+{
+
+}
+
+//=============================================================================
+void TestOdlmPixel::ExpectSameSegmentation(PixelLayer& a_layer1,
+										   PixelLayer& a_layer2,
+										   uint a_nb_cycles)
+{
+	// Labels are unique to each layer, compare them relatively to the
+	// initial label of the first neuron
+	int labelOffset = a_layer2.neurons[0].label - a_layer1.neurons[0].label;
+
+	a_layer1.MAX_SEG_CYCLES = a_nb_cycles;
+	a_layer2.MAX_SEG_CYCLES = a_nb_cycles;
+	a_layer1.SegmentLayer();
+	a_layer2.SegmentLayer();
+
+	ASSERT_EQ(a_layer1.GetNbCascades(), a_layer2.GetNbCascades());
+	ASSERT_EQ(a_layer1.GetNbSpikes(), a_layer2.GetNbSpikes());
+
+	// Compare the neurons by position since the layers can have different
+	// neuron layouts
+	for (uint y = 0; y < a_layer1.height; ++y)
+	for (uint x = 0; x < a_layer1.width; ++x)
+	{
+		const Neuron& n1 = a_layer1.neurons[a_layer1.GetNeuronId(x, y)];
+		const Neuron& n2 = a_layer2.neurons[a_layer2.GetNeuronId(x, y)];
+		ASSERT_EQ(n1.label + labelOffset, n2.label) << "Neuron " << x << "," << y;
+		ASSERT_EQ(n1.phase, n2.phase) << "Neuron " << x << "," << y;
+		ASSERT_EQ(n1.pot, n2.pot) << "Neuron " << x << "," << y;
+	}
+}
+
+//=============================================================================
+//									TESTS
+//=============================================================================
+TEST_F(TestOdlmPixel, DISABLED_Segmentation)
+{
+	bool randomInit = true;
+	bool regenerateValidationFile = false;
+	
+	string imgFilename = "carGray.bmp";
+	ImageData imgData(imgFilename);
+
+	PixelLayer pixelSegLayer(imgData, randomInit);
+	
+	SegmentLayerMonitor label_monitor("Segment Monitor",
+									  &pixelSegLayer,
+									  imgData, DSM_MONITOR_SEGMENTS);
+
+	using namespace std::chrono;
+	high_resolution_clock::time_point tStart, tEnd;
+	tStart = high_resolution_clock::now();
+
+	pixelSegLayer.SegmentLayer();
+
+	tEnd = std::chrono::high_resolution_clock::now();
+	duration<double> time_span =
+		duration_cast<duration<double>>(tEnd - tStart);
+	cout << "Segmentation time: " << time_span.count() << " seconds" << endl;
+
+	string validFilename = "test/TEST_Segmentation_" + 
+		imgFilename.substr(0, imgFilename.find('.')) +
+		(randomInit ? "_randInit": "") +
+		".valid";
+
+	if (regenerateValidationFile)
+		pixelSegLayer.SaveStateToFile(validFilename);
+	else
+		EXPECT_TRUE(pixelSegLayer.ValidateLayerState(validFilename));
+
+	label_monitor.Display();
+
+	cv::waitKey(DISPLAY_TIME);
+}
+
+//=============================================================================
+TEST_F(TestOdlmPixel, DISABLED_SegmentationDebugger)
+{
+	ImageData imgData("carGray.bmp");
+
+	PixelLayer pixelSegLayer(imgData);
+
+	//pixelSegLayer.TRIGGER_SAME_LABEL_NEURONS = true;
+	//pixelSegLayer.MERGE_SEGMENTS = true;
+	
+	SegmentLayerMonitor potentials_monitor("Potentials Monitor",
+										   &pixelSegLayer,
+										   imgData, DSM_MONITOR_POTENTIAL);
+	SegmentLayerMonitor label_monitor("Segment Monitor",
+									  &pixelSegLayer,
+									  imgData, DSM_MONITOR_SEGMENTS);
+
+
+	LayerDebugger::AddDebugger(pixelSegLayer, "Pixels");
+	LayerDebugger::SetDebugLvl(DEBUG_LEVEL_CASCADE);
+	
+	pixelSegLayer.SegmentLayer();
+
+	//cv::waitKey(DISPLAY_TIME);
+	cv::waitKey(0);
+}
+
+//=============================================================================
+TEST_F(TestOdlmPixel, SpecializedLayer)
+{
+	bool trigger = Config::SEG_TRIGGER_SAME_LABEL_NEURONS;
+	bool merge = Config::SEG_MERGE_SEGMENTS;
+
+	ImageData imgData("carGray.bmp");
+
+	// Specialized layers must give the same results as the generic layer for
+	// every combination of flags
+	for (int flags = 0; flags < 4; ++flags)
+	{
+		Config::SEG_TRIGGER_SAME_LABEL_NEURONS = (flags & 1) != 0;
+		Config::SEG_MERGE_SEGMENTS = (flags & 2) != 0;
+
+		PixelLayer layer(imgData, false);
+		unique_ptr<PixelLayer> specLayer = CreatePixelLayer(imgData, false);
+
+		ExpectSameSegmentation(layer, *specLayer, 5);
+	}
+
+	Config::SEG_TRIGGER_SAME_LABEL_NEURONS = trigger;
+	Config::SEG_MERGE_SEGMENTS = merge;
+}
+
+//=============================================================================
+TEST_F(TestOdlmPixel, FixedSizeLayer)
+{
+	bool fixedSize = Config::FIXED_INPUT_IMGS_SIZE;
+	bool trigger = Config::SEG_TRIGGER_SAME_LABEL_NEURONS;
+	bool merge = Config::SEG_MERGE_SEGMENTS;
+
+	ImageData carData("carGray.bmp");
+	cv::Mat img;
+	cv::resize(carData.gray_image_(cv::Rect(100, 0, 64, 115)), img,
+			   cv::Size(64, 128));
+	ImageData imgData(img);
+
+	typedef FixedPixelLayer<64, 128> FixedLayer;
+
+	// Fixed size layers must give the same results as the generic layer
+	PixelLayer layer(imgData, false);
+	FixedLayer fixedLayer(imgData, false);
+	ExpectSameSegmentation(layer, fixedLayer, 5);
+
+	// The fixed size layer is selected for the fixed input size only
+	Config::FIXED_INPUT_IMGS_SIZE = true;
+	for (int flags = 0; flags < 4; ++flags)
+	{
+		Config::SEG_TRIGGER_SAME_LABEL_NEURONS = (flags & 1) != 0;
+		Config::SEG_MERGE_SEGMENTS = (flags & 2) != 0;
+
+		PixelLayer flagsLayer(imgData, false);
+		unique_ptr<PixelLayer> specLayer = CreatePixelLayer(imgData, false);
+		EXPECT_TRUE(flags != 0 || 
+					dynamic_cast<FixedLayer*>(specLayer.get()) != nullptr);
+
+		ExpectSameSegmentation(flagsLayer, *specLayer, 5);
+	}
+	unique_ptr<PixelLayer> carLayer = CreatePixelLayer(carData, false);
+	EXPECT_TRUE(dynamic_cast<FixedLayer*>(carLayer.get()) == nullptr);
+
+	// Fixed size layers can't be created for other sizes
+	EXPECT_THROW(FixedLayer(carData, false), invalid_argument);
+
+	Config::FIXED_INPUT_IMGS_SIZE = fixedSize;
+	Config::SEG_TRIGGER_SAME_LABEL_NEURONS = trigger;
+	Config::SEG_MERGE_SEGMENTS = merge;
+}
+
+//=============================================================================
+TEST_F(TestOdlmPixel, WeightPlanes)
+{
+	ImageData imgData("carGray.bmp");
+
+	PixelLayer layer(imgData, false);
+	PixelLayer planesLayer(imgData, false);
+	layer.SetWeightPlanes(false);
+	planesLayer.SetWeightPlanes(true);
+
+	EXPECT_EQ(0u, layer.GetWeightPlanesMemory());
+	EXPECT_EQ(8 * planesLayer.size * sizeof(float),
+			  planesLayer.GetWeightPlanesMemory());
+
+	// Precomputed weights must give exactly the same segmentation
+	ExpectSameSegmentation(layer, planesLayer, 5);
+
+	// In auto mode, the planes are only computed once the layer spiked as
+	// many times as it has neurons
+	PixelLayer refLayer(imgData, false);
+	PixelLayer autoLayer(imgData, false);
+	refLayer.SetWeightPlanes(false);
+	ASSERT_EQ((uint)WEIGHT_PLANES_AUTO, autoLayer.WEIGHT_PLANES_MODE);
+	EXPECT_EQ(0u, autoLayer.GetWeightPlanesMemory());
+	ExpectSameSegmentation(refLayer, autoLayer, 5);
+	EXPECT_GE(autoLayer.GetNbSpikes(), (unsigned long)autoLayer.size);
+	EXPECT_EQ(8 * autoLayer.size * sizeof(float),
+			  autoLayer.GetWeightPlanesMemory());
+}
+
+//=============================================================================
+TEST_F(TestOdlmPixel, TiledLayout)
+{
+	uint layout = Config::SIM_NEURON_LAYOUT;
+	uint tileSize = Config::SIM_LAYOUT_TILE_SIZE;
+
+	ImageData imgData("carGray.bmp");
+	PixelLayer layer(imgData, false);
+
+	// Tiles truncated by the right and bottom borders
+	Config::SIM_NEURON_LAYOUT = LAYOUT_TILED;
+	Config::SIM_LAYOUT_TILE_SIZE = 16;
+	PixelLayer tiledLayer(imgData, false);
+
+	// Positions and indices must translate both ways, and the neurons must
+	// start in the same state as with the row-major layout
+	vector<bool> usedIds(tiledLayer.size, false);
+	for (int y = 0; y < (int)tiledLayer.height; ++y)
+	for (int x = 0; x < (int)tiledLayer.width; ++x)
+	{
+		uint id = tiledLayer.GetNeuronId(x, y);
+		ASSERT_LT(id, tiledLayer.size);
+		ASSERT_FALSE(usedIds[id]);
+		usedIds[id] = true;
+		ASSERT_EQ(cv::Point(x, y), tiledLayer.GetNeuronPos(id));
+
+		const Neuron& n1 = layer.neurons[layer.GetNeuronId(x, y)];
+		const Neuron& n2 = tiledLayer.neurons[id];
+		ASSERT_EQ(n1.pot, n2.pot);
+		ASSERT_EQ(layer.GetMaxCharge(layer.GetNeuronId(x, y)),
+				  tiledLayer.GetMaxCharge(id));
+	}
+
+	// With a single tile, the neurons are in row-major order, so the 
+	// segmentation must be identical
+	Config::SIM_LAYOUT_TILE_SIZE = 512;
+	PixelLayer singleTileLayer(imgData, false);
+	ExpectSameSegmentation(layer, singleTileLayer, 5);
+
+	Config::SIM_NEURON_LAYOUT = layout;
+	Config::SIM_LAYOUT_TILE_SIZE = tileSize;
+}
+
+//=============================================================================
+TEST_F(TestOdlmPixel, StableSegmentCoarsening)
+{
+	bool coarsen = Config::SEG_COARSEN_SEGMENTS;
+	float deltaPeriod = Config::SEG_COARSEN_DELTA_PERIOD;
+	uint cycles = Config::SEG_COARSEN_CYCLES;
+
+	Config::SEG_COARSEN_SEGMENTS = true;
+	Config::SEG_COARSEN_DELTA_PERIOD = 0.5f;
+	Config::SEG_COARSEN_CYCLES = 1;
+
+	ImageData imgData("carGray.bmp");
+	PixelLayer layer(imgData, false);
+	layer.SegmentLayer();
+
+	EXPECT_GT(layer.GetNbSuperNeurons(), 0u);
+
+	// The super-neurons are expanded at the end of the segmentation, so
+	// every neuron must be back in a valid state
+	for (uint i = 0; i < layer.size; ++i)
+	{
+		ASSERT_GE(layer.neurons[i].label, 0);
+	}
+
+	Config::SEG_COARSEN_SEGMENTS = coarsen;
+	Config::SEG_COARSEN_DELTA_PERIOD = deltaPeriod;
+	Config::SEG_COARSEN_CYCLES = cycles;
+}
+
+//=============================================================================
+TEST_F(TestOdlmPixel, PyramidSegmentation)
+{
+	uint levels = Config::SEG_PYRAMID_LEVELS;
+	Config::SEG_PYRAMID_LEVELS = 2;
+
+	ImageData imgData("carGray.bmp");
+	PyramidSegmenter segmenter;
+	unique_ptr<PixelLayer> layer = segmenter.Segment(imgData);
+
+	// The coarse level is half the size, the last level is full resolution
+	const vector<PyramidLevelStats>& stats = segmenter.GetLevelStats();
+	ASSERT_EQ(2u, stats.size());
+	EXPECT_EQ(imgData.cols / 2, stats[0].width);
+	EXPECT_EQ(imgData.rows / 2, stats[0].height);
+	EXPECT_EQ(imgData.cols, stats[1].width);
+	EXPECT_EQ(imgData.rows, stats[1].height);
+	EXPECT_LE(stats[1].cycles, segmenter.REFINE_CYCLES);
+	EXPECT_GT(stats[1].cascades, 0u);
+
+	ASSERT_EQ(imgData.size, layer->size);
+	EXPECT_EQ(stats[0].cascades + stats[1].cascades, layer->GetNbCascades());
+
+	Config::SEG_PYRAMID_LEVELS = levels;
+}
+
+//=============================================================================
+TEST_F(TestOdlmPixel, VideoWarmStart)
+{
+	ImageData imgData("carGray.bmp");
+	cv::Mat frame = imgData.gray_image_.clone();
+
+	VideoSegmenter segmenter;
+	segmenter.SegmentFrame(frame);
+	EXPECT_EQ(0u, segmenter.GetFrameStats().warm_neurons);
+	PixelLayer* layer = segmenter.GetLayer();
+	cv::Mat firstLabels = layer->GetLabels();
+
+	// Change a block of the frame, the other neurons start from their state
+	// in the previous frame, in the same layer
+	cv::Rect block(10, 10, 20, 20);
+	for (int y = block.y; y < block.y + block.height; ++y)
+	for (int x = block.x; x < block.x + block.width; ++x)
+	{
+		frame.at<uchar>(y, x) += 128;
+	}
+	segmenter.SegmentFrame(frame);
+
+	const VideoFrameStats& stats = segmenter.GetFrameStats();
+	EXPECT_EQ(layer, segmenter.GetLayer());
+	EXPECT_EQ(1u, stats.frame);
+	EXPECT_EQ(imgData.size - block.area(), stats.warm_neurons);
+	EXPECT_GT(stats.cascades, 0u);
+
+	// The segments outside of the changed block must be mostly the same,
+	// whatever their labels
+	cv::Mat labels = segmenter.GetLayer()->GetLabels();
+	uint nbPairs = 0;
+	uint nbSame = 0;
+	for (int y = 0; y < labels.rows; ++y)
+	for (int x = 0; x + 1 < labels.cols; ++x)
+	{
+		if (block.contains(cv::Point(x, y)) ||
+			block.contains(cv::Point(x + 1, y))) continue;
+
+		bool joined = labels.at<int>(y, x) == labels.at<int>(y, x + 1);
+		bool firstJoined = 
+			firstLabels.at<int>(y, x) == firstLabels.at<int>(y, x + 1);
+		++nbPairs;
+		if (joined == firstJoined) ++nbSame;
+	}
+	EXPECT_GT(nbSame, 0.9 * nbPairs);
+
+	// After a reset, the layer is reloaded from scratch
+	segmenter.Reset();
+	segmenter.SegmentFrame(frame);
+	EXPECT_EQ(layer, segmenter.GetLayer());
+	EXPECT_EQ(0u, segmenter.GetFrameStats().warm_neurons);
+	EXPECT_EQ(imgData.size, segmenter.GetFrameStats().active_neurons);
+}
+
+//=============================================================================
+TEST_F(TestOdlmPixel, PartialResegmentation)
+{
+	ImageData imgData("carGray.bmp");
+	cv::Mat frame = imgData.gray_image_.clone();
+
+	// Overlapping regions are only simulated once
+	PixelLayer layer(imgData, false);
+	layer.SetActiveRegions({ cv::Rect(0, 0, 10, 10), cv::Rect(5, 5, 10, 10) });
+	EXPECT_EQ(175u, layer.GetNbActiveNeurons());
+	layer.ClearActiveRegions();
+	EXPECT_EQ(layer.size, layer.GetNbActiveNeurons());
+
+	VideoSegmenter segmenter;
+	segmenter.PARTIAL_RESEGMENTATION = true;
+	segmenter.SegmentFrame(frame);
+	cv::Mat firstLabels = segmenter.GetLayer()->GetLabels();
+
+	cv::Rect block(10, 10, 20, 20);
+	for (int y = block.y; y < block.y + block.height; ++y)
+	for (int x = block.x; x < block.x + block.width; ++x)
+	{
+		frame.at<uchar>(y, x) += 128;
+	}
+	segmenter.SegmentFrame(frame);
+
+	// Only the changed tiles and their margin are segmented again, the
+	// labels are kept everywhere else
+	const VideoFrameStats& stats = segmenter.GetFrameStats();
+	EXPECT_LT(stats.active_neurons, imgData.size / 4);
+
+	PixelLayer* frameLayer = segmenter.GetLayer();
+	cv::Mat labels = frameLayer->GetLabels();
+	for (int y = 0; y < labels.rows; ++y)
+	for (int x = 0; x < labels.cols; ++x)
+	{
+		bool active = false;
+		for (auto& reg : frameLayer->GetActiveRegions())
+		{
+			active = active || reg.contains(cv::Point(x, y));
+		}
+		if (active) continue;
+
+		ASSERT_EQ(firstLabels.at<int>(y, x), labels.at<int>(y, x));
+	}
+
+	// Without changes, nothing is simulated
+	segmenter.SegmentFrame(frame);
+	EXPECT_EQ(0u, segmenter.GetFrameStats().active_neurons);
+	EXPECT_EQ(0u, segmenter.GetFrameStats().cascades);
+}
+
+//=============================================================================
+TEST_F(TestOdlmPixel, VideoPipeline)
+{
+	// The ring buffer is bounded and keeps the order
+	RingBuffer<int> ring(3);
+	ASSERT_EQ(4u, ring.GetCapacity());
+	for (int i = 0; i < 4; ++i) EXPECT_TRUE(ring.TryPush(i));
+	EXPECT_FALSE(ring.TryPush(4));
+	int item;
+	for (int i = 0; i < 4; ++i)
+	{
+		ASSERT_TRUE(ring.TryPop(item));
+		EXPECT_EQ(i, item);
+	}
+	EXPECT_FALSE(ring.TryPop(item));
+
+	// Once closed, the blocking queue gives the items left then stops
+	BlockingRingBuffer<int> blocking(2);
+	blocking.Push(1);
+	blocking.Close();
+	ASSERT_TRUE(blocking.Pop(item));
+	EXPECT_EQ(1, item);
+	EXPECT_FALSE(blocking.Pop(item));
+
+	// The threads sleeping on a full or an empty queue are woken up
+	const int nbItems = 10000;
+	BlockingRingBuffer<int> handoff(2);
+	thread producer([&handoff, nbItems]()
+	{
+		for (int i = 0; i < nbItems; ++i) handoff.Push(i);
+		handoff.Close();
+	});
+	int nbPopped = 0;
+	while (handoff.Pop(item))
+	{
+		EXPECT_EQ(nbPopped, item);
+		++nbPopped;
+	}
+	producer.join();
+	EXPECT_EQ(nbItems, nbPopped);
+
+	// Without random initialization, to compare with a sequential run
+	ImageData imgData("carGray.bmp");
+	const uint nbFrames = 6;
+	uint nbRead = 0;
+	bool randomInit = Config::PIXEL_RANDOM_INIT;
+	Config::PIXEL_RANDOM_INIT = false;
+
+	VideoPipeline::FrameSource frameSource = [&](cv::Mat& a_frame)
+	{
+		if (nbRead == nbFrames) return false;
+		imgData.gray_image_.copyTo(a_frame);
+		a_frame.at<uchar>(nbRead, nbRead) += 128;
+		++nbRead;
+		return true;
+	};
+
+	// The frames must come out in order, whatever the worker that segmented
+	// them
+	vector<uint> written;
+	vector<cv::Mat> frameLabels;
+	VideoPipeline::OutputCallback output = [&](uint a_frame, 
+		const cv::Mat& a_image, const cv::Mat& a_labels)
+	{
+		written.push_back(a_frame);
+		frameLabels.push_back(a_labels.clone());
+		EXPECT_EQ((int)imgData.rows, a_labels.rows);
+		EXPECT_EQ((int)imgData.cols, a_labels.cols);
+	};
+
+	// Labels of another segmentation matched one to one with the labels of
+	// the pipeline
+	map<int, int> pipelineLabels;
+	set<int> matchedLabels;
+	auto matchLabels = [&](const cv::Mat& a_labels, 
+						   const cv::Mat& a_pipeline_labels)
+	{
+		for (int y = 0; y < a_labels.rows; ++y)
+		for (int x = 0; x < a_labels.cols; ++x)
+		{
+			int label = a_labels.at<int>(y, x);
+			auto match = pipelineLabels.emplace(label,
+				a_pipeline_labels.at<int>(y, x));
+			if (match.second)
+			{
+				ASSERT_TRUE(matchedLabels.insert(match.first->second).second);
+			}
+			ASSERT_EQ(match.first->second, a_pipeline_labels.at<int>(y, x));
+		}
+	};
+
+	VideoPipeline pipeline;
+	pipeline.NB_WORKERS = 2;
+	pipeline.QUEUE_SIZE = 2;
+	pipeline.SetFrameSource(frameSource);
+	pipeline.SetOutputCallback(output);
+
+	VideoPipelineStats stats = pipeline.Run();
+
+	EXPECT_EQ(nbFrames, stats.frames_decoded);
+	EXPECT_EQ(nbFrames, stats.frames_segmented);
+	EXPECT_EQ(nbFrames, stats.frames_written);
+	EXPECT_GT(stats.throughput_fps, 0.0);
+	ASSERT_EQ(nbFrames, written.size());
+	for (uint i = 0; i < nbFrames; ++i)
+	{
+		EXPECT_EQ(i, written[i]);
+	}
+
+	// Each frame is warm-started from the previous frame of the stream, as 
+	// when the frames are segmented one after the other. The labels of both
+	// streams differ but must match one to one over the whole stream.
+	VideoSegmenter segmenter;
+	for (uint i = 0; i < nbFrames; ++i)
+	{
+		cv::Mat frame = imgData.gray_image_.clone();
+		frame.at<uchar>(i, i) += 128;
+		segmenter.SegmentFrame(frame);
+		matchLabels(segmenter.GetLayer()->GetLabels(), frameLabels[i]);
+	}
+
+	// Without warm start, the workers segment the frames concurrently, each
+	// from scratch as when they are segmented one after the other
+	int warmStartDelta = Config::SEG_WARM_START_DELTA;
+	Config::SEG_WARM_START_DELTA = -1;
+	VideoPipeline concurrentPipeline;
+	concurrentPipeline.NB_WORKERS = 3;
+	concurrentPipeline.QUEUE_SIZE = 2;
+	concurrentPipeline.SetFrameSource(frameSource);
+	concurrentPipeline.SetOutputCallback(output);
+	nbRead = 0;
+	written.clear();
+	frameLabels.clear();
+	stats = concurrentPipeline.Run();
+
+	EXPECT_EQ(nbFrames, stats.frames_written);
+	ASSERT_EQ(nbFrames, written.size());
+	VideoSegmenter independentSegmenter;
+	for (uint i = 0; i < nbFrames; ++i)
+	{
+		EXPECT_EQ(i, written[i]);
+
+		cv::Mat frame = imgData.gray_image_.clone();
+		frame.at<uchar>(i, i) += 128;
+		independentSegmenter.SegmentFrame(frame);
+		EXPECT_EQ(0u, independentSegmenter.GetFrameStats().warm_neurons);
+
+		pipelineLabels.clear();
+		matchedLabels.clear();
+		matchLabels(independentSegmenter.GetLayer()->GetLabels(), 
+					frameLabels[i]);
+	}
+
+	Config::SEG_WARM_START_DELTA = warmStartDelta;
+	Config::PIXEL_RANDOM_INIT = randomInit;
+}
+
+//=============================================================================
+TEST_F(TestOdlmPixel, StepwiseSegmentation)
+{
+	ImageData imgData("carGray.bmp");
+
+	PixelLayer layer(imgData, false);
+	PixelLayer cascadesLayer(imgData, false);
+	PixelLayer cyclesLayer(imgData, false);
+	int cascadesOffset = cascadesLayer.neurons[0].label - layer.neurons[0].label;
+	int cyclesOffset = cyclesLayer.neurons[0].label - layer.neurons[0].label;
+	layer.MAX_SEG_CYCLES = 5;
+	cascadesLayer.MAX_SEG_CYCLES = 5;
+	cyclesLayer.MAX_SEG_CYCLES = 5;
+
+	layer.SegmentLayer();
+
+	// Interleave two layers in the same thread, a few steps at a time
+	EXPECT_FALSE(cascadesLayer.IsSegmentationDone());
+	bool cascadesRunning = true;
+	bool cyclesRunning = true;
+	uint lastCycle = 0;
+	while (cascadesRunning || cyclesRunning)
+	{
+		if (cascadesRunning) cascadesRunning = cascadesLayer.RunCascades(7);
+		if (cyclesRunning)
+		{
+			cyclesRunning = cyclesLayer.RunCycles(1);
+			if (cyclesRunning)
+			{
+				EXPECT_EQ(lastCycle + 1, cyclesLayer.GetNbCycles());
+			}
+			lastCycle = cyclesLayer.GetNbCycles();
+		}
+	}
+	EXPECT_TRUE(cascadesLayer.IsSegmentationDone());
+	EXPECT_FALSE(cascadesLayer.Step());
+	EXPECT_EQ(layer.IsConverged(), cascadesLayer.IsConverged());
+	EXPECT_EQ(layer.GetConvergence(), cyclesLayer.GetConvergence());
+
+	// Stepping must give exactly the same segmentation
+	ASSERT_EQ(layer.GetNbCascades(), cascadesLayer.GetNbCascades());
+	ASSERT_EQ(layer.GetNbCascades(), cyclesLayer.GetNbCascades());
+	ASSERT_EQ(layer.GetNbSpikes(), cascadesLayer.GetNbSpikes());
+	for (uint i = 0; i < layer.size; ++i)
+	{
+		ASSERT_EQ(layer.neurons[i].label + cascadesOffset,
+				  cascadesLayer.neurons[i].label) << "Neuron " << i;
+		ASSERT_EQ(layer.neurons[i].label + cyclesOffset,
+				  cyclesLayer.neurons[i].label) << "Neuron " << i;
+		ASSERT_EQ(layer.neurons[i].pot, cyclesLayer.neurons[i].pot);
+	}
+}
+
+//=============================================================================
+TEST_F(TestOdlmPixel, SegmentationDeadline)
+{
+	ImageData imgData("carGray.bmp");
+
+	PixelLayer fullLayer(imgData, false);
+	SegmentationResult full = fullLayer.SegmentWithDeadline(0, nullptr, true);
+	EXPECT_FALSE(full.deadline_reached);
+	EXPECT_FALSE(full.cancelled);
+	EXPECT_EQ(fullLayer.GetNbCascades(), full.cascades);
+	ASSERT_EQ((int)imgData.rows, full.labels.rows);
+	ASSERT_EQ((int)imgData.cols, full.labels.cols);
+
+	// The neurons of the small segments are unlabeled
+	uint nbUnlabeled = 0;
+	for (int y = 0; y < full.labels.rows; ++y)
+	for (int x = 0; x < full.labels.cols; ++x)
+	{
+		if (full.labels.at<int>(y, x) == -1) ++nbUnlabeled;
+	}
+	EXPECT_GT(nbUnlabeled, 0u);
+
+	// Stops at the deadline with the labels reached so far
+	PixelLayer deadlineLayer(imgData, false);
+	SegmentationResult partial = deadlineLayer.SegmentWithDeadline(1.0);
+	EXPECT_TRUE(partial.deadline_reached);
+	EXPECT_FALSE(partial.converged);
+	EXPECT_TRUE(deadlineLayer.IsSegmentationDone());
+	EXPECT_LT(partial.cascades, full.cascades);
+	EXPECT_EQ(deadlineLayer.GetConvergence(), partial.convergence);
+
+	// A cancelled token stops the segmentation after the first cascade
+	CancellationToken token;
+	token.Cancel();
+	PixelLayer cancelLayer(imgData, false);
+	SegmentationResult cancelled = cancelLayer.SegmentWithDeadline(0, &token);
+	EXPECT_TRUE(cancelled.cancelled);
+	EXPECT_EQ(1u, cancelled.cascades);
+}
+
+//=============================================================================
+TEST_F(TestOdlmPixel, PackedLayer)
+{
+	ImageData imgData("carGray.bmp");
+
+	vector<cv::Mat> images;
+	images.push_back(imgData.gray_image_(cv::Rect(0, 0, 48, 100)).clone());
+	images.push_back(imgData.gray_image_(cv::Rect(100, 20, 40, 64)).clone());
+	images.push_back(imgData.gray_image_(cv::Rect(200, 10, 48, 100)).clone());
+
+	PackedPixelLayer layer(images, false);
+	ASSERT_EQ(3u, layer.GetNbImages());
+	EXPECT_EQ(48u + 1 + 40 + 1 + 48, layer.width);
+	EXPECT_EQ(100u, layer.height);
+
+	// The neurons outside of the images are inert
+	int separatorLabel = layer.neurons[layer.GetNeuronId(48, 0)].label;
+	int paddingLabel = layer.neurons[layer.GetNeuronId(60, 80)].label;
+	EXPECT_EQ(0.0f, layer.GetMaxCharge(layer.GetNeuronId(48, 0)));
+	EXPECT_EQ(0.0f, layer.GetMaxCharge(layer.GetNeuronId(60, 80)));
+	EXPECT_EQ(images[1].at<uchar>(5, 7),
+			  layer.pixel_data[layer.GetNeuronId(49 + 7, 5)]);
+
+	vector<PackedImageResult> results = layer.SegmentImages();
+	ASSERT_EQ(3u, results.size());
+
+	EXPECT_EQ(separatorLabel, layer.neurons[layer.GetNeuronId(48, 0)].label);
+	EXPECT_EQ(paddingLabel, layer.neurons[layer.GetNeuronId(60, 80)].label);
+
+	// Each image is segmented on its own, no label crosses the separators
+	vector<set<int> > imageLabels(results.size());
+	for (uint k = 0; k < results.size(); ++k)
+	{
+		const PackedImageResult& result = results[k];
+		ASSERT_EQ(images[k].rows, result.labels.rows);
+		ASSERT_EQ(images[k].cols, result.labels.cols);
+		EXPECT_GT(result.cascades, 0u);
+		EXPECT_LE(result.cascades, layer.GetNbCascades());
+		EXPECT_TRUE(result.converged || result.cycles == layer.MAX_SEG_CYCLES);
+
+		for (int y = 0; y < result.labels.rows; ++y)
+		for (int x = 0; x < result.labels.cols; ++x)
+		{
+			imageLabels[k].insert(result.labels.at<int>(y, x));
+		}
+		for (uint j = 0; j < k; ++j)
+		for (int label : imageLabels[k])
+		{
+			EXPECT_EQ(0u, imageLabels[j].count(label));
+		}
+	}
+}
+
+//=============================================================================
+TEST_F(TestOdlmPixel, LayerSnapshot)
+{
+	uint layout = Config::SIM_NEURON_LAYOUT;
+	uint tileSize = Config::SIM_LAYOUT_TILE_SIZE;
+
+	// Snapshots are row-major whatever the layout of the layer
+	Config::SIM_NEURON_LAYOUT = LAYOUT_TILED;
+	Config::SIM_LAYOUT_TILE_SIZE = 16;
+	ImageData carData("carGray.bmp");
+	ImageData imgData(carData.gray_image_(cv::Rect(100, 0, 60, 50)));
+	PixelLayer layer(imgData, false);
+	layer.RunCascades(20);
+
+	LayerSnapshot snapshot;
+	layer.CaptureSnapshot(snapshot);
+	EXPECT_EQ(layer.layer_id, snapshot.layer_id);
+	EXPECT_EQ(layer.GetNbCascades(), snapshot.cascade);
+	ASSERT_EQ(50, snapshot.potentials.rows);
+	ASSERT_EQ(60, snapshot.potentials.cols);
+	for (int y = 0; y < 50; ++y)
+	for (int x = 0; x < 60; ++x)
+	{
+		const Neuron& n = layer.neurons[layer.GetNeuronId(x, y)];
+		ASSERT_EQ(n.pot, snapshot.potentials.at<float>(y, x));
+		ASSERT_EQ(n.label, snapshot.labels.at<int>(y, x));
+		ASSERT_EQ(n.phase, snapshot.phases.at<int>(y, x));
+	}
+
+	// Capturing again reuses the buffers
+	const uchar* potData = snapshot.potentials.data;
+	layer.RunCascades(5);
+	layer.CaptureSnapshot(snapshot);
+	EXPECT_EQ(potData, snapshot.potentials.data);
+
+	Config::SIM_NEURON_LAYOUT = layout;
+	Config::SIM_LAYOUT_TILE_SIZE = tileSize;
+
+	// Nothing to consume until a snapshot is published, then only once
+	SnapshotBuffer buffer;
+	EXPECT_FALSE(buffer.Consume());
+	EXPECT_FALSE(buffer.HasSnapshot());
+	buffer.GetWriteSnapshot().cycle = 1;
+	buffer.Publish();
+	buffer.GetWriteSnapshot().cycle = 2;
+	buffer.Publish();
+	ASSERT_TRUE(buffer.Consume());
+	EXPECT_EQ(2u, buffer.GetReadSnapshot().cycle);
+	EXPECT_FALSE(buffer.Consume());
+	EXPECT_EQ(2u, buffer.GetReadSnapshot().cycle);
+
+	// The consumer never sees a snapshot being written, and only newer ones
+	const uint nbSnapshots = 20000;
+	thread producer([&buffer, nbSnapshots]()
+	{
+		for (uint i = 3; i < nbSnapshots; ++i)
+		{
+			LayerSnapshot& s = buffer.GetWriteSnapshot();
+			s.cycle = i;
+			s.labels.create(1, 64, CV_32S);
+			s.labels.setTo(cv::Scalar(i));
+			buffer.Publish();
+		}
+	});
+	uint lastCycle = 2;
+	uint nbErrors = 0;
+	while (lastCycle < nbSnapshots - 1)
+	{
+		if (!buffer.Consume()) continue;
+
+		const LayerSnapshot& s = buffer.GetReadSnapshot();
+		if (s.cycle <= lastCycle) ++nbErrors;
+		for (int x = 0; x < 64; ++x)
+		{
+			if (s.labels.at<int>(0, x) != (int)s.cycle) ++nbErrors;
+		}
+		lastCycle = s.cycle;
+	}
+	producer.join();
+	EXPECT_EQ(0u, nbErrors);
+}
+
+//=============================================================================
+TEST_F(TestOdlmPixel, LayerRenderer)
+{
+	ImageData carData("carGray.bmp");
+	ImageData imgData(carData.gray_image_(cv::Rect(100, 0, 60, 50)));
+	PixelLayer layer(imgData, false);
+	layer.RunCascades(30);
+
+	LayerSnapshot snapshot;
+	layer.CaptureSnapshot(snapshot);
+
+	// Zoomed region drawn pixel by pixel as the monitors used to
+	cv::Rect roi(10, 5, 20, 15);
+	cv::Point2f zoom(3.5f, 2.0f);
+	cv::Size size(71, 32);
+	cv::Mat expected(size.height, size.width, CV_8UC3);
+	for (int y = 0; y < size.height; ++y)
+	for (int x = 0; x < size.width; ++x)
+	{
+		const Neuron& n = layer.neurons[layer.GetNeuronId(
+			floor(x / zoom.x) + roi.x, floor(y / zoom.y) + roi.y)];
+
+		cv::Vec3b color(0, 0, 0);
+		if (n.phase >= 0)
+		{
+			color.val[0] = ((n.label + 299) * 37) % 256;
+			color.val[1] = ((n.label + 199) * 27) % 256;
+			color.val[2] = (n.label * 13) % 256;
+		}
+		expected.at<cv::Vec3b>(y, x) = color;
+	}
+
+	LayerRenderer renderer;
+	cv::Mat segments, snapshotSegments;
+	renderer.RenderSegments(layer, segments, size, roi, zoom);
+	renderer.RenderSegments(snapshot, snapshotSegments, size, roi, zoom);
+	ASSERT_EQ(size.height, segments.rows);
+	ASSERT_EQ(size.width, segments.cols);
+	EXPECT_EQ(0, cv::norm(expected, segments, cv::NORM_INF));
+	EXPECT_EQ(0, cv::norm(expected, snapshotSegments, cv::NORM_INF));
+
+	// The caller's buffer is reused
+	const uchar* data = segments.data;
+	renderer.RenderPotentials(layer, segments, size, roi, zoom);
+	EXPECT_EQ(data, segments.data);
+	renderer.RenderPotentials(snapshot, layer.POT_THRESHOLD, 
+							  snapshotSegments, size, roi, zoom);
+	EXPECT_EQ(0, cv::norm(segments, snapshotSegments, cv::NORM_INF));
+
+	// Whole layer at its own size by default
+	cv::Mat phases;
+	renderer.RenderPhases(layer, phases);
+	ASSERT_EQ(50, phases.rows);
+	ASSERT_EQ(60, phases.cols);
+	const Neuron& n = layer.neurons[layer.GetNeuronId(7, 9)];
+	cv::Vec3b color = n.phase >= 0 ? 
+		renderer.GetColor(n.phase * 153) : cv::Vec3b(0, 0, 0);
+	EXPECT_EQ(color, phases.at<cv::Vec3b>(9, 7));
+
+	// The monitors draw with the renderer
+	SegmentLayerMonitor monitor("Renderer Monitor", layer);
+	cv::Mat display;
+	monitor.GetDisplay(display);
+	renderer.RenderSegments(layer, segments);
+	EXPECT_EQ(0, cv::norm(display, segments, cv::NORM_INF));
+}
+
+//=============================================================================
+TEST_F(TestOdlmPixel, PhaseCounters)
+{
+	bool merge = Config::SEG_MERGE_SEGMENTS;
+	Config::SEG_MERGE_SEGMENTS = true;
+
+	ImageData carData("carGray.bmp");
+	ImageData imgData(carData.gray_image_(cv::Rect(100, 0, 60, 50)));
+	PixelLayer layer(imgData, false);
+	layer.SegmentLayer();
+
+	const PhaseCounters& counters = layer.GetPhaseCounters();
+#ifdef LAYER_PROFILER
+	// A cascade finds its time step once and fires the neurons in waves
+	EXPECT_EQ(layer.GetNbCascades(), 
+			  counters.calls[SIM_PHASE_FIND_TIME_STEP]);
+	EXPECT_EQ(layer.GetNbCascades(),
+			  counters.calls[SIM_PHASE_GLOBAL_INHIBITION]);
+	EXPECT_GT(counters.calls[SIM_PHASE_FIRE_NEURONS], 
+			  layer.GetNbCascades());
+	EXPECT_EQ(layer.GetNbSpikes(), counters.spikes);
+	EXPECT_GT(counters.merges, 0u);
+	EXPECT_EQ(counters.merges, counters.calls[SIM_PHASE_MERGE_SEGMENTS]);
+
+	double totalMs = 0;
+	for (int p = 0; p < NB_SIM_PHASES; ++p)
+	{
+		EXPECT_GE(counters.GetTimeMs((SimPhase)p), 0);
+		EXPECT_STRNE("", PhaseCounters::GetPhaseName((SimPhase)p));
+		totalMs += counters.GetTimeMs((SimPhase)p);
+	}
+	EXPECT_GT(totalMs, 0);
+#endif
+
+	layer.ResetPhaseCounters();
+	for (int p = 0; p < NB_SIM_PHASES; ++p)
+	{
+		EXPECT_EQ(0u, counters.calls[p]);
+		EXPECT_EQ(0u, counters.ticks[p]);
+	}
+	EXPECT_EQ(0u, counters.spikes);
+
+	Config::SEG_MERGE_SEGMENTS = merge;
+}
+
+//=============================================================================
+TEST_F(TestOdlmPixel, HardwareCounters)
+{
+	ImageData carData("carGray.bmp");
+	ImageData imgData(carData.gray_image_(cv::Rect(100, 0, 60, 50)));
+	PixelLayer reference(imgData, false);
+	reference.SegmentLayer();
+
+	// The segmentation is the same whether the counters are available or not
+	Config::PROFILE_HW_COUNTERS = true;
+	PixelLayer layer(imgData, false);
+	layer.SegmentLayer();
+	Config::PROFILE_HW_COUNTERS = false;
+	EXPECT_EQ(reference.GetNbSpikes(), layer.GetNbSpikes());
+	for (uint i = 0; i < layer.neurons.size(); ++i)
+	{
+		ASSERT_EQ(reference.neurons[i].phase, layer.neurons[i].phase);
+	}
+
+	HardwareCounters* hwCounters = HardwareCounters::GetThreadCounters();
+	uint available = hwCounters ? hwCounters->GetAvailable() : 0;
+	const PhaseCounters& counters = layer.GetPhaseCounters();
+#ifdef LAYER_PROFILER
+	// Counters of a group that was never scheduled aren't counted
+	EXPECT_EQ(0u, counters.hw_available & ~available);
+#endif
+	for (int c = 0; c < NB_HW_COUNTERS; ++c)
+	{
+		EXPECT_STRNE("", HardwareCounters::GetCounterName((HwCounter)c));
+		if (available & (1u << c)) continue;
+
+		// Unavailable counters are left at 0
+		for (int p = 0; p < NB_SIM_PHASES; ++p)
+		{
+			EXPECT_EQ(0u, counters.hw[p][c]);
+		}
+	}
+	if (available & (1u << HW_COUNTER_INSTRUCTIONS))
+	{
+		EXPECT_GT(counters.hw[SIM_PHASE_FIRE_NEURONS][HW_COUNTER_INSTRUCTIONS],
+				  0u);
+	}
+
+	// Not counted unless enabled
+	EXPECT_EQ(0u, reference.GetPhaseCounters().hw_available);
+}
+
+//=============================================================================
+TEST_F(TestOdlmPixel, SyntheticImage)
+{
+	SyntheticImageParams params;
+	params.width = 120;
+	params.height = 80;
+	params.nb_regions = 50;
+	params.seed = 7;
+
+	// Each region is uniform without noise nor gradient
+	cv::Mat regions;
+	cv::Mat img = GenerateSyntheticImage(params, &regions);
+	ASSERT_EQ(80, img.rows);
+	ASSERT_EQ(120, img.cols);
+	ASSERT_EQ(CV_8U, img.type());
+	ASSERT_EQ(CV_32S, regions.type());
+	vector<int> regionGray(params.nb_regions, -1);
+	vector<int> regionSizes(params.nb_regions, 0);
+	for (int y = 0; y < img.rows; ++y)
+	for (int x = 0; x < img.cols; ++x)
+	{
+		int r = regions.at<int>(y, x);
+		ASSERT_GE(r, 0);
+		ASSERT_LT(r, (int)params.nb_regions);
+		if (regionGray[r] < 0) regionGray[r] = img.at<uchar>(y, x);
+		ASSERT_EQ(regionGray[r], img.at<uchar>(y, x));
+		++regionSizes[r];
+	}
+	for (int size : regionSizes) EXPECT_GT(size, 0);
+
+	// The same seed gives the same image, another seed a different one
+	params.noise = 4.0f;
+	params.gradient = 20.0f;
+	cv::Mat img1 = GenerateSyntheticImage(params);
+	cv::Mat img2 = GenerateSyntheticImage(params);
+	EXPECT_EQ(0, cv::norm(img1, img2, cv::NORM_INF));
+	// Nor on the platform
+	uint64_t checksum = 0;
+	for (int y = 0; y < img1.rows; ++y)
+	for (int x = 0; x < img1.cols; ++x)
+	{
+		checksum = checksum * 31 + img1.at<uchar>(y, x);
+	}
+	EXPECT_EQ(11902812249210511632ull, checksum);
+	params.seed = 8;
+	cv::Mat img3 = GenerateSyntheticImage(params);
+	EXPECT_NE(0, cv::norm(img1, img3, cv::NORM_INF));
+
+	// The skew makes a few regions much larger than the others
+	params.size_skew = 1.0f;
+	GenerateSyntheticImage(params, &regions);
+	vector<int> skewedSizes(params.nb_regions, 0);
+	for (int y = 0; y < regions.rows; ++y)
+	for (int x = 0; x < regions.cols; ++x)
+	{
+		++skewedSizes[regions.at<int>(y, x)];
+	}
+	EXPECT_GT(*max_element(skewedSizes.begin(), skewedSizes.end()),
+			  2 * *max_element(regionSizes.begin(), regionSizes.end()));
+
+	// At most one region per pixel
+	params.width = 4;
+	params.height = 3;
+	params.nb_regions = 100;
+	GenerateSyntheticImage(params, &regions);
+	set<int> pixelRegions;
+	for (int y = 0; y < regions.rows; ++y)
+	for (int x = 0; x < regions.cols; ++x)
+	{
+		pixelRegions.insert(regions.at<int>(y, x));
+	}
+	EXPECT_EQ(12u, pixelRegions.size());
+}
+
+//=============================================================================
+static uint CountOccurrences(const string& a_str, const string& a_pattern)
+{
+	uint count = 0;
+	for (size_t pos = a_str.find(a_pattern); pos != string::npos;
+		 pos = a_str.find(a_pattern, pos + 1))
+	{
+		++count;
+	}
+	return count;
+}
+//-----------------------------------------------------------------------------
+TEST_F(TestOdlmPixel, LayerTracer)
+{
+	ImageData carData("carGray.bmp");
+	ImageData imgData(carData.gray_image_(cv::Rect(100, 0, 60, 50)));
+
+	// Nothing is recorded while not tracing
+	LayerTracer::Start();
+	LayerTracer::Stop();
+	{
+		PixelLayer layer(imgData, false);
+		layer.SegmentLayer();
+	}
+	EXPECT_EQ(0u, CountOccurrences(LayerTracer::GetChromeTrace(), "\"ph\""));
+
+	// One layer on this thread and one on a named worker thread
+	LayerTracer::Start();
+	{
+		PixelLayer layer(imgData, false);
+		layer.SegmentLayer();
+	}
+	thread worker([&imgData]()
+	{
+		LayerTracer::SetThreadName("Worker");
+		PixelLayer layer(imgData, false);
+		layer.SegmentLayer();
+	});
+	worker.join();
+	LayerTracer::Stop();
+
+	string trace = LayerTracer::GetChromeTrace();
+#ifdef LAYER_PROFILER
+	EXPECT_EQ(0u, trace.find("{\"displayTimeUnit\""));
+	EXPECT_EQ(2u, CountOccurrences(trace, "\"thread_name\""));
+	EXPECT_EQ(1u, CountOccurrences(trace, "\"name\":\"Worker"));
+	EXPECT_GT(CountOccurrences(trace, "\"name\":\"Spikes (layer "), 0u);
+
+	// The events are recorded as complete events
+	const char* names[] = { "Cycle", "Cascade", "Wave" };
+	for (const char* name : names)
+	{
+		string event = string("{\"name\":\"") + name + "\",\"ph\":";
+		EXPECT_GT(CountOccurrences(trace, event + "\"X\""), 0u) << name;
+	}
+	EXPECT_EQ(CountOccurrences(trace, "\"ph\":\"X\""),
+			  CountOccurrences(trace, "\"dur\":"));
+
+	EXPECT_TRUE(LayerTracer::WriteChromeTrace("trace.json"));
+	ifstream file("trace.json");
+	string written((istreambuf_iterator<char>(file)),
+				   istreambuf_iterator<char>());
+	// The timestamps may differ as the clock calibration gets refined
+	EXPECT_EQ(CountOccurrences(trace, "\n"),
+			  CountOccurrences(written, "\n"));
+	file.close();
+	remove("trace.json");
+
+	// A full buffer keeps the most recent events
+	uint bufferSize = Config::TRACE_BUFFER_SIZE;
+	Config::TRACE_BUFFER_SIZE = 16;
+	LayerTracer::Start();
+	{
+		PixelLayer layer(imgData, false);
+		layer.SegmentLayer();
+	}
+	LayerTracer::Stop();
+	trace = LayerTracer::GetChromeTrace();
+	EXPECT_EQ(16u, CountOccurrences(trace, "\"ph\"") -
+				   CountOccurrences(trace, "\"ph\":\"M\""));
+	EXPECT_NE(string::npos, trace.find("{\"name\":\"Cycle\",\"ph\":\"X\""));
+	EXPECT_EQ(0u, CountOccurrences(trace, "\"ph\":\"B\""));
+	EXPECT_EQ(0u, CountOccurrences(trace, "\"ph\":\"E\""));
+	Config::TRACE_BUFFER_SIZE = bufferSize;
+
+	// An end which doesn't match the last event begun is dropped
+	LayerTracer::Start();
+	LayerTracer::Begin("Outer", 0, 0);
+	LayerTracer::Begin("Inner", 0, 0);
+	LayerTracer::End("Outer", 0);
+	LayerTracer::End("Inner", 1);
+	LayerTracer::End("Inner", 0);
+	LayerTracer::End("Outer", 0);
+	LayerTracer::Stop();
+	trace = LayerTracer::GetChromeTrace();
+	EXPECT_EQ(2u, CountOccurrences(trace, "\"ph\":\"X\""));
+	EXPECT_EQ(1u, CountOccurrences(trace, "{\"name\":\"Inner\""));
+	EXPECT_EQ(1u, CountOccurrences(trace, "{\"name\":\"Outer\""));
+
+	LayerTracer::Clear();
+#else
+	EXPECT_EQ(0u, CountOccurrences(trace, "\"ph\""));
+#endif
+}
+
+//=============================================================================
+TEST_F(TestOdlmPixel, BinaryState)
+{
+	ImageData carData("carGray.bmp");
+	ImageData imgData(carData.gray_image_(cv::Rect(100, 0, 60, 50)));
+
+	// Save a layer in the middle of its segmentation
+	PixelLayer layer(imgData, false);
+	layer.MAX_SEG_CYCLES = 7;
+	ASSERT_TRUE(layer.RunCascades(5));
+	ASSERT_TRUE(layer.SaveBinaryState("layer.state"));
+	EXPECT_TRUE(layer.ValidateLayerState("layer.state"));
+
+	// The file holds the same bytes as the state in memory
+	vector<char> state = layer.GetBinaryState();
+	ifstream file("layer.state", ios::binary);
+	string written((istreambuf_iterator<char>(file)),
+				   istreambuf_iterator<char>());
+	file.close();
+	EXPECT_EQ(string(state.begin(), state.end()), written);
+
+	// The restored layer resumes the segmentation identically
+	PixelLayer resumed(imgData, false);
+	ASSERT_TRUE(resumed.LoadBinaryState("layer.state"));
+	EXPECT_EQ(7u, resumed.MAX_SEG_CYCLES);
+	EXPECT_EQ(layer.GetNbCascades(), resumed.GetNbCascades());
+	EXPECT_TRUE(resumed.ValidateLayerState("layer.state"));
+
+	while (layer.Step())
+	{
+	}
+	while (resumed.Step())
+	{
+	}
+	EXPECT_EQ(layer.GetNbCascades(), resumed.GetNbCascades());
+	EXPECT_EQ(layer.GetNbSpikes(), resumed.GetNbSpikes());
+	EXPECT_TRUE(resumed.IsSegmentationDone());
+	for (uint i = 0; i < layer.size; ++i)
+	{
+		ASSERT_EQ(layer.neurons[i].label, resumed.neurons[i].label);
+		ASSERT_EQ(layer.neurons[i].phase, resumed.neurons[i].phase);
+		ASSERT_EQ(layer.neurons[i].pot, resumed.neurons[i].pot);
+	}
+	EXPECT_FALSE(layer.ValidateLayerState("layer.state"));
+
+	// The state in memory, in a layer with another layout
+	LayerStateView view;
+	ASSERT_TRUE(view.Parse(state.data(), state.size()));
+	uint layout = Config::SIM_NEURON_LAYOUT;
+	uint tileSize = Config::SIM_LAYOUT_TILE_SIZE;
+	Config::SIM_NEURON_LAYOUT = LAYOUT_TILED;
+	Config::SIM_LAYOUT_TILE_SIZE = 16;
+	PixelLayer tiled(imgData, false);
+	Config::SIM_NEURON_LAYOUT = layout;
+	Config::SIM_LAYOUT_TILE_SIZE = tileSize;
+	ASSERT_TRUE(tiled.LoadBinaryState(view));
+	EXPECT_TRUE(tiled.ValidateBinaryState(view));
+	PixelLayer rowMajor(imgData, false);
+	ASSERT_TRUE(rowMajor.LoadBinaryState(view));
+	for (uint y = 0; y < tiled.height; ++y)
+	for (uint x = 0; x < tiled.width; ++x)
+	{
+		ASSERT_EQ(rowMajor.neurons[rowMajor.GetNeuronId(x, y)].label,
+				  tiled.neurons[tiled.GetNeuronId(x, y)].label);
+	}
+
+	// Invalid states are rejected
+	ImageData smallData(carData.gray_image_(cv::Rect(100, 0, 30, 30)));
+	PixelLayer small(smallData, false);
+	EXPECT_FALSE(small.LoadBinaryState(view));
+	EXPECT_FALSE(view.Parse(state.data(), state.size() - 8));
+	state[0] = 'X';
+	EXPECT_FALSE(view.Parse(state.data(), state.size()));
+	EXPECT_FALSE(resumed.LoadBinaryState("missing.state"));
+
+	// The super-neurons are saved expanded, without changing the layer
+	PixelLayer coarsened(carData, false);
+	coarsened.COARSEN_SEGMENTS = true;
+	coarsened.COARSEN_DELTA_PERIOD = 0.5f;
+	coarsened.COARSEN_CYCLES = 1;
+	while (coarsened.GetNbActiveNeurons() == coarsened.size &&
+		   coarsened.Step())
+	{
+	}
+	ASSERT_LT(coarsened.GetNbActiveNeurons(), coarsened.size);
+	vector<char> coarseState = coarsened.GetBinaryState();
+	EXPECT_TRUE(coarseState == coarsened.GetBinaryState());
+	ASSERT_TRUE(view.Parse(coarseState.data(), coarseState.size()));
+	PixelLayer expanded(carData, false);
+	ASSERT_TRUE(expanded.LoadBinaryState(view));
+	EXPECT_EQ(expanded.size, expanded.GetNbActiveNeurons());
+	for (uint i = 0; i < expanded.size; ++i)
+	{
+		ASSERT_EQ(coarsened.neurons[i].label, expanded.neurons[i].label);
+	}
+
+	// Text states are still validated
+	layer.SaveStateToFile("layer.valid");
+	EXPECT_TRUE(layer.ValidateLayerState("layer.valid"));
+
+	remove("layer.state");
+	remove("layer.valid");
+}
+
+//=============================================================================
+TEST_F(TestOdlmPixel, BinaryStateClasses)
+{
+	ImageData carData("carGray.bmp");
+	bool trigger = Config::SEG_TRIGGER_SAME_LABEL_NEURONS;
+	bool merge = Config::SEG_MERGE_SEGMENTS;
+	bool fixedSize = Config::FIXED_INPUT_IMGS_SIZE;
+
+	// Generic, specialized and fixed size layers come back with their class
+	ImageData genericData(carData.gray_image_(cv::Rect(100, 0, 60, 50)));
+	ImageData fixedData(carData.gray_image_(cv::Rect(100, 0, 64, 128)));
+	Config::SEG_TRIGGER_SAME_LABEL_NEURONS = true;
+	Config::SEG_MERGE_SEGMENTS = false;
+	Config::FIXED_INPUT_IMGS_SIZE = true;
+	vector<unique_ptr<PixelLayer> > layers;
+	layers.emplace_back(new PixelLayer(genericData, false));
+	layers.push_back(CreatePixelLayer(genericData, false));
+	layers.push_back(CreatePixelLayer(fixedData, false));
+	Config::SEG_TRIGGER_SAME_LABEL_NEURONS = trigger;
+	Config::SEG_MERGE_SEGMENTS = merge;
+	Config::FIXED_INPUT_IMGS_SIZE = fixedSize;
+	EXPECT_EQ(PIXEL_LAYER_GENERIC, layers[0]->GetLayerClass());
+	EXPECT_EQ(PIXEL_LAYER_SPECIALIZED, layers[1]->GetLayerClass());
+	EXPECT_EQ(PIXEL_LAYER_FIXED_SIZE, layers[2]->GetLayerClass());
+
+	// A packed layer, restored after its segmentation
+	vector<cv::Mat> images;
+	images.push_back(carData.gray_image_(cv::Rect(0, 0, 48, 60)).clone());
+	images.push_back(carData.gray_image_(cv::Rect(100, 20, 40, 40)).clone());
+	PackedPixelLayer* packed = new PackedPixelLayer(images, false);
+	layers.emplace_back(packed);
+	vector<PackedImageResult> results = packed->SegmentImages();
+
+	// The images of the states are used as is, whatever the input format
+	Config::FIXED_INPUT_IMGS_SIZE = true;
+	for (auto& layer : layers)
+	{
+		if (layer.get() != packed) layer->RunCascades(5);
+
+		vector<char> state = layer->GetBinaryState();
+		LayerStateView view;
+		ASSERT_TRUE(view.Parse(state.data(), state.size()));
+
+		unique_ptr<PixelLayer> restored = CreatePixelLayer(view);
+		ASSERT_TRUE(restored != nullptr);
+		EXPECT_TRUE(typeid(*layer) == typeid(*restored));
+		EXPECT_EQ(layer->GetLayerClass(), restored->GetLayerClass());
+		EXPECT_EQ(layer->TRIGGER_SAME_LABEL_NEURONS,
+				  restored->TRIGGER_SAME_LABEL_NEURONS);
+		EXPECT_TRUE(restored->ValidateBinaryState(view));
+		ASSERT_EQ(layer->size, restored->size);
+		for (uint i = 0; i < layer->size; ++i)
+		{
+			ASSERT_EQ(layer->neurons[i].label, restored->neurons[i].label);
+			ASSERT_EQ(layer->neurons[i].pot, restored->neurons[i].pot);
+		}
+	}
+	Config::FIXED_INPUT_IMGS_SIZE = fixedSize;
+
+	vector<char> packedState = packed->GetBinaryState();
+	LayerStateView packedView;
+	ASSERT_TRUE(packedView.Parse(packedState.data(), packedState.size()));
+	unique_ptr<PixelLayer> restored = CreatePixelLayer(packedView);
+	PackedPixelLayer* restoredPacked = 
+		dynamic_cast<PackedPixelLayer*>(restored.get());
+	ASSERT_TRUE(restoredPacked != nullptr);
+	ASSERT_EQ(packed->GetNbImages(), restoredPacked->GetNbImages());
+	for (uint k = 0; k < packed->GetNbImages(); ++k)
+	{
+		EXPECT_EQ(packed->GetImageRegion(k), restoredPacked->GetImageRegion(k));
+	}
+
+	// A packed state only fits a layer packing images of the same sizes
+	images.pop_back();
+	PackedPixelLayer other(images, false);
+	EXPECT_FALSE(other.LoadBinaryState(packedView));
+
+	// A specialized layer only takes the states of its segmentation flags
+	vector<char> genericState = layers[0]->GetBinaryState();
+	LayerStateView genericView;
+	ASSERT_TRUE(genericView.Parse(genericState.data(), genericState.size()));
+	Config::SEG_TRIGGER_SAME_LABEL_NEURONS = false;
+	unique_ptr<PixelLayer> otherFlags = CreatePixelLayer(genericData, false);
+	Config::SEG_TRIGGER_SAME_LABEL_NEURONS = trigger;
+	EXPECT_FALSE(otherFlags->LoadBinaryState(genericView));
+}
+
+//=============================================================================
+TEST_F(TestOdlmPixel, NeuronLayout)
+{
+	// The maximal charge is kept by the layer, and the compact neurons store
+	// their periods in half precision
+#ifdef COMPACT_NEURONS
+	EXPECT_EQ(20u, sizeof(Neuron));
+	EXPECT_EQ(sizeof(Half), sizeof(PeriodType));
+#else
+	EXPECT_EQ(28u, sizeof(Neuron));
+	EXPECT_EQ(sizeof(float), sizeof(PeriodType));
+#endif
+
+	// The neurons of a pixel layer share the leader and follower charges
+	ImageData carData("carGray.bmp");
+	ImageData imgData(carData.gray_image_(cv::Rect(100, 0, 60, 50)));
+	PixelLayer layer(imgData, false);
+	uint nbLeaders = 0;
+	for (uint i = 0; i < layer.size; ++i)
+	{
+		float charge = layer.GetMaxCharge(i);
+		ASSERT_TRUE(charge == layer.CHARGING_LEADER ||
+					charge == layer.CHARGING_FOLLOW);
+		if (charge == layer.CHARGING_LEADER) ++nbLeaders;
+	}
+	EXPECT_GT(nbLeaders, 0u);
+	EXPECT_LT(nbLeaders, layer.size);
+
+	// The charges come back with the state
+	ASSERT_TRUE(layer.RunCascades(3));
+	vector<char> state = layer.GetBinaryState();
+	LayerStateView view;
+	ASSERT_TRUE(view.Parse(state.data(), state.size()));
+	PixelLayer restored(imgData, false);
+	ASSERT_TRUE(restored.LoadBinaryState(view));
+	for (uint i = 0; i < layer.size; ++i)
+	{
+		ASSERT_EQ(layer.GetMaxCharge(i), restored.GetMaxCharge(i));
+	}
+}
+
+//=============================================================================
+TEST_F(TestOdlmPixel, LayerCoupling)
+{
+	ImageData carData("carGray.bmp");
+	ImageData probeData(carData.gray_image_(cv::Rect(100, 0, 20, 20)));
+	ImageData otherData(carData.gray_image_(cv::Rect(0, 60, 20, 20)));
+
+	// Couple a layer with the same image and with another image
+	float scores[2];
+	for (uint k = 0; k < 2; ++k)
+	{
+		PixelLayer probe(probeData, false);
+		PixelLayer gallery(k == 0 ? probeData : otherData, false);
+		probe.SegmentLayer();
+		gallery.SegmentLayer();
+
+		// Segmented apart, the layers share no label
+		PixelLayerCoupler coupler(&probe, &gallery);
+		EXPECT_EQ(0.0f, coupler.ComputeCorrespondence());
+
+		scores[k] = coupler.RunCoupling(20);
+		EXPECT_GE(scores[k], 0.0f);
+		EXPECT_LE(scores[k], 1.0f);
+
+		// The score can't reach more than a perfect correspondence
+		EXPECT_EQ(-1.0f, coupler.RunCoupling(5, 1.01f));
+	}
+	EXPECT_GT(scores[0], scores[1]);
+}
+
+//=============================================================================
+TEST_F(TestOdlmPixel, GalleryMatcher)
+{
+	ImageData carData("carGray.bmp");
+	cv::Mat probe = carData.gray_image_(cv::Rect(100, 0, 20, 20)).clone();
+
+	GalleryMatcher matcher;
+	matcher.COUPLING_CASCADES = 20;
+	matcher.NB_THREADS = 2;
+	matcher.SetProbe(probe);
+	matcher.AddGalleryImage(carData.gray_image_(cv::Rect(0, 60, 20, 20)));
+	matcher.AddGalleryImage(probe);
+	matcher.AddGalleryImage(carData.gray_image_(cv::Rect(40, 30, 24, 16)));
+	ASSERT_EQ(3u, matcher.GetGallerySize());
+
+	// The probe itself ranks first
+	vector<GalleryMatch> ranked = matcher.Match();
+	ASSERT_EQ(3u, ranked.size());
+	EXPECT_EQ(1u, ranked[0].gallery_id);
+	EXPECT_GE(ranked[0].score, ranked[1].score);
+	EXPECT_GE(ranked[1].score, ranked[2].score);
+	EXPECT_EQ(0u, matcher.GetNbAbandoned());
+
+	// The layers are restored after each coupling, so matching again gives
+	// the same scores
+	vector<GalleryMatch> again = matcher.Match();
+	ASSERT_EQ(ranked.size(), again.size());
+	for (uint k = 0; k < ranked.size(); ++k)
+	{
+		EXPECT_EQ(ranked[k].gallery_id, again[k].gallery_id);
+		EXPECT_EQ(ranked[k].score, again[k].score);
+	}
+
+	// The top match is the same when the others may be abandoned
+	vector<GalleryMatch> top = matcher.Match(1);
+	ASSERT_EQ(1u, top.size());
+	EXPECT_EQ(ranked[0].gallery_id, top[0].gallery_id);
+	EXPECT_EQ(ranked[0].score, top[0].score);
+}
+
+//=============================================================================
+namespace
+{
+	// Debugger recording the calls of the DebugHooks policy
+	struct RecordingDebugger
+	{
+		static bool IsActive() { ++nb_checks; return active; }
+
+		static void SetBreakpoint(const NeuralLayer& a_layer,
+								  DebugLevel a_level, int a_progress = -1)
+		{
+			levels.push_back(a_level);
+		}
+
+		static bool active;
+		static uint nb_checks;
+		static vector<DebugLevel> levels;
+	};
+	bool RecordingDebugger::active = false;
+	uint RecordingDebugger::nb_checks = 0;
+	vector<DebugLevel> RecordingDebugger::levels;
+
+	template <class Hooks>
+	void RunDebugHooks(const NeuralLayer& a_layer)
+	{
+		Hooks::Spike(a_layer, 0);
+		Hooks::Cascade(a_layer, 1);
+		Hooks::Cycle(a_layer, 2);
+		Hooks::End(a_layer);
+	}
+}
+
+TEST_F(TestOdlmPixel, DebugHooks)
+{
+	ImageData carData("carGray.bmp");
+	ImageData imgData(carData.gray_image_(cv::Rect(100, 0, 10, 10)));
+	PixelLayer layer(imgData, false);
+
+	typedef DebugHooks<true, true, RecordingDebugger> AllHooks;
+	typedef DebugHooks<true, false, RecordingDebugger> StepHooks;
+	typedef DebugHooks<false, false, RecordingDebugger> ReleaseHooks;
+
+	// Without a debugger, the hooks only check the flag
+	RunDebugHooks<AllHooks>(layer);
+	EXPECT_EQ(4u, RecordingDebugger::nb_checks);
+	EXPECT_TRUE(RecordingDebugger::levels.empty());
+
+	// With a debugger, the enabled levels fire
+	RecordingDebugger::active = true;
+	RunDebugHooks<AllHooks>(layer);
+	vector<DebugLevel> all = { DEBUG_LEVEL_SPIKE, DEBUG_LEVEL_CASCADE,
+							   DEBUG_LEVEL_CYCLE, DEBUG_LEVEL_END };
+	EXPECT_EQ(all, RecordingDebugger::levels);
+
+	RecordingDebugger::levels.clear();
+	RunDebugHooks<StepHooks>(layer);
+	vector<DebugLevel> steps(all.begin() + 1, all.end());
+	EXPECT_EQ(steps, RecordingDebugger::levels);
+
+	// The release hooks don't even check the flag
+	RecordingDebugger::levels.clear();
+	RecordingDebugger::nb_checks = 0;
+	RunDebugHooks<ReleaseHooks>(layer);
+	EXPECT_EQ(0u, RecordingDebugger::nb_checks);
+	EXPECT_TRUE(RecordingDebugger::levels.empty());
+	RecordingDebugger::active = false;
+
+	// The hooks selected by the build
+#if defined(LAYER_DEBUGGER_SPIKES)
+	EXPECT_TRUE((is_same<LayerDebugHooks, DebugHooks<true, true> >::value));
+#elif defined(LAYER_DEBUGGER)
+	EXPECT_TRUE((is_same<LayerDebugHooks, DebugHooks<true, false> >::value));
+#else
+	EXPECT_TRUE((is_same<LayerDebugHooks, DebugHooks<false, false> >::value));
+#endif
+}
+
+//=============================================================================
+TEST_F(TestOdlmPixel, Misc_Test)
+{
+	bool randomInit = true;
+	bool regenerateValidationFile = false;
+
+	string imgFilename = "small.bmp";
+	ImageData imgData(imgFilename);
+
+	PixelLayer pixelSegLayer(ImageData(imgFilename), randomInit);
+
+	//{
+		SegmentLayerMonitor label_monitor("Segment Monitor", pixelSegLayer);
+		label_monitor.Display();
+		LayerDebugger::AddDebugger(pixelSegLayer, "Debug");
+	//}
+
+
+	pixelSegLayer.SegmentLayer();
+	
+
+	cv::waitKey(DISPLAY_TIME);
 }
\ No newline at end of file
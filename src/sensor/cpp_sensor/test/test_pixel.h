@@ -1,39 +1,47 @@
-/** @file test_odlm.h
-*
-* @authors Vincent de Ladurantaye
-*/
-#pragma once
-
-#include "gtest/gtest.h"
-
-#include "NeuralNetwork.h"
-
-
-//=============================================================================
-//								TestOdlmPixel
-//=============================================================================
-/**
-* Class for testing the pixel ODLM working with gray pixel values.
-*/
-class TestOdlmPixel: public ::testing::Test
-{
-public:
-	/**
-	* Constructor
-	*/
-	TestOdlmPixel();
-
-
-	/**
-	* Code here will be called immediately after the constructor (right
-	* before each test).
-	*/
-	virtual void SetUp();
-
-	/**
-	* Code here will be called immediately after each test (right
-	* before the destructor).
-	*/
-	virtual void TearDown();
-	
-};
+/** @file test_odlm.h
+*
+* @authors Vincent de Ladurantaye
+*/
+#pragma once
+
+#include "gtest/gtest.h"
+
+#include "NeuralNetwork.h"
+
+
+//=============================================================================
+//								TestOdlmPixel
+//=============================================================================
+/**
+* Class for testing the pixel ODLM working with gray pixel values.
+*/
+class TestOdlmPixel: public ::testing::Test
+{
+public:
+	/**
+	* Constructor
+	*/
+	TestOdlmPixel();
+
+
+	/**
+	* Code here will be called immediately after the constructor (right
+	* before each test).
+	*/
+	virtual void SetUp();
+
+	/**
+	* Code here will be called immediately after each test (right
+	* before the destructor).
+	*/
+	virtual void TearDown();
+
+	/**
+	* Segments both layers for the given number of cycles and checks that
+	* they end up in the same state.
+	*/
+	void ExpectSameSegmentation(PixelLayer& a_layer1,
+								PixelLayer& a_layer2,
+								uint a_nb_cycles);
+	
+};